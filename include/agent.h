@@ -4,11 +4,26 @@
 #include <string>
 #include <memory>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
 #include "config.h"
+#include "config_store.h"
+#include "config_watcher.h"
 #include "file_monitor.h"
+#include "file_state_index.h"
+#include "baseline_crawler.h"
 #include "clipboard_monitor.h"
 #include "usb_monitor.h"
+#include "removable_volumes.h"
 #include "http_client.h"
+#include "event_spool.h"
+#include "event_reporter.h"
+#include "event_pipeline.h"
+#include "event_trace.h"
+#include "metrics_exporter.h"
+#include "events.h"
+#include "classifier.h"
 
 namespace cybersentinel {
 
@@ -28,29 +43,63 @@ public:
 
     // Agent registration
     bool register_agent();
-    void send_heartbeat();
+    bool send_heartbeat();
 
     // Event reporting
     void report_event(const std::string& event_type,
                      const std::string& severity,
                      const std::string& file_path = "",
-                     const std::string& classification = "");
+                     const ClassificationResult* classification = nullptr);
 
 private:
-    // Configuration
-    std::unique_ptr<Config> config_;
+    // Configuration: immutable snapshots, replaced when the file changes
+    std::string config_file_;
+    ConfigStore config_store_;
+    std::unique_ptr<ConfigWatcher> config_watcher_;
 
-    // Monitors
+    // The current snapshot; lock-free
+    const Config& config() const { return *config_store_.current(); }
+
+    // Monitors. The mutex guards the pointers against a reload starting or
+    // stopping monitors while heartbeats read them or the agent stops.
+    std::mutex monitors_mutex_;
+    std::unique_ptr<FileStateIndex> file_index_;
     std::unique_ptr<FileMonitor> file_monitor_;
+    std::unique_ptr<BaselineCrawler> baseline_crawler_;
     std::unique_ptr<ClipboardMonitor> clipboard_monitor_;
     std::unique_ptr<USBMonitor> usb_monitor_;
+    std::unique_ptr<RemovableVolumeWatcher> volume_watcher_;
 
     // HTTP client for server communication
     std::unique_ptr<HttpClient> http_client_;
 
+    // Local spool for events the server could not accept
+    std::unique_ptr<EventSpool> spool_;
+
+    // Encodes, delivers and spools events
+    std::unique_ptr<EventReporter> reporter_;
+
+    // Index check, classification and reporting of monitored events
+    std::unique_ptr<EventPipeline> pipeline_;
+
+    // Records monitored events for replay when event tracing is enabled
+    std::unique_ptr<TraceWriter> trace_writer_;
+
+    // Writes the metrics snapshot file when metrics are enabled
+    std::unique_ptr<MetricsExporter> metrics_exporter_;
+
+    // Health counters reported in heartbeats
+    uint64_t heartbeat_files_scanned_{0};
+    std::chrono::steady_clock::time_point heartbeat_time_;
+
     // Control flags
     std::atomic<bool> running_{false};
     std::atomic<bool> initialized_{false};
+    std::atomic<bool> registered_{false};
+
+    // Startup timing: time from initialize() to the first monitored event
+    std::chrono::steady_clock::time_point start_time_;
+    std::atomic<bool> first_event_seen_{false};
 
     // Agent info
     std::string agent_id_;
@@ -60,11 +109,29 @@ private:
 
     // Helper methods
     void initialize_system_info();
+    bool start_file_monitoring(const Config& config);
+    void start_baseline_crawl(const Config& config);
+    void stop_file_monitoring();
+    bool start_clipboard_monitoring(const Config& config);
+    void stop_clipboard_monitoring();
+    bool start_usb_monitoring(const Config& config);
+    void stop_usb_monitoring();
+    void start_metrics_export(const Config& config);
+    void update_metric_gauges();
+    void apply_config(const Config& previous, const Config& current);
+    void registration_loop();
     void heartbeat_loop();
+    void note_monitored_event();
+    AgentHealth collect_health();
+    void sleep_while_running(std::chrono::milliseconds duration);
     void handle_file_event(const std::string& file_path,
                            const std::string& event_type);
     void handle_clipboard_event(const std::string& content);
-    void handle_usb_event(const std::string& device_name);
+    void handle_usb_event(const VolumeInfo& volume);
+    void handle_usb_removal(const VolumeInfo& volume);
+    void handle_volume_file_event(const std::string& file_path,
+                                  const std::string& event_type,
+                                  const VolumeInfo& volume);
 };
 
 } // namespace cybersentinel
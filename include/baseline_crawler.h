@@ -0,0 +1,120 @@
+#ifndef CYBERSENTINEL_BASELINE_CRAWLER_H
+#define CYBERSENTINEL_BASELINE_CRAWLER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "file_monitor.h"
+#include "file_state_index.h"
+#include "token_bucket.h"
+
+namespace cybersentinel {
+
+// Walks the monitored paths once and feeds every existing file into the
+// classification pipeline, so data that was already on disk before the agent
+// started is classified too. Directories are crawled breadth-first by a pool
+// of workers; each worker holds at most one directory handle open, and only
+// while listing it. File reads are throttled by files/sec and MB/sec.
+//
+// Progress is checkpointed as the set of directories not yet finished, so
+// after a restart the crawl resumes where it stopped. A checkpoint written
+// for other classification rules is discarded and the crawl starts over.
+class BaselineCrawler {
+public:
+    struct Options {
+        int threads = 2;
+        double max_files_per_sec = 0.0;   // 0 = unlimited
+        double max_mb_per_sec = 0.0;      // 0 = unlimited
+        std::string checkpoint_path;      // empty = no checkpointing
+        uint32_t rules_version = 0;
+    };
+
+    struct Stats {
+        uint64_t directories = 0;
+        uint64_t files_found = 0;
+        uint64_t files_classified = 0;
+        uint64_t files_unchanged = 0;     // already in the file-state index
+        uint64_t bytes_classified = 0;
+        uint64_t pending_directories = 0;
+        uint64_t elapsed_ms = 0;
+        bool complete = false;
+    };
+
+    // callback receives each file with event type "baseline". index, when
+    // given, is consulted to skip files already classified unchanged.
+    BaselineCrawler(const std::vector<std::string>& paths, FileEventCallback callback,
+                    FileStateIndex* index, const Options& options);
+    ~BaselineCrawler();
+
+    // Delete copy constructor and assignment
+    BaselineCrawler(const BaselineCrawler&) = delete;
+    BaselineCrawler& operator=(const BaselineCrawler&) = delete;
+
+    // Resume from the checkpoint, or start a new crawl
+    bool start();
+
+    // Stop the workers and checkpoint the remaining directories
+    void stop();
+
+    // Discard all progress and crawl everything again, e.g. after the
+    // classification rules changed. Unchanged files are not skipped.
+    void restart(uint32_t rules_version);
+
+    // Block until the crawl completes or is stopped; true if it completed
+    bool wait();
+
+    Stats stats();
+
+private:
+    std::vector<std::string> monitored_paths_;
+    FileEventCallback callback_;
+    FileStateIndex* index_;
+    Options options_;
+    bool skip_unchanged_{true};
+
+    TokenBucket file_rate_;
+    TokenBucket byte_rate_;
+
+    std::atomic<bool> running_{false};
+    std::vector<std::thread> workers_;
+
+    // A directory whose subdirectories are already queued only needs its
+    // files classified when it is resumed from a checkpoint
+    struct PendingDirectory {
+        std::string path;
+        bool files_only;
+    };
+
+    // Directories waiting to be listed, and those being worked on (mapped to
+    // whether they have been listed); together they are what a checkpoint
+    // records
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<PendingDirectory> queue_;
+    std::unordered_map<std::string, bool> in_progress_;
+    std::vector<std::string> roots_;
+    bool complete_{false};
+    std::chrono::steady_clock::time_point start_time_;
+    std::chrono::steady_clock::time_point checkpoint_time_;
+    Stats stats_;
+
+    std::mutex checkpoint_mutex_;
+
+    bool start_workers(bool resume);
+    void worker_loop();
+    void crawl_directory(const PendingDirectory& directory);
+    void throttle(uint64_t bytes);
+    bool load_checkpoint(const std::vector<std::string>& roots);
+    void save_checkpoint();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_BASELINE_CRAWLER_H
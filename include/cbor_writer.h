@@ -0,0 +1,46 @@
+#ifndef CYBERSENTINEL_CBOR_WRITER_H
+#define CYBERSENTINEL_CBOR_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Streaming CBOR (RFC 8949) writer with the same interface as JsonWriter.
+// Maps and arrays use indefinite-length encoding so records are written in a
+// single pass with no intermediate copies. Text strings get the same UTF-8
+// sanitizing as JSON output.
+class CborWriter {
+public:
+    explicit CborWriter(std::string& out);
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text);
+    void value(bool flag);
+    void value(int number);
+    void value(int64_t number);
+    void value(uint64_t number);
+    void value(double number);
+    void null_value();
+
+    // Reusable per-thread buffer, cleared but keeping its capacity
+    static std::string& thread_buffer();
+
+private:
+    std::string& out_;
+
+    void write_head(uint8_t major_type, uint64_t argument);
+    void write_text(std::string_view text);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_CBOR_WRITER_H
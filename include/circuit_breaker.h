@@ -0,0 +1,76 @@
+#ifndef CYBERSENTINEL_CIRCUIT_BREAKER_H
+#define CYBERSENTINEL_CIRCUIT_BREAKER_H
+
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Exponential backoff with "equal jitter": a random delay in [d/2, d] where
+// d = min(cap, base * 2^attempt). Spreads retries from many agents apart.
+std::chrono::milliseconds jittered_backoff(int attempt,
+                                           std::chrono::milliseconds base,
+                                           std::chrono::milliseconds cap);
+
+// Per-endpoint circuit breaker. After failure_threshold consecutive failures
+// the circuit opens and requests fail fast without touching the network.
+// Once the (jittered, growing) open period elapses a single half-open probe
+// is let through; its outcome closes the circuit or re-opens it.
+class CircuitBreaker {
+public:
+    enum class State {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    struct Stats {
+        State state = State::CLOSED;
+        uint64_t times_opened = 0;
+        uint64_t times_half_opened = 0;
+        uint64_t times_closed = 0;
+        uint64_t rejected_requests = 0;
+        std::chrono::milliseconds time_open{0};
+    };
+
+    CircuitBreaker(const std::string& name,
+                   int failure_threshold,
+                   std::chrono::milliseconds open_duration,
+                   std::chrono::milliseconds max_open_duration);
+
+    // Returns false while the circuit is open; the caller must fail fast
+    bool allow_request();
+    void record_success();
+    void record_failure();
+
+    // Gives back the half-open probe slot taken by allow_request() for a
+    // request that was never sent, so the next request can probe instead
+    void release_probe();
+
+    Stats stats();
+
+    static const char* state_to_string(State state);
+
+private:
+    std::string name_;
+    int failure_threshold_;
+    std::chrono::milliseconds open_duration_;
+    std::chrono::milliseconds max_open_duration_;
+
+    std::mutex mutex_;
+    State state_{State::CLOSED};
+    int consecutive_failures_{0};
+    int open_attempts_{0};
+    bool probe_in_flight_{false};
+    std::chrono::steady_clock::time_point open_since_;
+    std::chrono::steady_clock::time_point open_until_;
+    Stats stats_;
+
+    void trip(std::chrono::steady_clock::time_point now);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_CIRCUIT_BREAKER_H
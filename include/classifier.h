@@ -4,26 +4,40 @@
 #include <string>
 #include <vector>
 #include <regex>
+#include <cstdint>
+#include "io_governor.h"
 
 namespace cybersentinel {
 
 struct ClassificationResult {
     std::vector<std::string> labels;
     double confidence;
+    uint64_t content_hash;  // FNV-1a of the file content; 0 for text
 
-    ClassificationResult() : confidence(0.0) {}
+    ClassificationResult() : confidence(0.0), content_hash(0) {}
 };
 
+// The patterns are compiled once, in the constructor; classification only
+// reads them, so one instance can serve several threads at once.
 class Classifier {
 public:
+    // Bump whenever the patterns change, so files classified under the old
+    // rules are classified again
+    static constexpr uint32_t kRulesVersion = 1;
+
     Classifier();
     ~Classifier() = default;
 
-    // Classify file content
-    ClassificationResult classify_file(const std::string& file_path);
+    // Classify file content, reading it at priority under the I/O governor
+    ClassificationResult classify_file(const std::string& file_path,
+                                       IoGovernor::Priority priority = IoGovernor::Priority::NORMAL) const;
 
     // Classify text content
-    ClassificationResult classify_text(const std::string& content);
+    ClassificationResult classify_text(const std::string& content) const;
+
+    // Labels as a bit set, one bit per label this classifier can produce, for
+    // compact storage in the file-state index
+    static uint32_t label_mask(const std::vector<std::string>& labels);
 
 private:
     // Pattern matchers
@@ -34,10 +48,10 @@ private:
     std::regex secret_regex_;   // Generic secrets
 
     // Helper methods
-    std::string read_file(const std::string& file_path);
-    bool matches_pattern(const std::string& content, const std::regex& pattern);
+    std::string read_file(const std::string& file_path, IoGovernor::Priority priority) const;
+    bool matches_pattern(const std::string& content, const std::regex& pattern) const;
     double calculate_confidence(const std::string& content,
-                                const std::vector<std::string>& labels);
+                                const std::vector<std::string>& labels) const;
 };
 
 } // namespace cybersentinel
@@ -0,0 +1,98 @@
+#ifndef CYBERSENTINEL_CLIPBOARD_DISPATCHER_H
+#define CYBERSENTINEL_CLIPBOARD_DISPATCHER_H
+
+#include <string>
+#include <list>
+#include <deque>
+#include <unordered_map>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+namespace cybersentinel {
+
+using ClipboardEventCallback = std::function<void(const std::string& content)>;
+
+// Hands captured clipboard text from the clipboard window thread to a worker
+// that runs the callback (classification and reporting), so a slow server
+// never stalls clipboard notifications. Content copied again within the
+// dedup window is recognised by its hash in a small LRU and dropped. When
+// the worker falls behind, the oldest pending content is dropped.
+// Platform-independent; the Win32 capture lives in ClipboardMonitor.
+class ClipboardDispatcher {
+public:
+    struct Options {
+        size_t dedup_entries = 64;
+        std::chrono::seconds dedup_window{300};  // older hits count as new content
+        size_t max_pending = 16;
+    };
+
+    struct Stats {
+        uint64_t captured = 0;
+        uint64_t duplicates = 0;
+        uint64_t dropped = 0;    // pending content discarded, worker too slow
+        uint64_t delivered = 0;  // callbacks completed
+    };
+
+    ClipboardDispatcher(ClipboardEventCallback callback, const Options& options);
+    ~ClipboardDispatcher();
+
+    // Delete copy constructor and assignment
+    ClipboardDispatcher(const ClipboardDispatcher&) = delete;
+    ClipboardDispatcher& operator=(const ClipboardDispatcher&) = delete;
+
+    void start();
+
+    // Content still pending is discarded; a running callback completes
+    void stop();
+
+    // Called on the capture thread; returns false for recent duplicates.
+    // Never waits for the callback.
+    bool submit(std::string content);
+
+    // Blocks until nothing is pending or running
+    void wait_idle();
+
+    Stats stats() const;
+
+private:
+    struct SeenEntry {
+        uint64_t hash;
+        std::chrono::steady_clock::time_point seen;
+    };
+
+    struct PendingContent {
+        uint64_t hash;
+        std::string text;
+    };
+
+    ClipboardEventCallback callback_;
+    Options options_;
+
+    // Most recently seen first
+    std::list<SeenEntry> seen_;
+    std::unordered_map<uint64_t, std::list<SeenEntry>::iterator> seen_index_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<PendingContent> pending_;
+    bool running_ = false;
+    bool busy_ = false;
+    std::thread worker_;
+    Stats stats_;
+
+    // Called with the mutex held
+    bool is_recent_duplicate(uint64_t hash, std::chrono::steady_clock::time_point now);
+    void forget(uint64_t hash);
+
+    void worker_loop();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_CLIPBOARD_DISPATCHER_H
@@ -5,22 +5,29 @@
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <cstddef>
 #include <windows.h>
+#include "clipboard_dispatcher.h"
 
 namespace cybersentinel {
 
-using ClipboardEventCallback = std::function<void(const std::string& content)>;
-
 class ClipboardMonitor {
 public:
-    explicit ClipboardMonitor(ClipboardEventCallback callback);
+    // The callback runs on a worker thread, once per distinct content.
+    // max_capture_bytes caps the UTF-16 text read from the clipboard.
+    explicit ClipboardMonitor(ClipboardEventCallback callback,
+                              size_t max_capture_bytes = 1024 * 1024,
+                              const ClipboardDispatcher::Options& options = ClipboardDispatcher::Options());
     ~ClipboardMonitor();
 
     bool start();
     void stop();
 
+    ClipboardDispatcher::Stats stats() const { return dispatcher_.stats(); }
+
 private:
-    ClipboardEventCallback callback_;
+    ClipboardDispatcher dispatcher_;
+    size_t max_capture_units_;
     std::atomic<bool> running_{false};
     std::thread monitor_thread_;
     HWND hwnd_{nullptr};
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include "policy.h"
 
 namespace cybersentinel {
 
@@ -13,17 +14,80 @@ public:
 
     bool load();
 
+    // Checks values load() cannot reject on type alone; error names the
+    // first problem. A reload that fails it keeps the running configuration.
+    bool validate(std::string& error) const;
+
+    const std::string& get_config_file() const { return config_file_; }
+
     // Getters
     std::string get_server_url() const { return server_url_; }
     std::string get_agent_id() const { return agent_id_; }
     std::string get_agent_name() const { return agent_name_; }
     int get_heartbeat_interval() const { return heartbeat_interval_; }
+    int get_heartbeat_min_interval() const { return heartbeat_min_interval_; }
+    int get_heartbeat_max_interval() const { return heartbeat_max_interval_; }
 
     bool is_file_monitoring_enabled() const { return file_monitoring_enabled_; }
     bool is_clipboard_monitoring_enabled() const { return clipboard_monitoring_enabled_; }
     bool is_usb_monitoring_enabled() const { return usb_monitoring_enabled_; }
 
     std::vector<std::string> get_monitored_paths() const { return monitored_paths_; }
+    std::string get_file_state_index_path() const { return file_state_index_path_; }
+
+    bool is_http2_enabled() const { return http2_enabled_; }
+    std::string get_uplink_encoding() const { return uplink_encoding_; }
+    int get_retry_attempts() const { return retry_attempts_; }
+    int get_retry_base_ms() const { return retry_base_ms_; }
+    int get_breaker_failure_threshold() const { return breaker_failure_threshold_; }
+    int get_breaker_open_seconds() const { return breaker_open_seconds_; }
+
+    bool is_spool_enabled() const { return spool_enabled_; }
+    std::string get_spool_directory() const { return spool_directory_; }
+    int get_spool_max_size_mb() const { return spool_max_size_mb_; }
+    int get_spool_replay_rate() const { return spool_replay_rate_; }
+
+    bool is_baseline_scan_enabled() const { return baseline_enabled_; }
+    int get_baseline_threads() const { return baseline_threads_; }
+    double get_baseline_max_files_per_sec() const { return baseline_max_files_per_sec_; }
+    double get_baseline_max_mb_per_sec() const { return baseline_max_mb_per_sec_; }
+    std::string get_baseline_checkpoint_file() const { return baseline_checkpoint_file_; }
+
+    double get_io_max_mb_per_sec() const { return io_max_mb_per_sec_; }
+    double get_io_max_iops() const { return io_max_iops_; }
+    double get_io_burst_seconds() const { return io_burst_seconds_; }
+    double get_io_idle_multiplier() const { return io_idle_multiplier_; }
+    double get_io_idle_cpu_percent() const { return io_idle_cpu_percent_; }
+
+    int get_clipboard_max_capture_kb() const { return clipboard_max_capture_kb_; }
+    int get_clipboard_dedup_entries() const { return clipboard_dedup_entries_; }
+    int get_clipboard_dedup_window_seconds() const { return clipboard_dedup_window_seconds_; }
+
+    bool is_removable_watch_enabled() const { return removable_watch_enabled_; }
+    bool is_removable_scan_enabled() const { return removable_scan_enabled_; }
+    int get_removable_scan_threads() const { return removable_scan_threads_; }
+    double get_removable_scan_max_files_per_sec() const { return removable_scan_max_files_per_sec_; }
+    double get_removable_scan_max_mb_per_sec() const { return removable_scan_max_mb_per_sec_; }
+
+    int get_log_max_file_mb() const { return log_max_file_mb_; }
+    int get_log_max_age_hours() const { return log_max_age_hours_; }
+    int get_log_max_files() const { return log_max_files_; }
+    bool is_log_compression_enabled() const { return log_compress_; }
+
+    // Severity and action rules, in evaluation order
+    std::vector<PolicyRule> get_policy_rules() const { return policy_rules_; }
+
+    bool is_config_reload_enabled() const { return config_reload_enabled_; }
+    int get_config_reload_poll_seconds() const { return config_reload_poll_seconds_; }
+
+    bool is_metrics_enabled() const { return metrics_enabled_; }
+    std::string get_metrics_path() const { return metrics_path_; }
+    std::string get_metrics_format() const { return metrics_format_; }  // "prometheus" or "json"
+    int get_metrics_interval_seconds() const { return metrics_interval_seconds_; }
+
+    bool is_event_trace_enabled() const { return trace_enabled_; }
+    std::string get_event_trace_directory() const { return trace_directory_; }
+    bool is_event_trace_content_enabled() const { return trace_record_content_; }
 
 private:
     std::string config_file_;
@@ -33,12 +97,68 @@ private:
     std::string agent_id_;
     std::string agent_name_;
     int heartbeat_interval_;
+    int heartbeat_min_interval_;
+    int heartbeat_max_interval_;
 
     bool file_monitoring_enabled_;
     bool clipboard_monitoring_enabled_;
     bool usb_monitoring_enabled_;
 
     std::vector<std::string> monitored_paths_;
+    std::string file_state_index_path_;
+
+    bool http2_enabled_;
+    std::string uplink_encoding_;
+    int retry_attempts_;
+    int retry_base_ms_;
+    int breaker_failure_threshold_;
+    int breaker_open_seconds_;
+
+    bool spool_enabled_;
+    std::string spool_directory_;
+    int spool_max_size_mb_;
+    int spool_replay_rate_;
+
+    bool baseline_enabled_;
+    int baseline_threads_;
+    double baseline_max_files_per_sec_;
+    double baseline_max_mb_per_sec_;
+    std::string baseline_checkpoint_file_;
+
+    double io_max_mb_per_sec_;
+    double io_max_iops_;
+    double io_burst_seconds_;
+    double io_idle_multiplier_;
+    double io_idle_cpu_percent_;
+
+    int clipboard_max_capture_kb_;
+    int clipboard_dedup_entries_;
+    int clipboard_dedup_window_seconds_;
+
+    bool removable_watch_enabled_;
+    bool removable_scan_enabled_;
+    int removable_scan_threads_;
+    double removable_scan_max_files_per_sec_;
+    double removable_scan_max_mb_per_sec_;
+
+    int log_max_file_mb_;
+    int log_max_age_hours_;
+    int log_max_files_;
+    bool log_compress_;
+
+    std::vector<PolicyRule> policy_rules_;
+
+    bool config_reload_enabled_;
+    int config_reload_poll_seconds_;
+
+    bool metrics_enabled_;
+    std::string metrics_path_;
+    std::string metrics_format_;
+    int metrics_interval_seconds_;
+
+    bool trace_enabled_;
+    std::string trace_directory_;
+    bool trace_record_content_;
 };
 
 } // namespace cybersentinel
@@ -0,0 +1,51 @@
+#ifndef CYBERSENTINEL_CONFIG_STORE_H
+#define CYBERSENTINEL_CONFIG_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "config.h"
+
+namespace cybersentinel {
+
+// The agent's configuration as immutable snapshots. A reload builds a new
+// Config off to the side and publishes it with one atomic pointer store;
+// readers take the current snapshot with one acquire load and never block
+// or see a half-applied change.
+//
+// Snapshots that were replaced stay allocated until the store is destroyed,
+// so a reader may keep the reference it loaded for as long as it likes
+// without registering anywhere. Reloads follow edits to the config file, so
+// the few kilobytes each retains are not worth a reclamation scheme.
+class ConfigStore {
+public:
+    ConfigStore() = default;
+
+    ConfigStore(const ConfigStore&) = delete;
+    ConfigStore& operator=(const ConfigStore&) = delete;
+
+    // nullptr until the first publish
+    const Config* current() const { return current_.load(std::memory_order_acquire); }
+
+    // Incremented by every publish; readers that cache derived values
+    // compare it to notice a reload
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    // Makes config the current snapshot and returns the one it replaced
+    // (nullptr for the first)
+    const Config* publish(std::unique_ptr<Config> config);
+
+private:
+    std::atomic<const Config*> current_{nullptr};
+    std::atomic<uint64_t> version_{0};
+
+    // Writers only
+    std::mutex publish_mutex_;
+    std::vector<std::unique_ptr<Config>> snapshots_;
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_CONFIG_STORE_H
@@ -0,0 +1,71 @@
+#ifndef CYBERSENTINEL_CONFIG_WATCHER_H
+#define CYBERSENTINEL_CONFIG_WATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "config_store.h"
+
+namespace cybersentinel {
+
+// Reloads the configuration file when it changes. A background thread
+// compares the file's modification time and size every poll_seconds (of the
+// current snapshot); a changed file is parsed and validated into a new
+// Config, which is published to the store and handed to on_change together
+// with the one it replaced. A file that fails to parse or validate is
+// logged and the running configuration stays in effect.
+//
+// Polling rather than a directory watch: editors and deployment tools often
+// replace the file instead of writing it, and a few stat calls a minute are
+// free.
+class ConfigWatcher {
+public:
+    // Called on the watcher's thread, one reload at a time
+    using ChangeHandler = std::function<void(const Config& previous, const Config& current)>;
+
+    // store must hold the configuration loaded at startup
+    ConfigWatcher(ConfigStore& store, ChangeHandler on_change);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    void start();
+    void stop();
+
+    // Reloads now if the file changed since the last check; true when a new
+    // snapshot was published
+    bool check();
+
+    uint64_t reloads() const { return reloads_; }
+    uint64_t rejected() const { return rejected_; }
+
+private:
+    ConfigStore& store_;
+    ChangeHandler on_change_;
+    std::string path_;
+
+    // The file as last read, by check() only
+    std::filesystem::file_time_type last_write_{};
+    uintmax_t last_size_{0};
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+
+    std::atomic<uint64_t> reloads_{0};
+    std::atomic<uint64_t> rejected_{0};
+
+    bool read_stamp(std::filesystem::file_time_type& write_time, uintmax_t& size) const;
+    void run();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_CONFIG_WATCHER_H
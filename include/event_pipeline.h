@@ -0,0 +1,91 @@
+#ifndef CYBERSENTINEL_EVENT_PIPELINE_H
+#define CYBERSENTINEL_EVENT_PIPELINE_H
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "classifier.h"
+#include "event_reporter.h"
+#include "file_state_index.h"
+#include "policy.h"
+
+namespace cybersentinel {
+
+// What happens to a monitored event after a monitor (or a trace replay)
+// produced it: the file-state index check, classification and reporting.
+// Kept free of platform APIs so the same code can be driven on Linux.
+class EventPipeline {
+public:
+    enum class Stage {
+        INDEX,     // stat and file-state index lookup
+        CLASSIFY,  // content read and pattern matching
+        REPORT     // encoding and delivery to the server, or the spool
+    };
+
+    // Called on the event's thread after each stage that ran
+    using StageObserver = std::function<void(Stage stage, std::chrono::nanoseconds elapsed)>;
+
+    EventPipeline(EventReporter& reporter, FileStateIndex& file_index);
+
+    // Delete copy constructor and assignment
+    EventPipeline(const EventPipeline&) = delete;
+    EventPipeline& operator=(const EventPipeline&) = delete;
+
+    // Set before events flow; not synchronised with the handlers
+    void set_stage_observer(StageObserver observer) { observer_ = std::move(observer); }
+
+    // Decides severity and whether a classified event is reported. May be
+    // replaced while events flow: handlers pick up the new rules with their
+    // next event, and one that is mid-evaluation finishes with the old ones,
+    // which stay allocated until the pipeline is destroyed. Without a policy
+    // the built-in severities apply.
+    void set_policy(std::unique_ptr<Policy> policy);
+
+    // Version of the classifier rules and the policy together, stored with
+    // each file-state index entry. Entries under another version are not
+    // skipped as unchanged, so after a policy change a crawl restarted with
+    // the new version decides every file again.
+    uint32_t rules_version() const { return rules_version_.load(std::memory_order_acquire); }
+
+    // volume: set for files on a removable volume. Files written there are
+    // read ahead of the I/O budget and anything sensitive is reported as
+    // critical, since that is how data leaves on a USB drive.
+    void handle_file_event(const std::string& file_path, const std::string& event_type,
+                           const VolumeInfo* volume = nullptr);
+    void handle_clipboard_event(const std::string& content);
+    void handle_usb_event(const VolumeInfo& volume);
+    void handle_usb_removal(const VolumeInfo& volume);
+
+    uint64_t files_scanned() const { return files_scanned_; }
+    uint64_t events_ignored() const { return events_ignored_; }
+
+private:
+    EventReporter& reporter_;
+    FileStateIndex& file_index_;
+    StageObserver observer_;
+    // Shared by every handler thread. Its patterns are fixed at build time
+    // (Classifier::kRulesVersion) and policies do not change them, so it is
+    // compiled once rather than per event.
+    const Classifier classifier_;
+    std::atomic<uint64_t> files_scanned_{0};
+    std::atomic<uint64_t> events_ignored_{0};
+
+    std::atomic<const Policy*> policy_{nullptr};
+    std::atomic<uint32_t> rules_version_;
+    std::mutex policy_mutex_;
+    std::vector<std::unique_ptr<Policy>> policies_;
+
+    void finish_stage(Stage stage, std::chrono::steady_clock::time_point& start);
+    PolicyDecision decide(const PolicyInput& input);
+};
+
+const char* stage_name(EventPipeline::Stage stage);
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_EVENT_PIPELINE_H
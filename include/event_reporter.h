@@ -0,0 +1,149 @@
+#ifndef CYBERSENTINEL_EVENT_REPORTER_H
+#define CYBERSENTINEL_EVENT_REPORTER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+#include "http_client.h"
+#include "event_spool.h"
+#include "events.h"
+
+namespace cybersentinel {
+
+enum class DeliveryResult {
+    DELIVERED,
+    QUEUED,     // posted in the background; stats() counts the outcome
+    SPOOLED,    // kept locally for later delivery
+    DROPPED
+};
+
+// The agent's reporting stack: encodes events in the negotiated wire format,
+// posts them to /events, spools what the server cannot take and replays the
+// spool in the background. Independent of the OS monitors so it can be driven
+// directly (see tools/uplink_loadtest.cpp).
+//
+// report() never waits on the network. Live events go to an in-memory queue
+// posted by the HTTP client's I/O thread, at most send_window at a time
+// (one by default, so the server receives them in order); the completion
+// callback counts the result and moves a retryable failure, with everything
+// queued behind it, to the spool.
+class EventReporter {
+public:
+    struct Stats {
+        uint64_t events_reported = 0;  // accepted by the server, including replays
+        uint64_t events_spooled = 0;
+        uint64_t events_dropped = 0;
+    };
+
+    EventReporter(HttpClient& http_client, const std::string& agent_id, EventSpool* spool = nullptr);
+    ~EventReporter();
+
+    // Delete copy constructor and assignment
+    EventReporter(const EventReporter&) = delete;
+    EventReporter& operator=(const EventReporter&) = delete;
+
+    // While paused (e.g. before registration succeeds) events are kept in the
+    // spool, or in a bounded in-memory buffer when there is no spool, and
+    // replay waits. Resuming flushes the in-memory buffer; events reported
+    // meanwhile stay paused and queue behind it.
+    void pause_delivery();
+    void resume_delivery();
+    bool is_paused() const { return paused_; }
+
+    void set_wire_format(WireFormat format) { wire_format_ = format; }
+    WireFormat get_wire_format() const { return wire_format_; }
+
+    DeliveryResult report(const std::string& event_type,
+                          const std::string& severity,
+                          const std::string& file_path = "",
+                          const ClassificationResult* classification = nullptr,
+                          const VolumeInfo* volume = nullptr);
+
+    // Live event posts in flight at once; above 1 the server may receive
+    // events slightly out of order
+    void set_send_window(size_t window);
+
+    // Waits up to timeout for queued live events to be answered. Events
+    // still queued then are spooled (dropped without a spool); returns once
+    // the posts in flight are answered, true if nothing had to be moved.
+    bool drain(std::chrono::milliseconds timeout);
+
+    // Heartbeats share the negotiated wire format; returns true on HTTP 200
+    bool send_heartbeat(std::string_view status, const AgentHealth* health = nullptr);
+
+    Stats stats() const;
+
+    // Time of the last request the server accepted; proves liveness
+    std::chrono::steady_clock::time_point last_contact() const;
+
+    // Background replay of spooled events, in windows of concurrent posts
+    // as fast as the server accepts them; paced to rate_per_second only
+    // while other requests are queued for a connection slot
+    void start_replay(int rate_per_second);
+    void stop_replay();
+
+private:
+    HttpClient& http_client_;
+    std::string agent_id_;
+    EventSpool* spool_;
+
+    // Encoding negotiated with the server at registration
+    std::atomic<WireFormat> wire_format_{WireFormat::JSON};
+
+    std::atomic<uint64_t> events_reported_{0};
+    std::atomic<uint64_t> events_spooled_{0};
+    std::atomic<uint64_t> events_dropped_{0};
+    std::atomic<std::chrono::steady_clock::rep> last_contact_{0};
+    std::atomic<uint64_t> next_event_sequence_{0};
+
+    std::atomic<bool> paused_{false};
+
+    // Events held in memory while paused and no spool is available
+    struct HeldEvent {
+        std::string payload;
+        WireFormat format;
+        std::string event_type;
+    };
+    std::deque<HeldEvent> held_;
+    std::mutex held_mutex_;
+
+    // Live events waiting for a send slot, and posts in flight
+    struct OutgoingEvent {
+        std::string payload;
+        WireFormat format;
+        std::string event_type;
+    };
+    std::deque<OutgoingEvent> outbox_;
+    size_t sending_ = 0;
+    size_t send_window_ = 1;
+    std::mutex outbox_mutex_;
+    std::condition_variable outbox_cv_;
+
+    std::atomic<bool> replaying_{false};
+    std::thread replay_thread_;
+
+    DeliveryResult hold(const std::string& payload, WireFormat format,
+                        const std::string& event_type);
+    DeliveryResult deliver(const std::string& payload, WireFormat format,
+                           const std::string& event_type);
+    // deliver() without the pause check
+    DeliveryResult send(const std::string& payload, WireFormat format,
+                        const std::string& event_type);
+    void pump_outbox();
+    void finish_send(const OutgoingEvent& event, const HttpResponse& response);
+    // Called with outbox_mutex_ held
+    void spool_outbox();
+    void mark_contact();
+    void replay_loop(int rate_per_second);
+    void sleep_while_replaying(std::chrono::milliseconds duration);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_EVENT_REPORTER_H
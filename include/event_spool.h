@@ -0,0 +1,112 @@
+#ifndef CYBERSENTINEL_EVENT_SPOOL_H
+#define CYBERSENTINEL_EVENT_SPOOL_H
+
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <mutex>
+#include <chrono>
+#include <vector>
+
+namespace cybersentinel {
+
+enum class SpoolRecordType : uint16_t {
+    EVENT_JSON = 1,
+    EVENT_CBOR = 2
+};
+
+struct SpoolRecord {
+    SpoolRecordType type;
+    std::string payload;
+
+    SpoolRecord() : type(SpoolRecordType::EVENT_JSON) {}
+};
+
+// Append-only, segment-based write-ahead spool for events that could not be
+// delivered. Records are checksummed so a torn write at the tail (crash or
+// power loss mid-append) is detected and truncated on open; a failed append
+// cuts the segment back to its last whole record. A record that fails its
+// checksum is skipped, and a segment whose framing is lost is renamed to
+// *.bad, so damage never stops the reader. Delivery is at-least-once:
+// records acknowledged after the last cursor sync may be replayed again
+// after a crash.
+class EventSpool {
+public:
+    EventSpool(const std::string& directory, uint64_t max_bytes);
+    ~EventSpool();
+
+    // Delete copy constructor and assignment
+    EventSpool(const EventSpool&) = delete;
+    EventSpool& operator=(const EventSpool&) = delete;
+
+    // Recover existing segments and open the active segment for appending
+    bool open();
+    void close();
+
+    // Writer side
+    bool append(const std::string& payload,
+                SpoolRecordType type = SpoolRecordType::EVENT_JSON);
+    void sync();
+
+    // Reader side: peek at the oldest record, pop once it has been delivered
+    bool peek(SpoolRecord& record);
+
+    // Peeks at up to max_records consecutive records (fewer at a segment
+    // boundary) into records, which is grown as needed; returns the count
+    size_t peek(std::vector<SpoolRecord>& records, size_t max_records);
+
+    // Removes the first count of the records returned by the last peek
+    void pop(size_t count = 1);
+
+    bool empty();
+    uint64_t size_bytes();
+    uint64_t evicted_bytes();
+
+    // Records skipped as corrupt since open; a segment set aside counts once
+    uint64_t corrupt_records();
+
+private:
+    std::string directory_;
+    uint64_t max_bytes_;
+    uint64_t segment_bytes_;
+
+    std::mutex mutex_;
+    bool open_{false};
+
+    // Active (write) segment
+    uint64_t write_seq_{0};
+    std::FILE* write_file_{nullptr};
+    uint64_t write_offset_{0};
+    size_t unsynced_records_{0};
+    std::chrono::steady_clock::time_point last_sync_;
+
+    // Read cursor
+    uint64_t read_seq_{0};
+    uint64_t read_offset_{0};
+    std::FILE* read_file_{nullptr};
+    std::vector<uint64_t> peeked_sizes_;
+    size_t unsynced_pops_{0};
+
+    uint64_t total_bytes_{0};
+    uint64_t evicted_bytes_{0};
+    uint64_t corrupt_records_{0};
+
+    std::string segment_path(uint64_t seq) const;
+    std::string cursor_path() const;
+
+    uint64_t recover_segment(uint64_t seq);
+    bool open_write_segment(uint64_t seq);
+    void roll_segment();
+    void repair_write_segment();
+    bool read_next(SpoolRecord& record, uint64_t& record_size);
+    void quarantine_read_segment();
+    void evict_oldest();
+    bool advance_read_segment();
+    void save_cursor();
+    void load_cursor();
+    void sync_locked();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_EVENT_SPOOL_H
@@ -0,0 +1,100 @@
+#ifndef CYBERSENTINEL_EVENT_TRACE_H
+#define CYBERSENTINEL_EVENT_TRACE_H
+
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Event traces record the raw events the monitors produce, with timestamps,
+// so a workload seen on an endpoint can be replayed against the pipeline
+// later (tools/trace_replay.cpp). A trace is a directory:
+//
+//   events     "cybersentinel-trace 1 content|hashes", then one line per event:
+//              <offset_us> <source> <action> <hash> <size> <c|-> <subject>
+//   content/   one file per distinct content, named by its hash
+//
+// The subject (file path or device name) runs to the end of the line, with
+// '%', CR and LF percent-encoded. Content is the file or clipboard text the
+// event referred to, capped like classifier reads, and the hash is its
+// FNV-1a hash. "hashes" traces keep no content, so the trace holds no
+// sensitive data, and do not read files at all: a file's hash there is
+// taken over its path, size and mtime instead.
+
+enum class TraceSource {
+    FILE,
+    CLIPBOARD,
+    USB
+};
+
+struct TraceEvent {
+    uint64_t offset_us = 0;    // since the recording started
+    TraceSource source = TraceSource::FILE;
+    std::string action;        // file event type; "-" for other sources
+    std::string subject;       // file path or removable volume root
+    uint64_t content_hash = 0;
+    uint64_t content_size = 0;
+    bool has_content = false;  // content is stored in the trace
+};
+
+class TraceWriter {
+public:
+    TraceWriter() = default;
+    ~TraceWriter();
+
+    // Delete copy constructor and assignment
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // Creates the directory; an existing trace in it is replaced
+    bool open(const std::string& directory, bool record_content);
+    void close();
+    bool is_open() const { return events_.is_open(); }
+
+    // Safe to call from the monitor threads concurrently
+    void record_file(const std::string& file_path, const std::string& event_type);
+    void record_clipboard(const std::string& content);
+    // action is "connected" or "removed"
+    void record_usb(const std::string& volume_root, const std::string& action);
+
+    uint64_t events_recorded() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::ofstream events_;
+    std::string directory_;
+    bool record_content_ = true;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t count_ = 0;
+
+    // Called with the mutex held
+    void write_event(TraceEvent& event, const std::string* content);
+    void store_content(uint64_t hash, const std::string& content);
+};
+
+class TraceReader {
+public:
+    bool open(const std::string& directory);
+
+    // False at the end of the trace; malformed lines are skipped
+    bool next(TraceEvent& event);
+
+    bool has_content() const { return has_content_; }
+
+    // Content recorded for the event; false when only its hash was kept
+    bool load_content(const TraceEvent& event, std::string& content) const;
+
+private:
+    std::ifstream events_;
+    std::string directory_;
+    bool has_content_ = false;
+};
+
+const char* trace_source_name(TraceSource source);
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_EVENT_TRACE_H
@@ -0,0 +1,227 @@
+#ifndef CYBERSENTINEL_EVENTS_H
+#define CYBERSENTINEL_EVENTS_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include "classifier.h"
+#include "json_writer.h"
+#include "cbor_writer.h"
+
+namespace cybersentinel {
+
+// Wire formats for the agent-to-server uplink. JSON is the default; CBOR is
+// only used once the server has accepted it during registration.
+enum class WireFormat {
+    JSON,
+    CBOR
+};
+
+inline const char* content_type(WireFormat format) {
+    return format == WireFormat::CBOR ? "application/cbor" : "application/json";
+}
+
+// Typed records for everything the agent sends to the server. Fields are
+// views into strings owned by the caller; records only live long enough to
+// be encoded.
+
+struct AgentCapabilities {
+    bool file_monitoring = false;
+    bool clipboard_monitoring = false;
+    bool usb_monitoring = false;
+};
+
+struct AgentRegistration {
+    std::string_view agent_id;
+    std::string_view agent_name;
+    std::string_view hostname;
+    std::string_view os_type;
+    std::string_view os_version;
+    std::string_view ip_address;
+    std::string_view agent_version;
+    AgentCapabilities capabilities;
+    bool offer_cbor = false;  // advertise CBOR in supported_encodings
+};
+
+// Health summary carried by heartbeats. Counters are cumulative since agent
+// start so the server can derive rates from consecutive heartbeats.
+struct AgentHealth {
+    uint64_t events_reported = 0;
+    uint64_t events_spooled = 0;
+    uint64_t events_dropped = 0;
+    uint64_t spool_bytes = 0;
+    uint64_t spool_evicted_bytes = 0;
+    uint64_t uplink_queue = 0;       // requests waiting for a connection
+    uint64_t files_scanned = 0;
+    double scan_rate = 0.0;          // files/sec since the previous heartbeat
+    int open_circuits = 0;
+    uint64_t watcher_overflows = 0;  // change notifications lost by the OS
+    uint64_t rescans = 0;
+    uint64_t rescan_files_examined = 0;
+    uint64_t rescan_files_changed = 0;
+    uint64_t rescan_ms = 0;
+    uint64_t io_throttled_reads = 0;  // classifier reads delayed by the I/O governor
+    uint64_t io_throttle_ms = 0;
+    uint64_t removable_volumes = 0;   // removable volumes being watched
+};
+
+struct Heartbeat {
+    std::string_view agent_id;
+    std::string_view status;
+    const AgentHealth* health = nullptr;  // omitted when null
+};
+
+// Identity of a removable volume, attached to events that concern it
+struct VolumeInfo {
+    std::string root;         // mount point, e.g. "E:\\"
+    std::string label;
+    std::string serial;       // volume serial number, hex
+    std::string file_system;  // "FAT32", "exFAT", "NTFS"
+    std::string bus;          // "usb", or "removable" when the bus is unknown
+    uint64_t total_bytes = 0;
+};
+
+struct DlpEvent {
+    std::string_view event_id;
+    std::string_view event_type;
+    std::string_view severity;
+    std::string_view agent_id;
+    std::string_view source_type = "endpoint";
+    std::string_view file_path;                          // omitted when empty
+    const ClassificationResult* classification = nullptr;  // omitted when null
+    const VolumeInfo* volume = nullptr;                    // omitted when null
+};
+
+// Encoders are templates over the writer so every wire format shares one
+// field layout. Writer must provide begin/end_object, begin/end_array, key
+// and value overloads (see JsonWriter).
+
+template <typename Writer>
+void encode(Writer& w, const ClassificationResult& classification) {
+    w.begin_object();
+    w.key("labels");
+    w.begin_array();
+    for (const auto& label : classification.labels) {
+        w.value(std::string_view(label));
+    }
+    w.end_array();
+    w.key("confidence");
+    w.value(classification.confidence);
+    w.end_object();
+}
+
+template <typename Writer>
+void encode(Writer& w, const VolumeInfo& volume) {
+    w.begin_object();
+    w.key("root");        w.value(std::string_view(volume.root));
+    w.key("label");       w.value(std::string_view(volume.label));
+    w.key("serial");      w.value(std::string_view(volume.serial));
+    w.key("file_system"); w.value(std::string_view(volume.file_system));
+    w.key("bus");         w.value(std::string_view(volume.bus));
+    w.key("total_bytes"); w.value(volume.total_bytes);
+    w.end_object();
+}
+
+template <typename Writer>
+void encode(Writer& w, const AgentRegistration& registration) {
+    w.begin_object();
+    w.key("agent_id");      w.value(registration.agent_id);
+    w.key("agent_name");    w.value(registration.agent_name);
+    w.key("hostname");      w.value(registration.hostname);
+    w.key("os_type");       w.value(registration.os_type);
+    w.key("os_version");    w.value(registration.os_version);
+    w.key("ip_address");    w.value(registration.ip_address);
+    w.key("agent_version"); w.value(registration.agent_version);
+    w.key("capabilities");
+    w.begin_object();
+    w.key("file_monitoring");      w.value(registration.capabilities.file_monitoring);
+    w.key("clipboard_monitoring"); w.value(registration.capabilities.clipboard_monitoring);
+    w.key("usb_monitoring");       w.value(registration.capabilities.usb_monitoring);
+    w.end_object();
+    if (registration.offer_cbor) {
+        w.key("supported_encodings");
+        w.begin_array();
+        w.value("cbor");
+        w.value("json");
+        w.end_array();
+    }
+    w.end_object();
+}
+
+template <typename Writer>
+void encode(Writer& w, const AgentHealth& health) {
+    w.begin_object();
+    w.key("events_reported");       w.value(health.events_reported);
+    w.key("events_spooled");        w.value(health.events_spooled);
+    w.key("events_dropped");        w.value(health.events_dropped);
+    w.key("spool_bytes");           w.value(health.spool_bytes);
+    w.key("spool_evicted_bytes");   w.value(health.spool_evicted_bytes);
+    w.key("uplink_queue");          w.value(health.uplink_queue);
+    w.key("files_scanned");         w.value(health.files_scanned);
+    w.key("scan_rate");             w.value(health.scan_rate);
+    w.key("open_circuits");         w.value(health.open_circuits);
+    w.key("watcher_overflows");     w.value(health.watcher_overflows);
+    w.key("rescans");               w.value(health.rescans);
+    w.key("rescan_files_examined"); w.value(health.rescan_files_examined);
+    w.key("rescan_files_changed");  w.value(health.rescan_files_changed);
+    w.key("rescan_ms");             w.value(health.rescan_ms);
+    w.key("io_throttled_reads");    w.value(health.io_throttled_reads);
+    w.key("io_throttle_ms");        w.value(health.io_throttle_ms);
+    w.key("removable_volumes");     w.value(health.removable_volumes);
+    w.end_object();
+}
+
+template <typename Writer>
+void encode(Writer& w, const Heartbeat& heartbeat) {
+    w.begin_object();
+    w.key("agent_id"); w.value(heartbeat.agent_id);
+    w.key("status");   w.value(heartbeat.status);
+    if (heartbeat.health) {
+        w.key("health");
+        encode(w, *heartbeat.health);
+    }
+    w.end_object();
+}
+
+template <typename Writer>
+void encode(Writer& w, const DlpEvent& event) {
+    w.begin_object();
+    w.key("event_id");    w.value(event.event_id);
+    w.key("event_type");  w.value(event.event_type);
+    w.key("severity");    w.value(event.severity);
+    w.key("agent_id");    w.value(event.agent_id);
+    w.key("source_type"); w.value(event.source_type);
+    if (!event.file_path.empty()) {
+        w.key("file_path");
+        w.value(event.file_path);
+    }
+    if (event.classification) {
+        w.key("classification");
+        encode(w, *event.classification);
+    }
+    if (event.volume) {
+        w.key("volume");
+        encode(w, *event.volume);
+    }
+    w.end_object();
+}
+
+// Encodes a record into the calling thread's reusable buffer for the format
+template <typename Record>
+std::string& encode_payload(WireFormat format, const Record& record) {
+    if (format == WireFormat::CBOR) {
+        std::string& out = CborWriter::thread_buffer();
+        CborWriter writer(out);
+        encode(writer, record);
+        return out;
+    }
+
+    std::string& out = JsonWriter::thread_buffer();
+    JsonWriter writer(out);
+    encode(writer, record);
+    return out;
+}
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_EVENTS_H
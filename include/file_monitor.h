@@ -3,10 +3,16 @@
 
 #include <string>
 #include <vector>
+#include <set>
+#include <memory>
 #include <functional>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <atomic>
-#include <windows.h>
+#include <cstdint>
+#include "watcher_backend.h"
+#include "file_state_index.h"
 
 namespace cybersentinel {
 
@@ -14,21 +20,73 @@ using FileEventCallback = std::function<void(const std::string& file_path, const
 
 class FileMonitor {
 public:
-    explicit FileMonitor(const std::vector<std::string>& paths, FileEventCallback callback);
+    // Overflow and rescan counters, for heartbeats
+    struct RescanStats {
+        uint64_t overflows = 0;
+        uint64_t rescans = 0;
+        uint64_t files_examined = 0;
+        uint64_t files_changed = 0;
+        uint64_t rescan_ms = 0;
+    };
+
+    // index: state of already-classified files, used to limit rescans after
+    // lost notifications to changed files. Without it a rescan reports every
+    // file. The caller keeps the index up to date as it classifies.
+    //
+    // callback runs on the backend thread for notifications and on the
+    // rescan thread after an overflow, but never on both at once.
+    explicit FileMonitor(const std::vector<std::string>& paths, FileEventCallback callback,
+                         FileStateIndex* index = nullptr);
     ~FileMonitor();
 
     bool start();
     void stop();
 
+    // Replaces the monitored paths. While running, watches on roots no
+    // longer listed are removed and new roots added without restarting the
+    // backend, so the other roots lose no notifications.
+    void update_paths(const std::vector<std::string>& paths);
+
+    // Per-root notification buffer; 0 keeps the backend default
+    void set_notify_buffer_size(size_t bytes) { notify_buffer_size_ = bytes; }
+
+    RescanStats rescan_stats();
+    uint64_t overflow_count() const { return overflows_; }
+    const std::string& backend_name() const { return backend_name_; }
+
+    // Expands environment variables (%USERNAME%) on Windows and a leading ~
+    // elsewhere
+    static std::string expand_path(const std::string& path);
+
 private:
+    // Serializes start, stop and update_paths
+    std::mutex control_mutex_;
     std::vector<std::string> monitored_paths_;
     FileEventCallback callback_;
+    FileStateIndex* index_;
+    size_t notify_buffer_size_{0};
     std::atomic<bool> running_{false};
-    std::vector<std::thread> monitor_threads_;
-    std::vector<HANDLE> dir_handles_;
+    std::unique_ptr<WatcherBackend> backend_;
+    std::string backend_name_;
+    std::atomic<uint64_t> overflows_{0};
+
+    // Full path of the event being delivered; reused on the backend thread
+    std::string event_path_;
+
+    // Held for each callback_ call, so the backend and rescan threads take
+    // turns; one call at a time, not the whole rescan
+    std::mutex callback_mutex_;
+
+    // Roots whose notifications were lost, rescanned by rescan_thread_
+    std::set<std::string> dirty_roots_;
+    std::mutex rescan_mutex_;
+    std::condition_variable rescan_cv_;
+    std::thread rescan_thread_;
+    RescanStats rescan_stats_;
 
-    void monitor_directory(const std::string& path);
-    std::string get_event_type(DWORD action);
+    void handle_overflow(const std::string& root);
+    void rescan_loop();
+    void rescan(const std::string& root);
 };
 
 } // namespace cybersentinel
@@ -0,0 +1,95 @@
+#ifndef CYBERSENTINEL_FILE_STATE_INDEX_H
+#define CYBERSENTINEL_FILE_STATE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace cybersentinel {
+
+// What a file looked like when it was last classified
+struct FileState {
+    uint64_t size = 0;
+    int64_t mtime = 0;          // ns since the epoch on POSIX, filesystem clock ticks on Windows
+    uint64_t file_id = 0;       // inode number; 0 where it is not available
+    uint64_t content_hash = 0;  // of the classified content, 0 = unknown
+    uint32_t labels = 0;        // Classifier::label_mask of the result
+    uint32_t rules_version = 0; // EventPipeline::rules_version() it was classified under
+
+    // Same file with the same metadata, so its content need not be read again
+    bool operator==(const FileState& other) const {
+        return size == other.size && mtime == other.mtime && file_id == other.file_id;
+    }
+    bool operator!=(const FileState& other) const { return !(*this == other); }
+};
+
+// Index of classified files keyed by full path. Lets the baseline crawl and a
+// rescan after lost notifications classify only files whose size, mtime or
+// identity changed.
+//
+// Once open() succeeds the index lives in a memory-mapped file, so it
+// survives restarts without being reloaded: a cleanly closed index is usable
+// as soon as it is mapped. The file holds a hash table of slots pointing
+// into a dense array of checksummed records, followed by a heap of path
+// names. Updates are written in place; after a crash the records are
+// verified and the hash table is rebuilt from the valid ones, so a torn
+// record costs a reclassification, never a wrong skip. Without open() the
+// same structure is kept in memory.
+class FileStateIndex {
+public:
+    FileStateIndex();
+    ~FileStateIndex();
+
+    // Delete copy constructor and assignment
+    FileStateIndex(const FileStateIndex&) = delete;
+    FileStateIndex& operator=(const FileStateIndex&) = delete;
+
+    // Map the index file, creating it if needed. Entries already in memory
+    // are discarded.
+    bool open(const std::string& path);
+
+    // Flush and unmap; the file is marked clean so the next open skips
+    // recovery
+    void close();
+
+    // Write dirty pages to disk
+    void sync();
+
+    bool lookup(const std::string& path, FileState& state) const;
+    void update(const std::string& path, const FileState& state);
+    void erase(const std::string& path);
+
+    // Indexed paths strictly below directory
+    std::vector<std::string> paths_under(const std::string& directory) const;
+
+    size_t size() const;
+
+    // Bytes of index storage (mapped file or memory)
+    size_t storage_bytes() const;
+
+    // Current size, mtime and file ID of a regular file; false if it is
+    // missing or not a regular file
+    static bool stat(const std::string& path, FileState& state);
+
+private:
+    // Mapped file or heap block holding the index
+    struct Region;
+
+    mutable std::mutex mutex_;
+    std::string path_;  // empty while the index is in memory
+    std::unique_ptr<Region> region_;
+
+    std::unique_ptr<Region> create_region(const std::string& path, uint32_t record_capacity,
+                                          uint64_t heap_capacity);
+    bool grow(size_t name_length);
+    void recover();
+    bool find(const std::string& path, uint64_t hash, size_t& slot) const;
+    void remove_slot(size_t slot);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_FILE_STATE_INDEX_H
@@ -0,0 +1,21 @@
+#ifndef CYBERSENTINEL_FNV_HASH_H
+#define CYBERSENTINEL_FNV_HASH_H
+
+#include <string_view>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// 64-bit FNV-1a. Not cryptographic: used for index keys and to tell whether
+// content changed, never to prove that it did not.
+inline uint64_t fnv1a_64(std::string_view data, uint64_t hash = 14695981039346656037ULL) {
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_FNV_HASH_H
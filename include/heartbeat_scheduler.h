@@ -0,0 +1,56 @@
+#ifndef CYBERSENTINEL_HEARTBEAT_SCHEDULER_H
+#define CYBERSENTINEL_HEARTBEAT_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Decides when a heartbeat is worth sending. Any successful uplink request
+// already proves the agent is alive, so while other traffic flows heartbeats
+// are stretched up to max_interval (they still carry the health summary).
+// Local trouble the server should hear about (events dropped, the spool
+// growing) tightens them to min_interval while heartbeats get through.
+// Failed heartbeats back off instead: the interval doubles with each one up
+// to max_interval, and the first success restores it, so an unhealthy
+// server is not pressed harder than the fixed schedule would.
+class HeartbeatScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    HeartbeatScheduler(std::chrono::seconds interval,
+                       std::chrono::seconds min_interval,
+                       std::chrono::seconds max_interval);
+
+    // New intervals from a configuration reload; the next heartbeat is
+    // scheduled from the last one sent
+    void set_intervals(std::chrono::seconds interval,
+                       std::chrono::seconds min_interval,
+                       std::chrono::seconds max_interval);
+
+    // last_contact: time of the most recent successful uplink request;
+    // degraded: local error conditions since the last heartbeat
+    bool due(Clock::time_point now, Clock::time_point last_contact, bool degraded);
+    void record_sent(Clock::time_point now, bool success);
+
+    uint64_t sent() const { return sent_; }
+    uint64_t skipped() const { return skipped_; }
+
+private:
+    std::chrono::seconds interval_;
+    std::chrono::seconds min_interval_;
+    std::chrono::seconds max_interval_;
+
+    bool has_sent_{false};
+    uint32_t failures_{0};  // consecutive failed heartbeats
+    Clock::time_point last_sent_;
+
+    // Heartbeats the fixed-interval schedule would have sent but were not
+    Clock::time_point last_skip_;
+    uint64_t sent_{0};
+    uint64_t skipped_{0};
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_HEARTBEAT_SCHEDULER_H
@@ -3,6 +3,21 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <future>
+#include <functional>
+#include <chrono>
+#include "circuit_breaker.h"
+
+typedef void CURL;
+typedef void CURLSH;
+typedef void CURLM;
+struct curl_slist;
 
 namespace cybersentinel {
 
@@ -15,30 +30,140 @@ struct HttpResponse {
         : status_code(code), body(response_body) {}
 };
 
+// Invoked on the client's I/O thread (or inline if the request is rejected);
+// must not block or issue synchronous requests
+using HttpCallback = std::function<void(const HttpResponse& response)>;
+
 class HttpClient {
 public:
     explicit HttpClient(const std::string& base_url);
     ~HttpClient();
 
-    // HTTP methods
+    // Delete copy constructor and assignment
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    // Asynchronous requests, driven by a single curl_multi I/O thread.
+    // timeout_ms bounds queueing plus transfer time; 0 uses the client timeout.
+    // An empty content_type sends the client's default Content-Type header.
+    std::future<HttpResponse> request_async(const std::string& method,
+                                            const std::string& endpoint,
+                                            const std::string& data = "",
+                                            int timeout_ms = 0,
+                                            const std::string& content_type = "");
+    void request_async(const std::string& method,
+                       const std::string& endpoint,
+                       const std::string& data,
+                       HttpCallback callback,
+                       int timeout_ms = 0,
+                       const std::string& content_type = "");
+
+    // Synchronous HTTP methods, thin wrappers over request_async
     HttpResponse get(const std::string& endpoint);
-    HttpResponse post(const std::string& endpoint, const std::string& data);
-    HttpResponse put(const std::string& endpoint, const std::string& data);
+    HttpResponse post(const std::string& endpoint, const std::string& data,
+                      const std::string& content_type = "");
+    HttpResponse put(const std::string& endpoint, const std::string& data,
+                     const std::string& content_type = "");
     HttpResponse del(const std::string& endpoint);
 
     // Configuration
     void set_timeout(int seconds);
     void set_header(const std::string& key, const std::string& value);
+    void set_http2(bool enabled);
+    void set_max_in_flight(size_t max_requests);
+
+    // Failed requests (transport errors, 429, 5xx) are retried with jittered
+    // exponential backoff while their deadline allows
+    void set_retry_policy(int max_attempts, int base_delay_ms, int max_delay_ms);
+
+    // Applies to breakers created after the call, one per endpoint
+    void set_circuit_breaker(int failure_threshold, int open_seconds, int max_open_seconds);
+
+    // Breaker state and transition counts per endpoint, for metrics
+    std::map<std::string, CircuitBreaker::Stats> circuit_stats();
+
+    // Requests waiting for an in-flight slot
+    size_t queued_requests();
 
 private:
+    struct Transfer {
+        std::string method;
+        std::string url;
+        std::string data;
+        std::string response_body;
+        std::shared_ptr<curl_slist> headers;
+        std::chrono::steady_clock::time_point deadline;
+        std::promise<HttpResponse> promise;
+        HttpCallback callback;
+        CURL* curl = nullptr;
+        std::shared_ptr<CircuitBreaker> breaker;
+        int attempt = 0;
+        std::chrono::steady_clock::time_point not_before;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
     std::string base_url_;
-    int timeout_;
+    std::atomic<int> timeout_;
+    std::atomic<bool> http2_;
+    std::atomic<size_t> max_in_flight_;
+
+    // Owned by the I/O thread
+    CURLM* multi_;
+    CURLSH* share_;
+    std::vector<CURL*> idle_handles_;
+    std::vector<std::unique_ptr<Transfer>> in_flight_;
+    std::vector<std::unique_ptr<Transfer>> retry_wait_;
+
+    // Retry policy
+    std::atomic<int> max_attempts_;
+    std::atomic<int> retry_base_ms_;
+    std::atomic<int> retry_max_ms_;
+
+    // Circuit breakers keyed by endpoint path (query string dropped). Closed
+    // breakers no transfer holds are pruned once there are kMaxBreakers.
+    static constexpr size_t kMaxBreakers = 64;
+    std::map<std::string, std::shared_ptr<CircuitBreaker>> breakers_;
+    std::mutex breakers_mutex_;
+    int breaker_threshold_;
+    int breaker_open_seconds_;
+    int breaker_max_open_seconds_;
+
+    // Requests waiting for an in-flight slot
+    std::deque<std::unique_ptr<Transfer>> pending_;
+    std::mutex pending_mutex_;
+
+    // Request headers; swapped as a whole so in-flight requests keep theirs
+    std::map<std::string, std::string> header_values_;
+    std::shared_ptr<curl_slist> headers_;
+    std::map<std::string, std::shared_ptr<curl_slist>> typed_headers_;
+    std::mutex headers_mutex_;
+
+    std::atomic<bool> running_{false};
+    std::thread io_thread_;
 
     HttpResponse perform_request(const std::string& method,
                                  const std::string& endpoint,
-                                 const std::string& data = "");
+                                 const std::string& data = "",
+                                 const std::string& content_type = "");
 
     std::string build_url(const std::string& endpoint);
+
+    void submit(std::unique_ptr<Transfer> transfer, int timeout_ms,
+                const std::string& content_type);
+    void io_loop();
+    void start_pending_transfers();
+    bool schedule_retry(std::unique_ptr<Transfer>& transfer, const HttpResponse& response,
+                        bool failed);
+    long poll_timeout_ms();
+    std::shared_ptr<CircuitBreaker> breaker_for(const std::string& endpoint);
+    bool start_transfer(Transfer* transfer);
+    void finish_transfer(CURL* curl, int result);
+    void complete(Transfer* transfer, const HttpResponse& response);
+
+    CURL* acquire_handle();
+    void release_handle(CURL* curl);
+    void rebuild_headers();
+    std::shared_ptr<curl_slist> headers_for(const std::string& content_type);
 };
 
 } // namespace cybersentinel
@@ -0,0 +1,62 @@
+#ifndef CYBERSENTINEL_IO_GOVERNOR_H
+#define CYBERSENTINEL_IO_GOVERNOR_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Process-wide budget for classifier file reads. A file is usually
+// classified right after it is saved, which is exactly when the application
+// that saved it is still busy with the disk; on spinning disks and VDI hosts
+// unthrottled reads show up as foreground stalls. Every read takes tokens
+// from a bytes/sec and a reads/sec bucket and waits when they run out.
+//
+// While the rest of the system is idle (CPU use by other processes below a
+// threshold) the caps are relaxed by a multiplier, so backlogs drain fast
+// when nobody is competing for the disk.
+class IoGovernor {
+public:
+    enum class Priority {
+        NORMAL,  // waits for budget
+        HIGH     // takes budget but only waits once it is a full burst in debt;
+                 // until then the next normal reads pay for it
+    };
+
+    struct Limits {
+        double max_bytes_per_sec = 0.0;  // 0 = unlimited
+        double max_iops = 0.0;           // 0 = unlimited
+        double burst_seconds = 1.0;      // bucket depth, in seconds of traffic
+        double idle_multiplier = 4.0;    // cap scale while idle; 0 lifts the caps
+        double idle_cpu_percent = 20.0;  // others' CPU use below this counts as idle
+    };
+
+    struct Stats {
+        uint64_t reads = 0;
+        uint64_t bytes = 0;
+        uint64_t throttled_reads = 0;
+        uint64_t throttle_wait_ms = 0;
+        uint64_t priority_reads = 0;
+        bool idle = false;
+    };
+
+    static void configure(const Limits& limits);
+
+    // Stop throttling and release waiting readers, e.g. at shutdown
+    static void disable();
+
+    // Wait until a read of `bytes` fits the budget; returns the time waited.
+    // Callers acquire per read call rather than per file, so a large file
+    // cannot take a whole burst at once.
+    static std::chrono::milliseconds acquire(uint64_t bytes, Priority priority = Priority::NORMAL);
+
+    static Stats stats();
+
+private:
+    static void sample_activity();
+    static void apply_rates();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_IO_GOVERNOR_H
@@ -0,0 +1,48 @@
+#ifndef CYBERSENTINEL_JSON_WRITER_H
+#define CYBERSENTINEL_JSON_WRITER_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace cybersentinel {
+
+// Streaming JSON writer that appends directly to a caller-owned buffer.
+// Strings are escaped per RFC 8259 and invalid UTF-8 is replaced with
+// U+FFFD, so arbitrary Windows paths always produce valid JSON.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out);
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+
+    void key(std::string_view name);
+
+    void value(std::string_view text);
+    void value(const char* text);
+    void value(bool flag);
+    void value(int number);
+    void value(int64_t number);
+    void value(uint64_t number);
+    void value(double number);
+    void null_value();
+
+    // Reusable per-thread buffer, cleared but keeping its capacity
+    static std::string& thread_buffer();
+
+private:
+    std::string& out_;
+    uint64_t need_comma_;  // one bit per nesting level
+    int depth_;
+    bool after_key_;
+
+    void separator();
+    void write_string(std::string_view text);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_JSON_WRITER_H
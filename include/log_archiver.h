@@ -0,0 +1,77 @@
+#ifndef CYBERSENTINEL_LOG_ARCHIVER_H
+#define CYBERSENTINEL_LOG_ARCHIVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace cybersentinel {
+
+// Background side of log rotation: gzips rotated segments of a log file and
+// deletes the oldest beyond the retention count. Runs on its own low-priority
+// thread, started with the first job, so the log writer only renames files.
+// Reports problems through Logger, never while holding its own lock.
+class LogArchiver {
+public:
+    struct Stats {
+        uint64_t archived = 0;
+        uint64_t removed = 0;
+    };
+
+    LogArchiver() = default;
+    ~LogArchiver();
+
+    LogArchiver(const LogArchiver&) = delete;
+    LogArchiver& operator=(const LogArchiver&) = delete;
+
+    void configure(const std::string& log_path, int max_files, bool compress);
+
+    // Unused name for a segment rotated out of log_path now: next to it, as
+    // <stem>.<yyyymmdd-hhmmss>-<n><ext>, so names sort by age
+    static std::string next_segment_path(const std::string& log_path);
+
+    // A segment of log_path, or an empty string for a scan of the directory
+    // that picks up segments an earlier run left uncompressed. However fast
+    // segments arrive, at most max_files wait: with the max_files kept and
+    // the one in hand, the directory never holds more than 2 * max_files + 2
+    // segments besides the live log.
+    void submit(const std::string& segment);
+
+    // Returns once every submitted segment is handled, then stops the thread
+    void finish();
+
+    // Stops after the segment in hand; the rest are compressed by the next
+    // run's scan
+    void stop();
+
+    Stats stats() const;
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::string> queue_;
+    bool stopping_ = false;
+    bool drain_on_stop_ = false;
+    std::thread thread_;
+
+    // Guarded by mutex_; copied by the worker for each job
+    std::string log_path_;
+    int max_files_ = 5;
+    bool compress_ = true;
+
+    std::atomic<uint64_t> archived_{0};
+    std::atomic<uint64_t> removed_{0};
+
+    void run();
+    void handle(const std::string& segment, const std::string& log_path, int max_files, bool compress);
+    bool compress_segment(const std::string& segment);
+    void prune(const std::string& log_path, int max_files);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_LOG_ARCHIVER_H
@@ -0,0 +1,139 @@
+#ifndef CYBERSENTINEL_LOG_FORMAT_H
+#define CYBERSENTINEL_LOG_FORMAT_H
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace cybersentinel {
+
+// A key/value pair attached to a log message, written as key=value after the
+// text. Holds a reference to the value: only valid within the logging call.
+template <typename T>
+struct LogField {
+    const char* key;
+    const T& value;
+};
+
+template <typename T>
+LogField<T> kv(const char* key, const T& value) {
+    return LogField<T>{key, value};
+}
+
+namespace log_format {
+
+template <typename T>
+struct is_field : std::false_type {};
+
+template <typename T>
+struct is_field<LogField<T>> : std::true_type {};
+
+inline void append_value(std::string& out, std::string_view value) {
+    out.append(value.data(), value.size());
+}
+
+inline void append_value(std::string& out, const std::string& value) {
+    out.append(value);
+}
+
+inline void append_value(std::string& out, const char* value) {
+    out.append(value ? value : "(null)");
+}
+
+inline void append_value(std::string& out, char value) {
+    out.push_back(value);
+}
+
+inline void append_value(std::string& out, bool value) {
+    out.append(value ? "true" : "false");
+}
+
+template <typename T>
+std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>> append_value(std::string& out, T value) {
+    if constexpr (std::is_enum_v<T>) {
+        append_value(out, static_cast<std::underlying_type_t<T>>(value));
+    } else {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+template <typename T>
+std::enable_if_t<std::is_floating_point_v<T>> append_value(std::string& out, T value) {
+    char buffer[32];
+    int length = std::snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+    if (length > 0) {
+        size_t written = static_cast<size_t>(length);
+        out.append(buffer, written < sizeof(buffer) ? written : sizeof(buffer) - 1);
+    }
+}
+
+// Field values with spaces, quotes or '=' are quoted so the line stays
+// splittable into key=value pairs. Backslashes are left alone: Windows paths
+// stay readable.
+template <typename T>
+void append_field_value(std::string& out, const T& value) {
+    size_t start = out.size();
+    append_value(out, value);
+
+    std::string_view text(out.data() + start, out.size() - start);
+    if (!text.empty() && text.find_first_of(" \t\"=") == std::string_view::npos) {
+        return;
+    }
+
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            quoted.push_back('\\');
+        }
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+    out.replace(start, std::string::npos, quoted);
+}
+
+template <typename T>
+void append_value(std::string& out, const LogField<T>& field) {
+    out.append(field.key);
+    out.push_back('=');
+    append_field_value(out, field.value);
+}
+
+// Copies the format up to the next "{}" and returns what follows it, or
+// copies all of it and returns an empty view
+inline std::string_view append_until_placeholder(std::string& out, std::string_view format, bool& found) {
+    size_t pos = format.find("{}");
+    found = pos != std::string_view::npos;
+    if (!found) {
+        out.append(format.data(), format.size());
+        return std::string_view();
+    }
+    out.append(format.data(), pos);
+    return format.substr(pos + 2);
+}
+
+inline void format_to(std::string& out, std::string_view format) {
+    out.append(format.data(), format.size());
+}
+
+// Arguments fill the "{}" placeholders in order; arguments left over are
+// appended after the text, space separated (fields as key=value)
+template <typename T, typename... Rest>
+void format_to(std::string& out, std::string_view format, const T& value, const Rest&... rest) {
+    bool found = false;
+    std::string_view remaining = append_until_placeholder(out, format, found);
+    if (!found) {
+        out.push_back(' ');
+    }
+    append_value(out, value);
+    format_to(out, remaining, rest...);
+}
+
+} // namespace log_format
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_LOG_FORMAT_H
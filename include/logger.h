@@ -1,12 +1,40 @@
 #ifndef CYBERSENTINEL_LOGGER_H
 #define CYBERSENTINEL_LOGGER_H
 
+#include "log_format.h"
+#include <atomic>
+#include <chrono>
 #include <string>
-#include <fstream>
-#include <mutex>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Calls below this level are compiled out of the CS_LOG_* macros entirely,
+// arguments included: 0 DEBUG, 1 INFO, 2 WARNING, 3 ERROR, 4 nothing
+#ifndef CYBERSENTINEL_LOG_MIN_LEVEL
+#define CYBERSENTINEL_LOG_MIN_LEVEL 0
+#endif
 
 namespace cybersentinel {
 
+// Callers only copy the message into a lock-free ring buffer; a background
+// thread formats records and writes them in batches to the log file and the
+// console. When the ring is nearly full, DEBUG and INFO messages are dropped
+// (and counted in the log); the rest of it is kept for WARNING and ERROR,
+// which wait briefly for space if even that runs out.
+// Pending records are written on shutdown() and at process exit. On a crash
+// the signal handler makes a best-effort attempt with async-signal-safe calls
+// only: the records still in the ring are written to the log file's
+// descriptor, and those the writer was in the middle of may be lost.
+//
+// With a rotation policy the writer renames the file once it is too large or
+// too old and carries on in a new one; a second background thread gzips the
+// rotated segments and deletes the oldest beyond the retention count.
+//
+// On hot paths use the CS_LOG_* macros, which check the level before the
+// arguments are evaluated and format only enabled messages:
+//   CS_LOG_DEBUG("File event", kv("type", event_type), kv("path", file_path));
+//   CS_LOG_INFO("Baseline crawl finished: {} files in {} ms", files, elapsed);
 class Logger {
 public:
     enum class Level {
@@ -16,24 +44,87 @@ public:
         ERROR
     };
 
-    static void init(const std::string& log_file = "cybersentinel_agent.log");
+    struct Stats {
+        uint64_t written = 0;
+        uint64_t dropped = 0;   // DEBUG/INFO discarded while the ring was full
+        uint64_t waited = 0;    // WARNING/ERROR that had to wait for space
+        uint64_t batches = 0;
+        uint64_t rotations = 0;
+        uint64_t archived = 0;  // rotated segments compressed
+        uint64_t removed = 0;   // segments deleted by retention
+    };
+
+    // Rotated segments sit next to the log as <stem>.<yyyymmdd-hhmmss>-<n><ext>,
+    // plus .gz once compressed
+    struct RotationPolicy {
+        uint64_t max_file_bytes = 0;         // 0: no size limit
+        std::chrono::seconds max_age{0};     // since the file was opened; 0: no limit
+        int max_files = 5;                   // rotated segments kept
+        bool compress = true;
+    };
+
+    // queue_capacity is rounded up to a power of two
+    static void init(const std::string& log_file = "cybersentinel_agent.log", size_t queue_capacity = 8192);
     static void set_level(Level level);
+    static void set_console_output(bool enabled);
+
+    // Also compresses segments left uncompressed by an earlier run
+    static void set_rotation(const RotationPolicy& policy);
 
     static void debug(const std::string& message);
     static void info(const std::string& message);
     static void warning(const std::string& message);
     static void error(const std::string& message);
 
+    // Cheap enough to call before building any message
+    static bool enabled(Level level) {
+        return level >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    // "{}" placeholders are filled from the arguments in order; arguments
+    // without a placeholder, typically kv() fields, follow the text. The
+    // message is rendered into a per-thread buffer, only if enabled.
+    template <typename... Args>
+    static void write(Level level, std::string_view format, const Args&... args) {
+        if (!enabled(level)) {
+            return;
+        }
+        std::string& message = format_buffer();
+        message.clear();
+        log_format::format_to(message, format, args...);
+        log(level, message);
+    }
+
+    // Write everything logged so far before returning
+    static void flush();
+
+    // Flush and stop the writer thread, and finish compressing rotated
+    // segments; later messages are written directly
+    static void shutdown();
+
+    static Stats stats();
+
 private:
-    static void log(Level level, const std::string& message);
-    static std::string level_to_string(Level level);
-    static std::string get_timestamp();
+    inline static std::atomic<Level> min_level_{Level::INFO};
 
-    static std::ofstream log_file_;
-    static std::mutex mutex_;
-    static Level min_level_;
+    static std::string& format_buffer();
+    static void log(Level level, const std::string& message);
 };
 
 } // namespace cybersentinel
 
+#define CS_LOG_AT(level_value, level, ...)                                         \
+    do {                                                                           \
+        if constexpr ((level_value) >= CYBERSENTINEL_LOG_MIN_LEVEL) {              \
+            if (::cybersentinel::Logger::enabled(level)) {                         \
+                ::cybersentinel::Logger::write(level, __VA_ARGS__);                \
+            }                                                                      \
+        }                                                                          \
+    } while (0)
+
+#define CS_LOG_DEBUG(...)   CS_LOG_AT(0, ::cybersentinel::Logger::Level::DEBUG, __VA_ARGS__)
+#define CS_LOG_INFO(...)    CS_LOG_AT(1, ::cybersentinel::Logger::Level::INFO, __VA_ARGS__)
+#define CS_LOG_WARNING(...) CS_LOG_AT(2, ::cybersentinel::Logger::Level::WARNING, __VA_ARGS__)
+#define CS_LOG_ERROR(...)   CS_LOG_AT(3, ::cybersentinel::Logger::Level::ERROR, __VA_ARGS__)
+
 #endif // CYBERSENTINEL_LOGGER_H
@@ -0,0 +1,184 @@
+#ifndef CYBERSENTINEL_METRICS_H
+#define CYBERSENTINEL_METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cybersentinel {
+
+// Internal metrics: counters, gauges and latency histograms cheap enough for
+// the classification hot path. Updates are relaxed atomic adds on one of
+// kMetricShards cache-line-sized slots, picked per thread, so threads updating
+// the same metric rarely touch the same line and never take a lock. Reads
+// (exports) sum the shards; a value read while updates are in flight may
+// miss the updates in progress, never more.
+
+static constexpr size_t kMetricShards = 8;
+
+// Index of the calling thread's shard, assigned round-robin on first use
+inline size_t metric_shard() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+    return shard;
+}
+
+class Counter {
+public:
+    void add(uint64_t n = 1) {
+        shards_[metric_shard()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+    std::array<Shard, kMetricShards> shards_;
+};
+
+// A level set by its owner, e.g. a queue length; not sharded
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// Log-linear histogram of nanosecond durations, in the manner of HDR
+// histograms: every power of two is split into 16 equal buckets, so any
+// recorded value is known to within 1/16 (6%) of itself across the whole
+// 64-bit range, in a fixed 976 buckets per shard. Recording is a bucket
+// index computed from the leading bit and three relaxed adds.
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum = 0;  // nanoseconds
+        std::vector<uint64_t> buckets;
+
+        // Value at quantile q (0..1), as the midpoint of its bucket; 0 when empty
+        uint64_t quantile(double q) const;
+        uint64_t max() const;  // upper bound of the highest non-empty bucket
+
+        // Recorded values below the limit; exact when limit is a power of two
+        uint64_t count_below(uint64_t limit) const;
+    };
+
+    void record(uint64_t nanoseconds) {
+        Shard& shard = shards_[metric_shard()];
+        shard.buckets[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        shard.count.fetch_add(1, std::memory_order_relaxed);
+        shard.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::nanoseconds elapsed) {
+        record(static_cast<uint64_t>((std::max)(elapsed.count(), std::chrono::nanoseconds::rep(0))));
+    }
+
+    Snapshot snapshot() const;
+
+    static int bucket_index(uint64_t value) {
+        if (value < static_cast<uint64_t>(kSubBuckets)) {
+            return static_cast<int>(value);
+        }
+        int exponent = highest_bit(value);
+        int shift = exponent - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<int>((value >> shift) & (kSubBuckets - 1));
+    }
+
+    // Smallest value that falls in bucket index
+    static uint64_t bucket_lower(int index);
+    static uint64_t bucket_upper(int index);  // inclusive
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> buckets[kBuckets] = {};
+    };
+    std::array<Shard, kMetricShards> shards_;
+
+    static int highest_bit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanReverse64(&index, value);
+        return static_cast<int>(index);
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+};
+
+// Records the time from construction to destruction
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {
+    }
+
+    ~ScopedTimer() {
+        histogram_.record(std::chrono::steady_clock::now() - start_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Process-wide registry. Metrics are created on first lookup and live until
+// exit, so callers keep the returned reference, typically in a function-local
+// static at the instrumentation site; looking one up takes a mutex.
+// Metric and label names follow Prometheus conventions: durations in
+// seconds, counters ending in _total.
+class Metrics {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    enum class Format {
+        PROMETHEUS,  // text exposition format 0.0.4
+        JSON
+    };
+
+    static Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    static Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    static Histogram& histogram(const std::string& name, const std::string& help, const Labels& labels = {});
+
+    // Latency of one pipeline stage: watch (OS notification to handler),
+    // sniff (file read), classify (pattern matching), serialize (event
+    // encoding) and upload (request to response, retries included)
+    static Histogram& stage(const std::string& stage);
+
+    // Every registered metric in the given format
+    static std::string render(Format format);
+
+    // Renders to a file beside path and renames it over path, so readers
+    // never see a partial export
+    static bool write_file(const std::string& path, Format format);
+
+    static bool parse_format(const std::string& name, Format& format);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_METRICS_H
@@ -0,0 +1,54 @@
+#ifndef CYBERSENTINEL_METRICS_EXPORTER_H
+#define CYBERSENTINEL_METRICS_EXPORTER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "metrics.h"
+
+namespace cybersentinel {
+
+// Writes a snapshot of every registered metric to a local file at a fixed
+// interval, for a node exporter's textfile collector or a support bundle to
+// pick up. The agent exposes no listening port; a file is all a collector
+// on the machine needs. A final snapshot is written on stop.
+class MetricsExporter {
+public:
+    // Called on the exporter's thread before each snapshot, to set gauges
+    // that are sampled rather than updated where they change
+    using CollectHook = std::function<void()>;
+
+    MetricsExporter(const std::string& path, Metrics::Format format,
+                    std::chrono::seconds interval, CollectHook collect);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    void start();
+    void stop();
+
+    // Writes a snapshot now; false if the file could not be written
+    bool export_now();
+
+private:
+    std::string path_;
+    Metrics::Format format_;
+    std::chrono::seconds interval_;
+    CollectHook collect_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    bool failing_{false};  // only the first of consecutive failures is logged
+
+    void run();
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_METRICS_EXPORTER_H
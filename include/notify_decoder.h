@@ -0,0 +1,111 @@
+#ifndef CYBERSENTINEL_NOTIFY_DECODER_H
+#define CYBERSENTINEL_NOTIFY_DECODER_H
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "watcher_backend.h"
+
+namespace cybersentinel {
+
+// Platform-independent view of the ReadDirectoryChangesW output format, so
+// buffer handling and decoding build (and can be exercised) without
+// windows.h. A buffer holds DWORD-aligned FILE_NOTIFY_INFORMATION records:
+//
+//   uint32_t NextEntryOffset;   // 0 on the last record
+//   uint32_t Action;            // FILE_ACTION_*
+//   uint32_t FileNameLength;    // in bytes
+//   char16_t FileName[];        // UTF-16LE, relative to the watched root
+
+// FILE_ACTION_* values
+enum NotifyAction : uint32_t {
+    kNotifyActionAdded = 1,
+    kNotifyActionRemoved = 2,
+    kNotifyActionModified = 3,
+    kNotifyActionRenamedOldName = 4,
+    kNotifyActionRenamedNewName = 5
+};
+
+constexpr size_t kNotifyHeaderSize = 12;
+
+bool notify_action_to_file_action(uint32_t action, FileAction& out);
+
+enum class NotifyDecodeStatus {
+    OK,
+    EVENTS_LOST,  // zero-byte completion: the kernel dropped notifications
+    MALFORMED     // offsets or lengths point outside the buffer
+};
+
+using NotifyEntryHandler = std::function<void(uint32_t action, std::u16string_view name)>;
+
+// Calls on_entry for every record in data[0, length). Records before a
+// malformed one are still delivered.
+NotifyDecodeStatus decode_notifications(const uint8_t* data, size_t length,
+                                        const NotifyEntryHandler& on_entry);
+
+// Turns notification records into WatchEvents. The directory part of the
+// relative name is joined to the root and interned; the file name is
+// transcoded into a reused buffer. Once the directories involved are
+// interned, building an event does not allocate.
+class NotifyEventBuilder {
+public:
+    explicit NotifyEventBuilder(PathPool& paths) : paths_(paths) {}
+
+    // Delete copy constructor and assignment
+    NotifyEventBuilder(const NotifyEventBuilder&) = delete;
+    NotifyEventBuilder& operator=(const NotifyEventBuilder&) = delete;
+
+    // root is the interned watch root. False for actions that are not
+    // reported and for records without a file name. The event's name is
+    // valid until the next call.
+    bool build(uint32_t root, uint32_t action, std::u16string_view name, WatchEvent& event);
+
+private:
+    PathPool& paths_;
+    std::string name_;
+    std::string directory_;
+
+    // Consecutive records usually share a directory; the id is only good
+    // while the pool has not dropped entries since
+    uint32_t cached_root_ = UINT32_MAX;
+    std::u16string cached_units_;
+    uint32_t cached_directory_ = 0;
+    uint64_t cached_generation_ = 0;
+};
+
+// Two heap buffers for one watched directory. The kernel fills the armed
+// buffer; on completion swap() hands it out for decoding and arms the other,
+// so the next read can be issued before the completed one is dispatched.
+class NotifyBuffers {
+public:
+    struct Chunk {
+        const uint8_t* data;
+        size_t length;
+    };
+
+    explicit NotifyBuffers(size_t buffer_size);
+
+    // Delete copy constructor and assignment
+    NotifyBuffers(const NotifyBuffers&) = delete;
+    NotifyBuffers& operator=(const NotifyBuffers&) = delete;
+
+    // Buffer to pass to the next ReadDirectoryChangesW call
+    uint8_t* armed() { return reinterpret_cast<uint8_t*>(storage_[armed_].get()); }
+    size_t size() const { return size_; }
+
+    // The armed buffer completed with `bytes`; returns its contents and arms
+    // the other buffer. The chunk stays valid until the following swap().
+    Chunk swap(size_t bytes);
+
+private:
+    size_t size_;
+    std::unique_ptr<uint32_t[]> storage_[2];  // uint32_t for DWORD alignment
+    int armed_;
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_NOTIFY_DECODER_H
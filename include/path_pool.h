@@ -0,0 +1,73 @@
+#ifndef CYBERSENTINEL_PATH_POOL_H
+#define CYBERSENTINEL_PATH_POOL_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+namespace cybersentinel {
+
+// Interned directory paths. A watcher sees the same few directories over
+// and over, so events refer to their directory by a 32-bit id instead of
+// carrying a copy of it.
+//
+// Directories held beyond one event (watch roots, watched directories) are
+// pinned with acquire() until the matching release(). The others are a
+// cache: once more than kMaxUnreferenced are unpinned, interning a new path
+// drops them all and their ids are reused, so churn through many short-lived
+// directories does not grow the pool. A view from get() stays valid while
+// its entry is pinned, or until the next intern() otherwise; generation()
+// changes whenever entries are dropped.
+//
+// Not synchronised: a pool belongs to one watcher backend thread.
+class PathPool {
+public:
+    // Unpinned entries kept for reuse before they are dropped
+    static constexpr size_t kMaxUnreferenced = 1024;
+
+    PathPool() = default;
+
+    // Delete copy constructor and assignment
+    PathPool(const PathPool&) = delete;
+    PathPool& operator=(const PathPool&) = delete;
+
+    // Id of path, adding it if it is new
+    uint32_t intern(std::string_view path);
+
+    void acquire(uint32_t id);
+    void release(uint32_t id);
+
+    std::string_view get(uint32_t id) const { return entries_[id].path; }
+
+    // Writes directory, separator and name to out, reusing its capacity
+    void join(uint32_t directory, std::string_view name, std::string& out) const;
+
+    size_t size() const { return entries_.size() - free_ids_.size(); }
+    size_t bytes() const { return bytes_; }
+    uint64_t generation() const { return generation_; }
+
+private:
+    struct Entry {
+        std::string path;  // a deque never moves it, so views stay valid
+        uint32_t references = 0;
+        bool live = false;
+    };
+
+    std::deque<Entry> entries_;
+    std::vector<uint32_t> free_ids_;
+    std::unordered_map<std::string_view, uint32_t> ids_;
+    size_t unreferenced_ = 0;
+    size_t bytes_ = 0;
+    uint64_t generation_ = 0;
+
+    // Drops every unpinned entry but keep
+    void trim(uint32_t keep);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_PATH_POOL_H
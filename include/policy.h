@@ -0,0 +1,137 @@
+#ifndef CYBERSENTINEL_POLICY_H
+#define CYBERSENTINEL_POLICY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cybersentinel {
+
+// One rule of the "policy" configuration section. Every listed dimension
+// must match (any of the values listed for it); an empty list matches
+// anything. Rules are tried in order and the first match decides.
+struct PolicyRule {
+    std::string name;
+    std::vector<std::string> sources;        // "file", "usb_file", "clipboard"
+    std::vector<std::string> volume_types;   // "local", "usb", "removable"
+    std::vector<std::string> labels;         // classifier labels, e.g. "PAN"
+    std::vector<std::string> path_prefixes;  // whole directories, e.g. "C:\\Finance";
+                                             // case-insensitive on Windows
+    std::vector<std::string> extensions;     // ".xlsx" or "xlsx"
+    double min_confidence = 0.0;
+    std::string severity;                    // "low", "medium", "high", "critical"
+    std::string action = "report";           // "report" or "ignore"
+
+    bool operator==(const PolicyRule& other) const;
+    bool operator!=(const PolicyRule& other) const { return !(*this == other); }
+};
+
+enum class PolicySource : uint8_t {
+    FILE,
+    USB_FILE,
+    CLIPBOARD
+};
+
+enum class VolumeType : uint8_t {
+    LOCAL,
+    USB,
+    REMOVABLE
+};
+
+// A classified event, as the policy sees it
+struct PolicyInput {
+    PolicySource source = PolicySource::FILE;
+    VolumeType volume_type = VolumeType::LOCAL;
+    uint32_t labels = 0;  // Classifier::label_mask
+    double confidence = 0.0;
+    std::string_view path;  // empty for clipboard
+};
+
+struct PolicyDecision {
+    std::string_view severity;  // valid while the Policy is
+    bool report = true;
+    int rule = -1;              // index of the deciding rule; -1 for the default
+};
+
+// Rules compiled into a decision table. Each dimension maps an event's value
+// to the set of rules it satisfies, as a bit set over rule indices:
+// sources, volume types and label masks index a table directly, extensions
+// go through a hash map and path prefixes through a trie of path components.
+// Evaluation intersects one set per dimension and takes the lowest rule
+// index left, so its cost depends on the path depth and the number of rules
+// / 64, never on how the rules are written.
+//
+// Immutable once compiled: any number of threads may evaluate one Policy.
+// Events no rule matches get the built-in severities (critical on a
+// removable volume or above 0.8 confidence, high otherwise, medium for the
+// clipboard).
+class Policy {
+public:
+    // nullptr, with error naming the rule, if a rule has an unknown source,
+    // volume type, label, severity or action
+    static std::unique_ptr<Policy> compile(const std::vector<PolicyRule>& rules, std::string& error);
+
+    PolicyDecision evaluate(const PolicyInput& input) const;
+
+    // The built-in decision, also used by an empty rule set
+    static PolicyDecision default_decision(const PolicyInput& input);
+
+    size_t rule_count() const { return rules_.size(); }
+
+    // Fingerprint of the rules it was compiled from; 0 for no rules
+    uint32_t version() const { return version_; }
+    const std::string& rule_name(int rule) const { return rules_[rule].name; }
+
+    static const char* source_name(PolicySource source);
+
+    // Extension of the path's last component, without the dot; matched
+    // case-insensitively
+    static std::string_view extension_of(std::string_view path);
+
+private:
+    using Bits = std::vector<uint64_t>;
+
+    static constexpr int kSources = 3;
+    static constexpr int kVolumeTypes = 3;
+    static constexpr int kLabelMasks = 32;  // Classifier produces 5 labels
+
+    struct CompiledRule {
+        std::string name;
+        std::string severity;
+        double min_confidence;
+        bool report;
+    };
+
+    // Path trie; a node's rules are those with a prefix ending there
+    struct TrieNode {
+        std::vector<std::pair<std::string, uint32_t>> children;  // sorted
+        std::vector<uint32_t> rules;
+    };
+
+    std::vector<CompiledRule> rules_;
+    size_t words_ = 0;
+    uint32_t version_ = 0;
+
+    Bits source_bits_[kSources];
+    Bits volume_bits_[kVolumeTypes];
+    Bits label_bits_[kLabelMasks];
+
+    // Rules listing the extension plus rules without extensions
+    std::unordered_map<std::string, Bits> extension_bits_;
+    Bits any_extension_;
+
+    std::vector<TrieNode> trie_;
+    Bits any_path_;
+
+    Policy() = default;
+
+    void add_prefix(const std::string& prefix, uint32_t rule);
+    void collect_path_rules(std::string_view path, Bits& candidates) const;
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_POLICY_H
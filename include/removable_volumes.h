@@ -0,0 +1,88 @@
+#ifndef CYBERSENTINEL_REMOVABLE_VOLUMES_H
+#define CYBERSENTINEL_REMOVABLE_VOLUMES_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "events.h"
+#include "file_monitor.h"
+#include "file_state_index.h"
+#include "baseline_crawler.h"
+
+namespace cybersentinel {
+
+using VolumeFileCallback = std::function<void(const std::string& file_path, const std::string& event_type,
+                                              const VolumeInfo& volume)>;
+
+// Watches removable volumes while they are mounted. Each attached volume
+// gets its own FileMonitor, so files copied to it are not queued behind
+// events from the fixed disks, and optionally a budgeted crawl of what is
+// already on it. Every event carries the volume's identity. Nothing here
+// is Windows-specific: USBMonitor reports arrivals and removals there, and
+// any directory can stand in for a mount point elsewhere.
+class RemovableVolumeWatcher {
+public:
+    struct Options {
+        bool scan_existing = true;
+        int scan_threads = 2;
+        double scan_max_files_per_sec = 100.0;  // 0 = unlimited
+        double scan_max_mb_per_sec = 20.0;      // 0 = unlimited
+    };
+
+    struct VolumeStats {
+        VolumeInfo volume;
+        uint64_t file_events = 0;     // changes reported by the watcher
+        bool scanning = false;
+        BaselineCrawler::Stats scan;  // empty when scan_existing is off
+    };
+
+    // callback runs on the volume's watcher thread for changes and on the
+    // crawl workers (event type "baseline") for existing files
+    RemovableVolumeWatcher(VolumeFileCallback callback, FileStateIndex* index, const Options& options);
+    ~RemovableVolumeWatcher();
+
+    // Delete copy constructor and assignment
+    RemovableVolumeWatcher(const RemovableVolumeWatcher&) = delete;
+    RemovableVolumeWatcher& operator=(const RemovableVolumeWatcher&) = delete;
+
+    // Start watching the volume's root; false if it is already attached or
+    // is not a directory
+    bool attach(const VolumeInfo& volume);
+
+    // Stop watching and scanning; returns once no more callbacks run for it.
+    // The volume's file-state index entries are dropped.
+    bool detach(const std::string& root);
+    void detach_all();
+
+    size_t attached_count();
+    std::vector<VolumeStats> stats();
+
+private:
+    struct AttachedVolume {
+        VolumeInfo volume;
+        std::unique_ptr<FileMonitor> monitor;
+        std::unique_ptr<BaselineCrawler> crawler;
+        std::atomic<uint64_t> file_events{0};
+    };
+
+    VolumeFileCallback callback_;
+    FileStateIndex* index_;
+    Options options_;
+
+    // Keyed by root
+    std::mutex mutex_;
+    std::map<std::string, std::unique_ptr<AttachedVolume>> volumes_;
+
+    // Drops the volume's entries from the file-state index
+    void forget_volume(const std::string& root);
+    static void shut_down(AttachedVolume& attached);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_REMOVABLE_VOLUMES_H
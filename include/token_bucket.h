@@ -0,0 +1,37 @@
+#ifndef CYBERSENTINEL_TOKEN_BUCKET_H
+#define CYBERSENTINEL_TOKEN_BUCKET_H
+
+#include <chrono>
+#include <mutex>
+
+namespace cybersentinel {
+
+// Token bucket rate limiter shared by several threads. take() never blocks:
+// it debits the bucket (possibly below zero) and returns how long the caller
+// must wait before going ahead, so a single request larger than the burst
+// still passes, just later. The caller does the waiting, which keeps it
+// interruptible on shutdown.
+class TokenBucket {
+public:
+    // rate: tokens per second, 0 = unlimited. burst: bucket capacity; 0 uses
+    // one second's worth of tokens.
+    explicit TokenBucket(double rate = 0.0, double burst = 0.0);
+
+    void set_rate(double rate, double burst = 0.0);
+    bool limited() const;
+
+    std::chrono::microseconds take(double amount);
+
+private:
+    mutable std::mutex mutex_;
+    double rate_;
+    double burst_;
+    double tokens_;
+    std::chrono::steady_clock::time_point refilled_;
+
+    void refill(std::chrono::steady_clock::time_point now);
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_TOKEN_BUCKET_H
@@ -2,29 +2,38 @@
 #define CYBERSENTINEL_USB_MONITOR_H
 
 #include <string>
+#include <map>
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <windows.h>
+#include "events.h"
 
 namespace cybersentinel {
 
-using USBEventCallback = std::function<void(const std::string& device_name)>;
+using VolumeEventCallback = std::function<void(const VolumeInfo& volume)>;
 
+// Reports removable volumes (removable media, and fixed disks on the USB
+// bus) as they are mounted and removed. Volumes already mounted when
+// monitoring starts are reported as arrivals.
 class USBMonitor {
 public:
-    explicit USBMonitor(USBEventCallback callback);
+    USBMonitor(VolumeEventCallback on_arrival, VolumeEventCallback on_removal);
     ~USBMonitor();
 
     bool start();
     void stop();
 
 private:
-    USBEventCallback callback_;
+    VolumeEventCallback on_arrival_;
+    VolumeEventCallback on_removal_;
     std::atomic<bool> running_{false};
     std::thread monitor_thread_;
     HWND hwnd_{nullptr};
 
+    // Mounted removable volumes by root; only touched on the monitor thread
+    std::map<std::string, VolumeInfo> volumes_;
+
     void monitor_loop();
     void check_usb_devices();
     static LRESULT CALLBACK window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam);
@@ -0,0 +1,29 @@
+#ifndef CYBERSENTINEL_UTF8_H
+#define CYBERSENTINEL_UTF8_H
+
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cstddef>
+
+namespace cybersentinel {
+
+// Length of the well-formed UTF-8 sequence starting at text[pos], or 0 if
+// the bytes there are not valid UTF-8 (overlongs and surrogates included)
+size_t utf8_sequence_length(std::string_view text, size_t pos);
+
+// Appends the UTF-8 form of UTF-16 text (file names from the Windows
+// notification API) to out, reusing its capacity. Unpaired surrogates become
+// U+FFFD. Runs of ASCII, the common case for paths, are converted eight
+// units at a time.
+void append_utf16_as_utf8(std::u16string_view text, std::string& out);
+
+// Paths travel through the agent as UTF-8 strings. Converting through these
+// keeps them intact on Windows, where narrow strings would otherwise be taken
+// to be in the ANSI code page.
+std::filesystem::path path_from_utf8(std::string_view text);
+std::string path_to_utf8(const std::filesystem::path& path);
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_UTF8_H
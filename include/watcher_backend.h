@@ -0,0 +1,100 @@
+#ifndef CYBERSENTINEL_WATCHER_BACKEND_H
+#define CYBERSENTINEL_WATCHER_BACKEND_H
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include "path_pool.h"
+
+namespace cybersentinel {
+
+enum class FileAction {
+    CREATED,
+    DELETED,
+    MODIFIED,
+    MOVED
+};
+
+const char* file_action_to_string(FileAction action);
+
+// Platform path separator, for joining watch roots and relative names
+#ifdef _WIN32
+constexpr char kPathSeparator = '\\';
+#else
+constexpr char kPathSeparator = '/';
+#endif
+
+// A changed entry: its name inside a directory interned in the backend's
+// PathPool. The name is only valid during the handler call.
+struct WatchEvent {
+    uint32_t directory;
+    std::string_view name;
+    FileAction action;
+    std::chrono::steady_clock::time_point received{};  // when the OS delivered it
+};
+
+// Invoked on the backend's thread for every change
+using WatchEventHandler = std::function<void(const WatchEvent& event)>;
+
+// Invoked when the OS dropped notifications under root; every file below it
+// may have changed without an event
+using WatchOverflowHandler = std::function<void(const std::string& root)>;
+
+// OS-specific recursive directory watcher. FileMonitor drives one backend
+// for all monitored paths; the rest of the pipeline is platform-independent.
+class WatcherBackend {
+public:
+    virtual ~WatcherBackend() = default;
+
+    // Watch root and everything below it. Once started, the change is made
+    // on the backend's thread and this returns when it is in place; do not
+    // call it from an event handler.
+    virtual bool add_watch(const std::string& root) = 0;
+
+    // Stop watching root; no event under it is delivered after this returns.
+    // Same threading rules as add_watch.
+    virtual bool remove_watch(const std::string& root) = 0;
+
+    virtual bool start(WatchEventHandler on_event, WatchOverflowHandler on_overflow) = 0;
+    virtual void stop() = 0;
+
+    virtual const char* name() const = 0;
+
+    // Directories referenced by WatchEvents; only read it from the handler
+    const PathPool& paths() const { return paths_; }
+
+    // ReadDirectoryChangesW on Windows, inotify on Linux. buffer_size is the
+    // per-read notification buffer; 0 uses the backend default.
+    static std::unique_ptr<WatcherBackend> create(size_t buffer_size = 0);
+
+protected:
+    PathPool paths_;
+
+    // Runs command on the backend's thread and returns its result: queued,
+    // the thread woken, and waited for. Before start() and after the thread
+    // has exited it runs on the caller's thread instead.
+    bool run_on_backend_thread(std::function<bool()> command);
+
+    // start() calls serve_commands(true) before launching the thread; the
+    // thread calls run_commands() when woken and serve_commands(false) as
+    // it exits
+    void serve_commands(bool serving);
+    void run_commands();
+    virtual void wake() = 0;
+
+private:
+    std::mutex commands_mutex_;
+    std::deque<std::packaged_task<bool()>> commands_;
+    bool serving_ = false;
+};
+
+} // namespace cybersentinel
+
+#endif // CYBERSENTINEL_WATCHER_BACKEND_H
@@ -187,7 +187,7 @@ Write-Host ""
 Write-Host "[5/10] Installing C++ dependencies..." -ForegroundColor Green
 Write-Host "  This may take 5-10 minutes on first run..." -ForegroundColor Yellow
 
-$packages = @("curl:x64-windows", "nlohmann-json:x64-windows")
+$packages = @("curl:x64-windows", "nlohmann-json:x64-windows", "zlib:x64-windows")
 foreach ($package in $packages) {
     $packageName = $package -replace ':.*', ''
     Write-Host "  Installing $packageName..." -ForegroundColor Yellow
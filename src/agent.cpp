@@ -1,16 +1,62 @@
 #include "agent.h"
 #include "logger.h"
-#include "classifier.h"
+#include "events.h"
+#include "heartbeat_scheduler.h"
+#include "io_governor.h"
+#include <nlohmann/json.hpp>
 #include <windows.h>
 #include <thread>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <vector>
 
 namespace cybersentinel {
 
+// Keep the agent's own log from filling the disk
+static void apply_log_rotation(const Config& config) {
+    Logger::RotationPolicy rotation;
+    rotation.max_file_bytes = static_cast<uint64_t>((std::max)(0, config.get_log_max_file_mb())) * 1024 * 1024;
+    rotation.max_age = std::chrono::hours((std::max)(0, config.get_log_max_age_hours()));
+    rotation.max_files = config.get_log_max_files();
+    rotation.compress = config.is_log_compression_enabled();
+    Logger::set_rotation(rotation);
+}
+
+// Throttle classifier reads
+static void apply_io_limits(const Config& config) {
+    IoGovernor::Limits io_limits;
+    io_limits.max_bytes_per_sec = config.get_io_max_mb_per_sec() * 1024 * 1024;
+    io_limits.max_iops = config.get_io_max_iops();
+    io_limits.burst_seconds = config.get_io_burst_seconds();
+    io_limits.idle_multiplier = config.get_io_idle_multiplier();
+    io_limits.idle_cpu_percent = config.get_io_idle_cpu_percent();
+    IoGovernor::configure(io_limits);
+}
+
+// Path prefixes may use environment variables like monitored paths. Without
+// a valid rule set the built-in severities apply.
+static std::unique_ptr<Policy> compile_policy(const Config& config) {
+    std::vector<PolicyRule> rules = config.get_policy_rules();
+    for (auto& rule : rules) {
+        for (auto& prefix : rule.path_prefixes) {
+            prefix = FileMonitor::expand_path(prefix);
+        }
+    }
+
+    std::string error;
+    auto policy = Policy::compile(rules, error);
+    if (!policy) {
+        Logger::error("Invalid " + error + "; using the built-in severities");
+    } else if (policy->rule_count() > 0) {
+        Logger::info("Policy compiled: " + std::to_string(policy->rule_count()) + " rules");
+    }
+    return policy;
+}
+
 Agent::Agent(const std::string& config_file)
-    : config_(std::make_unique<Config>(config_file)) {
+    : config_file_(config_file) {
 }
 
 Agent::~Agent() {
@@ -18,74 +64,114 @@ Agent::~Agent() {
 }
 
 bool Agent::initialize() {
+    start_time_ = std::chrono::steady_clock::now();
     Logger::info("Initializing CyberSentinel DLP Agent...");
 
     // Load configuration
-    if (!config_->load()) {
+    auto loaded = std::make_unique<Config>(config_file_);
+    if (!loaded->load()) {
         Logger::error("Failed to load configuration");
         return false;
     }
+    std::string config_error;
+    if (!loaded->validate(config_error)) {
+        Logger::warning("Configuration: " + config_error);
+    }
+    config_store_.publish(std::move(loaded));
+
+    apply_log_rotation(config());
 
     // Initialize system information
     initialize_system_info();
 
     // Initialize HTTP client
     http_client_ = std::make_unique<HttpClient>(
-        config_->get_server_url()
+        config().get_server_url()
     );
+    http_client_->set_http2(config().is_http2_enabled());
+    http_client_->set_retry_policy(config().get_retry_attempts(),
+                                   config().get_retry_base_ms(), 10000);
+    http_client_->set_circuit_breaker(config().get_breaker_failure_threshold(),
+                                      config().get_breaker_open_seconds(), 600);
+
+    // Open offline spool so events survive server outages
+    if (config().is_spool_enabled()) {
+        spool_ = std::make_unique<EventSpool>(
+            config().get_spool_directory(),
+            static_cast<uint64_t>(config().get_spool_max_size_mb()) * 1024 * 1024
+        );
 
-    // Register with server
-    if (!register_agent()) {
-        Logger::error("Failed to register agent with server");
-        return false;
+        if (!spool_->open()) {
+            Logger::warning("Event spool unavailable, undelivered events will be lost");
+            spool_.reset();
+        }
     }
 
-    // Initialize monitors
-    if (config_->is_file_monitoring_enabled()) {
-        file_monitor_ = std::make_unique<FileMonitor>(
-            config_->get_monitored_paths(),
-            [this](const std::string& path, const std::string& event_type) {
-                handle_file_event(path, event_type);
-            }
-        );
+    // Events are buffered locally until registration succeeds in run(), so
+    // monitoring starts immediately even when the server is unreachable
+    reporter_ = std::make_unique<EventReporter>(*http_client_, agent_id_, spool_.get());
+    reporter_->pause_delivery();
 
-        if (!file_monitor_->start()) {
-            Logger::error("Failed to start file monitor");
-            return false;
-        }
-        Logger::info("File monitoring started");
+    // Before any monitor can trigger classifier reads
+    apply_io_limits(config());
+
+    // Persisted so a restart does not classify unchanged files again
+    file_index_ = std::make_unique<FileStateIndex>();
+    std::string index_path = config().get_file_state_index_path();
+    if (config().is_file_monitoring_enabled() && !index_path.empty() && !file_index_->open(index_path)) {
+        Logger::warning("File state index unavailable, unchanged files will be classified again");
+    }
+
+    pipeline_ = std::make_unique<EventPipeline>(*reporter_, *file_index_);
+    if (auto policy = compile_policy(config())) {
+        pipeline_->set_policy(std::move(policy));
+    }
+
+    if (config().is_metrics_enabled()) {
+        start_metrics_export(config());
     }
 
-    if (config_->is_clipboard_monitoring_enabled()) {
-        clipboard_monitor_ = std::make_unique<ClipboardMonitor>(
-            [this](const std::string& content) {
-                handle_clipboard_event(content);
+    // Raw events for offline replay (tools/trace_replay.cpp)
+    if (config().is_event_trace_enabled()) {
+        trace_writer_ = std::make_unique<TraceWriter>();
+        bool record_content = config().is_event_trace_content_enabled();
+        if (trace_writer_->open(config().get_event_trace_directory(), record_content)) {
+            if (record_content) {
+                Logger::warning("Recording event trace with content to " +
+                                config().get_event_trace_directory() + "; the trace holds sensitive data");
+            } else {
+                Logger::info("Recording event trace to " + config().get_event_trace_directory());
             }
-        );
+        } else {
+            trace_writer_.reset();
+        }
+    }
 
-        if (!clipboard_monitor_->start()) {
-            Logger::error("Failed to start clipboard monitor");
+    // Initialize monitors
+    {
+        std::lock_guard<std::mutex> lock(monitors_mutex_);
+        if ((config().is_file_monitoring_enabled() && !start_file_monitoring(config())) ||
+            (config().is_clipboard_monitoring_enabled() && !start_clipboard_monitoring(config())) ||
+            (config().is_usb_monitoring_enabled() && !start_usb_monitoring(config()))) {
             return false;
         }
-        Logger::info("Clipboard monitoring started");
     }
 
-    if (config_->is_usb_monitoring_enabled()) {
-        usb_monitor_ = std::make_unique<USBMonitor>(
-            [this](const std::string& device_name) {
-                handle_usb_event(device_name);
+    // Changes to the file apply while running; see apply_config()
+    if (config().is_config_reload_enabled()) {
+        config_watcher_ = std::make_unique<ConfigWatcher>(
+            config_store_,
+            [this](const Config& previous, const Config& current) {
+                apply_config(previous, current);
             }
         );
-
-        if (!usb_monitor_->start()) {
-            Logger::error("Failed to start USB monitor");
-            return false;
-        }
-        Logger::info("USB monitoring started");
+        config_watcher_->start();
     }
 
     initialized_ = true;
-    Logger::info("Agent initialized successfully");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+    Logger::info("Agent initialized successfully in " + std::to_string(elapsed.count()) + " ms");
     return true;
 }
 
@@ -98,20 +184,37 @@ void Agent::run() {
     running_ = true;
     Logger::info("Agent is now running...");
 
+    // Register in the background; monitors are already running
+    std::thread registration_thread([this]() {
+        registration_loop();
+    });
+
     // Start heartbeat thread
     std::thread heartbeat_thread([this]() {
         heartbeat_loop();
     });
 
+    // Start spool replay
+    reporter_->start_replay(config().get_spool_replay_rate());
+
     // Main loop
     while (running_) {
         std::this_thread::sleep_for(std::chrono::seconds(1));
     }
 
     // Cleanup
+    if (registration_thread.joinable()) {
+        registration_thread.join();
+    }
     if (heartbeat_thread.joinable()) {
         heartbeat_thread.join();
     }
+    // Live events still queued go to the spool while it is open
+    reporter_->drain(std::chrono::seconds(5));
+    reporter_->stop_replay();
+    if (spool_) {
+        spool_->close();
+    }
 
     Logger::info("Agent stopped");
 }
@@ -120,14 +223,345 @@ void Agent::stop() {
     Logger::info("Stopping agent...");
     running_ = false;
 
+    // No reload may start monitors from here on
+    if (config_watcher_) {
+        config_watcher_->stop();
+    }
+
+    // Release classifier reads waiting for I/O budget so monitors stop promptly
+    IoGovernor::disable();
+
+    {
+        std::lock_guard<std::mutex> lock(monitors_mutex_);
+        stop_file_monitoring();
+        stop_clipboard_monitoring();
+        stop_usb_monitoring();
+    }
+    if (file_index_) {
+        file_index_->close();
+    }
+    if (trace_writer_) {
+        trace_writer_->close();
+    }
+
+    // Writes a final snapshot
+    if (metrics_exporter_) {
+        metrics_exporter_->stop();
+    }
+}
+
+void Agent::start_metrics_export(const Config& config) {
+    Metrics::Format format = Metrics::Format::PROMETHEUS;
+    Metrics::parse_format(config.get_metrics_format(), format);
+
+    metrics_exporter_ = std::make_unique<MetricsExporter>(
+        config.get_metrics_path(), format, std::chrono::seconds(config.get_metrics_interval_seconds()),
+        [this]() {
+            update_metric_gauges();
+        }
+    );
+    metrics_exporter_->start();
+}
+
+// Levels owned by other components, sampled before each export
+void Agent::update_metric_gauges() {
+    static Gauge& uplink_queue = Metrics::gauge("cybersentinel_uplink_queue_requests",
+                                                "HTTP requests waiting for a connection.");
+    static Gauge& open_circuits = Metrics::gauge("cybersentinel_open_circuits",
+                                                 "Endpoints whose circuit breaker is open.");
+    static Gauge& spool_bytes = Metrics::gauge("cybersentinel_spool_bytes",
+                                               "Events spooled on disk for later delivery, in bytes.");
+    static Gauge& removable_volumes = Metrics::gauge("cybersentinel_removable_volumes",
+                                                     "Removable volumes being watched.");
+
+    uplink_queue.set(static_cast<int64_t>(http_client_->queued_requests()));
+    int64_t open = 0;
+    for (const auto& entry : http_client_->circuit_stats()) {
+        open += entry.second.state == CircuitBreaker::State::OPEN;
+    }
+    open_circuits.set(open);
+    spool_bytes.set(spool_ ? static_cast<int64_t>(spool_->size_bytes()) : 0);
+
+    std::lock_guard<std::mutex> lock(monitors_mutex_);
+    removable_volumes.set(volume_watcher_ ? static_cast<int64_t>(volume_watcher_->attached_count()) : 0);
+}
+
+// The start/stop helpers run with monitors_mutex_ held
+
+bool Agent::start_file_monitoring(const Config& config) {
+    file_monitor_ = std::make_unique<FileMonitor>(
+        config.get_monitored_paths(),
+        [this](const std::string& path, const std::string& event_type) {
+            handle_file_event(path, event_type);
+        },
+        file_index_.get()
+    );
+
+    if (!file_monitor_->start()) {
+        Logger::error("Failed to start file monitor");
+        file_monitor_.reset();
+        return false;
+    }
+    Logger::info("File monitoring started");
+
+    start_baseline_crawl(config);
+    return true;
+}
+
+// Classify files that were already there; the watcher is running, so changes
+// made during the crawl are not missed. The checkpoint makes a restarted
+// crawl skip finished directories and crawl newly added roots in full.
+void Agent::start_baseline_crawl(const Config& config) {
+    if (!config.is_baseline_scan_enabled()) {
+        return;
+    }
+
+    BaselineCrawler::Options options;
+    options.threads = config.get_baseline_threads();
+    options.max_files_per_sec = config.get_baseline_max_files_per_sec();
+    options.max_mb_per_sec = config.get_baseline_max_mb_per_sec();
+    options.checkpoint_path = config.get_baseline_checkpoint_file();
+    options.rules_version = pipeline_->rules_version();
+
+    baseline_crawler_ = std::make_unique<BaselineCrawler>(
+        config.get_monitored_paths(),
+        [this](const std::string& path, const std::string& event_type) {
+            handle_file_event(path, event_type);
+        },
+        file_index_.get(),
+        options
+    );
+    baseline_crawler_->start();
+}
+
+void Agent::stop_file_monitoring() {
+    if (baseline_crawler_) {
+        baseline_crawler_->stop();
+        baseline_crawler_.reset();
+    }
     if (file_monitor_) {
         file_monitor_->stop();
+        file_monitor_.reset();
     }
+}
+
+bool Agent::start_clipboard_monitoring(const Config& config) {
+    ClipboardDispatcher::Options options;
+    options.dedup_entries = static_cast<size_t>((std::max)(0, config.get_clipboard_dedup_entries()));
+    options.dedup_window = std::chrono::seconds(config.get_clipboard_dedup_window_seconds());
+
+    clipboard_monitor_ = std::make_unique<ClipboardMonitor>(
+        [this](const std::string& content) {
+            handle_clipboard_event(content);
+        },
+        static_cast<size_t>((std::max)(1, config.get_clipboard_max_capture_kb())) * 1024,
+        options
+    );
+
+    if (!clipboard_monitor_->start()) {
+        Logger::error("Failed to start clipboard monitor");
+        clipboard_monitor_.reset();
+        return false;
+    }
+    Logger::info("Clipboard monitoring started");
+    return true;
+}
+
+void Agent::stop_clipboard_monitoring() {
     if (clipboard_monitor_) {
         clipboard_monitor_->stop();
+        clipboard_monitor_.reset();
+    }
+}
+
+bool Agent::start_usb_monitoring(const Config& config) {
+    // Files copied to a removable volume are watched while it is mounted
+    if (config.is_removable_watch_enabled()) {
+        RemovableVolumeWatcher::Options options;
+        options.scan_existing = config.is_removable_scan_enabled();
+        options.scan_threads = config.get_removable_scan_threads();
+        options.scan_max_files_per_sec = config.get_removable_scan_max_files_per_sec();
+        options.scan_max_mb_per_sec = config.get_removable_scan_max_mb_per_sec();
+
+        volume_watcher_ = std::make_unique<RemovableVolumeWatcher>(
+            [this](const std::string& path, const std::string& event_type, const VolumeInfo& volume) {
+                handle_volume_file_event(path, event_type, volume);
+            },
+            file_index_.get(),
+            options
+        );
+    }
+
+    usb_monitor_ = std::make_unique<USBMonitor>(
+        [this](const VolumeInfo& volume) {
+            handle_usb_event(volume);
+        },
+        [this](const VolumeInfo& volume) {
+            handle_usb_removal(volume);
+        }
+    );
+
+    if (!usb_monitor_->start()) {
+        Logger::error("Failed to start USB monitor");
+        usb_monitor_.reset();
+        volume_watcher_.reset();
+        return false;
     }
+    Logger::info("USB monitoring started");
+    return true;
+}
+
+// The USB monitor's thread uses volume_watcher_, so it goes first
+void Agent::stop_usb_monitoring() {
     if (usb_monitor_) {
         usb_monitor_->stop();
+        usb_monitor_.reset();
+    }
+    if (volume_watcher_) {
+        volume_watcher_->detach_all();
+        volume_watcher_.reset();
+    }
+}
+
+// On the config watcher's thread. Policy rules are swapped in and monitors
+// whose settings changed are adjusted in place where they support it
+// (watched paths) and restarted otherwise; the uplink, spool, index and trace are set up once and keep
+// their settings until the agent restarts.
+void Agent::apply_config(const Config& previous, const Config& current) {
+    apply_log_rotation(current);
+    apply_io_limits(current);
+
+    // Handlers switch to the new rules with their next event
+    bool policy_changed = false;
+    if (current.get_policy_rules() != previous.get_policy_rules()) {
+        if (auto policy = compile_policy(current)) {
+            pipeline_->set_policy(std::move(policy));
+            policy_changed = true;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(monitors_mutex_);
+
+        bool file_enabled = current.is_file_monitoring_enabled();
+        if (file_enabled != previous.is_file_monitoring_enabled()) {
+            if (file_enabled) {
+                start_file_monitoring(current);
+            } else {
+                stop_file_monitoring();
+                Logger::info("File monitoring stopped");
+            }
+        } else if (file_enabled && file_monitor_) {
+            bool paths_changed = current.get_monitored_paths() != previous.get_monitored_paths();
+            if (paths_changed) {
+                file_monitor_->update_paths(current.get_monitored_paths());
+            }
+
+            bool crawl_changed = current.is_baseline_scan_enabled() != previous.is_baseline_scan_enabled() ||
+                                 current.get_baseline_threads() != previous.get_baseline_threads() ||
+                                 current.get_baseline_max_files_per_sec() != previous.get_baseline_max_files_per_sec() ||
+                                 current.get_baseline_max_mb_per_sec() != previous.get_baseline_max_mb_per_sec() ||
+                                 current.get_baseline_checkpoint_file() != previous.get_baseline_checkpoint_file();
+            if (paths_changed || crawl_changed) {
+                if (baseline_crawler_) {
+                    baseline_crawler_->stop();
+                    baseline_crawler_.reset();
+                }
+                start_baseline_crawl(current);
+            } else if (policy_changed && baseline_crawler_) {
+                // Files that have not changed were decided under the old
+                // rules; crawl them all again under the new version
+                Logger::info("Policy changed, restarting the baseline crawl");
+                baseline_crawler_->restart(pipeline_->rules_version());
+            }
+        }
+
+        bool clipboard_enabled = current.is_clipboard_monitoring_enabled();
+        bool clipboard_changed = current.get_clipboard_max_capture_kb() != previous.get_clipboard_max_capture_kb() ||
+                                 current.get_clipboard_dedup_entries() != previous.get_clipboard_dedup_entries() ||
+                                 current.get_clipboard_dedup_window_seconds() !=
+                                     previous.get_clipboard_dedup_window_seconds();
+        if (clipboard_enabled != previous.is_clipboard_monitoring_enabled() || (clipboard_enabled && clipboard_changed)) {
+            stop_clipboard_monitoring();
+            if (clipboard_enabled) {
+                start_clipboard_monitoring(current);
+            } else {
+                Logger::info("Clipboard monitoring stopped");
+            }
+        }
+
+        bool usb_enabled = current.is_usb_monitoring_enabled();
+        bool usb_changed = current.is_removable_watch_enabled() != previous.is_removable_watch_enabled() ||
+                           current.is_removable_scan_enabled() != previous.is_removable_scan_enabled() ||
+                           current.get_removable_scan_threads() != previous.get_removable_scan_threads() ||
+                           current.get_removable_scan_max_files_per_sec() !=
+                               previous.get_removable_scan_max_files_per_sec() ||
+                           current.get_removable_scan_max_mb_per_sec() != previous.get_removable_scan_max_mb_per_sec();
+        if (usb_enabled != previous.is_usb_monitoring_enabled() || (usb_enabled && usb_changed)) {
+            // Mounted volumes are reported again as the monitor starts
+            stop_usb_monitoring();
+            if (usb_enabled) {
+                start_usb_monitoring(current);
+            } else {
+                Logger::info("USB monitoring stopped");
+            }
+        }
+    }
+
+    if (current.is_metrics_enabled() != previous.is_metrics_enabled() ||
+        current.get_metrics_path() != previous.get_metrics_path() ||
+        current.get_metrics_format() != previous.get_metrics_format() ||
+        current.get_metrics_interval_seconds() != previous.get_metrics_interval_seconds()) {
+        if (metrics_exporter_) {
+            metrics_exporter_->stop();
+            metrics_exporter_.reset();
+        }
+        if (current.is_metrics_enabled()) {
+            start_metrics_export(current);
+        } else {
+            Logger::info("Metrics export stopped");
+        }
+    }
+
+    std::vector<std::string> restart_required;
+    if (current.get_server_url() != previous.get_server_url()) {
+        restart_required.push_back("server_url");
+    }
+    if (current.get_agent_id() != previous.get_agent_id()) {
+        restart_required.push_back("agent_id");
+    }
+    if (current.is_http2_enabled() != previous.is_http2_enabled() ||
+        current.get_uplink_encoding() != previous.get_uplink_encoding() ||
+        current.get_retry_attempts() != previous.get_retry_attempts() ||
+        current.get_retry_base_ms() != previous.get_retry_base_ms() ||
+        current.get_breaker_failure_threshold() != previous.get_breaker_failure_threshold() ||
+        current.get_breaker_open_seconds() != previous.get_breaker_open_seconds()) {
+        restart_required.push_back("uplink");
+    }
+    if (current.is_spool_enabled() != previous.is_spool_enabled() ||
+        current.get_spool_directory() != previous.get_spool_directory() ||
+        current.get_spool_max_size_mb() != previous.get_spool_max_size_mb() ||
+        current.get_spool_replay_rate() != previous.get_spool_replay_rate()) {
+        restart_required.push_back("spool");
+    }
+    if (current.get_file_state_index_path() != previous.get_file_state_index_path()) {
+        restart_required.push_back("file_state_index");
+    }
+    if (current.is_event_trace_enabled() != previous.is_event_trace_enabled() ||
+        current.get_event_trace_directory() != previous.get_event_trace_directory() ||
+        current.is_event_trace_content_enabled() != previous.is_event_trace_content_enabled()) {
+        restart_required.push_back("event_trace");
+    }
+    if (current.is_config_reload_enabled() != previous.is_config_reload_enabled()) {
+        restart_required.push_back("config_reload.enabled");
+    }
+
+    if (!restart_required.empty()) {
+        std::string names;
+        for (const auto& name : restart_required) {
+            names += (names.empty() ? "" : ", ") + name;
+        }
+        Logger::warning("Configuration changes take effect after a restart: " + names);
     }
 }
 
@@ -135,25 +569,35 @@ bool Agent::register_agent() {
     Logger::info("Registering agent with server...");
 
     // Build registration payload
-    std::ostringstream payload;
-    payload << "{"
-            << "\"agent_id\":\"" << agent_id_ << "\","
-            << "\"agent_name\":\"" << hostname_ << "\","
-            << "\"hostname\":\"" << hostname_ << "\","
-            << "\"os_type\":\"windows\","
-            << "\"os_version\":\"" << os_version_ << "\","
-            << "\"ip_address\":\"" << ip_address_ << "\","
-            << "\"agent_version\":\"1.0.0\","
-            << "\"capabilities\":{"
-            << "\"file_monitoring\":" << (config_->is_file_monitoring_enabled() ? "true" : "false") << ","
-            << "\"clipboard_monitoring\":" << (config_->is_clipboard_monitoring_enabled() ? "true" : "false") << ","
-            << "\"usb_monitoring\":" << (config_->is_usb_monitoring_enabled() ? "true" : "false")
-            << "}}";
-
-    auto response = http_client_->post("/agents", payload.str());
+    AgentRegistration registration;
+    registration.agent_id = agent_id_;
+    registration.agent_name = hostname_;
+    registration.hostname = hostname_;
+    registration.os_type = "windows";
+    registration.os_version = os_version_;
+    registration.ip_address = ip_address_;
+    registration.agent_version = "1.0.0";
+    registration.capabilities.file_monitoring = config().is_file_monitoring_enabled();
+    registration.capabilities.clipboard_monitoring = config().is_clipboard_monitoring_enabled();
+    registration.capabilities.usb_monitoring = config().is_usb_monitoring_enabled();
+    registration.offer_cbor = (config().get_uplink_encoding() == "cbor");
+
+    // Registration itself is always JSON; it is where the encoding is negotiated
+    std::string& payload = encode_payload(WireFormat::JSON, registration);
+
+    auto response = http_client_->post("/agents", payload);
 
     if (response.status_code == 200 || response.status_code == 201) {
         Logger::info("Agent registered successfully");
+
+        reporter_->set_wire_format(WireFormat::JSON);
+        if (registration.offer_cbor) {
+            auto body = nlohmann::json::parse(response.body, nullptr, false);
+            if (body.is_object() && body.value("encoding", "") == "cbor") {
+                reporter_->set_wire_format(WireFormat::CBOR);
+                Logger::info("Server accepted CBOR uplink encoding");
+            }
+        }
         return true;
     } else {
         Logger::error("Agent registration failed: HTTP " + std::to_string(response.status_code));
@@ -161,57 +605,16 @@ bool Agent::register_agent() {
     }
 }
 
-void Agent::send_heartbeat() {
-    std::ostringstream payload;
-    payload << "{"
-            << "\"agent_id\":\"" << agent_id_ << "\","
-            << "\"status\":\"online\"}";
-
-    auto response = http_client_->put("/agents/" + agent_id_ + "/heartbeat", payload.str());
-
-    if (response.status_code != 200) {
-        Logger::warning("Heartbeat failed: HTTP " + std::to_string(response.status_code));
-    }
+bool Agent::send_heartbeat() {
+    AgentHealth health = collect_health();
+    return reporter_->send_heartbeat("online", &health);
 }
 
 void Agent::report_event(const std::string& event_type,
                         const std::string& severity,
                         const std::string& file_path,
-                        const std::string& classification) {
-    // Generate event ID
-    auto now = std::chrono::system_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()).count();
-
-    std::ostringstream event_id;
-    event_id << "evt-" << agent_id_ << "-" << ms;
-
-    // Build event payload
-    std::ostringstream payload;
-    payload << "{"
-            << "\"event_id\":\"" << event_id.str() << "\","
-            << "\"event_type\":\"" << event_type << "\","
-            << "\"severity\":\"" << severity << "\","
-            << "\"agent_id\":\"" << agent_id_ << "\","
-            << "\"source_type\":\"endpoint\"";
-
-    if (!file_path.empty()) {
-        payload << ",\"file_path\":\"" << file_path << "\"";
-    }
-
-    if (!classification.empty()) {
-        payload << ",\"classification\":" << classification;
-    }
-
-    payload << "}";
-
-    auto response = http_client_->post("/events", payload.str());
-
-    if (response.status_code == 200 || response.status_code == 201) {
-        Logger::info("Event reported: " + event_type);
-    } else {
-        Logger::error("Failed to report event: HTTP " + std::to_string(response.status_code));
-    }
+                        const ClassificationResult* classification) {
+    reporter_->report(event_type, severity, file_path, classification);
 }
 
 void Agent::initialize_system_info() {
@@ -225,7 +628,7 @@ void Agent::initialize_system_info() {
     }
 
     // Agent ID from config or generate
-    agent_id_ = config_->get_agent_id();
+    agent_id_ = config().get_agent_id();
     if (agent_id_ == "CHANGE_THIS_TO_UNIQUE_ID") {
         agent_id_ = "WIN-" + hostname_;
     }
@@ -252,62 +655,195 @@ void Agent::initialize_system_info() {
     Logger::info("System Info: " + hostname_ + " (" + os_version_ + ")");
 }
 
+void Agent::registration_loop() {
+    int attempt = 0;
+
+    while (running_ && !register_agent()) {
+        auto delay = jittered_backoff(attempt++, std::chrono::seconds(2), std::chrono::minutes(5));
+        Logger::warning("Registration failed, retrying in " + std::to_string(delay.count() / 1000) +
+                        "s; events are buffered locally");
+        sleep_while_running(delay);
+    }
+
+    if (!running_) {
+        return;
+    }
+
+    registered_ = true;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+    Logger::info("Registered " + std::to_string(elapsed.count()) + " ms after startup (" +
+                 std::to_string(attempt + 1) + " attempts)");
+
+    reporter_->resume_delivery();
+}
+
 void Agent::heartbeat_loop() {
-    int interval = config_->get_heartbeat_interval();
+    HeartbeatScheduler scheduler(std::chrono::seconds(config().get_heartbeat_interval()),
+                                 std::chrono::seconds(config().get_heartbeat_min_interval()),
+                                 std::chrono::seconds(config().get_heartbeat_max_interval()));
+    uint64_t config_version = config_store_.version();
+    uint64_t dropped_at_last_heartbeat = 0;
+    uint64_t spooled_at_last_heartbeat = 0;
 
     while (running_) {
-        send_heartbeat();
-        std::this_thread::sleep_for(std::chrono::seconds(interval));
+        if (config_store_.version() != config_version) {
+            config_version = config_store_.version();
+            scheduler.set_intervals(std::chrono::seconds(config().get_heartbeat_interval()),
+                                    std::chrono::seconds(config().get_heartbeat_min_interval()),
+                                    std::chrono::seconds(config().get_heartbeat_max_interval()));
+        }
+
+        // The server does not know this agent until registration completes
+        if (!registered_) {
+            sleep_while_running(std::chrono::seconds(1));
+            continue;
+        }
+
+        // Degraded: events lost or the backlog growing since the last
+        // heartbeat. A server refusing requests fails the heartbeats too,
+        // and the scheduler backs off.
+        auto stats = reporter_->stats();
+        uint64_t spooled = spool_ ? spool_->size_bytes() : 0;
+        bool degraded = stats.events_dropped > dropped_at_last_heartbeat ||
+                        spooled > spooled_at_last_heartbeat;
+
+        auto now = std::chrono::steady_clock::now();
+        if (scheduler.due(now, reporter_->last_contact(), degraded)) {
+            dropped_at_last_heartbeat = stats.events_dropped;
+            spooled_at_last_heartbeat = spooled;
+            scheduler.record_sent(now, send_heartbeat());
+        }
+
+        sleep_while_running(std::chrono::seconds(1));
     }
+
+    Logger::info("Heartbeats sent: " + std::to_string(scheduler.sent()) +
+                 ", skipped while uplink was active: " + std::to_string(scheduler.skipped()));
 }
 
-void Agent::handle_file_event(const std::string& file_path,
-                               const std::string& event_type) {
-    Logger::debug("File event: " + event_type + " - " + file_path);
-
-    // Classify file content
-    Classifier classifier;
-    auto result = classifier.classify_file(file_path);
-
-    if (!result.labels.empty()) {
-        // Sensitive data detected
-        std::ostringstream classification;
-        classification << "{\"labels\":[";
-        for (size_t i = 0; i < result.labels.size(); ++i) {
-            if (i > 0) classification << ",";
-            classification << "\"" << result.labels[i] << "\"";
+AgentHealth Agent::collect_health() {
+    AgentHealth health;
+
+    auto stats = reporter_->stats();
+    health.events_reported = stats.events_reported;
+    health.events_spooled = stats.events_spooled;
+    health.events_dropped = stats.events_dropped;
+
+    if (spool_) {
+        health.spool_bytes = spool_->size_bytes();
+        health.spool_evicted_bytes = spool_->evicted_bytes();
+    }
+
+    health.uplink_queue = http_client_->queued_requests();
+    for (const auto& entry : http_client_->circuit_stats()) {
+        if (entry.second.state == CircuitBreaker::State::OPEN) {
+            ++health.open_circuits;
         }
-        classification << "],\"confidence\":" << result.confidence << "}";
+    }
 
-        std::string severity = (result.confidence > 0.8) ? "critical" : "high";
+    std::unique_lock<std::mutex> monitors_lock(monitors_mutex_);
+    if (file_monitor_) {
+        auto rescan = file_monitor_->rescan_stats();
+        health.watcher_overflows = rescan.overflows;
+        health.rescans = rescan.rescans;
+        health.rescan_files_examined = rescan.files_examined;
+        health.rescan_files_changed = rescan.files_changed;
+        health.rescan_ms = rescan.rescan_ms;
+    }
 
-        report_event("file_" + event_type, severity, file_path, classification.str());
+    if (volume_watcher_) {
+        health.removable_volumes = volume_watcher_->attached_count();
     }
+    monitors_lock.unlock();
+
+    auto io = IoGovernor::stats();
+    health.io_throttled_reads = io.throttled_reads;
+    health.io_throttle_ms = io.throttle_wait_ms;
+
+    // Scan throughput over the period since the previous heartbeat
+    auto now = std::chrono::steady_clock::now();
+    health.files_scanned = pipeline_->files_scanned();
+    if (heartbeat_time_ != std::chrono::steady_clock::time_point()) {
+        double elapsed = std::chrono::duration<double>(now - heartbeat_time_).count();
+        if (elapsed > 0) {
+            health.scan_rate = (health.files_scanned - heartbeat_files_scanned_) / elapsed;
+        }
+    }
+    heartbeat_files_scanned_ = health.files_scanned;
+    heartbeat_time_ = now;
+
+    return health;
+}
+
+void Agent::sleep_while_running(std::chrono::milliseconds duration) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    while (running_ && std::chrono::steady_clock::now() < deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        std::this_thread::sleep_for((std::min)(remaining, std::chrono::milliseconds(100)));
+    }
+}
+
+void Agent::note_monitored_event() {
+    if (first_event_seen_.exchange(true)) {
+        return;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time_);
+    Logger::info("First monitored event " + std::to_string(elapsed.count()) +
+                 " ms after startup (" + (registered_ ? "registered" : "not yet registered") + ")");
+}
+
+void Agent::handle_file_event(const std::string& file_path,
+                               const std::string& event_type) {
+    note_monitored_event();
+    if (trace_writer_) {
+        trace_writer_->record_file(file_path, event_type);
+    }
+    pipeline_->handle_file_event(file_path, event_type);
 }
 
 void Agent::handle_clipboard_event(const std::string& content) {
-    Logger::debug("Clipboard event detected");
-
-    // Classify clipboard content
-    Classifier classifier;
-    auto result = classifier.classify_text(content);
-
-    if (!result.labels.empty()) {
-        std::ostringstream classification;
-        classification << "{\"labels\":[";
-        for (size_t i = 0; i < result.labels.size(); ++i) {
-            if (i > 0) classification << ",";
-            classification << "\"" << result.labels[i] << "\"";
-        }
-        classification << "],\"confidence\":" << result.confidence << "}";
+    note_monitored_event();
+    if (trace_writer_) {
+        trace_writer_->record_clipboard(content);
+    }
+    pipeline_->handle_clipboard_event(content);
+}
+
+void Agent::handle_usb_event(const VolumeInfo& volume) {
+    note_monitored_event();
+    if (trace_writer_) {
+        trace_writer_->record_usb(volume.root, "connected");
+    }
+    pipeline_->handle_usb_event(volume);
 
-        report_event("clipboard_copy", "medium", "", classification.str());
+    if (volume_watcher_) {
+        volume_watcher_->attach(volume);
     }
 }
 
-void Agent::handle_usb_event(const std::string& device_name) {
-    Logger::info("USB device connected: " + device_name);
-    report_event("usb_connected", "medium");
+void Agent::handle_usb_removal(const VolumeInfo& volume) {
+    if (volume_watcher_) {
+        volume_watcher_->detach(volume.root);
+    }
+
+    if (trace_writer_) {
+        trace_writer_->record_usb(volume.root, "removed");
+    }
+    pipeline_->handle_usb_removal(volume);
+}
+
+void Agent::handle_volume_file_event(const std::string& file_path,
+                                     const std::string& event_type,
+                                     const VolumeInfo& volume) {
+    note_monitored_event();
+    if (trace_writer_) {
+        trace_writer_->record_file(file_path, event_type);
+    }
+    pipeline_->handle_file_event(file_path, event_type, &volume);
 }
 
 } // namespace cybersentinel
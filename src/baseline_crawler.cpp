@@ -0,0 +1,463 @@
+#include "baseline_crawler.h"
+#include "logger.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+static const char* kCheckpointMagic = "cybersentinel-baseline 2";
+static const auto kCheckpointInterval = std::chrono::seconds(10);
+
+static void sync_file(std::FILE* file) {
+    std::fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+static bool is_under(const std::string& path, const std::string& root) {
+    return path.compare(0, root.size(), root) == 0 &&
+           (path.size() == root.size() || path[root.size()] == kPathSeparator);
+}
+
+// Paths in the checkpoint are one per line; a name may contain a newline
+// (or a carriage return, which getline would keep), so those and the escape
+// character itself are percent-encoded
+static std::string escape_path(const std::string& path) {
+    std::string escaped;
+    escaped.reserve(path.size());
+    for (char c : path) {
+        if (c == '%') {
+            escaped += "%25";
+        } else if (c == '\n') {
+            escaped += "%0A";
+        } else if (c == '\r') {
+            escaped += "%0D";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static bool unescape_path(const std::string& escaped, std::string& path) {
+    path.clear();
+    for (size_t i = 0; i < escaped.size(); ++i) {
+        if (escaped[i] != '%') {
+            path += escaped[i];
+            continue;
+        }
+        std::string code = escaped.substr(i + 1, 2);
+        if (code == "25") {
+            path += '%';
+        } else if (code == "0A") {
+            path += '\n';
+        } else if (code == "0D") {
+            path += '\r';
+        } else {
+            return false;
+        }
+        i += 2;
+    }
+    return true;
+}
+
+BaselineCrawler::BaselineCrawler(const std::vector<std::string>& paths, FileEventCallback callback,
+                                 FileStateIndex* index, const Options& options)
+    : monitored_paths_(paths), callback_(callback), index_(index), options_(options),
+      file_rate_(options.max_files_per_sec),
+      byte_rate_(options.max_mb_per_sec * 1024 * 1024) {
+}
+
+BaselineCrawler::~BaselineCrawler() {
+    stop();
+}
+
+bool BaselineCrawler::start() {
+    return start_workers(true);
+}
+
+void BaselineCrawler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    bool complete;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        complete = complete_;
+    }
+
+    if (!complete) {
+        save_checkpoint();
+        Logger::info("Baseline crawl stopped with " + std::to_string(stats().pending_directories) +
+                     " directories pending");
+    }
+}
+
+void BaselineCrawler::restart(uint32_t rules_version) {
+    stop();
+
+    options_.rules_version = rules_version;
+    skip_unchanged_ = false;
+    if (!options_.checkpoint_path.empty()) {
+        std::error_code ec;
+        fs::remove(options_.checkpoint_path, ec);
+    }
+
+    start_workers(false);
+}
+
+bool BaselineCrawler::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() {
+        return complete_ || !running_;
+    });
+    return complete_;
+}
+
+BaselineCrawler::Stats BaselineCrawler::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.pending_directories = queue_.size() + in_progress_.size();
+    stats.complete = complete_;
+    if (!complete_ && start_time_ != std::chrono::steady_clock::time_point()) {
+        stats.elapsed_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time_).count());
+    }
+    return stats;
+}
+
+bool BaselineCrawler::start_workers(bool resume) {
+    std::vector<std::string> roots;
+    for (const auto& path : monitored_paths_) {
+        roots.push_back(FileMonitor::expand_path(path));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        Logger::warning("Baseline crawl already running");
+        return true;
+    }
+
+    queue_.clear();
+    in_progress_.clear();
+    roots_.clear();
+    complete_ = false;
+    stats_ = Stats();
+    start_time_ = std::chrono::steady_clock::now();
+    checkpoint_time_ = start_time_;
+
+    bool resumed = resume && load_checkpoint(roots);
+
+    // Paths added to the configuration since the checkpoint are crawled in full
+    for (const auto& root : roots) {
+        if (std::find(roots_.begin(), roots_.end(), root) == roots_.end()) {
+            roots_.push_back(root);
+            queue_.push_back(PendingDirectory{root, false});
+        }
+    }
+
+    if (queue_.empty()) {
+        complete_ = true;
+        Logger::info("Baseline crawl already complete for the monitored paths");
+        return true;
+    }
+
+    if (resumed) {
+        Logger::info("Resuming baseline crawl: " + std::to_string(queue_.size()) + " directories pending");
+    } else {
+        Logger::info("Starting baseline crawl of " + std::to_string(roots_.size()) + " paths");
+    }
+
+    running_ = true;
+    int threads = (std::max)(1, options_.threads);
+    for (int i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() {
+            worker_loop();
+        });
+    }
+    return true;
+}
+
+void BaselineCrawler::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (running_) {
+        cv_.wait(lock, [this]() {
+            return !running_ || !queue_.empty() || in_progress_.empty();
+        });
+
+        // Nothing queued and nothing in progress: the crawl is done
+        if (!running_ || queue_.empty()) {
+            break;
+        }
+
+        PendingDirectory directory = std::move(queue_.front());
+        queue_.pop_front();
+        in_progress_[directory.path] = directory.files_only;
+
+        lock.unlock();
+        crawl_directory(directory);
+        lock.lock();
+
+        // Interrupted directories stay in progress for the checkpoint
+        if (!running_) {
+            break;
+        }
+
+        in_progress_.erase(directory.path);
+        ++stats_.directories;
+
+        auto now = std::chrono::steady_clock::now();
+        if (queue_.empty() && in_progress_.empty()) {
+            complete_ = true;
+            stats_.elapsed_ms = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time_).count());
+            Stats done = stats_;
+            lock.unlock();
+            cv_.notify_all();
+
+            save_checkpoint();
+            double seconds = (std::max)(done.elapsed_ms / 1000.0, 0.001);
+            Logger::info("Baseline crawl complete: " + std::to_string(done.files_found) + " files in " +
+                         std::to_string(done.directories) + " directories, " +
+                         std::to_string(done.files_classified) + " classified, " +
+                         std::to_string(done.files_unchanged) + " unchanged, " +
+                         std::to_string(static_cast<uint64_t>(done.files_found / seconds)) + " files/sec");
+            return;
+        }
+
+        if (now - checkpoint_time_ >= kCheckpointInterval) {
+            checkpoint_time_ = now;
+            lock.unlock();
+            save_checkpoint();
+            lock.lock();
+        }
+    }
+}
+
+void BaselineCrawler::crawl_directory(const PendingDirectory& directory) {
+    std::vector<std::string> files;
+    std::vector<std::string> subdirectories;
+
+    // List in one pass so the directory handle is closed before any file is read
+    {
+        std::error_code ec;
+        fs::directory_iterator it(path_from_utf8(directory.path), fs::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            CS_LOG_DEBUG("Baseline crawl cannot list directory", kv("path", directory.path), kv("error", ec.message()));
+        }
+
+        for (; !ec && it != fs::directory_iterator(); it.increment(ec)) {
+            std::error_code entry_ec;
+
+            // Links are not followed: they lead out of the tree or into cycles
+            if (it->is_symlink(entry_ec)) {
+                continue;
+            }
+            if (it->is_directory(entry_ec)) {
+                if (!directory.files_only) {
+                    subdirectories.push_back(path_to_utf8(it->path()));
+                }
+            } else if (it->is_regular_file(entry_ec)) {
+                files.push_back(path_to_utf8(it->path()));
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& subdirectory : subdirectories) {
+            queue_.push_back(PendingDirectory{std::move(subdirectory), false});
+        }
+        in_progress_[directory.path] = true;
+        stats_.files_found += files.size();
+    }
+    if (!subdirectories.empty()) {
+        cv_.notify_all();
+    }
+
+    for (const auto& path : files) {
+        if (!running_) {
+            return;
+        }
+
+        // Vanished since listing; the file monitor reports the deletion
+        FileState state;
+        if (!FileStateIndex::stat(path, state)) {
+            continue;
+        }
+
+        FileState indexed;
+        if (skip_unchanged_ && index_ && index_->lookup(path, indexed) && indexed == state &&
+            indexed.rules_version == options_.rules_version) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.files_unchanged;
+            continue;
+        }
+
+        throttle(state.size);
+        if (!running_) {
+            return;
+        }
+
+        if (callback_) {
+            callback_(path, "baseline");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.files_classified;
+        stats_.bytes_classified += state.size;
+    }
+}
+
+void BaselineCrawler::throttle(uint64_t bytes) {
+    auto delay = (std::max)(file_rate_.take(1.0), byte_rate_.take(static_cast<double>(bytes)));
+    if (delay.count() <= 0) {
+        return;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + delay;
+    while (running_ && std::chrono::steady_clock::now() < deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        std::this_thread::sleep_for((std::min)(remaining, std::chrono::microseconds(100000)));
+    }
+}
+
+// Checkpoint file:
+//
+//   cybersentinel-baseline 2 <rules version>
+//   complete 0|1
+//   root <path>      one per crawled root
+//   dir <path>       not yet listed
+//   files <path>     listed, subdirectories queued, files not all classified
+//
+// Paths are escaped with escape_path(). A version 1 checkpoint wrote them
+// raw; it is treated like one for other rules and the crawl starts over.
+
+bool BaselineCrawler::load_checkpoint(const std::vector<std::string>& roots) {
+    if (options_.checkpoint_path.empty()) {
+        return false;
+    }
+
+    std::ifstream file(options_.checkpoint_path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(file, line) ||
+        line != std::string(kCheckpointMagic) + " " + std::to_string(options_.rules_version)) {
+        Logger::info("Baseline checkpoint is from other classification rules, crawling again");
+        return false;
+    }
+
+    auto configured = [&roots](const std::string& path) {
+        return std::any_of(roots.begin(), roots.end(), [&path](const std::string& root) {
+            return is_under(path, root);
+        });
+    };
+
+    while (std::getline(file, line)) {
+        size_t space = line.find(' ');
+        if (space == std::string::npos) {
+            continue;
+        }
+        std::string kind = line.substr(0, space);
+        std::string path;
+        if (kind == "complete") {
+            continue;
+        }
+        if (!unescape_path(line.substr(space + 1), path)) {
+            Logger::warning("Ignoring damaged baseline checkpoint entry: " + line);
+            continue;
+        }
+
+        // Entries for paths no longer monitored are dropped
+        if (!configured(path)) {
+            continue;
+        }
+
+        if (kind == "root") {
+            roots_.push_back(path);
+        } else if (kind == "dir" || kind == "files") {
+            queue_.push_back(PendingDirectory{path, kind == "files"});
+        }
+    }
+
+    return true;
+}
+
+void BaselineCrawler::save_checkpoint() {
+    if (options_.checkpoint_path.empty()) {
+        return;
+    }
+
+    // Serialised so an older snapshot never replaces a newer one
+    std::lock_guard<std::mutex> checkpoint_lock(checkpoint_mutex_);
+
+    std::ostringstream content;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        content << kCheckpointMagic << " " << options_.rules_version << "\n";
+        content << "complete " << (complete_ ? 1 : 0) << "\n";
+        for (const auto& root : roots_) {
+            content << "root " << escape_path(root) << "\n";
+        }
+        for (const auto& entry : in_progress_) {
+            content << (entry.second ? "files " : "dir ") << escape_path(entry.first) << "\n";
+        }
+        for (const auto& directory : queue_) {
+            content << (directory.files_only ? "files " : "dir ") << escape_path(directory.path) << "\n";
+        }
+    }
+
+    // Write-then-rename so a crash never leaves a half-written checkpoint
+    std::string tmp_path = options_.checkpoint_path + ".tmp";
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        Logger::warning("Failed to write baseline checkpoint: " + tmp_path);
+        return;
+    }
+
+    std::string data = content.str();
+    std::fwrite(data.data(), 1, data.size(), file);
+    sync_file(file);
+    std::fclose(file);
+
+    std::error_code ec;
+    fs::rename(tmp_path, options_.checkpoint_path, ec);
+    if (ec) {
+        Logger::warning("Failed to update baseline checkpoint: " + ec.message());
+    }
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,179 @@
+#include "cbor_writer.h"
+#include "utf8.h"
+#include <cstring>
+
+namespace cybersentinel {
+
+// Major types (RFC 8949 section 3.1)
+static const uint8_t kMajorUnsigned = 0;
+static const uint8_t kMajorNegative = 1;
+static const uint8_t kMajorText = 3;
+
+// Simple values and break marker
+static const char kFalse = static_cast<char>(0xF4);
+static const char kTrue = static_cast<char>(0xF5);
+static const char kNull = static_cast<char>(0xF6);
+static const char kFloat32 = static_cast<char>(0xFA);
+static const char kFloat64 = static_cast<char>(0xFB);
+static const char kIndefiniteMap = static_cast<char>(0xBF);
+static const char kIndefiniteArray = static_cast<char>(0x9F);
+static const char kBreak = static_cast<char>(0xFF);
+
+static const char kReplacementCharacter[] = "\xEF\xBF\xBD";  // U+FFFD
+
+CborWriter::CborWriter(std::string& out)
+    : out_(out) {
+}
+
+std::string& CborWriter::thread_buffer() {
+    static thread_local std::string buffer;
+    buffer.clear();
+    return buffer;
+}
+
+void CborWriter::write_head(uint8_t major_type, uint64_t argument) {
+    uint8_t major = static_cast<uint8_t>(major_type << 5);
+
+    if (argument < 24) {
+        out_.push_back(static_cast<char>(major | argument));
+        return;
+    }
+
+    int bytes;
+    if (argument <= 0xFF) {
+        out_.push_back(static_cast<char>(major | 24));
+        bytes = 1;
+    } else if (argument <= 0xFFFF) {
+        out_.push_back(static_cast<char>(major | 25));
+        bytes = 2;
+    } else if (argument <= 0xFFFFFFFFull) {
+        out_.push_back(static_cast<char>(major | 26));
+        bytes = 4;
+    } else {
+        out_.push_back(static_cast<char>(major | 27));
+        bytes = 8;
+    }
+
+    // Network byte order
+    for (int i = bytes - 1; i >= 0; --i) {
+        out_.push_back(static_cast<char>((argument >> (8 * i)) & 0xFF));
+    }
+}
+
+void CborWriter::begin_object() {
+    out_.push_back(kIndefiniteMap);
+}
+
+void CborWriter::end_object() {
+    out_.push_back(kBreak);
+}
+
+void CborWriter::begin_array() {
+    out_.push_back(kIndefiniteArray);
+}
+
+void CborWriter::end_array() {
+    out_.push_back(kBreak);
+}
+
+void CborWriter::key(std::string_view name) {
+    write_text(name);
+}
+
+void CborWriter::value(std::string_view text) {
+    write_text(text);
+}
+
+void CborWriter::value(const char* text) {
+    if (!text) {
+        null_value();
+        return;
+    }
+    write_text(text);
+}
+
+void CborWriter::value(bool flag) {
+    out_.push_back(flag ? kTrue : kFalse);
+}
+
+void CborWriter::value(int number) {
+    value(static_cast<int64_t>(number));
+}
+
+void CborWriter::value(int64_t number) {
+    if (number >= 0) {
+        write_head(kMajorUnsigned, static_cast<uint64_t>(number));
+    } else {
+        write_head(kMajorNegative, static_cast<uint64_t>(-(number + 1)));
+    }
+}
+
+void CborWriter::value(uint64_t number) {
+    write_head(kMajorUnsigned, number);
+}
+
+void CborWriter::value(double number) {
+    // Use single precision whenever it round-trips exactly
+    float narrow = static_cast<float>(number);
+    if (static_cast<double>(narrow) == number) {
+        uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        out_.push_back(kFloat32);
+        for (int i = 3; i >= 0; --i) {
+            out_.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+        }
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    out_.push_back(kFloat64);
+    for (int i = 7; i >= 0; --i) {
+        out_.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+    }
+}
+
+void CborWriter::null_value() {
+    out_.push_back(kNull);
+}
+
+void CborWriter::write_text(std::string_view text) {
+    // Text strings must be valid UTF-8; count replacements to size the head
+    size_t invalid_bytes = 0;
+    for (size_t i = 0; i < text.size();) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t length = utf8_sequence_length(text, i);
+        if (length == 0) {
+            ++invalid_bytes;
+            ++i;
+        } else {
+            i += length;
+        }
+    }
+
+    write_head(kMajorText, text.size() + invalid_bytes * 2);
+
+    if (invalid_bytes == 0) {
+        out_.append(text.data(), text.size());
+        return;
+    }
+
+    size_t run_start = 0;
+    for (size_t i = 0; i < text.size();) {
+        size_t length = utf8_sequence_length(text, i);
+        if (length > 0) {
+            i += length;
+            continue;
+        }
+        out_.append(text.data() + run_start, i - run_start);
+        out_.append(kReplacementCharacter, 3);
+        ++i;
+        run_start = i;
+    }
+    out_.append(text.data() + run_start, text.size() - run_start);
+}
+
+} // namespace cybersentinel
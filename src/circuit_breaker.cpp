@@ -0,0 +1,144 @@
+#include "circuit_breaker.h"
+#include "logger.h"
+#include <random>
+#include <algorithm>
+
+namespace cybersentinel {
+
+std::chrono::milliseconds jittered_backoff(int attempt,
+                                           std::chrono::milliseconds base,
+                                           std::chrono::milliseconds cap) {
+    static thread_local std::mt19937_64 rng{std::random_device{}()};
+
+    // Clamp the shift so the doubling cannot overflow
+    int64_t delay = base.count() << std::min(std::max(attempt, 0), 20);
+    delay = std::min<int64_t>(delay, cap.count());
+    if (delay <= 1) {
+        return std::chrono::milliseconds(delay);
+    }
+
+    std::uniform_int_distribution<int64_t> jitter(delay / 2, delay);
+    return std::chrono::milliseconds(jitter(rng));
+}
+
+CircuitBreaker::CircuitBreaker(const std::string& name,
+                               int failure_threshold,
+                               std::chrono::milliseconds open_duration,
+                               std::chrono::milliseconds max_open_duration)
+    : name_(name),
+      failure_threshold_(std::max(1, failure_threshold)),
+      open_duration_(open_duration),
+      max_open_duration_(std::max(open_duration, max_open_duration)) {
+}
+
+bool CircuitBreaker::allow_request() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    switch (state_) {
+        case State::CLOSED:
+            return true;
+
+        case State::OPEN:
+            if (std::chrono::steady_clock::now() < open_until_) {
+                ++stats_.rejected_requests;
+                return false;
+            }
+            state_ = State::HALF_OPEN;
+            ++stats_.times_half_opened;
+            probe_in_flight_ = true;
+            Logger::info("Circuit breaker for " + name_ + " half-open, sending probe");
+            return true;
+
+        case State::HALF_OPEN:
+            // Only one probe at a time
+            if (probe_in_flight_) {
+                ++stats_.rejected_requests;
+                return false;
+            }
+            probe_in_flight_ = true;
+            return true;
+    }
+    return true;
+}
+
+void CircuitBreaker::record_success() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    consecutive_failures_ = 0;
+    if (state_ == State::CLOSED) {
+        return;
+    }
+
+    auto open_for = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - open_since_);
+    stats_.time_open += open_for;
+    ++stats_.times_closed;
+
+    state_ = State::CLOSED;
+    open_attempts_ = 0;
+    probe_in_flight_ = false;
+
+    Logger::info("Circuit breaker for " + name_ + " closed after " +
+                 std::to_string(open_for.count() / 1000) + "s open");
+}
+
+void CircuitBreaker::record_failure() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+
+    if (state_ == State::HALF_OPEN) {
+        // Probe failed: back off further before the next one
+        ++open_attempts_;
+        trip(now);
+        return;
+    }
+
+    if (state_ == State::CLOSED && ++consecutive_failures_ >= failure_threshold_) {
+        open_since_ = now;
+        open_attempts_ = 0;
+        trip(now);
+    }
+}
+
+void CircuitBreaker::release_probe() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ == State::HALF_OPEN) {
+        probe_in_flight_ = false;
+    }
+}
+
+void CircuitBreaker::trip(std::chrono::steady_clock::time_point now) {
+    // Caller holds mutex_
+    auto delay = jittered_backoff(open_attempts_, open_duration_, max_open_duration_);
+
+    state_ = State::OPEN;
+    probe_in_flight_ = false;
+    open_until_ = now + delay;
+    ++stats_.times_opened;
+
+    Logger::warning("Circuit breaker for " + name_ + " open, failing fast for " +
+                    std::to_string(delay.count()) + "ms");
+}
+
+CircuitBreaker::Stats CircuitBreaker::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Stats snapshot = stats_;
+    snapshot.state = state_;
+    if (state_ != State::CLOSED) {
+        snapshot.time_open += std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - open_since_);
+    }
+    return snapshot;
+}
+
+const char* CircuitBreaker::state_to_string(State state) {
+    switch (state) {
+        case State::CLOSED:    return "closed";
+        case State::OPEN:      return "open";
+        case State::HALF_OPEN: return "half_open";
+        default:               return "unknown";
+    }
+}
+
+} // namespace cybersentinel
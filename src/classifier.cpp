@@ -1,11 +1,17 @@
 #include "classifier.h"
 #include "logger.h"
+#include "fnv_hash.h"
+#include "io_governor.h"
+#include "metrics.h"
+#include "utf8.h"
 #include <fstream>
-#include <sstream>
 #include <algorithm>
 
 namespace cybersentinel {
 
+// Classifier reads go through the I/O governor one chunk at a time
+static const std::streamsize kReadChunkSize = 64 * 1024;
+
 Classifier::Classifier() {
     // Initialize regex patterns
 
@@ -25,17 +31,23 @@ Classifier::Classifier() {
     secret_regex_ = std::regex(R"((password|passwd|pwd|secret|token)[:\s=]+['\"]?([^\s'\";,]{8,})['\"]?)", std::regex::icase);
 }
 
-ClassificationResult Classifier::classify_file(const std::string& file_path) {
-    std::string content = read_file(file_path);
+ClassificationResult Classifier::classify_file(const std::string& file_path,
+                                               IoGovernor::Priority priority) const {
+    std::string content = read_file(file_path, priority);
 
     if (content.empty()) {
         return ClassificationResult();
     }
 
-    return classify_text(content);
+    ClassificationResult result = classify_text(content);
+    result.content_hash = fnv1a_64(content);
+    return result;
 }
 
-ClassificationResult Classifier::classify_text(const std::string& content) {
+ClassificationResult Classifier::classify_text(const std::string& content) const {
+    static Histogram& latency = Metrics::stage("classify");
+    ScopedTimer timer(latency);
+
     ClassificationResult result;
 
     // Check for credit card numbers
@@ -69,9 +81,14 @@ ClassificationResult Classifier::classify_text(const std::string& content) {
     return result;
 }
 
-std::string Classifier::read_file(const std::string& file_path) {
+std::string Classifier::read_file(const std::string& file_path, IoGovernor::Priority priority) const {
+    static Histogram& latency = Metrics::stage("sniff");
+    static Counter& bytes_read = Metrics::counter("cybersentinel_sniff_bytes_total",
+                                                  "Bytes read from files for classification.");
+    ScopedTimer timer(latency);
+
     try {
-        std::ifstream file(file_path, std::ios::binary);
+        std::ifstream file(path_from_utf8(file_path), std::ios::binary);
         if (!file.is_open()) {
             Logger::warning("Could not open file: " + file_path);
             return "";
@@ -88,9 +105,22 @@ std::string Classifier::read_file(const std::string& file_path) {
             return "";
         }
 
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
+        // Reads share a global budget so they do not starve the foreground;
+        // each chunk is paid for as it is read
+        std::string content(static_cast<size_t>((std::max)(size, std::streamsize(0))), '\0');
+        std::streamsize done = 0;
+        while (done < size) {
+            std::streamsize want = (std::min)(size - done, kReadChunkSize);
+            IoGovernor::acquire(static_cast<uint64_t>(want), priority);
+            file.read(&content[static_cast<size_t>(done)], want);
+            if (file.gcount() <= 0) {
+                break;
+            }
+            done += file.gcount();
+        }
+        content.resize(static_cast<size_t>(done));
+        bytes_read.add(content.size());
+        return content;
 
     } catch (const std::exception& e) {
         Logger::error("Error reading file " + file_path + ": " + e.what());
@@ -98,12 +128,26 @@ std::string Classifier::read_file(const std::string& file_path) {
     }
 }
 
-bool Classifier::matches_pattern(const std::string& content, const std::regex& pattern) {
+uint32_t Classifier::label_mask(const std::vector<std::string>& labels) {
+    static const char* const kLabels[] = {"PAN", "SSN", "EMAIL", "API_KEY", "SECRET"};
+
+    uint32_t mask = 0;
+    for (const auto& label : labels) {
+        for (uint32_t bit = 0; bit < sizeof(kLabels) / sizeof(kLabels[0]); ++bit) {
+            if (label == kLabels[bit]) {
+                mask |= 1u << bit;
+            }
+        }
+    }
+    return mask;
+}
+
+bool Classifier::matches_pattern(const std::string& content, const std::regex& pattern) const {
     return std::regex_search(content, pattern);
 }
 
 double Classifier::calculate_confidence(const std::string& content,
-                                       const std::vector<std::string>& labels) {
+                                       const std::vector<std::string>& labels) const {
     if (labels.empty()) {
         return 0.0;
     }
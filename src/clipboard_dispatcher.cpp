@@ -0,0 +1,146 @@
+#include "clipboard_dispatcher.h"
+#include "fnv_hash.h"
+#include "logger.h"
+
+namespace cybersentinel {
+
+ClipboardDispatcher::ClipboardDispatcher(ClipboardEventCallback callback, const Options& options)
+    : callback_(std::move(callback)), options_(options) {
+    if (options_.max_pending == 0) {
+        options_.max_pending = 1;
+    }
+}
+
+ClipboardDispatcher::~ClipboardDispatcher() {
+    stop();
+}
+
+void ClipboardDispatcher::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+
+    running_ = true;
+    worker_ = std::thread([this]() {
+        worker_loop();
+    });
+}
+
+void ClipboardDispatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        pending_.clear();
+    }
+    work_cv_.notify_all();
+
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    idle_cv_.notify_all();
+}
+
+bool ClipboardDispatcher::submit(std::string content) {
+    // Hashed outside the lock; content is capped by the capture side
+    uint64_t hash = fnv1a_64(content);
+    auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.captured;
+
+        if (is_recent_duplicate(hash, now)) {
+            ++stats_.duplicates;
+            return false;
+        }
+
+        if (pending_.size() >= options_.max_pending) {
+            // Never classified, so copying it again must not count as a duplicate
+            forget(pending_.front().hash);
+            pending_.pop_front();
+            ++stats_.dropped;
+            Logger::warning("Clipboard classification is behind, dropped the oldest pending content");
+        }
+        pending_.push_back(PendingContent{hash, std::move(content)});
+    }
+
+    work_cv_.notify_one();
+    return true;
+}
+
+bool ClipboardDispatcher::is_recent_duplicate(uint64_t hash, std::chrono::steady_clock::time_point now) {
+    if (options_.dedup_entries == 0) {
+        return false;
+    }
+
+    auto it = seen_index_.find(hash);
+    if (it != seen_index_.end()) {
+        bool recent = now - it->second->seen < options_.dedup_window;
+        it->second->seen = now;
+        seen_.splice(seen_.begin(), seen_, it->second);
+        return recent;
+    }
+
+    seen_.push_front(SeenEntry{hash, now});
+    seen_index_[hash] = seen_.begin();
+    if (seen_.size() > options_.dedup_entries) {
+        seen_index_.erase(seen_.back().hash);
+        seen_.pop_back();
+    }
+    return false;
+}
+
+void ClipboardDispatcher::forget(uint64_t hash) {
+    auto it = seen_index_.find(hash);
+    if (it != seen_index_.end()) {
+        seen_.erase(it->second);
+        seen_index_.erase(it);
+    }
+}
+
+void ClipboardDispatcher::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_cv_.wait(lock, [this]() {
+        return !running_ || (pending_.empty() && !busy_);
+    });
+}
+
+ClipboardDispatcher::Stats ClipboardDispatcher::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void ClipboardDispatcher::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        work_cv_.wait(lock, [this]() {
+            return !running_ || !pending_.empty();
+        });
+        if (!running_) {
+            break;
+        }
+
+        std::string content = std::move(pending_.front().text);
+        pending_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        if (callback_) {
+            callback_(content);
+        }
+
+        lock.lock();
+        busy_ = false;
+        ++stats_.delivered;
+        if (pending_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+} // namespace cybersentinel
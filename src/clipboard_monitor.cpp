@@ -1,10 +1,15 @@
 #include "clipboard_monitor.h"
 #include "logger.h"
+#include "utf8.h"
+#include <algorithm>
+#include <string_view>
 
 namespace cybersentinel {
 
-ClipboardMonitor::ClipboardMonitor(ClipboardEventCallback callback)
-    : callback_(callback) {
+ClipboardMonitor::ClipboardMonitor(ClipboardEventCallback callback, size_t max_capture_bytes,
+                                   const ClipboardDispatcher::Options& options)
+    : dispatcher_(std::move(callback), options),
+      max_capture_units_(max_capture_bytes / sizeof(wchar_t)) {
 }
 
 ClipboardMonitor::~ClipboardMonitor() {
@@ -18,6 +23,7 @@ bool ClipboardMonitor::start() {
     }
 
     running_ = true;
+    dispatcher_.start();
     monitor_thread_ = std::thread([this]() { monitor_loop(); });
 
     Logger::info("Clipboard monitoring started");
@@ -39,8 +45,12 @@ void ClipboardMonitor::stop() {
     if (monitor_thread_.joinable()) {
         monitor_thread_.join();
     }
+    dispatcher_.stop();
 
-    Logger::info("Clipboard monitor stopped");
+    auto stats = dispatcher_.stats();
+    Logger::info("Clipboard monitor stopped: " + std::to_string(stats.captured) + " captured, " +
+                 std::to_string(stats.duplicates) + " duplicates skipped, " +
+                 std::to_string(stats.dropped) + " dropped");
 }
 
 void ClipboardMonitor::monitor_loop() {
@@ -94,17 +104,35 @@ void ClipboardMonitor::monitor_loop() {
 }
 
 std::string ClipboardMonitor::get_clipboard_text() {
-    if (!OpenClipboard(nullptr)) {
+    // The application that just set the clipboard may still have it open
+    bool opened = false;
+    for (int attempt = 0; attempt < 3 && !opened; ++attempt) {
+        opened = OpenClipboard(hwnd_) != FALSE;
+        if (!opened) {
+            Sleep(10);
+        }
+    }
+    if (!opened) {
+        CS_LOG_DEBUG("Clipboard busy, update skipped");
         return "";
     }
 
+    // CF_UNICODETEXT is synthesized by Windows when only CF_TEXT was set
     std::string result;
-    HANDLE h_data = GetClipboardData(CF_TEXT);
+    HANDLE h_data = GetClipboardData(CF_UNICODETEXT);
 
     if (h_data) {
-        char* text = static_cast<char*>(GlobalLock(h_data));
+        const wchar_t* text = static_cast<const wchar_t*>(GlobalLock(h_data));
         if (text) {
-            result = text;
+            // Bounded by the allocation, which need not be terminated, and the cap
+            size_t limit = (std::min)(GlobalSize(h_data) / sizeof(wchar_t), max_capture_units_);
+            size_t units = 0;
+            while (units < limit && text[units] != L'\0') {
+                ++units;
+            }
+
+            static_assert(sizeof(wchar_t) == sizeof(char16_t), "Windows wchar_t is UTF-16");
+            append_utf16_as_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(text), units), result);
             GlobalUnlock(h_data);
         }
     }
@@ -125,9 +153,10 @@ LRESULT CALLBACK ClipboardMonitor::window_proc(HWND hwnd, UINT msg, WPARAM wpara
     );
 
     if (msg == WM_CLIPBOARDUPDATE && monitor) {
+        // Classification and reporting happen on the dispatcher's worker
         std::string content = monitor->get_clipboard_text();
-        if (!content.empty() && monitor->callback_) {
-            monitor->callback_(content);
+        if (!content.empty()) {
+            monitor->dispatcher_.submit(std::move(content));
         }
         return 0;
     }
@@ -1,5 +1,6 @@
 #include "config.h"
 #include "logger.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <nlohmann/json.hpp>
@@ -11,9 +12,53 @@ namespace cybersentinel {
 Config::Config(const std::string& config_file)
     : config_file_(config_file),
       heartbeat_interval_(60),
+      heartbeat_min_interval_(15),
+      heartbeat_max_interval_(300),
       file_monitoring_enabled_(true),
       clipboard_monitoring_enabled_(true),
-      usb_monitoring_enabled_(true) {
+      usb_monitoring_enabled_(true),
+      file_state_index_path_("file_state.idx"),
+      http2_enabled_(false),
+      uplink_encoding_("json"),
+      retry_attempts_(3),
+      retry_base_ms_(500),
+      breaker_failure_threshold_(5),
+      breaker_open_seconds_(30),
+      spool_enabled_(true),
+      spool_directory_("spool"),
+      spool_max_size_mb_(100),
+      spool_replay_rate_(20),
+      baseline_enabled_(true),
+      baseline_threads_(2),
+      baseline_max_files_per_sec_(200),
+      baseline_max_mb_per_sec_(20),
+      baseline_checkpoint_file_("baseline.checkpoint"),
+      io_max_mb_per_sec_(50),
+      io_max_iops_(500),
+      io_burst_seconds_(1.0),
+      io_idle_multiplier_(4.0),
+      io_idle_cpu_percent_(20.0),
+      clipboard_max_capture_kb_(1024),
+      clipboard_dedup_entries_(64),
+      clipboard_dedup_window_seconds_(300),
+      removable_watch_enabled_(true),
+      removable_scan_enabled_(true),
+      removable_scan_threads_(2),
+      removable_scan_max_files_per_sec_(100),
+      removable_scan_max_mb_per_sec_(20),
+      log_max_file_mb_(10),
+      log_max_age_hours_(24),
+      log_max_files_(5),
+      log_compress_(true),
+      config_reload_enabled_(true),
+      config_reload_poll_seconds_(5),
+      metrics_enabled_(true),
+      metrics_path_("metrics.prom"),
+      metrics_format_("prometheus"),
+      metrics_interval_seconds_(15),
+      trace_enabled_(false),
+      trace_directory_("trace"),
+      trace_record_content_(false) {
 }
 
 bool Config::load() {
@@ -51,6 +96,14 @@ bool Config::load() {
             heartbeat_interval_ = config["heartbeat_interval"].get<int>();
         }
 
+        if (config.contains("heartbeat_min_interval")) {
+            heartbeat_min_interval_ = config["heartbeat_min_interval"].get<int>();
+        }
+
+        if (config.contains("heartbeat_max_interval")) {
+            heartbeat_max_interval_ = config["heartbeat_max_interval"].get<int>();
+        }
+
         // Monitoring configuration
         if (config.contains("monitoring")) {
             auto monitoring = config["monitoring"];
@@ -70,6 +123,251 @@ bool Config::load() {
             if (monitoring.contains("monitored_paths")) {
                 monitored_paths_ = monitoring["monitored_paths"].get<std::vector<std::string>>();
             }
+
+            // Empty keeps the index in memory only
+            if (monitoring.contains("file_state_index")) {
+                file_state_index_path_ = monitoring["file_state_index"].get<std::string>();
+            }
+        }
+
+        // Uplink configuration
+        if (config.contains("uplink")) {
+            auto uplink = config["uplink"];
+
+            if (uplink.contains("http2")) {
+                http2_enabled_ = uplink["http2"].get<bool>();
+            }
+
+            if (uplink.contains("encoding")) {
+                uplink_encoding_ = uplink["encoding"].get<std::string>();
+                if (uplink_encoding_ != "json" && uplink_encoding_ != "cbor") {
+                    Logger::warning("Unknown uplink encoding '" + uplink_encoding_ + "', using json");
+                    uplink_encoding_ = "json";
+                }
+            }
+
+            if (uplink.contains("retry_attempts")) {
+                retry_attempts_ = uplink["retry_attempts"].get<int>();
+            }
+
+            if (uplink.contains("retry_base_ms")) {
+                retry_base_ms_ = uplink["retry_base_ms"].get<int>();
+            }
+
+            if (uplink.contains("breaker_failure_threshold")) {
+                breaker_failure_threshold_ = uplink["breaker_failure_threshold"].get<int>();
+            }
+
+            if (uplink.contains("breaker_open_seconds")) {
+                breaker_open_seconds_ = uplink["breaker_open_seconds"].get<int>();
+            }
+        }
+
+        // Offline event spool configuration
+        if (config.contains("spool")) {
+            auto spool = config["spool"];
+
+            if (spool.contains("enabled")) {
+                spool_enabled_ = spool["enabled"].get<bool>();
+            }
+
+            if (spool.contains("directory")) {
+                spool_directory_ = spool["directory"].get<std::string>();
+            }
+
+            if (spool.contains("max_size_mb")) {
+                spool_max_size_mb_ = spool["max_size_mb"].get<int>();
+            }
+
+            if (spool.contains("replay_rate")) {
+                spool_replay_rate_ = spool["replay_rate"].get<int>();
+            }
+        }
+
+        // Baseline crawl of files that existed before the agent started
+        if (config.contains("baseline_scan")) {
+            auto baseline = config["baseline_scan"];
+
+            if (baseline.contains("enabled")) {
+                baseline_enabled_ = baseline["enabled"].get<bool>();
+            }
+
+            if (baseline.contains("threads")) {
+                baseline_threads_ = baseline["threads"].get<int>();
+            }
+
+            if (baseline.contains("max_files_per_sec")) {
+                baseline_max_files_per_sec_ = baseline["max_files_per_sec"].get<double>();
+            }
+
+            if (baseline.contains("max_mb_per_sec")) {
+                baseline_max_mb_per_sec_ = baseline["max_mb_per_sec"].get<double>();
+            }
+
+            if (baseline.contains("checkpoint_file")) {
+                baseline_checkpoint_file_ = baseline["checkpoint_file"].get<std::string>();
+            }
+        }
+
+        // Global budget for classifier file reads
+        if (config.contains("io_governor")) {
+            auto governor = config["io_governor"];
+
+            if (governor.contains("max_mb_per_sec")) {
+                io_max_mb_per_sec_ = governor["max_mb_per_sec"].get<double>();
+            }
+
+            if (governor.contains("max_iops")) {
+                io_max_iops_ = governor["max_iops"].get<double>();
+            }
+
+            if (governor.contains("burst_seconds")) {
+                io_burst_seconds_ = governor["burst_seconds"].get<double>();
+            }
+
+            if (governor.contains("idle_multiplier")) {
+                io_idle_multiplier_ = governor["idle_multiplier"].get<double>();
+            }
+
+            if (governor.contains("idle_cpu_percent")) {
+                io_idle_cpu_percent_ = governor["idle_cpu_percent"].get<double>();
+            }
+        }
+
+        // Clipboard capture
+        if (config.contains("clipboard")) {
+            auto clipboard = config["clipboard"];
+
+            if (clipboard.contains("max_capture_kb")) {
+                clipboard_max_capture_kb_ = clipboard["max_capture_kb"].get<int>();
+            }
+
+            if (clipboard.contains("dedup_entries")) {
+                clipboard_dedup_entries_ = clipboard["dedup_entries"].get<int>();
+            }
+
+            if (clipboard.contains("dedup_window_seconds")) {
+                clipboard_dedup_window_seconds_ = clipboard["dedup_window_seconds"].get<int>();
+            }
+        }
+
+        // Removable volumes: watching writes and scanning existing contents
+        if (config.contains("removable_volumes")) {
+            auto removable = config["removable_volumes"];
+
+            if (removable.contains("watch_files")) {
+                removable_watch_enabled_ = removable["watch_files"].get<bool>();
+            }
+
+            if (removable.contains("scan_existing")) {
+                removable_scan_enabled_ = removable["scan_existing"].get<bool>();
+            }
+
+            if (removable.contains("scan_threads")) {
+                removable_scan_threads_ = removable["scan_threads"].get<int>();
+            }
+
+            if (removable.contains("scan_max_files_per_sec")) {
+                removable_scan_max_files_per_sec_ = removable["scan_max_files_per_sec"].get<double>();
+            }
+
+            if (removable.contains("scan_max_mb_per_sec")) {
+                removable_scan_max_mb_per_sec_ = removable["scan_max_mb_per_sec"].get<double>();
+            }
+        }
+
+        // Agent log rotation and retention
+        if (config.contains("logging")) {
+            auto logging = config["logging"];
+
+            if (logging.contains("max_file_mb")) {
+                log_max_file_mb_ = logging["max_file_mb"].get<int>();
+            }
+
+            if (logging.contains("max_age_hours")) {
+                log_max_age_hours_ = logging["max_age_hours"].get<int>();
+            }
+
+            if (logging.contains("max_files")) {
+                log_max_files_ = logging["max_files"].get<int>();
+            }
+
+            if (logging.contains("compress")) {
+                log_compress_ = logging["compress"].get<bool>();
+            }
+        }
+
+        // Severity and action rules
+        if (config.contains("policy")) {
+            auto policy = config["policy"];
+
+            if (policy.contains("rules")) {
+                policy_rules_.clear();
+                for (const auto& entry : policy["rules"]) {
+                    PolicyRule rule;
+                    rule.name = entry.value("name", "");
+                    rule.sources = entry.value("sources", std::vector<std::string>());
+                    rule.volume_types = entry.value("volume_types", std::vector<std::string>());
+                    rule.labels = entry.value("labels", std::vector<std::string>());
+                    rule.path_prefixes = entry.value("path_prefixes", std::vector<std::string>());
+                    rule.extensions = entry.value("extensions", std::vector<std::string>());
+                    rule.min_confidence = entry.value("min_confidence", 0.0);
+                    rule.severity = entry.value("severity", "");
+                    rule.action = entry.value("action", "report");
+                    policy_rules_.push_back(std::move(rule));
+                }
+            }
+        }
+
+        // Reload on change while running
+        if (config.contains("config_reload")) {
+            auto reload = config["config_reload"];
+
+            if (reload.contains("enabled")) {
+                config_reload_enabled_ = reload["enabled"].get<bool>();
+            }
+
+            if (reload.contains("poll_seconds")) {
+                config_reload_poll_seconds_ = reload["poll_seconds"].get<int>();
+            }
+        }
+
+        // Local metrics snapshot file
+        if (config.contains("metrics")) {
+            auto metrics = config["metrics"];
+
+            if (metrics.contains("enabled")) {
+                metrics_enabled_ = metrics["enabled"].get<bool>();
+            }
+
+            if (metrics.contains("path")) {
+                metrics_path_ = metrics["path"].get<std::string>();
+            }
+
+            if (metrics.contains("format")) {
+                metrics_format_ = metrics["format"].get<std::string>();
+            }
+
+            if (metrics.contains("interval_seconds")) {
+                metrics_interval_seconds_ = metrics["interval_seconds"].get<int>();
+            }
+        }
+
+        // Event trace recording (off unless diagnosing performance)
+        if (config.contains("event_trace")) {
+            auto trace = config["event_trace"];
+
+            if (trace.contains("enabled")) {
+                trace_enabled_ = trace["enabled"].get<bool>();
+            }
+
+            if (trace.contains("directory")) {
+                trace_directory_ = trace["directory"].get<std::string>();
+            }
+
+            if (trace.contains("record_content")) {
+                trace_record_content_ = trace["record_content"].get<bool>();
+            }
         }
 
         Logger::info("Configuration loaded successfully");
@@ -84,4 +382,32 @@ bool Config::load() {
     }
 }
 
+bool Config::validate(std::string& error) const {
+    if (server_url_.rfind("http://", 0) != 0 && server_url_.rfind("https://", 0) != 0) {
+        error = "server_url must start with http:// or https://";
+    } else if (heartbeat_interval_ < 1 || heartbeat_min_interval_ < 1 ||
+               heartbeat_min_interval_ > heartbeat_interval_ || heartbeat_max_interval_ < heartbeat_interval_) {
+        error = "heartbeat intervals must satisfy 1 <= min <= interval <= max";
+    } else if (std::any_of(monitored_paths_.begin(), monitored_paths_.end(),
+                           [](const std::string& path) { return path.empty(); })) {
+        error = "monitored_paths contains an empty path";
+    } else if (baseline_threads_ < 1 || removable_scan_threads_ < 1) {
+        error = "scan thread counts must be at least 1";
+    } else if (spool_enabled_ && spool_max_size_mb_ < 1) {
+        error = "spool max_size_mb must be at least 1";
+    } else if (log_max_file_mb_ < 0 || log_max_age_hours_ < 0 || log_max_files_ < 0) {
+        error = "logging limits must not be negative";
+    } else if (config_reload_poll_seconds_ < 1) {
+        error = "config_reload poll_seconds must be at least 1";
+    } else if (metrics_enabled_ && (metrics_path_.empty() || metrics_interval_seconds_ < 1)) {
+        error = "metrics needs a path and an interval_seconds of at least 1";
+    } else if (metrics_format_ != "prometheus" && metrics_format_ != "json") {
+        error = "metrics format must be prometheus or json";
+    } else {
+        // Sets error to name the offending rule
+        return Policy::compile(policy_rules_, error) != nullptr;
+    }
+    return false;
+}
+
 } // namespace cybersentinel
@@ -0,0 +1,17 @@
+#include "config_store.h"
+
+namespace cybersentinel {
+
+const Config* ConfigStore::publish(std::unique_ptr<Config> config) {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+
+    const Config* previous = current_.load(std::memory_order_relaxed);
+    snapshots_.push_back(std::move(config));
+
+    // Release: a reader that sees the pointer sees the fully loaded Config
+    current_.store(snapshots_.back().get(), std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+    return previous;
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,107 @@
+#include "config_watcher.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+ConfigWatcher::ConfigWatcher(ConfigStore& store, ChangeHandler on_change)
+    : store_(store), on_change_(std::move(on_change)), path_(store.current()->get_config_file()) {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+void ConfigWatcher::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+
+    // The file as loaded at startup is the baseline
+    read_stamp(last_write_, last_size_);
+
+    stopping_ = false;
+    thread_ = std::thread([this]() {
+        run();
+    });
+    Logger::info("Watching " + path_ + " for configuration changes");
+}
+
+void ConfigWatcher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool ConfigWatcher::check() {
+    fs::file_time_type write_time;
+    uintmax_t size = 0;
+
+    // Missing for a moment while an editor replaces it: try again next poll
+    if (!read_stamp(write_time, size) || (write_time == last_write_ && size == last_size_)) {
+        return false;
+    }
+    last_write_ = write_time;
+    last_size_ = size;
+
+    // A half-written file fails here; the write that completes it changes
+    // the stamp again
+    auto config = std::make_unique<Config>(path_);
+    std::string error;
+    if (!config->load()) {
+        error = "could not be loaded";
+    } else if (!config->validate(error)) {
+        error = "is invalid: " + error;
+    }
+    if (!error.empty()) {
+        ++rejected_;
+        Logger::warning("Changed configuration " + error + "; keeping the running configuration");
+        return false;
+    }
+
+    const Config& current = *config;
+    const Config* previous = store_.publish(std::move(config));
+    ++reloads_;
+    Logger::info("Configuration reloaded (version " + std::to_string(store_.version()) + ")");
+
+    if (on_change_) {
+        on_change_(*previous, current);
+    }
+    return true;
+}
+
+bool ConfigWatcher::read_stamp(fs::file_time_type& write_time, uintmax_t& size) const {
+    std::error_code ec;
+    write_time = fs::last_write_time(path_, ec);
+    if (ec) {
+        return false;
+    }
+    size = fs::file_size(path_, ec);
+    return !ec;
+}
+
+void ConfigWatcher::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        auto poll = std::chrono::seconds((std::max)(1, store_.current()->get_config_reload_poll_seconds()));
+        if (cv_.wait_for(lock, poll, [this]() { return stopping_; })) {
+            break;
+        }
+
+        lock.unlock();
+        check();
+        lock.lock();
+    }
+}
+
+} // namespace cybersentinel
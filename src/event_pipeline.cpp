@@ -0,0 +1,157 @@
+#include "event_pipeline.h"
+#include "logger.h"
+
+namespace cybersentinel {
+
+EventPipeline::EventPipeline(EventReporter& reporter, FileStateIndex& file_index)
+    : reporter_(reporter), file_index_(file_index), rules_version_(Classifier::kRulesVersion) {
+}
+
+void EventPipeline::finish_stage(Stage stage, std::chrono::steady_clock::time_point& start) {
+    if (!observer_) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    observer_(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(now - start));
+    start = now;
+}
+
+void EventPipeline::set_policy(std::unique_ptr<Policy> policy) {
+    std::lock_guard<std::mutex> lock(policy_mutex_);
+    uint32_t version = policy ? policy->version() : 0;
+    policies_.push_back(std::move(policy));
+    policy_.store(policies_.back().get(), std::memory_order_release);
+
+    // Published after the policy: an event that sees the new version
+    // decides with the new rules
+    rules_version_.store(Classifier::kRulesVersion ^ version, std::memory_order_release);
+}
+
+PolicyDecision EventPipeline::decide(const PolicyInput& input) {
+    const Policy* policy = policy_.load(std::memory_order_acquire);
+    PolicyDecision decision = policy ? policy->evaluate(input) : Policy::default_decision(input);
+    if (!decision.report) {
+        ++events_ignored_;
+        CS_LOG_DEBUG("Ignored by policy", kv("rule", policy->rule_name(decision.rule)),
+                     kv("source", Policy::source_name(input.source)), kv("path", input.path));
+    }
+    return decision;
+}
+
+void EventPipeline::handle_file_event(const std::string& file_path,
+                                      const std::string& event_type,
+                                      const VolumeInfo* volume) {
+    CS_LOG_DEBUG("File event", kv("type", event_type), kv("path", file_path));
+    auto start = std::chrono::steady_clock::now();
+
+    if (event_type == "deleted") {
+        file_index_.erase(file_path);
+        finish_stage(Stage::INDEX, start);
+        return;
+    }
+
+    // Unchanged since it was classified and decided under the current rules
+    // (the classifier's and the policy's). Changes on
+    // a removable volume are always classified: its paths are keyed like
+    // local ones but file IDs are not available there, so a copy that
+    // keeps size and mtime would look unchanged.
+    uint32_t rules_version = this->rules_version();
+    FileState state;
+    bool exists = FileStateIndex::stat(file_path, state);
+    FileState indexed;
+    bool unchanged = exists && (!volume || event_type == "baseline") &&
+                     file_index_.lookup(file_path, indexed) && indexed == state &&
+                     indexed.rules_version == rules_version;
+    finish_stage(Stage::INDEX, start);
+    if (unchanged) {
+        CS_LOG_DEBUG("Unchanged since last classification", kv("path", file_path));
+        return;
+    }
+
+    // Classify file content; a copy to a removable volume does not wait
+    // behind background reads
+    auto priority = volume && event_type != "baseline" ? IoGovernor::Priority::HIGH
+                                                       : IoGovernor::Priority::NORMAL;
+    auto result = classifier_.classify_file(file_path, priority);
+    ++files_scanned_;
+
+    // Remember what was classified so later events, rescans and restarts can
+    // skip the file while it is unchanged. The state is taken before reading,
+    // so a write during classification shows up as a change.
+    if (exists) {
+        state.content_hash = result.content_hash;
+        state.labels = Classifier::label_mask(result.labels);
+        state.rules_version = rules_version;
+        file_index_.update(file_path, state);
+    }
+    finish_stage(Stage::CLASSIFY, start);
+
+    if (!result.labels.empty()) {
+        // Sensitive data detected
+        PolicyInput input;
+        input.source = volume ? PolicySource::USB_FILE : PolicySource::FILE;
+        input.volume_type = !volume ? VolumeType::LOCAL : volume->bus == "usb" ? VolumeType::USB
+                                                                               : VolumeType::REMOVABLE;
+        input.labels = Classifier::label_mask(result.labels);
+        input.confidence = result.confidence;
+        input.path = file_path;
+
+        PolicyDecision decision = decide(input);
+        if (decision.report) {
+            reporter_.report((volume ? "usb_file_" : "file_") + event_type, std::string(decision.severity),
+                             file_path, &result, volume);
+            finish_stage(Stage::REPORT, start);
+        }
+    }
+}
+
+void EventPipeline::handle_clipboard_event(const std::string& content) {
+    CS_LOG_DEBUG("Clipboard event detected");
+    auto start = std::chrono::steady_clock::now();
+
+    // Classify clipboard content
+    auto result = classifier_.classify_text(content);
+    finish_stage(Stage::CLASSIFY, start);
+
+    if (!result.labels.empty()) {
+        PolicyInput input;
+        input.source = PolicySource::CLIPBOARD;
+        input.labels = Classifier::label_mask(result.labels);
+        input.confidence = result.confidence;
+
+        PolicyDecision decision = decide(input);
+        if (decision.report) {
+            reporter_.report("clipboard_copy", std::string(decision.severity), "", &result);
+            finish_stage(Stage::REPORT, start);
+        }
+    }
+}
+
+void EventPipeline::handle_usb_event(const VolumeInfo& volume) {
+    Logger::info("Removable volume connected: " + volume.root + " (" + volume.bus + ", serial " +
+                 volume.serial + ")");
+    auto start = std::chrono::steady_clock::now();
+
+    reporter_.report("usb_connected", "medium", "", nullptr, &volume);
+    finish_stage(Stage::REPORT, start);
+}
+
+void EventPipeline::handle_usb_removal(const VolumeInfo& volume) {
+    Logger::info("Removable volume removed: " + volume.root);
+    auto start = std::chrono::steady_clock::now();
+
+    reporter_.report("usb_disconnected", "low", "", nullptr, &volume);
+    finish_stage(Stage::REPORT, start);
+}
+
+const char* stage_name(EventPipeline::Stage stage) {
+    switch (stage) {
+        case EventPipeline::Stage::INDEX:    return "index";
+        case EventPipeline::Stage::CLASSIFY: return "classify";
+        case EventPipeline::Stage::REPORT:   return "report";
+    }
+    return "unknown";
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,401 @@
+#include "event_reporter.h"
+#include "logger.h"
+#include "metrics.h"
+#include <algorithm>
+#include <charconv>
+#include <memory>
+#include <vector>
+
+namespace cybersentinel {
+
+// Transport failures and server-side errors are worth retrying later;
+// other 4xx responses mean the server rejected the event itself
+static bool is_retryable_status(int status_code) {
+    return status_code == 0 || status_code == 429 || status_code >= 500;
+}
+
+// Upper bound on events buffered in memory while delivery is paused
+static const size_t kMaxHeldEvents = 1000;
+
+// Spooled events replayed concurrently when the HTTP client has free slots
+static const size_t kReplayWindow = 8;
+
+// Upper bound on live events queued for posting; beyond it they are spooled
+static const size_t kMaxQueuedEvents = 1000;
+
+static SpoolRecordType spool_record_type(WireFormat format) {
+    return format == WireFormat::CBOR ? SpoolRecordType::EVENT_CBOR : SpoolRecordType::EVENT_JSON;
+}
+
+EventReporter::EventReporter(HttpClient& http_client, const std::string& agent_id, EventSpool* spool)
+    : http_client_(http_client), agent_id_(agent_id), spool_(spool) {
+}
+
+EventReporter::~EventReporter() {
+    // Completion callbacks refer to this reporter
+    drain(std::chrono::milliseconds(0));
+    stop_replay();
+}
+
+DeliveryResult EventReporter::report(const std::string& event_type,
+                                     const std::string& severity,
+                                     const std::string& file_path,
+                                     const ClassificationResult* classification,
+                                     const VolumeInfo* volume) {
+    static Histogram& latency = Metrics::stage("serialize");
+    auto start = std::chrono::steady_clock::now();
+
+    // Event ID: agent, millisecond timestamp and a per-reporter sequence
+    // number, so events reported in the same millisecond stay distinct
+    auto now = std::chrono::system_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now.time_since_epoch()).count();
+    uint64_t sequence = next_event_sequence_.fetch_add(1, std::memory_order_relaxed);
+
+    char digits[24];
+    static thread_local std::string event_id;
+    event_id.assign("evt-").append(agent_id_).append(1, '-');
+    event_id.append(digits, std::to_chars(digits, digits + sizeof(digits), static_cast<int64_t>(ms)).ptr);
+    event_id.append(1, '-');
+    event_id.append(digits, std::to_chars(digits, digits + sizeof(digits), sequence).ptr);
+
+    // Build event payload
+    DlpEvent event;
+    event.event_id = event_id;
+    event.event_type = event_type;
+    event.severity = severity;
+    event.agent_id = agent_id_;
+    event.file_path = file_path;
+    event.classification = classification;
+    event.volume = volume;
+
+    WireFormat format = wire_format_;
+    std::string& payload = encode_payload(format, event);
+    latency.record(std::chrono::steady_clock::now() - start);
+
+    return deliver(payload, format, event_type);
+}
+
+void EventReporter::pause_delivery() {
+    paused_ = true;
+}
+
+void EventReporter::resume_delivery() {
+    // paused_ stays set until the buffer is empty, so events reported while
+    // it drains queue behind the held ones instead of overtaking them. It is
+    // cleared under held_mutex_, the lock hold() re-checks it under, so no
+    // event can be added after the last one is taken.
+    size_t delivered = 0;
+    for (;;) {
+        HeldEvent event;
+        {
+            std::lock_guard<std::mutex> lock(held_mutex_);
+            if (held_.empty()) {
+                paused_ = false;
+                break;
+            }
+            event = std::move(held_.front());
+            held_.pop_front();
+        }
+        send(event.payload, event.format, event.event_type);
+        ++delivered;
+    }
+
+    if (delivered > 0) {
+        Logger::info("Sent " + std::to_string(delivered) + " buffered events");
+    }
+}
+
+DeliveryResult EventReporter::hold(const std::string& payload, WireFormat format,
+                                   const std::string& event_type) {
+    if (spool_ && spool_->append(payload, spool_record_type(format))) {
+        CS_LOG_DEBUG("Event spooled until delivery resumes", kv("type", event_type));
+        ++events_spooled_;
+        return DeliveryResult::SPOOLED;
+    }
+
+    std::unique_lock<std::mutex> lock(held_mutex_);
+    if (!paused_) {
+        // Resumed and drained since deliver() looked; send rather than strand it
+        lock.unlock();
+        return send(payload, format, event_type);
+    }
+    if (held_.size() >= kMaxHeldEvents) {
+        Logger::error("Event buffer full, dropping event: " + event_type);
+        ++events_dropped_;
+        return DeliveryResult::DROPPED;
+    }
+
+    held_.push_back(HeldEvent{payload, format, event_type});
+    ++events_spooled_;
+    return DeliveryResult::SPOOLED;
+}
+
+DeliveryResult EventReporter::deliver(const std::string& payload, WireFormat format,
+                                      const std::string& event_type) {
+    if (paused_) {
+        return hold(payload, format, event_type);
+    }
+    return send(payload, format, event_type);
+}
+
+DeliveryResult EventReporter::send(const std::string& payload, WireFormat format,
+                                   const std::string& event_type) {
+    // Keep ordering: while a backlog is being replayed, new events queue behind it
+    if (spool_ && !spool_->empty()) {
+        if (spool_->append(payload, spool_record_type(format))) {
+            CS_LOG_DEBUG("Event spooled behind backlog", kv("type", event_type));
+            ++events_spooled_;
+            return DeliveryResult::SPOOLED;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(outbox_mutex_);
+    if (outbox_.size() >= kMaxQueuedEvents) {
+        lock.unlock();
+        if (spool_ && spool_->append(payload, spool_record_type(format))) {
+            CS_LOG_DEBUG("Send queue full, event spooled", kv("type", event_type));
+            ++events_spooled_;
+            return DeliveryResult::SPOOLED;
+        }
+        Logger::error("Send queue full, dropping event: " + event_type);
+        ++events_dropped_;
+        return DeliveryResult::DROPPED;
+    }
+    outbox_.push_back(OutgoingEvent{payload, format, event_type});
+    lock.unlock();
+
+    pump_outbox();
+    return DeliveryResult::QUEUED;
+}
+
+void EventReporter::pump_outbox() {
+    for (;;) {
+        auto event = std::make_shared<OutgoingEvent>();
+        {
+            std::lock_guard<std::mutex> lock(outbox_mutex_);
+            if (outbox_.empty() || sending_ >= send_window_) {
+                return;
+            }
+            *event = std::move(outbox_.front());
+            outbox_.pop_front();
+            ++sending_;
+        }
+
+        // Answered on the I/O thread, the callback continues with the next
+        // event; answered inline (queue full, circuit open), this loop does,
+        // so a long queue never recurses
+        auto submitted = std::make_shared<std::atomic<bool>>(false);
+        http_client_.request_async("POST", "/events", event->payload,
+            [this, event, submitted](const HttpResponse& response) {
+                finish_send(*event, response);
+                {
+                    std::lock_guard<std::mutex> lock(outbox_mutex_);
+                    --sending_;
+                }
+                outbox_cv_.notify_all();
+                if (submitted->exchange(true)) {
+                    pump_outbox();
+                }
+            },
+            0, content_type(event->format));
+        submitted->store(true);
+    }
+}
+
+void EventReporter::finish_send(const OutgoingEvent& event, const HttpResponse& response) {
+    if (response.status_code == 200 || response.status_code == 201) {
+        Logger::info("Event reported: " + event.event_type);
+        ++events_reported_;
+        mark_contact();
+    } else if (spool_ && is_retryable_status(response.status_code) &&
+               spool_->append(event.payload, spool_record_type(event.format))) {
+        Logger::warning("Failed to report event: HTTP " + std::to_string(response.status_code) +
+                        ", spooled for replay: " + event.event_type);
+        ++events_spooled_;
+
+        // The queue follows it into the spool, keeping the order and
+        // leaving the retries to replay
+        std::lock_guard<std::mutex> lock(outbox_mutex_);
+        spool_outbox();
+    } else {
+        Logger::error("Failed to report event: HTTP " + std::to_string(response.status_code));
+        ++events_dropped_;
+    }
+}
+
+void EventReporter::spool_outbox() {
+    for (auto& event : outbox_) {
+        if (spool_ && spool_->append(event.payload, spool_record_type(event.format))) {
+            ++events_spooled_;
+        } else {
+            Logger::error("Failed to spool queued event, dropping it: " + event.event_type);
+            ++events_dropped_;
+        }
+    }
+    outbox_.clear();
+}
+
+void EventReporter::set_send_window(size_t window) {
+    {
+        std::lock_guard<std::mutex> lock(outbox_mutex_);
+        send_window_ = (std::max)(window, size_t(1));
+    }
+    pump_outbox();
+}
+
+bool EventReporter::drain(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(outbox_mutex_);
+    outbox_cv_.wait_for(lock, timeout, [this]() {
+        return outbox_.empty() && sending_ == 0;
+    });
+    bool drained = outbox_.empty();
+    if (!drained) {
+        Logger::warning("Uplink still busy, moving " + std::to_string(outbox_.size()) +
+                        " queued events to the spool");
+        spool_outbox();
+    }
+    outbox_cv_.wait(lock, [this]() {
+        return sending_ == 0;
+    });
+    return drained;
+}
+
+bool EventReporter::send_heartbeat(std::string_view status, const AgentHealth* health) {
+    Heartbeat heartbeat;
+    heartbeat.agent_id = agent_id_;
+    heartbeat.status = status;
+    heartbeat.health = health;
+
+    WireFormat format = wire_format_;
+    std::string& payload = encode_payload(format, heartbeat);
+
+    auto response = http_client_.put("/agents/" + agent_id_ + "/heartbeat", payload,
+                                     content_type(format));
+
+    if (response.status_code != 200) {
+        Logger::warning("Heartbeat failed: HTTP " + std::to_string(response.status_code));
+        return false;
+    }
+
+    mark_contact();
+    return true;
+}
+
+EventReporter::Stats EventReporter::stats() const {
+    Stats stats;
+    stats.events_reported = events_reported_;
+    stats.events_spooled = events_spooled_;
+    stats.events_dropped = events_dropped_;
+    return stats;
+}
+
+std::chrono::steady_clock::time_point EventReporter::last_contact() const {
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_contact_));
+}
+
+void EventReporter::mark_contact() {
+    last_contact_ = std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+void EventReporter::start_replay(int rate_per_second) {
+    if (!spool_ || replaying_) {
+        return;
+    }
+
+    replaying_ = true;
+    replay_thread_ = std::thread([this, rate_per_second]() {
+        replay_loop(rate_per_second);
+    });
+}
+
+void EventReporter::stop_replay() {
+    replaying_ = false;
+    if (replay_thread_.joinable()) {
+        replay_thread_.join();
+    }
+    if (spool_) {
+        spool_->sync();
+    }
+}
+
+void EventReporter::replay_loop(int rate_per_second) {
+    int rate = std::max(1, rate_per_second);
+    auto pacing = std::chrono::milliseconds(1000 / rate);
+    std::vector<SpoolRecord> batch;
+    std::vector<std::future<HttpResponse>> responses;
+    int failures = 0;
+
+    while (replaying_) {
+        if (paused_) {
+            sleep_while_replaying(std::chrono::seconds(1));
+            continue;
+        }
+
+        // A window of concurrent posts while the client has free slots; one
+        // at a time while other requests are queued for a slot
+        size_t window = http_client_.queued_requests() > 0 ? 1 : kReplayWindow;
+        size_t count = spool_->peek(batch, window);
+        if (count == 0) {
+            spool_->sync();
+            sleep_while_replaying(std::chrono::seconds(1));
+            continue;
+        }
+
+        responses.clear();
+        for (size_t i = 0; i < count; ++i) {
+            WireFormat format = (batch[i].type == SpoolRecordType::EVENT_CBOR) ? WireFormat::CBOR
+                                                                                : WireFormat::JSON;
+            responses.push_back(http_client_.request_async("POST", "/events", batch[i].payload, 0,
+                                                           content_type(format)));
+        }
+
+        // Only the records up to the first retryable failure are popped;
+        // later ones in the window are sent again (delivery is at-least-once)
+        size_t done = 0;
+        bool retry_later = false;
+        for (auto& future : responses) {
+            HttpResponse response = future.get();
+            if (retry_later) {
+                continue;
+            }
+            if (response.status_code == 200 || response.status_code == 201) {
+                ++events_reported_;
+                mark_contact();
+                ++done;
+            } else if (!is_retryable_status(response.status_code)) {
+                Logger::warning("Server rejected spooled event: HTTP " +
+                                std::to_string(response.status_code) + ", dropping it");
+                ++events_dropped_;
+                ++done;
+            } else {
+                retry_later = true;
+            }
+        }
+        spool_->pop(done);
+
+        if (retry_later) {
+            // Server still unreachable (or its circuit is open), back off
+            sleep_while_replaying(jittered_backoff(failures++, std::chrono::seconds(1),
+                                                   std::chrono::seconds(60)));
+        } else {
+            failures = 0;
+            // Replay runs at whatever rate the server accepts; the configured
+            // rate only applies while other requests are waiting for a slot
+            if (http_client_.queued_requests() > 0) {
+                sleep_while_replaying(pacing * static_cast<int>(count));
+            }
+        }
+    }
+}
+
+void EventReporter::sleep_while_replaying(std::chrono::milliseconds duration) {
+    auto deadline = std::chrono::steady_clock::now() + duration;
+    while (replaying_ && std::chrono::steady_clock::now() < deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        std::this_thread::sleep_for(std::min(remaining, std::chrono::milliseconds(100)));
+    }
+}
+
+} // namespace cybersentinel
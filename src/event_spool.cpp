@@ -0,0 +1,636 @@
+#include "event_spool.h"
+#include "logger.h"
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <charconv>
+#include <sstream>
+#include <iomanip>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+// On-disk record: magic, payload length, CRC32 of (type + payload), type, reserved
+static const uint32_t kRecordMagic = 0x50535343; // "CSSP"
+static const size_t kHeaderSize = 16;
+static const uint32_t kMaxRecordSize = 16 * 1024 * 1024;
+
+// fsync batching: at most this many records or this much time between syncs
+static const size_t kSyncBatchRecords = 32;
+static const auto kSyncInterval = std::chrono::seconds(1);
+
+// Cursor is persisted after this many acknowledged records
+static const size_t kCursorSyncPops = 64;
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t length) {
+    static uint32_t table[256];
+    static bool table_ready = [] {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return true;
+    }();
+    (void)table_ready;
+
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static uint32_t record_crc(uint16_t type, const char* payload, size_t length) {
+    uint8_t type_bytes[2] = { static_cast<uint8_t>(type & 0xFF), static_cast<uint8_t>(type >> 8) };
+    uint32_t crc = crc32_update(0, type_bytes, sizeof(type_bytes));
+    return crc32_update(crc, reinterpret_cast<const uint8_t*>(payload), length);
+}
+
+static void put_u32(uint8_t* out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) out[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+static void put_u16(uint8_t* out, uint16_t value) {
+    out[0] = static_cast<uint8_t>(value & 0xFF);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static uint32_t get_u32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+static uint16_t get_u16(const uint8_t* in) {
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+// Quarantined segments kept for inspection; older ones are deleted
+static const size_t kMaxQuarantinedSegments = 4;
+
+// False if buffered data could not be written out
+static bool sync_file(std::FILE* file) {
+    bool flushed = std::fflush(file) == 0;
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+    return flushed;
+}
+
+enum class ReadStatus {
+    OK,
+    END,      // no data at the position
+    CORRUPT,  // a complete frame whose checksum fails; record_size spans it
+    TORN      // a partial frame or garbage: the next frame cannot be found
+};
+
+// Reads one record at the current position
+static ReadStatus read_record(std::FILE* file, SpoolRecord& record, uint64_t& record_size) {
+    uint8_t header[kHeaderSize];
+    size_t header_read = std::fread(header, 1, kHeaderSize, file);
+    if (header_read == 0) {
+        return ReadStatus::END;
+    }
+    if (header_read != kHeaderSize) {
+        return ReadStatus::TORN;
+    }
+
+    uint32_t magic = get_u32(header);
+    uint32_t length = get_u32(header + 4);
+    uint32_t crc = get_u32(header + 8);
+    uint16_t type = get_u16(header + 12);
+
+    if (magic != kRecordMagic || length > kMaxRecordSize) {
+        return ReadStatus::TORN;
+    }
+
+    record.payload.resize(length);
+    if (length > 0 && std::fread(&record.payload[0], 1, length, file) != length) {
+        return ReadStatus::TORN;
+    }
+
+    record_size = kHeaderSize + length;
+    if (record_crc(type, record.payload.data(), length) != crc) {
+        return ReadStatus::CORRUPT;
+    }
+
+    record.type = static_cast<SpoolRecordType>(type);
+    return ReadStatus::OK;
+}
+
+// Sequence number of a segment file; false for anything the spool did not
+// name, so stray files in the directory are left alone
+static bool parse_segment_name(const fs::path& path, uint64_t& seq) {
+    if (path.extension() != ".seg") {
+        return false;
+    }
+    std::string stem = path.stem().string();
+    if (stem.size() < 10 || stem.size() > 20) {
+        return false;
+    }
+    auto result = std::from_chars(stem.data(), stem.data() + stem.size(), seq);
+    return result.ec == std::errc() && result.ptr == stem.data() + stem.size();
+}
+
+EventSpool::EventSpool(const std::string& directory, uint64_t max_bytes)
+    : directory_(directory),
+      max_bytes_(max_bytes),
+      segment_bytes_(std::min<uint64_t>(std::max<uint64_t>(max_bytes / 8, 64 * 1024),
+                                        16 * 1024 * 1024)) {
+}
+
+EventSpool::~EventSpool() {
+    close();
+}
+
+std::string EventSpool::segment_path(uint64_t seq) const {
+    std::ostringstream name;
+    name << std::setfill('0') << std::setw(10) << seq << ".seg";
+    return (fs::path(directory_) / name.str()).string();
+}
+
+std::string EventSpool::cursor_path() const {
+    return (fs::path(directory_) / "cursor").string();
+}
+
+bool EventSpool::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_) {
+        return true;
+    }
+
+    try {
+        fs::create_directories(directory_);
+
+        std::vector<uint64_t> segments;
+        for (const auto& entry : fs::directory_iterator(directory_)) {
+            uint64_t seq = 0;
+            if (!entry.is_regular_file() || !parse_segment_name(entry.path(), seq)) {
+                continue;
+            }
+            if (entry.path().filename() != fs::path(segment_path(seq)).filename()) {
+                Logger::warning("Event spool: ignoring unexpected file " + entry.path().string());
+                continue;
+            }
+            segments.push_back(seq);
+        }
+        std::sort(segments.begin(), segments.end());
+
+        total_bytes_ = 0;
+        for (size_t i = 0; i + 1 < segments.size(); ++i) {
+            total_bytes_ += fs::file_size(segment_path(segments[i]));
+        }
+
+        // Only the last segment can hold a torn write
+        write_seq_ = segments.empty() ? 1 : segments.back();
+        if (!segments.empty()) {
+            total_bytes_ += recover_segment(write_seq_);
+        }
+
+        load_cursor();
+        uint64_t first_seq = segments.empty() ? write_seq_ : segments.front();
+        if (read_seq_ < first_seq || read_seq_ > write_seq_) {
+            read_seq_ = first_seq;
+            read_offset_ = 0;
+        }
+
+        if (!open_write_segment(write_seq_)) {
+            return false;
+        }
+        if (read_seq_ == write_seq_ && read_offset_ > write_offset_) {
+            read_offset_ = write_offset_;
+        }
+
+        last_sync_ = std::chrono::steady_clock::now();
+        open_ = true;
+
+        if (total_bytes_ > 0) {
+            Logger::info("Event spool opened with " + std::to_string(total_bytes_) +
+                         " bytes pending: " + directory_);
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        Logger::error("Failed to open event spool " + directory_ + ": " + e.what());
+        return false;
+    }
+}
+
+void EventSpool::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_) {
+        return;
+    }
+
+    sync_locked();
+    save_cursor();
+
+    if (write_file_) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+    }
+    if (read_file_) {
+        std::fclose(read_file_);
+        read_file_ = nullptr;
+    }
+    open_ = false;
+}
+
+uint64_t EventSpool::recover_segment(uint64_t seq) {
+    std::string path = segment_path(seq);
+    uint64_t file_size = fs::file_size(path);
+    uint64_t valid = 0;
+
+    // Corrupt but complete frames are kept; peek() skips them
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        SpoolRecord record;
+        uint64_t record_size = 0;
+        ReadStatus status;
+        while ((status = read_record(file, record, record_size)) == ReadStatus::OK ||
+               status == ReadStatus::CORRUPT) {
+            valid += record_size;
+        }
+        std::fclose(file);
+    }
+
+    if (valid < file_size) {
+        Logger::warning("Event spool: truncating " + std::to_string(file_size - valid) +
+                        " bytes of incomplete data in " + path);
+        fs::resize_file(path, valid);
+    }
+    return valid;
+}
+
+bool EventSpool::open_write_segment(uint64_t seq) {
+    std::string path = segment_path(seq);
+    write_file_ = std::fopen(path.c_str(), "ab");
+    if (!write_file_) {
+        Logger::error("Failed to open spool segment: " + path);
+        return false;
+    }
+    write_seq_ = seq;
+    write_offset_ = fs::file_size(path);
+    return true;
+}
+
+bool EventSpool::append(const std::string& payload, SpoolRecordType type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_ || !write_file_ || payload.size() > kMaxRecordSize) {
+        return false;
+    }
+
+    uint16_t type_value = static_cast<uint16_t>(type);
+    uint8_t header[kHeaderSize] = {0};
+    put_u32(header, kRecordMagic);
+    put_u32(header + 4, static_cast<uint32_t>(payload.size()));
+    put_u32(header + 8, record_crc(type_value, payload.data(), payload.size()));
+    put_u16(header + 12, type_value);
+
+    if (std::fwrite(header, 1, kHeaderSize, write_file_) != kHeaderSize ||
+        std::fwrite(payload.data(), 1, payload.size(), write_file_) != payload.size()) {
+        Logger::error("Failed to write to event spool");
+        repair_write_segment();
+        return false;
+    }
+
+    uint64_t record_size = kHeaderSize + payload.size();
+    write_offset_ += record_size;
+    total_bytes_ += record_size;
+    ++unsynced_records_;
+
+    if (unsynced_records_ >= kSyncBatchRecords ||
+        std::chrono::steady_clock::now() - last_sync_ >= kSyncInterval) {
+        sync_locked();
+    }
+
+    if (write_offset_ >= segment_bytes_) {
+        roll_segment();
+    }
+
+    while (total_bytes_ > max_bytes_ && read_seq_ < write_seq_) {
+        evict_oldest();
+    }
+    return true;
+}
+
+void EventSpool::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_) {
+        sync_locked();
+    }
+}
+
+void EventSpool::sync_locked() {
+    if (write_file_ && unsynced_records_ > 0 && !sync_file(write_file_)) {
+        Logger::error("Failed to flush event spool");
+        repair_write_segment();
+    }
+    unsynced_records_ = 0;
+    last_sync_ = std::chrono::steady_clock::now();
+
+    if (unsynced_pops_ > 0) {
+        save_cursor();
+    }
+}
+
+void EventSpool::roll_segment() {
+    sync_locked();
+    if (write_file_) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+    }
+    open_write_segment(write_seq_ + 1);
+}
+
+void EventSpool::repair_write_segment() {
+    // A short write leaves part of a frame in the file (or in the stdio
+    // buffer, to be written later). Cut the segment back to its last whole
+    // record so the file and write_offset_ agree again and later appends
+    // start on a frame boundary.
+    if (write_file_) {
+        std::fclose(write_file_);
+        write_file_ = nullptr;
+    }
+
+    uint64_t expected = write_offset_;
+    try {
+        uint64_t valid = recover_segment(write_seq_);
+        if (valid < expected) {
+            total_bytes_ -= std::min(total_bytes_, expected - valid);
+        }
+    } catch (const std::exception& e) {
+        Logger::error(std::string("Event spool: failed to repair active segment: ") + e.what());
+    }
+
+    open_write_segment(write_seq_);
+    if (read_seq_ == write_seq_ && read_offset_ > write_offset_) {
+        read_offset_ = write_offset_;
+    }
+    unsynced_records_ = 0;
+}
+
+void EventSpool::evict_oldest() {
+    // Drained segments are deleted as the reader leaves them, so the oldest
+    // segment on disk is always the one under the read cursor
+    uint64_t size = 0;
+    try {
+        size = fs::file_size(segment_path(read_seq_));
+    } catch (const std::exception&) {
+    }
+
+    advance_read_segment();
+    evicted_bytes_ += size;
+    Logger::warning("Event spool full, evicted " + std::to_string(size) + " bytes of oldest events");
+}
+
+bool EventSpool::advance_read_segment() {
+    if (read_file_) {
+        std::fclose(read_file_);
+        read_file_ = nullptr;
+    }
+
+    std::string path = segment_path(read_seq_);
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    if (!ec) {
+        total_bytes_ -= std::min(total_bytes_, size);
+    }
+    fs::remove(path, ec);
+
+    ++read_seq_;
+    read_offset_ = 0;
+    peeked_sizes_.clear();
+    save_cursor();
+    return true;
+}
+
+bool EventSpool::peek(SpoolRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peeked_sizes_.clear();
+    uint64_t record_size = 0;
+    if (!open_ || !read_next(record, record_size)) {
+        return false;
+    }
+    peeked_sizes_.push_back(record_size);
+    return true;
+}
+
+size_t EventSpool::peek(std::vector<SpoolRecord>& records, size_t max_records) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    peeked_sizes_.clear();
+    if (!open_ || max_records == 0) {
+        return 0;
+    }
+
+    if (records.size() < max_records) {
+        records.resize(max_records);
+    }
+    uint64_t record_size = 0;
+    if (!read_next(records[0], record_size)) {
+        return 0;
+    }
+    peeked_sizes_.push_back(record_size);
+
+    // Further records follow in the same segment; a batch stops at anything
+    // but a good record and the next peek deals with it
+    uint64_t offset = read_offset_ + record_size;
+    uint64_t limit = read_seq_ == write_seq_ ? write_offset_ : UINT64_MAX;
+    while (peeked_sizes_.size() < max_records && offset < limit &&
+           read_record(read_file_, records[peeked_sizes_.size()], record_size) == ReadStatus::OK) {
+        peeked_sizes_.push_back(record_size);
+        offset += record_size;
+    }
+    return peeked_sizes_.size();
+}
+
+bool EventSpool::read_next(SpoolRecord& record, uint64_t& record_size) {
+    while (true) {
+        if (read_seq_ == write_seq_) {
+            if (read_offset_ >= write_offset_) {
+                return false;
+            }
+            // Make buffered appends visible to the reader
+            if (std::fflush(write_file_) != 0) {
+                Logger::error("Failed to flush event spool");
+                repair_write_segment();
+                continue;
+            }
+        }
+
+        if (!read_file_) {
+            read_file_ = std::fopen(segment_path(read_seq_).c_str(), "rb");
+            if (!read_file_) {
+                if (read_seq_ < write_seq_) {
+                    advance_read_segment();
+                    continue;
+                }
+                return false;
+            }
+        }
+
+        ReadStatus status = ReadStatus::TORN;
+        if (std::fseek(read_file_, static_cast<long>(read_offset_), SEEK_SET) == 0) {
+            status = read_record(read_file_, record, record_size);
+        }
+
+        if (status == ReadStatus::OK) {
+            return true;
+        }
+
+        if (status == ReadStatus::CORRUPT) {
+            // The frame is intact, only its content is damaged: drop just it
+            Logger::warning("Event spool: skipping corrupt record at offset " +
+                            std::to_string(read_offset_) + " of " + segment_path(read_seq_));
+            read_offset_ += record_size;
+            ++corrupt_records_;
+            ++unsynced_pops_;
+            continue;
+        }
+
+        if (read_seq_ < write_seq_) {
+            // End of a sealed segment, or damage that hides where the next
+            // frame starts
+            if (status == ReadStatus::END) {
+                advance_read_segment();
+            } else {
+                quarantine_read_segment();
+            }
+            continue;
+        }
+
+        // The active segment holds less than write_offset_ says. Seal it so
+        // new events go to a fresh segment, and set the damaged one aside.
+        roll_segment();
+        quarantine_read_segment();
+    }
+}
+
+void EventSpool::quarantine_read_segment() {
+    if (read_file_) {
+        std::fclose(read_file_);
+        read_file_ = nullptr;
+    }
+
+    std::string path = segment_path(read_seq_);
+    std::error_code ec;
+    uint64_t size = fs::file_size(path, ec);
+    fs::rename(path, path + ".bad", ec);
+    if (!ec) {
+        total_bytes_ -= std::min(total_bytes_, size);
+        ++corrupt_records_;
+        Logger::warning("Event spool: unreadable data at offset " + std::to_string(read_offset_) +
+                        ", segment moved aside as " + path + ".bad");
+    }
+
+    // Keep only the most recent quarantined segments
+    std::vector<fs::path> quarantined;
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        if (entry.path().extension() == ".bad") {
+            quarantined.push_back(entry.path());
+        }
+    }
+    std::sort(quarantined.begin(), quarantined.end());
+    for (size_t i = 0; i + kMaxQuarantinedSegments < quarantined.size(); ++i) {
+        fs::remove(quarantined[i], ec);
+    }
+
+    advance_read_segment();
+}
+
+void EventSpool::pop(size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_ || peeked_sizes_.empty()) {
+        return;
+    }
+
+    count = std::min(count, peeked_sizes_.size());
+    for (size_t i = 0; i < count; ++i) {
+        read_offset_ += peeked_sizes_[i];
+        ++unsynced_pops_;
+    }
+    peeked_sizes_.clear();
+
+    if (read_seq_ == write_seq_ && read_offset_ >= write_offset_) {
+        // Fully drained: start a fresh segment so the old one can be reclaimed
+        roll_segment();
+        advance_read_segment();
+    } else if (unsynced_pops_ >= kCursorSyncPops) {
+        save_cursor();
+    }
+}
+
+bool EventSpool::empty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !open_ || (read_seq_ == write_seq_ && read_offset_ >= write_offset_);
+}
+
+uint64_t EventSpool::size_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_bytes_;
+}
+
+uint64_t EventSpool::evicted_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return evicted_bytes_;
+}
+
+uint64_t EventSpool::corrupt_records() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return corrupt_records_;
+}
+
+void EventSpool::save_cursor() {
+    // Write-then-rename so a crash never leaves a half-written cursor
+    std::string tmp_path = cursor_path() + ".tmp";
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        Logger::warning("Failed to write spool cursor: " + tmp_path);
+        return;
+    }
+
+    std::string line = std::to_string(read_seq_) + " " + std::to_string(read_offset_) + "\n";
+    std::fwrite(line.data(), 1, line.size(), file);
+    sync_file(file);
+    std::fclose(file);
+
+    std::error_code ec;
+    fs::rename(tmp_path, cursor_path(), ec);
+    if (ec) {
+        Logger::warning("Failed to update spool cursor: " + ec.message());
+        return;
+    }
+    unsynced_pops_ = 0;
+}
+
+void EventSpool::load_cursor() {
+    read_seq_ = 0;
+    read_offset_ = 0;
+
+    std::FILE* file = std::fopen(cursor_path().c_str(), "rb");
+    if (!file) {
+        return;
+    }
+
+    unsigned long long seq = 0;
+    unsigned long long offset = 0;
+    if (std::fscanf(file, "%llu %llu", &seq, &offset) == 2) {
+        read_seq_ = seq;
+        read_offset_ = offset;
+    }
+    std::fclose(file);
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,297 @@
+#include "event_trace.h"
+#include "fnv_hash.h"
+#include "logger.h"
+#include "utf8.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+// Content above this size is not copied into the trace; the classifier does
+// not read such files either
+static const uint64_t kMaxContentBytes = 10 * 1024 * 1024;
+
+static const char* kTraceMagic = "cybersentinel-trace";
+static const int kTraceVersion = 1;
+
+namespace {
+
+std::string hash_name(uint64_t hash) {
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+std::string encode_subject(const std::string& subject) {
+    std::string encoded;
+    encoded.reserve(subject.size());
+    for (char c : subject) {
+        switch (c) {
+            case '%':  encoded += "%25"; break;
+            case '\r': encoded += "%0D"; break;
+            case '\n': encoded += "%0A"; break;
+            default:   encoded += c; break;
+        }
+    }
+    return encoded;
+}
+
+std::string decode_subject(const std::string& encoded) {
+    std::string subject;
+    subject.reserve(encoded.size());
+    for (size_t i = 0; i < encoded.size(); ++i) {
+        if (encoded[i] == '%' && i + 2 < encoded.size()) {
+            subject += static_cast<char>(std::strtol(encoded.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            subject += encoded[i];
+        }
+    }
+    return subject;
+}
+
+bool parse_source(const std::string& name, TraceSource& source) {
+    if (name == "file") {
+        source = TraceSource::FILE;
+    } else if (name == "clipboard") {
+        source = TraceSource::CLIPBOARD;
+    } else if (name == "usb") {
+        source = TraceSource::USB;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+const char* trace_source_name(TraceSource source) {
+    switch (source) {
+        case TraceSource::FILE:      return "file";
+        case TraceSource::CLIPBOARD: return "clipboard";
+        case TraceSource::USB:       return "usb";
+    }
+    return "unknown";
+}
+
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+bool TraceWriter::open(const std::string& directory, bool record_content) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::error_code ec;
+    fs::remove_all(fs::path(directory) / "content", ec);
+    fs::create_directories(fs::path(directory) / "content", ec);
+    if (ec) {
+        Logger::error("Cannot create trace directory " + directory + ": " + ec.message());
+        return false;
+    }
+
+    events_.open((fs::path(directory) / "events").string(), std::ios::out | std::ios::trunc);
+    if (!events_.is_open()) {
+        Logger::error("Cannot create trace file in " + directory);
+        return false;
+    }
+
+    directory_ = directory;
+    record_content_ = record_content;
+    start_ = std::chrono::steady_clock::now();
+    count_ = 0;
+
+    events_ << kTraceMagic << ' ' << kTraceVersion << ' '
+            << (record_content ? "content" : "hashes") << '\n';
+    events_.flush();
+    return true;
+}
+
+void TraceWriter::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (events_.is_open()) {
+        events_.close();
+        Logger::info("Event trace closed, " + std::to_string(count_) + " events recorded");
+    }
+}
+
+uint64_t TraceWriter::events_recorded() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+void TraceWriter::record_file(const std::string& file_path, const std::string& event_type) {
+    TraceEvent event;
+    event.source = TraceSource::FILE;
+    event.action = event_type;
+    event.subject = file_path;
+
+    bool record_content;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record_content = record_content_;
+    }
+
+    // Snapshot the content now; by replay time the file has moved on
+    std::string content;
+    bool readable = false;
+    if (event_type != "deleted") {
+        std::error_code ec;
+        fs::path path = path_from_utf8(file_path);
+        uint64_t size = fs::file_size(path, ec);
+        if (!ec && record_content && size <= kMaxContentBytes) {
+            std::ifstream file(path, std::ios::binary);
+            if (file.is_open()) {
+                std::ostringstream buffer;
+                buffer << file.rdbuf();
+                content = buffer.str();
+                readable = true;
+            }
+        } else if (!ec) {
+            // Hashes traces do not read the file, which would double the
+            // monitor thread's I/O; path, size and mtime stand in for the
+            // content so the same version of a file keeps the same hash
+            int64_t mtime = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+            event.content_size = size;
+            event.content_hash = fnv1a_64(file_path);
+            event.content_hash = fnv1a_64(std::string_view(reinterpret_cast<const char*>(&size), sizeof(size)),
+                                          event.content_hash);
+            event.content_hash = fnv1a_64(std::string_view(reinterpret_cast<const char*>(&mtime), sizeof(mtime)),
+                                          event.content_hash);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_event(event, readable ? &content : nullptr);
+}
+
+void TraceWriter::record_clipboard(const std::string& content) {
+    TraceEvent event;
+    event.source = TraceSource::CLIPBOARD;
+    event.action = "-";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_event(event, &content);
+}
+
+void TraceWriter::record_usb(const std::string& volume_root, const std::string& action) {
+    TraceEvent event;
+    event.source = TraceSource::USB;
+    event.action = action;
+    event.subject = volume_root;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    write_event(event, nullptr);
+}
+
+void TraceWriter::write_event(TraceEvent& event, const std::string* content) {
+    if (!events_.is_open()) {
+        return;
+    }
+
+    event.offset_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+
+    if (content) {
+        event.content_hash = fnv1a_64(*content);
+        event.content_size = content->size();
+        if (record_content_) {
+            store_content(event.content_hash, *content);
+            event.has_content = true;
+        }
+    }
+
+    // Flushed per event so a trace cut short by a crash is still usable
+    events_ << event.offset_us << ' ' << trace_source_name(event.source) << ' '
+            << event.action << ' ' << hash_name(event.content_hash) << ' '
+            << event.content_size << ' ' << (event.has_content ? 'c' : '-') << ' '
+            << encode_subject(event.subject) << '\n';
+    events_.flush();
+    ++count_;
+}
+
+void TraceWriter::store_content(uint64_t hash, const std::string& content) {
+    fs::path path = fs::path(directory_) / "content" / hash_name(hash);
+    std::error_code ec;
+    if (fs::exists(path, ec)) {
+        return;
+    }
+
+    std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    if (!file) {
+        Logger::warning("Failed to store trace content " + path.string());
+    }
+}
+
+bool TraceReader::open(const std::string& directory) {
+    events_.open((fs::path(directory) / "events").string());
+    if (!events_.is_open()) {
+        Logger::error("Cannot open trace in " + directory);
+        return false;
+    }
+
+    std::string magic, mode;
+    int version = 0;
+    std::string header;
+    std::getline(events_, header);
+    std::istringstream fields(header);
+    fields >> magic >> version >> mode;
+    if (magic != kTraceMagic || version != kTraceVersion) {
+        Logger::error("Unsupported trace format in " + directory);
+        events_.close();
+        return false;
+    }
+
+    directory_ = directory;
+    has_content_ = mode == "content";
+    return true;
+}
+
+bool TraceReader::next(TraceEvent& event) {
+    std::string line;
+    while (std::getline(events_, line)) {
+        std::istringstream fields(line);
+        std::string source, hash, stored;
+        event = TraceEvent();
+        if (!(fields >> event.offset_us >> source >> event.action >> hash >> event.content_size >> stored) ||
+            !parse_source(source, event.source)) {
+            Logger::warning("Skipping malformed trace line: " + line);
+            continue;
+        }
+
+        event.content_hash = std::strtoull(hash.c_str(), nullptr, 16);
+        event.has_content = stored == "c";
+
+        // The subject follows a single separator and may contain spaces
+        std::string subject;
+        if (fields.get() == ' ') {
+            std::getline(fields, subject);
+        }
+        event.subject = decode_subject(subject);
+        return true;
+    }
+    return false;
+}
+
+bool TraceReader::load_content(const TraceEvent& event, std::string& content) const {
+    if (!event.has_content) {
+        return false;
+    }
+
+    std::ifstream file((fs::path(directory_) / "content" / hash_name(event.content_hash)).string(),
+                       std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+} // namespace cybersentinel
@@ -1,11 +1,23 @@
 #include "file_monitor.h"
 #include "logger.h"
-#include <sstream>
+#include "metrics.h"
+#include "utf8.h"
+#include <cstdlib>
+#include <chrono>
+#include <filesystem>
+#include <unordered_set>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+namespace fs = std::filesystem;
 
 namespace cybersentinel {
 
-FileMonitor::FileMonitor(const std::vector<std::string>& paths, FileEventCallback callback)
-    : monitored_paths_(paths), callback_(callback) {
+FileMonitor::FileMonitor(const std::vector<std::string>& paths, FileEventCallback callback,
+                         FileStateIndex* index)
+    : monitored_paths_(paths), callback_(callback), index_(index) {
 }
 
 FileMonitor::~FileMonitor() {
@@ -13,168 +25,266 @@ FileMonitor::~FileMonitor() {
 }
 
 bool FileMonitor::start() {
+    std::lock_guard<std::mutex> control_lock(control_mutex_);
     if (running_) {
         Logger::warning("File monitor already running");
         return true;
     }
 
-    running_ = true;
+    backend_ = WatcherBackend::create(notify_buffer_size_);
 
+    size_t watched = 0;
     for (const auto& path : monitored_paths_) {
-        // Expand environment variables
-        char expanded_path[MAX_PATH];
-        ExpandEnvironmentStringsA(path.c_str(), expanded_path, MAX_PATH);
+        std::string expanded_path = expand_path(path);
 
-        // Start monitoring thread for each path
-        monitor_threads_.emplace_back([this, p = std::string(expanded_path)]() {
-            monitor_directory(p);
-        });
+        if (backend_->add_watch(expanded_path)) {
+            ++watched;
+            Logger::info("Started monitoring: " + expanded_path);
+        }
+    }
 
-        Logger::info("Started monitoring: " + std::string(expanded_path));
+    if (watched == 0 && !monitored_paths_.empty()) {
+        Logger::warning("None of the monitored paths could be watched");
     }
 
+    bool started = backend_->start(
+        [this](const WatchEvent& event) {
+            static Histogram& latency = Metrics::stage("watch");
+            static Counter& events = Metrics::counter("cybersentinel_watch_events_total",
+                                                      "File change notifications received.");
+            events.add();
+            // Includes the wait behind earlier events of the same OS batch
+            if (event.received != std::chrono::steady_clock::time_point()) {
+                latency.record(std::chrono::steady_clock::now() - event.received);
+            }
+
+            if (callback_) {
+                backend_->paths().join(event.directory, event.name, event_path_);
+                std::lock_guard<std::mutex> lock(callback_mutex_);
+                callback_(event_path_, file_action_to_string(event.action));
+            }
+        },
+        [this](const std::string& root) {
+            handle_overflow(root);
+        }
+    );
+
+    if (!started) {
+        Logger::error(std::string("Failed to start ") + backend_->name() + " watcher");
+        backend_.reset();
+        return false;
+    }
+
+    running_ = true;
+    rescan_thread_ = std::thread([this]() {
+        rescan_loop();
+    });
+
+    backend_name_ = backend_->name();
+    Logger::info("File watcher backend: " + backend_name_);
     return true;
 }
 
 void FileMonitor::stop() {
+    std::lock_guard<std::mutex> control_lock(control_mutex_);
     if (!running_) {
         return;
     }
 
     running_ = false;
 
-    // Close directory handles to unblock ReadDirectoryChangesW
-    for (auto handle : dir_handles_) {
-        if (handle != INVALID_HANDLE_VALUE) {
-            CloseHandle(handle);
-        }
+    if (backend_) {
+        backend_->stop();
+        backend_.reset();
     }
-    dir_handles_.clear();
 
-    // Wait for threads to finish
-    for (auto& thread : monitor_threads_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
+    rescan_cv_.notify_all();
+    if (rescan_thread_.joinable()) {
+        rescan_thread_.join();
     }
-    monitor_threads_.clear();
 
     Logger::info("File monitor stopped");
 }
 
-void FileMonitor::monitor_directory(const std::string& path) {
-    // Open directory handle
-    HANDLE dir_handle = CreateFileA(
-        path.c_str(),
-        FILE_LIST_DIRECTORY,
-        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
-        nullptr,
-        OPEN_EXISTING,
-        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
-        nullptr
-    );
+void FileMonitor::update_paths(const std::vector<std::string>& paths) {
+    std::lock_guard<std::mutex> control_lock(control_mutex_);
+
+    std::set<std::string> current;
+    for (const auto& path : monitored_paths_) {
+        current.insert(expand_path(path));
+    }
+    std::set<std::string> wanted;
+    for (const auto& path : paths) {
+        wanted.insert(expand_path(path));
+    }
+    monitored_paths_ = paths;
 
-    if (dir_handle == INVALID_HANDLE_VALUE) {
-        Logger::error("Failed to open directory: " + path);
+    // Not running: start() picks up the new list
+    if (!running_ || !backend_) {
         return;
     }
 
-    dir_handles_.push_back(dir_handle);
+    for (const auto& root : current) {
+        if (wanted.count(root)) {
+            continue;
+        }
+        if (backend_->remove_watch(root)) {
+            Logger::info("Stopped monitoring: " + root);
+        }
+        std::lock_guard<std::mutex> lock(rescan_mutex_);
+        dirty_roots_.erase(root);
+    }
 
-    const DWORD buffer_size = 4096;
-    char buffer[buffer_size];
-    DWORD bytes_returned;
+    for (const auto& root : wanted) {
+        if (!current.count(root) && backend_->add_watch(root)) {
+            Logger::info("Started monitoring: " + root);
+        }
+    }
+}
 
-    OVERLAPPED overlapped = {0};
-    overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+FileMonitor::RescanStats FileMonitor::rescan_stats() {
+    std::lock_guard<std::mutex> lock(rescan_mutex_);
+    RescanStats stats = rescan_stats_;
+    stats.overflows = overflows_;
+    return stats;
+}
 
-    while (running_) {
-        // Read directory changes
-        BOOL result = ReadDirectoryChangesW(
-            dir_handle,
-            buffer,
-            buffer_size,
-            TRUE, // Watch subdirectories
-            FILE_NOTIFY_CHANGE_FILE_NAME |
-            FILE_NOTIFY_CHANGE_DIR_NAME |
-            FILE_NOTIFY_CHANGE_SIZE |
-            FILE_NOTIFY_CHANGE_LAST_WRITE,
-            &bytes_returned,
-            &overlapped,
-            nullptr
-        );
-
-        if (!result) {
-            Logger::error("ReadDirectoryChangesW failed for: " + path);
-            break;
-        }
+void FileMonitor::handle_overflow(const std::string& root) {
+    static Counter& overflows = Metrics::counter("cybersentinel_watch_overflows_total",
+                                                 "Times the OS dropped change notifications.");
+    overflows.add();
+    ++overflows_;
+
+    // Repeated overflows while a rescan is queued collapse into one
+    bool queued;
+    {
+        std::lock_guard<std::mutex> lock(rescan_mutex_);
+        queued = dirty_roots_.insert(root).second;
+    }
 
-        // Wait for event
-        DWORD wait_result = WaitForSingleObject(overlapped.hEvent, 1000);
+    if (queued) {
+        Logger::warning("File change notifications overflowed under " + root + ", scheduling rescan");
+        rescan_cv_.notify_one();
+    }
+}
 
-        if (wait_result == WAIT_TIMEOUT) {
-            continue;
-        }
+void FileMonitor::rescan_loop() {
+    std::unique_lock<std::mutex> lock(rescan_mutex_);
 
-        if (wait_result != WAIT_OBJECT_0) {
-            break;
-        }
+    while (running_) {
+        rescan_cv_.wait(lock, [this]() {
+            return !running_ || !dirty_roots_.empty();
+        });
 
-        if (!GetOverlappedResult(dir_handle, &overlapped, &bytes_returned, FALSE)) {
-            if (GetLastError() != ERROR_OPERATION_ABORTED) {
-                Logger::error("GetOverlappedResult failed");
-            }
-            break;
+        while (running_ && !dirty_roots_.empty()) {
+            std::string root = *dirty_roots_.begin();
+            dirty_roots_.erase(dirty_roots_.begin());
+
+            lock.unlock();
+            rescan(root);
+            lock.lock();
         }
+    }
+}
 
-        // Reset event
-        ResetEvent(overlapped.hEvent);
+void FileMonitor::rescan(const std::string& root) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t examined = 0;
+    uint64_t changed = 0;
+    std::unordered_set<std::string> seen;
+
+    // Report files that are new or whose size/mtime differ from the index
+    std::error_code ec;
+    fs::recursive_directory_iterator it(path_from_utf8(root), fs::directory_options::skip_permission_denied, ec);
+    for (; running_ && !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
 
-        // Process notifications
-        FILE_NOTIFY_INFORMATION* fni = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(buffer);
+        std::string path = path_to_utf8(it->path());
+        ++examined;
 
-        while (true) {
-            // Convert filename from wide string
-            std::wstring wfilename(fni->FileName, fni->FileNameLength / sizeof(WCHAR));
-            std::string filename(wfilename.begin(), wfilename.end());
+        FileState current;
+        if (!FileStateIndex::stat(path, current)) {
+            continue;
+        }
 
-            std::string full_path = path + "\\" + filename;
-            std::string event_type = get_event_type(fni->Action);
+        FileState indexed;
+        bool known = index_ && index_->lookup(path, indexed);
+        if (index_) {
+            seen.insert(path);
+        }
 
-            // Call callback
+        if (!known || indexed != current) {
+            ++changed;
             if (callback_) {
-                callback_(full_path, event_type);
+                std::lock_guard<std::mutex> lock(callback_mutex_);
+                callback_(path, known ? "modified" : "created");
             }
+        }
+    }
 
-            // Check if there are more entries
-            if (fni->NextEntryOffset == 0) {
-                break;
+    // Indexed files that no longer exist were deleted while events were lost
+    if (index_ && running_) {
+        for (const auto& path : index_->paths_under(root)) {
+            if (seen.find(path) == seen.end()) {
+                ++changed;
+                if (callback_) {
+                    std::lock_guard<std::mutex> lock(callback_mutex_);
+                    callback_(path, "deleted");
+                }
             }
-
-            fni = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(
-                reinterpret_cast<BYTE*>(fni) + fni->NextEntryOffset
-            );
         }
     }
 
-    CloseHandle(overlapped.hEvent);
-    CloseHandle(dir_handle);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    {
+        std::lock_guard<std::mutex> lock(rescan_mutex_);
+        ++rescan_stats_.rescans;
+        rescan_stats_.files_examined += examined;
+        rescan_stats_.files_changed += changed;
+        rescan_stats_.rescan_ms += static_cast<uint64_t>(elapsed.count());
+    }
+
+    Logger::info("Rescanned " + root + ": " + std::to_string(examined) + " files examined, " +
+                 std::to_string(changed) + " changed, " + std::to_string(elapsed.count()) + " ms");
 }
 
-std::string FileMonitor::get_event_type(DWORD action) {
-    switch (action) {
-        case FILE_ACTION_ADDED:
-            return "created";
-        case FILE_ACTION_REMOVED:
-            return "deleted";
-        case FILE_ACTION_MODIFIED:
-            return "modified";
-        case FILE_ACTION_RENAMED_OLD_NAME:
-        case FILE_ACTION_RENAMED_NEW_NAME:
-            return "moved";
-        default:
-            return "unknown";
+std::string FileMonitor::expand_path(const std::string& path) {
+#ifdef _WIN32
+    // Expand environment variables such as %USERNAME%. Wide, so non-ASCII
+    // user names survive and the result may exceed MAX_PATH; the required
+    // size is asked for first and rechecked in case the environment changed.
+    std::wstring source = path_from_utf8(path).wstring();
+    std::wstring expanded(MAX_PATH, L'\0');
+    for (;;) {
+        DWORD length = ExpandEnvironmentStringsW(source.c_str(), &expanded[0],
+                                                 static_cast<DWORD>(expanded.size()));
+        if (length == 0) {
+            return path;
+        }
+        if (length <= expanded.size()) {
+            expanded.resize(length - 1);  // length counts the terminator
+            break;
+        }
+        expanded.resize(length);
+    }
+    std::string result;
+    append_utf16_as_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(expanded.data()),
+                                             expanded.size()), result);
+    return result;
+#else
+    // Leading ~ only; config paths are otherwise literal
+    if (!path.empty() && path[0] == '~') {
+        const char* home = std::getenv("HOME");
+        if (home) {
+            return std::string(home) + path.substr(1);
+        }
     }
+    return path;
+#endif
 }
 
 } // namespace cybersentinel
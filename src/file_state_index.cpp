@@ -0,0 +1,644 @@
+#include "file_state_index.h"
+#include "watcher_backend.h"
+#include "fnv_hash.h"
+#include "utf8.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+// File layout, little-endian, all sections 64-byte aligned:
+//
+//   Header
+//   uint64_t slots[slot_count]           hash table, 0 = empty
+//   Record records[record_capacity]      dense, append-only until rebuilt
+//   char heap[heap_capacity]             path names, append-only
+//
+// A slot is (upper 32 bits of the path hash << 32) | (record index + 1).
+// Linear probing at a load factor of at most 0.5.
+
+static const uint32_t kIndexMagic = 0x58465343; // "CSFX"
+static const uint32_t kIndexVersion = 1;
+static const uint32_t kMinRecordCapacity = 4096;
+static const uint64_t kHeapBytesPerRecord = 96;
+static const size_t kMaxNameLength = 0xFFFF;
+
+namespace {
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;       // power of two, at least 2 * record_capacity
+    uint32_t record_capacity;
+    uint32_t record_count;     // records written, including erased ones
+    uint32_t live_count;
+    uint64_t heap_capacity;
+    uint64_t heap_used;
+    uint32_t clean;            // set by close(), cleared while open
+    uint32_t reserved[5];
+};
+
+struct Record {
+    uint64_t path_hash;
+    uint64_t size;
+    int64_t mtime;
+    uint64_t file_id;
+    uint64_t content_hash;
+    uint32_t labels;
+    uint32_t rules_version;
+    uint64_t name_offset;
+    uint16_t name_length;
+    uint8_t live;
+    uint8_t reserved;
+    uint32_t checksum;         // of the bytes above
+};
+
+static_assert(sizeof(Header) == 64, "index header layout");
+static_assert(sizeof(Record) == 64, "index record layout");
+
+uint32_t record_checksum(const Record& record) {
+    uint64_t hash = fnv1a_64(std::string_view(reinterpret_cast<const char*>(&record),
+                                              offsetof(Record, checksum)));
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+uint32_t slot_count_for(uint32_t record_capacity) {
+    uint32_t count = 8;
+    while (count < record_capacity * 2) {
+        count *= 2;
+    }
+    return count;
+}
+
+size_t region_size(uint32_t slot_count, uint32_t record_capacity, uint64_t heap_capacity) {
+    return sizeof(Header) + slot_count * sizeof(uint64_t) + record_capacity * sizeof(Record) +
+           static_cast<size_t>(heap_capacity);
+}
+
+} // namespace
+
+struct FileStateIndex::Region {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    std::unique_ptr<uint8_t[]> memory;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    Region() = default;
+    ~Region() { unmap(); }
+
+    // Delete copy constructor and assignment
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+
+    Header* header() const { return reinterpret_cast<Header*>(data); }
+    uint64_t* slots() const { return reinterpret_cast<uint64_t*>(data + sizeof(Header)); }
+    Record* records() const {
+        return reinterpret_cast<Record*>(data + sizeof(Header) + header()->slot_count * sizeof(uint64_t));
+    }
+    char* heap() const {
+        return reinterpret_cast<char*>(records() + header()->record_capacity);
+    }
+
+    bool allocate(size_t bytes) {
+        memory.reset(new uint8_t[bytes]());
+        data = memory.get();
+        size = bytes;
+        return true;
+    }
+
+    // Map path; bytes > 0 creates or resizes the file, 0 maps it as it is
+    bool map(const std::string& path, size_t bytes);
+    void flush();
+    void unmap();
+
+    // Point a free slot at record index
+    void insert(uint64_t hash, uint32_t index) {
+        size_t mask = header()->slot_count - 1;
+        size_t slot = static_cast<size_t>(hash) & mask;
+        while (slots()[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots()[slot] = (hash & 0xFFFFFFFF00000000ULL) | (static_cast<uint64_t>(index) + 1);
+    }
+};
+
+#ifdef _WIN32
+
+bool FileStateIndex::Region::map(const std::string& path, size_t bytes) {
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                       bytes > 0 ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER length;
+    if (bytes > 0) {
+        length.QuadPart = static_cast<long long>(bytes);
+        if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file)) {
+            unmap();
+            return false;
+        }
+    } else if (!GetFileSizeEx(file, &length) || length.QuadPart < static_cast<long long>(sizeof(Header))) {
+        unmap();
+        return false;
+    }
+    size = static_cast<size_t>(length.QuadPart);
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    data = mapping ? static_cast<uint8_t*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0)) : nullptr;
+    if (!data) {
+        unmap();
+        return false;
+    }
+    return true;
+}
+
+void FileStateIndex::Region::flush() {
+    if (mapping) {
+        FlushViewOfFile(data, 0);
+        FlushFileBuffers(file);
+    }
+}
+
+void FileStateIndex::Region::unmap() {
+    if (mapping) {
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+    }
+    memory.reset();
+    data = nullptr;
+    size = 0;
+}
+
+#else
+
+bool FileStateIndex::Region::map(const std::string& path, size_t bytes) {
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC | (bytes > 0 ? O_CREAT | O_TRUNC : 0), 0600);
+    if (fd < 0) {
+        return false;
+    }
+
+    if (bytes > 0) {
+        if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+            unmap();
+            return false;
+        }
+    } else {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Header))) {
+            unmap();
+            return false;
+        }
+        bytes = static_cast<size_t>(info.st_size);
+    }
+    size = bytes;
+
+    void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        unmap();
+        return false;
+    }
+    data = static_cast<uint8_t*>(mapped);
+    return true;
+}
+
+void FileStateIndex::Region::flush() {
+    if (fd >= 0) {
+        msync(data, size, MS_SYNC);
+    }
+}
+
+void FileStateIndex::Region::unmap() {
+    if (fd >= 0) {
+        if (data) {
+            munmap(data, size);
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    memory.reset();
+    data = nullptr;
+    size = 0;
+}
+
+#endif
+
+FileStateIndex::FileStateIndex()
+    : region_(create_region("", kMinRecordCapacity, kMinRecordCapacity * kHeapBytesPerRecord)) {
+}
+
+FileStateIndex::~FileStateIndex() {
+    close();
+}
+
+std::unique_ptr<FileStateIndex::Region> FileStateIndex::create_region(
+        const std::string& path, uint32_t record_capacity, uint64_t heap_capacity) {
+    uint32_t slot_count = slot_count_for(record_capacity);
+    size_t bytes = region_size(slot_count, record_capacity, heap_capacity);
+
+    auto region = std::make_unique<Region>();
+    bool created = path.empty() ? region->allocate(bytes) : region->map(path, bytes);
+    if (!created) {
+        return nullptr;
+    }
+
+    Header* header = region->header();
+    std::memset(header, 0, sizeof(Header));
+    header->magic = kIndexMagic;
+    header->version = kIndexVersion;
+    header->slot_count = slot_count;
+    header->record_capacity = record_capacity;
+    header->heap_capacity = heap_capacity;
+    return region;
+}
+
+bool FileStateIndex::open(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    region_.reset();
+    path_ = path;
+
+    // Left behind by a rebuild that did not complete; the index itself is intact
+    std::error_code ec;
+    fs::remove(path + ".tmp", ec);
+
+    auto region = std::make_unique<Region>();
+    bool valid = false;
+    if (fs::exists(path, ec) && region->map(path, 0)) {
+        const Header* header = region->header();
+        valid = header->magic == kIndexMagic && header->version == kIndexVersion &&
+                header->slot_count == slot_count_for(header->record_capacity) &&
+                header->record_count <= header->record_capacity &&
+                region->size == region_size(header->slot_count, header->record_capacity,
+                                            header->heap_capacity);
+        if (!valid) {
+            Logger::warning("File state index " + path + " is not usable, starting a new one");
+        }
+    }
+
+    if (valid) {
+        region_ = std::move(region);
+        bool clean = region_->header()->clean != 0;
+        if (!clean) {
+            recover();
+        }
+        region_->header()->clean = 0;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        Logger::info("File state index " + path + ": " + std::to_string(region_->header()->live_count) +
+                     " entries " + (clean ? "mapped" : "recovered") + " in " +
+                     std::to_string(elapsed.count()) + " ms");
+        return true;
+    }
+
+    region.reset();
+    region_ = create_region(path, kMinRecordCapacity, kMinRecordCapacity * kHeapBytesPerRecord);
+    if (!region_) {
+        Logger::error("Failed to create file state index: " + path);
+        path_.clear();
+        region_ = create_region("", kMinRecordCapacity, kMinRecordCapacity * kHeapBytesPerRecord);
+        return false;
+    }
+    return true;
+}
+
+void FileStateIndex::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (path_.empty()) {
+        return;
+    }
+
+    region_->header()->clean = 1;
+    region_->flush();
+    region_ = create_region("", kMinRecordCapacity, kMinRecordCapacity * kHeapBytesPerRecord);
+    path_.clear();
+}
+
+void FileStateIndex::sync() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    region_->flush();
+}
+
+void FileStateIndex::recover() {
+    Header* header = region_->header();
+    Record* records = region_->records();
+    const char* heap = region_->heap();
+
+    // Rebuild the hash table from the records that verify; anything torn by
+    // the crash is dropped and will simply be classified again
+    std::memset(region_->slots(), 0, header->slot_count * sizeof(uint64_t));
+    header->live_count = 0;
+    uint64_t heap_used = 0;
+    uint32_t dropped = 0;
+
+    for (uint32_t i = 0; i < header->record_count; ++i) {
+        Record& record = records[i];
+        if (!record.live) {
+            continue;
+        }
+
+        bool valid = record.checksum == record_checksum(record) &&
+                     record.name_offset + record.name_length <= header->heap_capacity &&
+                     fnv1a_64(std::string_view(heap + record.name_offset, record.name_length)) ==
+                         record.path_hash;
+        if (!valid) {
+            record.live = 0;
+            record.checksum = record_checksum(record);
+            ++dropped;
+            continue;
+        }
+
+        region_->insert(record.path_hash, i);
+        ++header->live_count;
+        heap_used = (std::max)(heap_used, record.name_offset + record.name_length);
+    }
+
+    header->heap_used = heap_used;
+    if (dropped > 0) {
+        Logger::warning("File state index: dropped " + std::to_string(dropped) + " damaged entries");
+    }
+}
+
+bool FileStateIndex::find(const std::string& path, uint64_t hash, size_t& slot) const {
+    const uint64_t* slots = region_->slots();
+    const Record* records = region_->records();
+    const char* heap = region_->heap();
+    size_t mask = region_->header()->slot_count - 1;
+
+    for (slot = static_cast<size_t>(hash) & mask; slots[slot] != 0; slot = (slot + 1) & mask) {
+        if ((slots[slot] >> 32) != (hash >> 32)) {
+            continue;
+        }
+        const Record& record = records[(slots[slot] & 0xFFFFFFFF) - 1];
+        if (record.path_hash == hash && record.name_length == path.size() &&
+            std::memcmp(heap + record.name_offset, path.data(), path.size()) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FileStateIndex::remove_slot(size_t slot) {
+    // Backward-shift deletion keeps probe sequences intact without tombstones
+    uint64_t* slots = region_->slots();
+    const Record* records = region_->records();
+    size_t mask = region_->header()->slot_count - 1;
+
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; slots[next] != 0; next = (next + 1) & mask) {
+        size_t home = static_cast<size_t>(records[(slots[next] & 0xFFFFFFFF) - 1].path_hash) & mask;
+        bool stays = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!stays) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = 0;
+}
+
+bool FileStateIndex::grow(size_t name_length) {
+    const Header* old_header = region_->header();
+    const Record* old_records = region_->records();
+    const char* old_heap = region_->heap();
+
+    uint64_t live_heap = name_length;
+    for (uint32_t i = 0; i < old_header->record_count; ++i) {
+        if (old_records[i].live) {
+            live_heap += old_records[i].name_length;
+        }
+    }
+
+    // Room to double; erased records and their names are compacted away
+    uint32_t record_capacity = (std::max)(kMinRecordCapacity, (old_header->live_count + 1) * 2);
+    uint64_t heap_capacity = (std::max)(record_capacity * kHeapBytesPerRecord, live_heap * 2);
+
+    // Built beside the index and renamed over it, so a crash mid-rebuild
+    // leaves the old index in place
+    std::string tmp_path = path_.empty() ? "" : path_ + ".tmp";
+    auto fresh = create_region(tmp_path, record_capacity, heap_capacity);
+    if (!fresh) {
+        Logger::error("Failed to grow file state index to " + std::to_string(record_capacity) + " entries");
+        return false;
+    }
+
+    Header* header = fresh->header();
+    Record* records = fresh->records();
+    char* heap = fresh->heap();
+    for (uint32_t i = 0; i < old_header->record_count; ++i) {
+        const Record& old_record = old_records[i];
+        if (!old_record.live) {
+            continue;
+        }
+
+        Record& record = records[header->record_count];
+        record = old_record;
+        record.name_offset = header->heap_used;
+        record.checksum = record_checksum(record);
+        std::memcpy(heap + header->heap_used, old_heap + old_record.name_offset, old_record.name_length);
+
+        fresh->insert(record.path_hash, header->record_count);
+        header->heap_used += record.name_length;
+        ++header->record_count;
+        ++header->live_count;
+    }
+
+    if (path_.empty()) {
+        region_ = std::move(fresh);
+        return true;
+    }
+
+    fresh->flush();
+    fresh.reset();
+    region_.reset();
+
+    std::error_code ec;
+    fs::rename(tmp_path, path_, ec);
+    region_ = std::make_unique<Region>();
+    if (ec || !region_->map(path_, 0)) {
+        // The entries can be rebuilt by classifying again; keep going in memory
+        Logger::error("Failed to replace file state index " + path_ + ", continuing in memory");
+        path_.clear();
+        region_ = create_region("", kMinRecordCapacity, kMinRecordCapacity * kHeapBytesPerRecord);
+        return false;
+    }
+    return true;
+}
+
+bool FileStateIndex::lookup(const std::string& path, FileState& state) const {
+    uint64_t hash = fnv1a_64(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t slot;
+    if (!find(path, hash, slot)) {
+        return false;
+    }
+
+    const Record& record = region_->records()[(region_->slots()[slot] & 0xFFFFFFFF) - 1];
+    state.size = record.size;
+    state.mtime = record.mtime;
+    state.file_id = record.file_id;
+    state.content_hash = record.content_hash;
+    state.labels = record.labels;
+    state.rules_version = record.rules_version;
+    return true;
+}
+
+void FileStateIndex::update(const std::string& path, const FileState& state) {
+    // Such paths are never skipped, only classified every time
+    if (path.size() > kMaxNameLength) {
+        return;
+    }
+
+    uint64_t hash = fnv1a_64(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t slot;
+    Record* record;
+    if (find(path, hash, slot)) {
+        record = &region_->records()[(region_->slots()[slot] & 0xFFFFFFFF) - 1];
+    } else {
+        const Header* header = region_->header();
+        if (header->record_count == header->record_capacity ||
+            header->heap_used + path.size() > header->heap_capacity) {
+            if (!grow(path.size())) {
+                return;
+            }
+        }
+
+        // Name first: a record is only trusted once it verifies against it
+        Header* current = region_->header();
+        uint32_t index = current->record_count;
+        std::memcpy(region_->heap() + current->heap_used, path.data(), path.size());
+
+        record = &region_->records()[index];
+        record->path_hash = hash;
+        record->name_offset = current->heap_used;
+        record->name_length = static_cast<uint16_t>(path.size());
+        record->live = 1;
+        record->reserved = 0;
+
+        current->heap_used += path.size();
+        ++current->record_count;
+        ++current->live_count;
+        region_->insert(hash, index);
+    }
+
+    record->size = state.size;
+    record->mtime = state.mtime;
+    record->file_id = state.file_id;
+    record->content_hash = state.content_hash;
+    record->labels = state.labels;
+    record->rules_version = state.rules_version;
+    record->checksum = record_checksum(*record);
+}
+
+void FileStateIndex::erase(const std::string& path) {
+    uint64_t hash = fnv1a_64(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t slot;
+    if (!find(path, hash, slot)) {
+        return;
+    }
+
+    Record& record = region_->records()[(region_->slots()[slot] & 0xFFFFFFFF) - 1];
+    record.live = 0;
+    record.checksum = record_checksum(record);
+    --region_->header()->live_count;
+    remove_slot(slot);
+}
+
+std::vector<std::string> FileStateIndex::paths_under(const std::string& directory) const {
+    std::string prefix = directory;
+    if (prefix.empty() || prefix.back() != kPathSeparator) {
+        prefix.push_back(kPathSeparator);
+    }
+
+    // A sequential pass over the dense record array; only rescans and
+    // removable volume detach need it
+    std::vector<std::string> paths;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Header* header = region_->header();
+    const Record* records = region_->records();
+    const char* heap = region_->heap();
+
+    for (uint32_t i = 0; i < header->record_count; ++i) {
+        const Record& record = records[i];
+        if (record.live && record.name_length > prefix.size() &&
+            std::memcmp(heap + record.name_offset, prefix.data(), prefix.size()) == 0) {
+            paths.emplace_back(heap + record.name_offset, record.name_length);
+        }
+    }
+    return paths;
+}
+
+size_t FileStateIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return region_->header()->live_count;
+}
+
+size_t FileStateIndex::storage_bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return region_->size;
+}
+
+bool FileStateIndex::stat(const std::string& path, FileState& state) {
+#ifdef _WIN32
+    std::error_code ec;
+    fs::directory_entry entry(path_from_utf8(path), ec);
+    if (ec || !entry.is_regular_file(ec)) {
+        return false;
+    }
+
+    state.size = entry.file_size(ec);
+    if (ec) {
+        return false;
+    }
+    state.mtime = entry.last_write_time(ec).time_since_epoch().count();
+    state.file_id = 0;
+    return !ec;
+#else
+    // One stat() call instead of three through std::filesystem, and it
+    // yields the inode
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+
+    state.size = static_cast<uint64_t>(info.st_size);
+    state.mtime = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    state.file_id = static_cast<uint64_t>(info.st_ino);
+    return true;
+#endif
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,65 @@
+#include "heartbeat_scheduler.h"
+#include <algorithm>
+
+namespace cybersentinel {
+
+HeartbeatScheduler::HeartbeatScheduler(std::chrono::seconds interval,
+                                       std::chrono::seconds min_interval,
+                                       std::chrono::seconds max_interval) {
+    set_intervals(interval, min_interval, max_interval);
+}
+
+void HeartbeatScheduler::set_intervals(std::chrono::seconds interval,
+                                       std::chrono::seconds min_interval,
+                                       std::chrono::seconds max_interval) {
+    interval_ = std::max(interval, std::chrono::seconds(1));
+    min_interval_ = std::clamp(min_interval, std::chrono::seconds(1), interval_);
+    max_interval_ = std::max(max_interval, interval_);
+}
+
+bool HeartbeatScheduler::due(Clock::time_point now, Clock::time_point last_contact, bool degraded) {
+    // Always announce ourselves once at startup
+    if (!has_sent_) {
+        return true;
+    }
+
+    auto since_sent = now - last_sent_;
+
+    if (failures_ > 0) {
+        // interval, 2x, 4x ... after consecutive failures
+        auto backoff = interval_;
+        for (uint32_t i = 1; i < failures_ && backoff < max_interval_; ++i) {
+            backoff *= 2;
+        }
+        return since_sent >= std::min(backoff, max_interval_);
+    }
+
+    if (degraded) {
+        return since_sent >= min_interval_;
+    }
+
+    if (since_sent < interval_) {
+        return false;
+    }
+
+    // Recent traffic proves liveness; stretch until max_interval
+    if (now - last_contact < interval_ && since_sent < max_interval_) {
+        if (now - std::max(last_skip_, last_sent_) >= interval_) {
+            last_skip_ = now;
+            ++skipped_;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void HeartbeatScheduler::record_sent(Clock::time_point now, bool success) {
+    has_sent_ = true;
+    failures_ = success ? 0 : failures_ + 1;
+    last_sent_ = now;
+    last_skip_ = now;
+    ++sent_;
+}
+
+} // namespace cybersentinel
@@ -1,23 +1,80 @@
 #include "http_client.h"
 #include "logger.h"
+#include "metrics.h"
 #include <curl/curl.h>
+#include <algorithm>
 #include <sstream>
 
 namespace cybersentinel {
 
+// Requests queued beyond this are rejected instead of growing without bound
+static const size_t kMaxPendingRequests = 1024;
+
 // Callback for curl to write response data
 static size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     ((std::string*)userp)->append((char*)contents, size * nmemb);
     return size * nmemb;
 }
 
+// curl_global_init/cleanup are not thread-safe and must run once per process,
+// not once per client, so they are tied to a function-local static.
+static void ensure_curl_global_init() {
+    struct CurlGlobal {
+        CurlGlobal() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+        ~CurlGlobal() { curl_global_cleanup(); }
+    };
+    static CurlGlobal global;
+}
+
 HttpClient::HttpClient(const std::string& base_url)
-    : base_url_(base_url), timeout_(30) {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+    : base_url_(base_url), timeout_(30), http2_(false), max_in_flight_(16),
+      multi_(nullptr), share_(nullptr),
+      max_attempts_(3), retry_base_ms_(500), retry_max_ms_(10000),
+      breaker_threshold_(5), breaker_open_seconds_(30), breaker_max_open_seconds_(600) {
+    ensure_curl_global_init();
+
+    // The multi handle owns the connection and DNS caches for all transfers;
+    // TLS sessions are shared separately. Only the I/O thread touches either.
+    multi_ = curl_multi_init();
+    if (!multi_) {
+        Logger::error("Failed to initialize CURL multi handle");
+        return;
+    }
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+    share_ = curl_share_init();
+    if (share_) {
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    }
+
+    header_values_["Content-Type"] = "application/json";
+    header_values_["Accept"] = "application/json";
+    rebuild_headers();
+
+    running_ = true;
+    io_thread_ = std::thread([this]() { io_loop(); });
 }
 
 HttpClient::~HttpClient() {
-    curl_global_cleanup();
+    running_ = false;
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+    if (io_thread_.joinable()) {
+        io_thread_.join();
+    }
+
+    for (CURL* curl : idle_handles_) {
+        curl_easy_cleanup(curl);
+    }
+    idle_handles_.clear();
+
+    if (share_) {
+        curl_share_cleanup(share_);
+    }
+    if (multi_) {
+        curl_multi_cleanup(multi_);
+    }
 }
 
 void HttpClient::set_timeout(int seconds) {
@@ -25,25 +82,137 @@ void HttpClient::set_timeout(int seconds) {
 }
 
 void HttpClient::set_header(const std::string& key, const std::string& value) {
-    // Headers can be added per request if needed
+    std::lock_guard<std::mutex> lock(headers_mutex_);
+    header_values_[key] = value;
+    rebuild_headers();
+}
+
+void HttpClient::set_http2(bool enabled) {
+    http2_ = enabled;
+}
+
+void HttpClient::set_max_in_flight(size_t max_requests) {
+    max_in_flight_ = std::max<size_t>(1, max_requests);
+    if (multi_) {
+        curl_multi_wakeup(multi_);
+    }
+}
+
+void HttpClient::set_retry_policy(int max_attempts, int base_delay_ms, int max_delay_ms) {
+    max_attempts_ = std::max(1, max_attempts);
+    retry_base_ms_ = std::max(1, base_delay_ms);
+    retry_max_ms_ = std::max(base_delay_ms, max_delay_ms);
+}
+
+void HttpClient::set_circuit_breaker(int failure_threshold, int open_seconds, int max_open_seconds) {
+    std::lock_guard<std::mutex> lock(breakers_mutex_);
+    breaker_threshold_ = failure_threshold;
+    breaker_open_seconds_ = open_seconds;
+    breaker_max_open_seconds_ = max_open_seconds;
+}
+
+std::map<std::string, CircuitBreaker::Stats> HttpClient::circuit_stats() {
+    std::map<std::string, CircuitBreaker::Stats> stats;
+    std::lock_guard<std::mutex> lock(breakers_mutex_);
+    for (auto& entry : breakers_) {
+        stats[entry.first] = entry.second->stats();
+    }
+    return stats;
+}
+
+size_t HttpClient::queued_requests() {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    return pending_.size();
+}
+
+std::shared_ptr<CircuitBreaker> HttpClient::breaker_for(const std::string& endpoint) {
+    // "/events?delay_ms=100" is the same endpoint as "/events"
+    std::string path = endpoint.substr(0, endpoint.find('?'));
+
+    std::lock_guard<std::mutex> lock(breakers_mutex_);
+    auto it = breakers_.find(path);
+    if (it != breakers_.end()) {
+        return it->second;
+    }
+
+    // A closed breaker nothing holds carries no state worth keeping; open
+    // ones stay so their endpoints keep failing fast
+    if (breakers_.size() >= kMaxBreakers) {
+        for (auto entry = breakers_.begin(); entry != breakers_.end();) {
+            if (entry->second.use_count() == 1 &&
+                entry->second->stats().state == CircuitBreaker::State::CLOSED) {
+                entry = breakers_.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+    }
+
+    auto breaker = std::make_shared<CircuitBreaker>(
+        path, breaker_threshold_,
+        std::chrono::seconds(breaker_open_seconds_),
+        std::chrono::seconds(breaker_max_open_seconds_));
+    breakers_.emplace(path, breaker);
+    return breaker;
+}
+
+std::future<HttpResponse> HttpClient::request_async(const std::string& method,
+                                                    const std::string& endpoint,
+                                                    const std::string& data,
+                                                    int timeout_ms,
+                                                    const std::string& content_type) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->method = method;
+    transfer->url = build_url(endpoint);
+    transfer->data = data;
+    transfer->breaker = breaker_for(endpoint);
+
+    std::future<HttpResponse> future = transfer->promise.get_future();
+    submit(std::move(transfer), timeout_ms, content_type);
+    return future;
+}
+
+void HttpClient::request_async(const std::string& method,
+                               const std::string& endpoint,
+                               const std::string& data,
+                               HttpCallback callback,
+                               int timeout_ms,
+                               const std::string& content_type) {
+    auto transfer = std::make_unique<Transfer>();
+    transfer->method = method;
+    transfer->url = build_url(endpoint);
+    transfer->data = data;
+    transfer->breaker = breaker_for(endpoint);
+    transfer->callback = std::move(callback);
+
+    submit(std::move(transfer), timeout_ms, content_type);
 }
 
 HttpResponse HttpClient::get(const std::string& endpoint) {
     return perform_request("GET", endpoint);
 }
 
-HttpResponse HttpClient::post(const std::string& endpoint, const std::string& data) {
-    return perform_request("POST", endpoint, data);
+HttpResponse HttpClient::post(const std::string& endpoint, const std::string& data,
+                              const std::string& content_type) {
+    return perform_request("POST", endpoint, data, content_type);
 }
 
-HttpResponse HttpClient::put(const std::string& endpoint, const std::string& data) {
-    return perform_request("PUT", endpoint, data);
+HttpResponse HttpClient::put(const std::string& endpoint, const std::string& data,
+                             const std::string& content_type) {
+    return perform_request("PUT", endpoint, data, content_type);
 }
 
 HttpResponse HttpClient::del(const std::string& endpoint) {
     return perform_request("DELETE", endpoint);
 }
 
+HttpResponse HttpClient::perform_request(const std::string& method,
+                                        const std::string& endpoint,
+                                        const std::string& data,
+                                        const std::string& content_type) {
+    return request_async(method, endpoint, data, 0, content_type).get();
+}
+
 std::string HttpClient::build_url(const std::string& endpoint) {
     std::string url = base_url_;
     if (!url.empty() && url.back() == '/' && !endpoint.empty() && endpoint[0] == '/') {
@@ -52,72 +221,347 @@ std::string HttpClient::build_url(const std::string& endpoint) {
     return url + endpoint;
 }
 
-HttpResponse HttpClient::perform_request(const std::string& method,
-                                        const std::string& endpoint,
-                                        const std::string& data) {
-    CURL* curl = curl_easy_init();
-    if (!curl) {
-        Logger::error("Failed to initialize CURL");
-        return HttpResponse(0, "");
-    }
-
-    std::string response_body;
-    std::string url = build_url(endpoint);
-    long response_code = 0;
-
-    try {
-        // Set URL
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-
-        // Set timeout
-        curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_);
-
-        // Set response callback
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_body);
-
-        // Set headers
-        struct curl_slist* headers = nullptr;
-        headers = curl_slist_append(headers, "Content-Type: application/json");
-        headers = curl_slist_append(headers, "Accept: application/json");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-        // Set method and data
-        if (method == "POST") {
-            curl_easy_setopt(curl, CURLOPT_POST, 1L);
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
-        } else if (method == "PUT") {
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data.c_str());
-        } else if (method == "DELETE") {
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+void HttpClient::rebuild_headers() {
+    // Caller holds headers_mutex_ (or is the constructor)
+    struct curl_slist* list = nullptr;
+    for (const auto& header : header_values_) {
+        list = curl_slist_append(list, (header.first + ": " + header.second).c_str());
+    }
+    headers_ = std::shared_ptr<curl_slist>(list, curl_slist_free_all);
+    typed_headers_.clear();
+}
+
+std::shared_ptr<curl_slist> HttpClient::headers_for(const std::string& content_type) {
+    // Caller holds headers_mutex_
+    if (content_type.empty()) {
+        return headers_;
+    }
+
+    auto it = typed_headers_.find(content_type);
+    if (it != typed_headers_.end()) {
+        return it->second;
+    }
+
+    struct curl_slist* list = nullptr;
+    for (const auto& header : header_values_) {
+        const std::string& value = header.first == "Content-Type" ? content_type : header.second;
+        list = curl_slist_append(list, (header.first + ": " + value).c_str());
+    }
+    auto headers = std::shared_ptr<curl_slist>(list, curl_slist_free_all);
+    typed_headers_[content_type] = headers;
+    return headers;
+}
+
+void HttpClient::submit(std::unique_ptr<Transfer> transfer, int timeout_ms,
+                        const std::string& content_type) {
+    if (timeout_ms <= 0) {
+        timeout_ms = timeout_ * 1000;
+    }
+    transfer->submitted = std::chrono::steady_clock::now();
+    transfer->deadline = transfer->submitted + std::chrono::milliseconds(timeout_ms);
+    {
+        std::lock_guard<std::mutex> lock(headers_mutex_);
+        transfer->headers = headers_for(content_type);
+    }
+
+    if (!multi_ || !running_) {
+        complete(transfer.get(), HttpResponse(0, ""));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_.size() < kMaxPendingRequests) {
+            pending_.push_back(std::move(transfer));
+        }
+    }
+
+    if (transfer) {
+        Logger::warning("HTTP request queue full, dropping request to " + transfer->url);
+        complete(transfer.get(), HttpResponse(0, ""));
+        return;
+    }
+
+    curl_multi_wakeup(multi_);
+}
+
+void HttpClient::io_loop() {
+    while (running_) {
+        start_pending_transfers();
+
+        int still_running = 0;
+        curl_multi_perform(multi_, &still_running);
+
+        bool finished_any = false;
+        int messages_left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &messages_left)) {
+            if (msg->msg == CURLMSG_DONE) {
+                finish_transfer(msg->easy_handle, msg->data.result);
+                finished_any = true;
+            }
+        }
+
+        // Freed slots are refilled right away rather than after the next poll
+        if (finished_any) {
+            continue;
         }
-        // GET is default
 
-        // Perform request
-        CURLcode res = curl_easy_perform(curl);
+        // Sleeps until socket activity, a curl timer, a due retry or curl_multi_wakeup
+        curl_multi_poll(multi_, nullptr, 0, static_cast<int>(poll_timeout_ms()), nullptr);
+    }
+
+    // Fail everything still outstanding so no caller waits forever
+    for (auto& transfer : in_flight_) {
+        curl_multi_remove_handle(multi_, transfer->curl);
+        release_handle(transfer->curl);
+        complete(transfer.get(), HttpResponse(0, ""));
+    }
+    in_flight_.clear();
+
+    for (auto& transfer : retry_wait_) {
+        complete(transfer.get(), HttpResponse(0, ""));
+    }
+    retry_wait_.clear();
+
+    std::deque<std::unique_ptr<Transfer>> pending;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending.swap(pending_);
+    }
+    for (auto& transfer : pending) {
+        complete(transfer.get(), HttpResponse(0, ""));
+    }
+}
+
+long HttpClient::poll_timeout_ms() {
+    long timeout = 1000;
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& transfer : retry_wait_) {
+        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+            transfer->not_before - now).count();
+        timeout = std::min<long>(timeout, std::max<long>(0, static_cast<long>(wait)));
+    }
+    return timeout;
+}
+
+void HttpClient::start_pending_transfers() {
+    auto now = std::chrono::steady_clock::now();
+
+    while (in_flight_.size() < max_in_flight_) {
+        std::unique_ptr<Transfer> transfer;
 
-        if (res != CURLE_OK) {
-            Logger::error("HTTP request failed: " + std::string(curl_easy_strerror(res)));
-            curl_slist_free_all(headers);
-            curl_easy_cleanup(curl);
-            return HttpResponse(0, "");
+        // Due retries go first, they have been waiting longest
+        auto due = std::find_if(retry_wait_.begin(), retry_wait_.end(),
+                                [now](const std::unique_ptr<Transfer>& t) { return t->not_before <= now; });
+        if (due != retry_wait_.end()) {
+            transfer = std::move(*due);
+            retry_wait_.erase(due);
+        } else {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            if (pending_.empty()) {
+                return;
+            }
+            transfer = std::move(pending_.front());
+            pending_.pop_front();
         }
 
-        // Get response code
+        if (now >= transfer->deadline) {
+            Logger::error("HTTP request failed: deadline expired before sending to " + transfer->url);
+            complete(transfer.get(), HttpResponse(0, ""));
+            continue;
+        }
+
+        // Fail fast without touching the network while the endpoint's circuit is open
+        if (transfer->breaker && !transfer->breaker->allow_request()) {
+            complete(transfer.get(), HttpResponse(0, ""));
+            continue;
+        }
+
+        if (!start_transfer(transfer.get())) {
+            // Never reached the server, so it says nothing about the endpoint;
+            // free the probe slot if this was the half-open probe
+            if (transfer->breaker) {
+                transfer->breaker->release_probe();
+            }
+            complete(transfer.get(), HttpResponse(0, ""));
+            continue;
+        }
+        in_flight_.push_back(std::move(transfer));
+    }
+}
+
+bool HttpClient::start_transfer(Transfer* transfer) {
+    CURL* curl = acquire_handle();
+    if (!curl) {
+        Logger::error("Failed to initialize CURL");
+        return false;
+    }
+    transfer->curl = curl;
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        transfer->deadline - std::chrono::steady_clock::now()).count();
+
+    if (share_) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+    }
+
+    // Set URL and per-request deadline
+    curl_easy_setopt(curl, CURLOPT_URL, transfer->url.c_str());
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, static_cast<long>(std::max<long long>(1, remaining)));
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+    // Keep idle connections alive between heartbeats and events
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 60L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 30L);
+
+    if (http2_) {
+        // Falls back to HTTP/1.1 when the server does not negotiate h2
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    // Set response callback
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response_body);
+
+    // Set headers
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers.get());
+
+    // Set method and data
+    if (transfer->method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->data.size()));
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->data.c_str());
+    } else if (transfer->method == "PUT") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->data.size()));
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->data.c_str());
+    } else if (transfer->method == "DELETE") {
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
+    }
+    // GET is default
+
+    if (curl_multi_add_handle(multi_, curl) != CURLM_OK) {
+        Logger::error("Failed to add HTTP request to CURL multi handle");
+        release_handle(curl);
+        return false;
+    }
+    return true;
+}
+
+void HttpClient::finish_transfer(CURL* curl, int result) {
+    auto it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                           [curl](const std::unique_ptr<Transfer>& t) { return t->curl == curl; });
+    curl_multi_remove_handle(multi_, curl);
+
+    if (it == in_flight_.end()) {
+        release_handle(curl);
+        return;
+    }
+
+    std::unique_ptr<Transfer> transfer = std::move(*it);
+    in_flight_.erase(it);
+
+    HttpResponse response;
+    std::string error;
+    if (result != CURLE_OK) {
+        error = curl_easy_strerror(static_cast<CURLcode>(result));
+    } else {
+        long response_code = 0;
         curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+        response = HttpResponse(static_cast<int>(response_code), std::move(transfer->response_body));
+    }
 
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+    // Return the handle to the pool so its connection can be reused
+    release_handle(curl);
+    transfer->curl = nullptr;
 
-        return HttpResponse(static_cast<int>(response_code), response_body);
+    // Any answer short of 429/5xx proves the endpoint is alive
+    bool failed = response.status_code == 0 || response.status_code == 429 ||
+                  response.status_code >= 500;
+    if (transfer->breaker) {
+        if (failed) {
+            transfer->breaker->record_failure();
+        } else {
+            transfer->breaker->record_success();
+        }
+    }
 
-    } catch (const std::exception& e) {
-        Logger::error("HTTP request exception: " + std::string(e.what()));
-        curl_easy_cleanup(curl);
-        return HttpResponse(0, "");
+    if (schedule_retry(transfer, response, failed)) {
+        return;
+    }
+
+    if (!error.empty()) {
+        Logger::error("HTTP request failed: " + error);
     }
+    complete(transfer.get(), response);
+}
+
+bool HttpClient::schedule_retry(std::unique_ptr<Transfer>& transfer, const HttpResponse& response,
+                                bool failed) {
+    if (!failed || transfer->attempt + 1 >= max_attempts_ || !running_) {
+        return false;
+    }
+
+    auto delay = jittered_backoff(transfer->attempt,
+                                  std::chrono::milliseconds(retry_base_ms_),
+                                  std::chrono::milliseconds(retry_max_ms_));
+    auto now = std::chrono::steady_clock::now();
+    if (now + delay >= transfer->deadline) {
+        return false;
+    }
+
+    CS_LOG_DEBUG("Retrying {} {} in {}ms (HTTP {})", transfer->method, transfer->url, delay.count(),
+                 response.status_code);
+
+    static Counter& retries = Metrics::counter("cybersentinel_http_retries_total",
+                                               "HTTP request attempts retried after a failure.");
+    retries.add();
+    ++transfer->attempt;
+    transfer->not_before = now + delay;
+    transfer->response_body.clear();
+    retry_wait_.push_back(std::move(transfer));
+    return true;
+}
+
+void HttpClient::complete(Transfer* transfer, const HttpResponse& response) {
+    static Histogram& latency = Metrics::stage("upload");
+    static Counter& requests = Metrics::counter("cybersentinel_http_requests_total",
+                                                "HTTP requests completed, after retries.");
+    static Counter& failures = Metrics::counter("cybersentinel_http_failures_total",
+                                                "HTTP requests that ended without a 2xx response.");
+    latency.record(std::chrono::steady_clock::now() - transfer->submitted);
+    requests.add();
+    if (response.status_code < 200 || response.status_code >= 300) {
+        failures.add();
+    }
+
+    if (transfer->callback) {
+        try {
+            transfer->callback(response);
+        } catch (const std::exception& e) {
+            Logger::error("HTTP callback exception: " + std::string(e.what()));
+        }
+    } else {
+        transfer->promise.set_value(response);
+    }
+}
+
+CURL* HttpClient::acquire_handle() {
+    if (!idle_handles_.empty()) {
+        CURL* curl = idle_handles_.back();
+        idle_handles_.pop_back();
+        return curl;
+    }
+    return curl_easy_init();
+}
+
+void HttpClient::release_handle(CURL* curl) {
+    // curl_easy_reset keeps live connections and caches, only options are cleared
+    curl_easy_reset(curl);
+    idle_handles_.push_back(curl);
 }
 
 } // namespace cybersentinel
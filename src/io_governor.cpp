@@ -0,0 +1,229 @@
+#include "io_governor.h"
+#include "token_bucket.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+namespace cybersentinel {
+
+// How often system activity is re-sampled to decide whether to relax
+static const auto kSampleInterval = std::chrono::seconds(1);
+
+namespace {
+
+struct GovernorState {
+    std::mutex mutex;
+    IoGovernor::Limits limits;
+    std::atomic<bool> enabled{false};
+    TokenBucket bytes;
+    TokenBucket reads;
+
+    // Activity sampling
+    bool idle = false;
+    std::chrono::steady_clock::time_point sampled;
+    double last_busy = 0.0;
+    double last_total = 0.0;
+    double last_own = 0.0;
+
+    std::atomic<uint64_t> read_count{0};
+    std::atomic<uint64_t> byte_count{0};
+    std::atomic<uint64_t> throttled_count{0};
+    std::atomic<uint64_t> wait_ms{0};
+    std::atomic<uint64_t> priority_count{0};
+};
+
+GovernorState& state() {
+    static GovernorState instance;
+    return instance;
+}
+
+// CPU seconds: busy and total summed over all CPUs, and used by this process
+bool read_cpu_times(double& busy, double& total, double& own) {
+#ifdef _WIN32
+    FILETIME idle_time, kernel_time, user_time;
+    FILETIME creation, exit, process_kernel, process_user;
+    if (!GetSystemTimes(&idle_time, &kernel_time, &user_time) ||
+        !GetProcessTimes(GetCurrentProcess(), &creation, &exit, &process_kernel, &process_user)) {
+        return false;
+    }
+
+    auto seconds = [](const FILETIME& time) {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;
+    };
+
+    // Kernel time includes idle time
+    total = seconds(kernel_time) + seconds(user_time);
+    busy = total - seconds(idle_time);
+    own = seconds(process_kernel) + seconds(process_user);
+    return true;
+#else
+    std::FILE* file = std::fopen("/proc/stat", "r");
+    if (!file) {
+        return false;
+    }
+
+    unsigned long long user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+    int fields = std::fscanf(file, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
+                             &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
+    std::fclose(file);
+    if (fields < 4) {
+        return false;
+    }
+
+    double ticks = static_cast<double>(sysconf(_SC_CLK_TCK));
+    busy = (user + nice + system + irq + softirq + steal) / ticks;
+    total = busy + (idle + iowait) / ticks;
+
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return false;
+    }
+    own = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+          (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    return true;
+#endif
+}
+
+} // namespace
+
+void IoGovernor::configure(const Limits& limits) {
+    GovernorState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.limits = limits;
+    s.idle = false;
+    s.sampled = std::chrono::steady_clock::time_point();
+    s.enabled = limits.max_bytes_per_sec > 0.0 || limits.max_iops > 0.0;
+    apply_rates();
+}
+
+void IoGovernor::disable() {
+    GovernorState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.enabled = false;
+}
+
+std::chrono::milliseconds IoGovernor::acquire(uint64_t bytes, Priority priority) {
+    GovernorState& s = state();
+    ++s.read_count;
+    s.byte_count += bytes;
+
+    if (!s.enabled) {
+        return std::chrono::milliseconds(0);
+    }
+
+    sample_activity();
+
+    auto delay = (std::max)(s.reads.take(1.0), s.bytes.take(static_cast<double>(bytes)));
+    if (priority == Priority::HIGH) {
+        // Priority reads may run up to one burst of debt without waiting;
+        // past that they are paced like any other read
+        ++s.priority_count;
+        double burst_seconds;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            burst_seconds = s.limits.burst_seconds;
+        }
+        delay -= std::chrono::microseconds(static_cast<long long>(burst_seconds * 1e6));
+    }
+    if (delay.count() <= 0) {
+        return std::chrono::milliseconds(0);
+    }
+
+    // Waits in slices so disable() releases readers promptly
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + delay;
+    while (s.enabled && std::chrono::steady_clock::now() < deadline) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        std::this_thread::sleep_for((std::min)(remaining, std::chrono::microseconds(100000)));
+    }
+
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    ++s.throttled_count;
+    s.wait_ms += static_cast<uint64_t>(waited.count());
+    return waited;
+}
+
+IoGovernor::Stats IoGovernor::stats() {
+    GovernorState& s = state();
+    Stats stats;
+    stats.reads = s.read_count;
+    stats.bytes = s.byte_count;
+    stats.throttled_reads = s.throttled_count;
+    stats.throttle_wait_ms = s.wait_ms;
+    stats.priority_reads = s.priority_count;
+
+    std::lock_guard<std::mutex> lock(s.mutex);
+    stats.idle = s.idle;
+    return stats;
+}
+
+void IoGovernor::sample_activity() {
+    GovernorState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - s.sampled < kSampleInterval) {
+        return;
+    }
+
+    double busy, total, own;
+    if (!read_cpu_times(busy, total, own)) {
+        s.sampled = now;
+        return;
+    }
+
+    bool first = s.sampled == std::chrono::steady_clock::time_point();
+    double busy_delta = busy - s.last_busy;
+    double total_delta = total - s.last_total;
+    double own_delta = own - s.last_own;
+    s.sampled = now;
+    s.last_busy = busy;
+    s.last_total = total;
+    s.last_own = own;
+
+    if (first || total_delta <= 0.0) {
+        return;
+    }
+
+    // The agent's own classification work does not make the system busy
+    double others_percent = (std::max)(0.0, busy_delta - own_delta) / total_delta * 100.0;
+    bool idle = others_percent < s.limits.idle_cpu_percent;
+    if (idle != s.idle) {
+        s.idle = idle;
+        apply_rates();
+        CS_LOG_DEBUG("I/O governor: system {} read caps (others' CPU {}%)",
+                     idle ? "idle, relaxing" : "busy, restoring", static_cast<int>(others_percent));
+    }
+}
+
+void IoGovernor::apply_rates() {
+    // Called with the state mutex held
+    GovernorState& s = state();
+    const Limits& limits = s.limits;
+
+    double scale = 1.0;
+    if (s.idle) {
+        scale = limits.idle_multiplier;
+    }
+
+    // A scale of 0 while idle maps to a rate of 0, which TokenBucket treats
+    // as unlimited
+    double byte_rate = limits.max_bytes_per_sec * scale;
+    double read_rate = limits.max_iops * scale;
+    s.bytes.set_rate(byte_rate, byte_rate * limits.burst_seconds);
+    s.reads.set_rate(read_rate, read_rate * limits.burst_seconds);
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,167 @@
+#include "json_writer.h"
+#include "utf8.h"
+#include <charconv>
+#include <cmath>
+
+namespace cybersentinel {
+
+static const char kHexDigits[] = "0123456789abcdef";
+
+JsonWriter::JsonWriter(std::string& out)
+    : out_(out), need_comma_(0), depth_(0), after_key_(false) {
+}
+
+std::string& JsonWriter::thread_buffer() {
+    static thread_local std::string buffer;
+    buffer.clear();
+    return buffer;
+}
+
+void JsonWriter::separator() {
+    if (after_key_) {
+        after_key_ = false;
+        return;
+    }
+
+    uint64_t bit = uint64_t(1) << (depth_ & 63);
+    if (need_comma_ & bit) {
+        out_.push_back(',');
+    }
+    need_comma_ |= bit;
+}
+
+void JsonWriter::begin_object() {
+    separator();
+    out_.push_back('{');
+    ++depth_;
+    need_comma_ &= ~(uint64_t(1) << (depth_ & 63));
+}
+
+void JsonWriter::end_object() {
+    --depth_;
+    out_.push_back('}');
+}
+
+void JsonWriter::begin_array() {
+    separator();
+    out_.push_back('[');
+    ++depth_;
+    need_comma_ &= ~(uint64_t(1) << (depth_ & 63));
+}
+
+void JsonWriter::end_array() {
+    --depth_;
+    out_.push_back(']');
+}
+
+void JsonWriter::key(std::string_view name) {
+    separator();
+    write_string(name);
+    out_.push_back(':');
+    after_key_ = true;
+}
+
+void JsonWriter::value(std::string_view text) {
+    separator();
+    write_string(text);
+}
+
+void JsonWriter::value(const char* text) {
+    if (!text) {
+        null_value();
+        return;
+    }
+    value(std::string_view(text));
+}
+
+void JsonWriter::value(bool flag) {
+    separator();
+    out_.append(flag ? "true" : "false");
+}
+
+void JsonWriter::value(int number) {
+    value(static_cast<int64_t>(number));
+}
+
+void JsonWriter::value(int64_t number) {
+    separator();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, result.ptr);
+}
+
+void JsonWriter::value(uint64_t number) {
+    separator();
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, result.ptr);
+}
+
+void JsonWriter::value(double number) {
+    separator();
+    if (!std::isfinite(number)) {
+        // JSON has no representation for NaN or infinity
+        out_.append("null");
+        return;
+    }
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out_.append(digits, result.ptr);
+}
+
+void JsonWriter::null_value() {
+    separator();
+    out_.append("null");
+}
+
+void JsonWriter::write_string(std::string_view text) {
+    out_.push_back('"');
+
+    size_t run_start = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+
+        // Fast path: plain ASCII that needs no escaping is copied in runs
+        if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+            ++i;
+            continue;
+        }
+
+        if (c >= 0x80) {
+            size_t length = utf8_sequence_length(text, i);
+            if (length > 0) {
+                i += length;
+                continue;
+            }
+        }
+
+        out_.append(text.data() + run_start, i - run_start);
+
+        switch (c) {
+            case '"':  out_.append("\\\""); break;
+            case '\\': out_.append("\\\\"); break;
+            case '\b': out_.append("\\b"); break;
+            case '\f': out_.append("\\f"); break;
+            case '\n': out_.append("\\n"); break;
+            case '\r': out_.append("\\r"); break;
+            case '\t': out_.append("\\t"); break;
+            default:
+                if (c < 0x20) {
+                    char escape[6] = { '\\', 'u', '0', '0', kHexDigits[c >> 4], kHexDigits[c & 0xF] };
+                    out_.append(escape, sizeof(escape));
+                } else {
+                    out_.append("\\ufffd");
+                }
+                break;
+        }
+
+        ++i;
+        run_start = i;
+    }
+
+    out_.append(text.data() + run_start, text.size() - run_start);
+    out_.push_back('"');
+}
+
+} // namespace cybersentinel
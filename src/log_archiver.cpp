@@ -0,0 +1,344 @@
+#include "log_archiver.h"
+#include "logger.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <map>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#undef ERROR  // wingdi.h; clashes with Logger::Level::ERROR
+#endif
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+// "yyyymmdd-hhmmss-nnnn" between the stem and the extension
+static const size_t kStampLength = 20;
+
+static const size_t kCopyBufferBytes = 64 * 1024;
+
+namespace {
+
+enum class SegmentForm {
+    PLAIN,
+    COMPRESSED,
+    PARTIAL  // .gz.tmp left by a run that stopped mid-compression
+};
+
+// Splits a directory entry into the segment it belongs to and its form;
+// false for the live log and anything else in the directory
+bool parse_segment(const std::string& name, const std::string& stem, const std::string& extension,
+                   std::string& base, SegmentForm& form) {
+    std::string prefix = stem + ".";
+    if (name.size() < prefix.size() + kStampLength + extension.size() || name.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+
+    for (size_t i = 0; i < kStampLength; ++i) {
+        char c = name[prefix.size() + i];
+        bool dash = i == 8 || i == 15;
+        if (dash ? c != '-' : !std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
+        }
+    }
+
+    size_t base_length = prefix.size() + kStampLength + extension.size();
+    if (name.compare(prefix.size() + kStampLength, extension.size(), extension) != 0) {
+        return false;
+    }
+
+    std::string suffix = name.substr(base_length);
+    if (suffix.empty()) {
+        form = SegmentForm::PLAIN;
+    } else if (suffix == ".gz") {
+        form = SegmentForm::COMPRESSED;
+    } else if (suffix == ".gz.tmp") {
+        form = SegmentForm::PARTIAL;
+    } else {
+        return false;
+    }
+    base = name.substr(0, base_length);
+    return true;
+}
+
+struct SegmentFiles {
+    bool plain = false;
+    bool compressed = false;
+    bool partial = false;
+};
+
+// Segments of log_path by name, oldest first
+std::map<std::string, SegmentFiles> list_segments(const std::string& log_path) {
+    std::map<std::string, SegmentFiles> segments;
+    fs::path path(log_path);
+    fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+    std::string stem = path.stem().string();
+    std::string extension = path.extension().string();
+
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::string base;
+        SegmentForm form = SegmentForm::PLAIN;
+        if (!parse_segment(it->path().filename().string(), stem, extension, base, form)) {
+            continue;
+        }
+        SegmentFiles& files = segments[(directory / base).string()];
+        switch (form) {
+            case SegmentForm::PLAIN:      files.plain = true; break;
+            case SegmentForm::COMPRESSED: files.compressed = true; break;
+            case SegmentForm::PARTIAL:    files.partial = true; break;
+        }
+    }
+    return segments;
+}
+
+} // namespace
+
+LogArchiver::~LogArchiver() {
+    stop();
+}
+
+void LogArchiver::configure(const std::string& log_path, int max_files, bool compress) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_path_ = log_path;
+    max_files_ = (std::max)(0, max_files);
+    compress_ = compress;
+}
+
+std::string LogArchiver::next_segment_path(const std::string& log_path) {
+    fs::path path(log_path);
+    std::string stem = path.stem().string();
+    std::string extension = path.extension().string();
+
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm tm_buf;
+#ifdef _WIN32
+    localtime_s(&tm_buf, &now);
+#else
+    localtime_r(&now, &tm_buf);
+#endif
+    char stamp[16];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm_buf);
+
+    // Several rotations within a second, or a restart within it
+    std::string candidate;
+    for (int n = 0; n < 10000; ++n) {
+        char name_suffix[32];
+        std::snprintf(name_suffix, sizeof(name_suffix), ".%s-%04d", stamp, n);
+        candidate = path.parent_path().empty() ? stem + name_suffix + extension
+                                               : (path.parent_path() / (stem + name_suffix + extension)).string();
+
+        std::error_code ec;
+        if (!fs::exists(candidate, ec) && !fs::exists(candidate + ".gz", ec)) {
+            break;
+        }
+    }
+    return candidate;
+}
+
+void LogArchiver::submit(const std::string& segment) {
+    std::string overflow;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(segment);
+
+        // Logging faster than this thread compresses: at most max_files
+        // segments wait, the oldest beyond that is deleted here
+        size_t waiting = static_cast<size_t>(std::count_if(queue_.begin(), queue_.end(),
+                                       [](const std::string& queued) { return !queued.empty(); }));
+        if (!segment.empty() && waiting > static_cast<size_t>(max_files_)) {
+            auto oldest = std::find_if(queue_.begin(), queue_.end(),
+                                       [](const std::string& queued) { return !queued.empty(); });
+            overflow = *oldest;
+            queue_.erase(oldest);
+        }
+
+        if (!thread_.joinable()) {
+            stopping_ = false;
+            thread_ = std::thread([this]() { run(); });
+        }
+    }
+    cv_.notify_one();
+
+    std::error_code ec;
+    if (!overflow.empty() && fs::remove(overflow, ec)) {
+        ++removed_;
+    }
+}
+
+void LogArchiver::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+        drain_on_stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void LogArchiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) {
+            return;
+        }
+        stopping_ = true;
+        drain_on_stop_ = false;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+LogArchiver::Stats LogArchiver::stats() const {
+    Stats stats;
+    stats.archived = archived_;
+    stats.removed = removed_;
+    return stats;
+}
+
+void LogArchiver::run() {
+#ifdef _WIN32
+    // Lowers I/O priority too: compression must not compete with the
+    // agent's own reads or the user's work
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+
+    for (;;) {
+        std::string segment;
+        std::string log_path;
+        int max_files;
+        bool compress;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (stopping_ && (!drain_on_stop_ || queue_.empty())) {
+                return;
+            }
+            segment = queue_.front();
+            queue_.pop_front();
+            log_path = log_path_;
+            max_files = max_files_;
+            compress = compress_;
+        }
+
+        handle(segment, log_path, max_files, compress);
+    }
+}
+
+void LogArchiver::handle(const std::string& segment, const std::string& log_path, int max_files, bool compress) {
+    if (log_path.empty()) {
+        return;
+    }
+
+    if (!segment.empty()) {
+        // When logging outpaces compression, segments past retention are
+        // deleted rather than compressed first
+        prune(log_path, max_files);
+        if (compress) {
+            compress_segment(segment);
+        }
+    } else {
+        // Scan: finish what an earlier run left behind
+        std::error_code ec;
+        for (const auto& entry : list_segments(log_path)) {
+            if (entry.second.partial) {
+                fs::remove(entry.first + ".gz.tmp", ec);
+            }
+            if (entry.second.plain && entry.second.compressed) {
+                fs::remove(entry.first, ec);
+            } else if (entry.second.plain && compress) {
+                compress_segment(entry.first);
+            }
+        }
+    }
+
+    prune(log_path, max_files);
+}
+
+// Written to a temporary name first, so a .gz is always complete
+bool LogArchiver::compress_segment(const std::string& segment) {
+    std::FILE* in = std::fopen(segment.c_str(), "rb");
+    if (!in) {
+        // Retention may already have deleted it
+        std::error_code ec;
+        if (fs::exists(segment, ec)) {
+            Logger::warning("Log archive: cannot open " + segment);
+        }
+        return false;
+    }
+
+    std::string target = segment + ".gz";
+    std::string partial = target + ".tmp";
+    gzFile out = gzopen(partial.c_str(), "wb6");
+    if (!out) {
+        std::fclose(in);
+        Logger::warning("Log archive: cannot create " + partial);
+        return false;
+    }
+
+    std::vector<char> buffer(kCopyBufferBytes);
+    bool ok = true;
+    size_t read;
+    while (ok && (read = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+        ok = gzwrite(out, buffer.data(), static_cast<unsigned>(read)) == static_cast<int>(read);
+    }
+    ok = ok && !std::ferror(in);
+    std::fclose(in);
+    ok = gzclose(out) == Z_OK && ok;
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(partial, target, ec);
+    }
+    if (!ok || ec) {
+        fs::remove(partial, ec);
+        Logger::warning("Log archive: compressing " + segment + " failed");
+        return false;
+    }
+
+    fs::remove(segment, ec);
+    ++archived_;
+    return true;
+}
+
+void LogArchiver::prune(const std::string& log_path, int max_files) {
+    auto segments = list_segments(log_path);
+    size_t keep = static_cast<size_t>(max_files);
+    if (segments.size() <= keep) {
+        return;
+    }
+
+    size_t excess = segments.size() - keep;
+    std::error_code ec;
+    for (const auto& entry : segments) {
+        if (excess == 0) {
+            break;
+        }
+        --excess;
+
+        bool removed = true;
+        if (entry.second.plain && !fs::remove(entry.first, ec) && ec) {
+            removed = false;
+        }
+        if (entry.second.compressed && !fs::remove(entry.first + ".gz", ec) && ec) {
+            removed = false;
+        }
+        if (removed) {
+            ++removed_;
+        } else {
+            Logger::warning("Log archive: cannot delete old segment " + entry.first);
+        }
+    }
+}
+
+} // namespace cybersentinel
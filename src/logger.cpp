@@ -1,31 +1,629 @@
 #include "logger.h"
-#include <iostream>
-#include <iomanip>
+#include "log_archiver.h"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <sstream>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#undef ERROR  // wingdi.h; clashes with Logger::Level::ERROR
+#else
+#include <unistd.h>
+#endif
 
 namespace cybersentinel {
 
-std::ofstream Logger::log_file_;
-std::mutex Logger::mutex_;
-Logger::Level Logger::min_level_ = Level::INFO;
+// The writer wakes at least this often; WARNING/ERROR and a half-full ring
+// wake it immediately
+static const auto kFlushInterval = std::chrono::milliseconds(50);
+
+// Longest a WARNING/ERROR waits for space before it is dropped too
+static const auto kMaxWaitForSpace = std::chrono::milliseconds(20);
+
+// Batches are written out when they reach this size
+static const size_t kBatchBytes = 64 * 1024;
+
+// Preallocated for the crash handler, which must not allocate
+static const size_t kCrashBufferBytes = 16 * 1024;
+
+namespace {
+
+const char* level_name(Logger::Level level) {
+    switch (level) {
+        case Logger::Level::DEBUG:   return "DEBUG";
+        case Logger::Level::INFO:    return "INFO";
+        case Logger::Level::WARNING: return "WARNING";
+        case Logger::Level::ERROR:   return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+// Days since 1970-01-01 for a civil date, and back (Howard Hinnant's
+// algorithms); integer arithmetic only, so usable in a signal handler
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = static_cast<unsigned>(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = static_cast<unsigned>(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+char* put_digits(char* out, int64_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+// write() until done or it fails; async-signal-safe
+void write_fd(int fd, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned>((std::min)(size, size_t(1) << 30)));
+#else
+        ssize_t n = ::write(fd, data, size);
+#endif
+        if (n <= 0) {
+            return;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+struct Record {
+    std::atomic<size_t> sequence{0};
+    Logger::Level level = Logger::Level::INFO;
+    std::chrono::system_clock::time_point time;
+    std::string text;  // keeps its capacity, so steady-state pushes do not allocate
+};
+
+// Bounded multi-producer ring (Vyukov): each slot's sequence number says
+// whether it is free for the producer at that position or holds a record
+// for the consumer. Producers never take a lock; pop() must not run on two
+// threads at once.
+class RecordRing {
+public:
+    explicit RecordRing(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        records_ = std::make_unique<Record[]>(size);
+        mask_ = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            records_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    size_t size_estimate() const {
+        return enqueue_pos_.load(std::memory_order_relaxed) - dequeue_pos_.load(std::memory_order_relaxed);
+    }
+
+    bool try_push(Logger::Level level, std::chrono::system_clock::time_point time, const std::string& text) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Record* record;
+        for (;;) {
+            record = &records_[pos & mask_];
+            size_t sequence = record->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->level = level;
+        record->time = time;
+        record->text.assign(text);
+        record->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Visits published records not yet consumed, without taking them. Only
+    // reads memory, for the crash handler; a record the consumer takes
+    // meanwhile may still be visited.
+    template <typename Visit>
+    void peek_all(Visit&& visit) const {
+        size_t end = enqueue_pos_.load(std::memory_order_acquire);
+        size_t pos = dequeue_pos_.load(std::memory_order_acquire);
+        for (size_t n = 0; pos != end && n <= mask_; ++pos, ++n) {
+            const Record& record = records_[pos & mask_];
+            if (record.sequence.load(std::memory_order_acquire) == pos + 1) {
+                visit(record);
+            }
+        }
+    }
+
+    template <typename Consume>
+    bool pop(Consume&& consume) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Record& record = records_[pos & mask_];
+        if (record.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        consume(record);
+        record.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::unique_ptr<Record[]> records_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
+
+struct LogState {
+    std::atomic<bool> console{true};
+    std::unique_ptr<RecordRing> ring;
+
+    // Writer side: whoever holds io_mutex is the ring's consumer
+    std::mutex io_mutex;
+    std::string path;
+    std::FILE* file = nullptr;
+    std::atomic<int> file_fd{-1};  // file's descriptor, for the crash handler
+    uint64_t file_bytes = 0;
+    std::chrono::steady_clock::time_point opened_at;
+    Logger::RotationPolicy rotation;
+    std::atomic<bool> crashing{false};  // no rotation while the crash handler drains
+    std::string file_batch;
+    std::string out_batch;
+    std::string err_batch;
+    std::time_t cached_second = 0;
+    char cached_prefix[32] = {};
+    std::atomic<int64_t> utc_offset{0};  // local time minus UTC, seconds
+    char crash_buffer[kCrashBufferBytes];
+    uint64_t reported_dropped = 0;
+
+    // Background writer
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    std::atomic<bool> wake_requested{false};
+    std::atomic<bool> running{false};
+    std::thread writer;
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> waited{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> rotations{0};
+
+    LogArchiver archiver;
+
+    LogState() : ring(std::make_unique<RecordRing>(8192)) {
+        start_writer();
+    }
+
+    // Static destruction at exit: nothing logged before it is lost
+    ~LogState() {
+        stop_writer();
+        archiver.stop();
+        drain();
+        std::lock_guard<std::mutex> lock(io_mutex);
+        if (file) {
+            file_fd = -1;
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    void start_writer() {
+        running = true;
+        writer = std::thread([this]() {
+            writer_loop();
+        });
+    }
+
+    void stop_writer() {
+        if (!running.exchange(false)) {
+            return;
+        }
+        wake_cv.notify_all();
+        if (writer.joinable()) {
+            writer.join();
+        }
+    }
+
+    void wake() {
+        if (!wake_requested.exchange(true)) {
+            wake_cv.notify_one();
+        }
+    }
+
+    void writer_loop() {
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        while (running) {
+            wake_cv.wait_for(lock, kFlushInterval, [this]() {
+                return !running || wake_requested;
+            });
+            wake_requested = false;
+
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> lock(io_mutex);
+        drain_locked();
+    }
+
+    void drain_locked() {
+        uint64_t count = 0;
+        while (ring->pop([this](const Record& record) { format(record); })) {
+            ++count;
+            if (file_batch.size() >= kBatchBytes) {
+                write_batches();
+            }
+        }
+
+        uint64_t dropped_now = dropped;
+        if (dropped_now != reported_dropped) {
+            notice(std::to_string(dropped_now - reported_dropped) + " log messages dropped, logging too fast");
+            reported_dropped = dropped_now;
+        }
+
+        if (!file_batch.empty()) {
+            write_batches();
+        }
+        written += count;
+    }
+
+    // A WARNING from the writer itself, which must not go through the ring
+    void notice(const std::string& text) {
+        Record record;
+        record.level = Logger::Level::WARNING;
+        record.time = std::chrono::system_clock::now();
+        record.text = text;
+        format(record);
+    }
+
+    void format(const Record& record) {
+        auto since_epoch = record.time.time_since_epoch();
+        std::time_t second = static_cast<std::time_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(since_epoch).count());
+        int ms = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count() % 1000);
+
+        // Calendar conversion once per second rather than per message
+        if (second != cached_second) {
+            std::tm tm_buf;
+#ifdef _WIN32
+            localtime_s(&tm_buf, &second);
+#else
+            localtime_r(&second, &tm_buf);
+#endif
+            std::strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &tm_buf);
+            cached_second = second;
+            utc_offset = days_from_civil(tm_buf.tm_year + 1900, tm_buf.tm_mon + 1, tm_buf.tm_mday) * 86400 +
+                         tm_buf.tm_hour * 3600 + tm_buf.tm_min * 60 + tm_buf.tm_sec - int64_t(second);
+        }
 
-void Logger::init(const std::string& log_file) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (log_file_.is_open()) {
-        log_file_.close();
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03d", ms);
+
+        size_t start = file_batch.size();
+        file_batch.append(cached_prefix).append(millis);
+        file_batch.append(" [").append(level_name(record.level)).append("] ");
+        file_batch.append(record.text).append(1, '\n');
+
+        if (console) {
+            std::string& target = record.level >= Logger::Level::WARNING ? err_batch : out_batch;
+            target.append(file_batch, start, std::string::npos);
+        }
+    }
+
+    void write_batches() {
+        if (file) {
+            std::fwrite(file_batch.data(), 1, file_batch.size(), file);
+            std::fflush(file);
+            file_bytes += file_batch.size();
+        }
+        if (!out_batch.empty()) {
+            std::fwrite(out_batch.data(), 1, out_batch.size(), stdout);
+            std::fflush(stdout);
+        }
+        if (!err_batch.empty()) {
+            std::fwrite(err_batch.data(), 1, err_batch.size(), stderr);
+            std::fflush(stderr);
+        }
+
+        file_batch.clear();
+        out_batch.clear();
+        err_batch.clear();
+        ++batches;
+
+        if (rotation_due()) {
+            rotate();
+        }
+    }
+
+    void open_file() {
+        file_bytes = 0;
+        opened_at = std::chrono::steady_clock::now();
+        file = std::fopen(path.c_str(), "a");
+        if (!file) {
+            std::fprintf(stderr, "Failed to open log file: %s\n", path.c_str());
+            return;
+        }
+#ifdef _WIN32
+        file_fd = _fileno(file);
+#else
+        file_fd = fileno(file);
+#endif
+        if (std::fseek(file, 0, SEEK_END) == 0) {
+            long size = std::ftell(file);
+            file_bytes = size > 0 ? static_cast<uint64_t>(size) : 0;
+        }
     }
-    log_file_.open(log_file, std::ios::app);
-    if (!log_file_.is_open()) {
-        std::cerr << "Failed to open log file: " << log_file << std::endl;
+
+    bool rotation_due() const {
+        if (!file || crashing) {
+            return false;
+        }
+        if (rotation.max_file_bytes > 0 && file_bytes >= rotation.max_file_bytes) {
+            return true;
+        }
+        return rotation.max_age.count() > 0 && file_bytes > 0 &&
+               std::chrono::steady_clock::now() - opened_at >= rotation.max_age;
+    }
+
+    // Only a rename on this side; producers keep filling the ring meanwhile
+    // and compression happens on the archiver's thread
+    void rotate() {
+        std::string segment = LogArchiver::next_segment_path(path);
+        file_fd = -1;
+        std::fclose(file);
+        file = nullptr;
+
+        std::error_code ec;
+        std::filesystem::rename(path, segment, ec);
+        open_file();
+
+        if (ec) {
+            // Typically another process holding the file open without delete
+            // sharing: carry on in it and try again after another segment
+            file_bytes = 0;
+            notice("Log rotation failed, continuing in " + path + ": " + ec.message());
+            return;
+        }
+        ++rotations;
+        archiver.submit(segment);
+    }
+
+    void push(Logger::Level level, const std::string& message) {
+        auto now = std::chrono::system_clock::now();
+
+        // The last eighth of the ring is kept for WARNING/ERROR, so chatter
+        // cannot take every slot the writer frees
+        bool chatter = level < Logger::Level::WARNING;
+        if (chatter && ring->size_estimate() >= ring->capacity() - ring->capacity() / 8) {
+            ++dropped;
+            wake();
+            return;
+        }
+
+        if (!ring->try_push(level, now, message)) {
+            // Bounded loss: chatter is dropped, problems wait a little
+            if (chatter) {
+                ++dropped;
+                wake();
+                return;
+            }
+
+            ++waited;
+            auto deadline = std::chrono::steady_clock::now() + kMaxWaitForSpace;
+            bool pushed = false;
+            while (!pushed && std::chrono::steady_clock::now() < deadline) {
+                if (running) {
+                    wake();
+                    std::this_thread::yield();
+                } else {
+                    drain();
+                }
+                pushed = ring->try_push(level, now, message);
+            }
+            if (!pushed) {
+                ++dropped;
+                return;
+            }
+        }
+
+        if (!running) {
+            drain();  // after shutdown(), written directly
+        } else if (level >= Logger::Level::WARNING || ring->size_estimate() > ring->capacity() / 2) {
+            wake();
+        }
+    }
+};
+
+LogState& state() {
+    static LogState instance;
+    return instance;
+}
+
+// "yyyy-mm-dd hh:mm:ss.mmm [LEVEL] ", as format() writes it, from integer
+// arithmetic and the writer's last known UTC offset
+size_t format_crash_prefix(char* out, const Record& record, int64_t utc_offset) {
+    int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count();
+    int64_t seconds = (ms >= 0 ? ms / 1000 : (ms - 999) / 1000) + utc_offset;
+    int64_t days = seconds >= 0 ? seconds / 86400 : (seconds - 86399) / 86400;
+    int64_t of_day = seconds - days * 86400;
+    int64_t year;
+    unsigned month, day;
+    civil_from_days(days, year, month, day);
+
+    char* p = out;
+    p = put_digits(p, year, 4);
+    *p++ = '-';
+    p = put_digits(p, month, 2);
+    *p++ = '-';
+    p = put_digits(p, day, 2);
+    *p++ = ' ';
+    p = put_digits(p, of_day / 3600, 2);
+    *p++ = ':';
+    p = put_digits(p, of_day / 60 % 60, 2);
+    *p++ = ':';
+    p = put_digits(p, of_day % 60, 2);
+    *p++ = '.';
+    p = put_digits(p, (ms % 1000 + 1000) % 1000, 3);
+    *p++ = ' ';
+    *p++ = '[';
+    for (const char* name = level_name(record.level); *name; ++name) {
+        *p++ = *name;
+    }
+    *p++ = ']';
+    *p++ = ' ';
+    return static_cast<size_t>(p - out);
+}
+
+// Best effort, and only async-signal-safe work: no lock, allocation or
+// stdio. Records still in the ring are formatted into the preallocated
+// buffer and written to the log file's descriptor (stderr without a file).
+// Records the writer had already taken but not yet written are lost, and
+// one it writes meanwhile may appear twice.
+void write_pending_on_crash() {
+    LogState& s = state();
+    s.crashing = true;
+    int fd = s.file_fd;
+    if (fd < 0) {
+        if (!s.console) {
+            return;
+        }
+        fd = 2;
+    }
+
+    int64_t utc_offset = s.utc_offset;
+    char* buffer = s.crash_buffer;
+    size_t used = 0;
+    s.ring->peek_all([&](const Record& record) {
+        char prefix[64];
+        size_t prefix_size = format_crash_prefix(prefix, record, utc_offset);
+        size_t line_size = prefix_size + record.text.size() + 1;
+        if (used + line_size > kCrashBufferBytes) {
+            write_fd(fd, buffer, used);
+            used = 0;
+        }
+        if (line_size > kCrashBufferBytes) {
+            write_fd(fd, prefix, prefix_size);
+            write_fd(fd, record.text.data(), record.text.size());
+            write_fd(fd, "\n", 1);
+            return;
+        }
+        std::memcpy(buffer + used, prefix, prefix_size);
+        std::memcpy(buffer + used + prefix_size, record.text.data(), record.text.size());
+        buffer[used + line_size - 1] = '\n';
+        used += line_size;
+    });
+    write_fd(fd, buffer, used);
+}
+
+void crash_signal_handler(int signal) {
+    write_pending_on_crash();
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+#ifdef _WIN32
+LONG WINAPI unhandled_exception_filter(EXCEPTION_POINTERS*) {
+    write_pending_on_crash();
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+#endif
+
+} // namespace
+
+void Logger::init(const std::string& log_file, size_t queue_capacity) {
+    LogState& s = state();
+
+    // Called before other threads log: the ring is replaced once drained
+    s.stop_writer();
+    s.drain();
+    {
+        std::lock_guard<std::mutex> lock(s.io_mutex);
+        if (s.ring->capacity() < queue_capacity || s.ring->capacity() >= queue_capacity * 2) {
+            s.ring = std::make_unique<RecordRing>(queue_capacity);
+        }
+
+        if (s.file) {
+            std::fclose(s.file);
+            s.file = nullptr;
+        }
+        s.path = log_file;
+        if (!log_file.empty()) {
+            s.open_file();
+        }
+        s.archiver.configure(s.path, s.rotation.max_files, s.rotation.compress);
     }
+    s.start_writer();
+
+    std::signal(SIGSEGV, crash_signal_handler);
+    std::signal(SIGABRT, crash_signal_handler);
+    std::signal(SIGFPE, crash_signal_handler);
+    std::signal(SIGILL, crash_signal_handler);
+#ifdef _WIN32
+    SetUnhandledExceptionFilter(unhandled_exception_filter);
+#endif
 }
 
 void Logger::set_level(Level level) {
-    std::lock_guard<std::mutex> lock(mutex_);
     min_level_ = level;
 }
 
+void Logger::set_console_output(bool enabled) {
+    state().console = enabled;
+}
+
+void Logger::set_rotation(const RotationPolicy& policy) {
+    LogState& s = state();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(s.io_mutex);
+        s.rotation = policy;
+        path = s.path;
+    }
+    s.archiver.configure(path, policy.max_files, policy.compress);
+    if (!path.empty()) {
+        s.archiver.submit("");
+    }
+}
+
 void Logger::debug(const std::string& message) {
     log(Level::DEBUG, message);
 }
@@ -42,53 +640,41 @@ void Logger::error(const std::string& message) {
     log(Level::ERROR, message);
 }
 
-void Logger::log(Level level, const std::string& message) {
-    if (level < min_level_) {
-        return;
-    }
-
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    std::string log_entry = get_timestamp() + " [" + level_to_string(level) + "] " + message;
-
-    // Write to file
-    if (log_file_.is_open()) {
-        log_file_ << log_entry << std::endl;
-        log_file_.flush();
-    }
-
-    // Also write to console
-    if (level >= Level::WARNING) {
-        std::cerr << log_entry << std::endl;
-    } else {
-        std::cout << log_entry << std::endl;
-    }
+void Logger::flush() {
+    state().drain();
 }
 
-std::string Logger::level_to_string(Level level) {
-    switch (level) {
-        case Level::DEBUG:   return "DEBUG";
-        case Level::INFO:    return "INFO";
-        case Level::WARNING: return "WARNING";
-        case Level::ERROR:   return "ERROR";
-        default:             return "UNKNOWN";
-    }
+void Logger::shutdown() {
+    LogState& s = state();
+    s.stop_writer();
+    s.drain();
+    s.archiver.finish();
 }
 
-std::string Logger::get_timestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-
-    std::tm tm_buf;
-    localtime_s(&tm_buf, &time_t);
+Logger::Stats Logger::stats() {
+    LogState& s = state();
+    Stats stats;
+    stats.written = s.written;
+    stats.dropped = s.dropped;
+    stats.waited = s.waited;
+    stats.batches = s.batches;
+    stats.rotations = s.rotations;
+    auto archive = s.archiver.stats();
+    stats.archived = archive.archived;
+    stats.removed = archive.removed;
+    return stats;
+}
 
-    std::ostringstream oss;
-    oss << std::put_time(&tm_buf, "%Y-%m-%d %H:%M:%S");
-    oss << '.' << std::setfill('0') << std::setw(3) << ms.count();
+std::string& Logger::format_buffer() {
+    thread_local std::string buffer;
+    return buffer;
+}
 
-    return oss.str();
+void Logger::log(Level level, const std::string& message) {
+    if (!enabled(level)) {
+        return;
+    }
+    state().push(level, message);
 }
 
 } // namespace cybersentinel
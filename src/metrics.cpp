@@ -0,0 +1,373 @@
+#include "metrics.h"
+#include "json_writer.h"
+#include "utf8.h"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+namespace cybersentinel {
+
+namespace {
+
+enum class MetricType {
+    COUNTER,
+    GAUGE,
+    HISTOGRAM
+};
+
+struct Entry {
+    std::string name;
+    std::string help;
+    Metrics::Labels labels;
+    MetricType type;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Entry>> entries;  // in registration order
+};
+
+// Never destroyed: threads still running during static destruction may
+// record into metrics they looked up earlier
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+Entry& find_or_add(const std::string& name, const std::string& help, const Metrics::Labels& labels,
+                   MetricType type) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (const auto& entry : reg.entries) {
+        if (entry->name == name && entry->labels == labels && entry->type == type) {
+            return *entry;
+        }
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->labels = labels;
+    entry->type = type;
+    switch (type) {
+        case MetricType::COUNTER: entry->counter = std::make_unique<Counter>(); break;
+        case MetricType::GAUGE: entry->gauge = std::make_unique<Gauge>(); break;
+        case MetricType::HISTOGRAM: entry->histogram = std::make_unique<Histogram>(); break;
+    }
+    reg.entries.push_back(std::move(entry));
+    return *reg.entries.back();
+}
+
+// Entries grouped by name, each group in registration order
+std::vector<const Entry*> sorted_entries() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::vector<const Entry*> entries;
+    for (const auto& entry : reg.entries) {
+        entries.push_back(entry.get());
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) {
+        return a->name < b->name;
+    });
+    return entries;
+}
+
+const char* type_name(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER: return "counter";
+        case MetricType::GAUGE: return "gauge";
+        case MetricType::HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+double seconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1e9;
+}
+
+void append_number(std::string& out, double number) {
+    char digits[32];
+    std::snprintf(digits, sizeof(digits), "%.9g", number);
+    out.append(digits);
+}
+
+// Help text escapes backslash and newline; label values also the quote
+void append_escaped(std::string& out, const std::string& text, bool quote) {
+    for (char c : text) {
+        if (c == '\\') {
+            out.append("\\\\");
+        } else if (c == '\n') {
+            out.append("\\n");
+        } else if (c == '"' && quote) {
+            out.append("\\\"");
+        } else {
+            out.push_back(c);
+        }
+    }
+}
+
+void append_labels(std::string& out, const Metrics::Labels& labels, const char* le = nullptr) {
+    if (labels.empty() && !le) {
+        return;
+    }
+    out.push_back('{');
+    bool first = true;
+    for (const auto& label : labels) {
+        if (!first) {
+            out.push_back(',');
+        }
+        first = false;
+        out.append(label.first).append("=\"");
+        append_escaped(out, label.second, true);
+        out.push_back('"');
+    }
+    if (le) {
+        out.append(first ? "" : ",").append("le=\"").append(le).append("\"");
+    }
+    out.push_back('}');
+}
+
+// Prometheus bucket bounds: powers of four from about 1us to about 69s, all
+// bucket boundaries of the log-linear histogram, so the counts are exact
+const int kFirstBoundBit = 10;
+const int kLastBoundBit = 36;
+
+void render_prometheus(std::string& out) {
+    const std::string* family = nullptr;
+
+    for (const Entry* entry : sorted_entries()) {
+        if (!family || *family != entry->name) {
+            family = &entry->name;
+            out.append("# HELP ").append(entry->name).push_back(' ');
+            append_escaped(out, entry->help, false);
+            out.append("\n# TYPE ").append(entry->name).append(" ").append(type_name(entry->type)).push_back('\n');
+        }
+
+        if (entry->type == MetricType::COUNTER) {
+            out.append(entry->name);
+            append_labels(out, entry->labels);
+            out.append(" ").append(std::to_string(entry->counter->value())).push_back('\n');
+        } else if (entry->type == MetricType::GAUGE) {
+            out.append(entry->name);
+            append_labels(out, entry->labels);
+            out.append(" ").append(std::to_string(entry->gauge->value())).push_back('\n');
+        } else {
+            Histogram::Snapshot snapshot = entry->histogram->snapshot();
+            for (int bit = kFirstBoundBit; bit <= kLastBoundBit; bit += 2) {
+                std::string le;
+                append_number(le, seconds(uint64_t(1) << bit));
+                out.append(entry->name).append("_bucket");
+                append_labels(out, entry->labels, le.c_str());
+                out.append(" ").append(std::to_string(snapshot.count_below(uint64_t(1) << bit))).push_back('\n');
+            }
+            out.append(entry->name).append("_bucket");
+            append_labels(out, entry->labels, "+Inf");
+            out.append(" ").append(std::to_string(snapshot.count)).push_back('\n');
+
+            out.append(entry->name).append("_sum");
+            append_labels(out, entry->labels);
+            out.push_back(' ');
+            append_number(out, seconds(snapshot.sum));
+            out.push_back('\n');
+
+            out.append(entry->name).append("_count");
+            append_labels(out, entry->labels);
+            out.append(" ").append(std::to_string(snapshot.count)).push_back('\n');
+        }
+    }
+}
+
+void render_json(std::string& out) {
+    JsonWriter writer(out);
+    writer.begin_object();
+    writer.key("timestamp_ms");
+    writer.value(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()));
+
+    writer.key("metrics");
+    writer.begin_array();
+    for (const Entry* entry : sorted_entries()) {
+        writer.begin_object();
+        writer.key("name");
+        writer.value(entry->name);
+        writer.key("type");
+        writer.value(type_name(entry->type));
+        if (!entry->labels.empty()) {
+            writer.key("labels");
+            writer.begin_object();
+            for (const auto& label : entry->labels) {
+                writer.key(label.first);
+                writer.value(label.second);
+            }
+            writer.end_object();
+        }
+
+        if (entry->type == MetricType::COUNTER) {
+            writer.key("value");
+            writer.value(entry->counter->value());
+        } else if (entry->type == MetricType::GAUGE) {
+            writer.key("value");
+            writer.value(entry->gauge->value());
+        } else {
+            Histogram::Snapshot snapshot = entry->histogram->snapshot();
+            writer.key("count");
+            writer.value(snapshot.count);
+            writer.key("sum_seconds");
+            writer.value(seconds(snapshot.sum));
+            writer.key("p50_seconds");
+            writer.value(seconds(snapshot.quantile(0.5)));
+            writer.key("p90_seconds");
+            writer.value(seconds(snapshot.quantile(0.9)));
+            writer.key("p99_seconds");
+            writer.value(seconds(snapshot.quantile(0.99)));
+            writer.key("max_seconds");
+            writer.value(seconds(snapshot.max()));
+        }
+        writer.end_object();
+    }
+    writer.end_array();
+    writer.end_object();
+    out.push_back('\n');
+}
+
+} // namespace
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.buckets.assign(kBuckets, 0);
+    for (const auto& shard : shards_) {
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+        for (int i = 0; i < kBuckets; ++i) {
+            snapshot.buckets[i] += shard.buckets[i].load(std::memory_order_relaxed);
+        }
+    }
+    // Counted from the buckets so the two always agree, even mid-update
+    for (uint64_t n : snapshot.buckets) {
+        snapshot.count += n;
+    }
+    return snapshot;
+}
+
+uint64_t Histogram::bucket_lower(int index) {
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(kSubBuckets + index % kSubBuckets) << shift;
+}
+
+uint64_t Histogram::bucket_upper(int index) {
+    if (index < kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / kSubBuckets - 1;
+    return bucket_lower(index) + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil((std::min)((std::max)(q, 0.0), 1.0) * count));
+    rank = (std::max)(rank, uint64_t(1));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_lower(i) + (bucket_upper(i) - bucket_lower(i)) / 2;
+        }
+    }
+    return max();
+}
+
+uint64_t Histogram::Snapshot::max() const {
+    for (int i = kBuckets - 1; i >= 0; --i) {
+        if (buckets[i]) {
+            return bucket_upper(i);
+        }
+    }
+    return 0;
+}
+
+uint64_t Histogram::Snapshot::count_below(uint64_t limit) const {
+    uint64_t total = 0;
+    for (int i = 0; i < kBuckets && bucket_upper(i) < limit; ++i) {
+        total += buckets[i];
+    }
+    return total;
+}
+
+Counter& Metrics::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    return *find_or_add(name, help, labels, MetricType::COUNTER).counter;
+}
+
+Gauge& Metrics::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    return *find_or_add(name, help, labels, MetricType::GAUGE).gauge;
+}
+
+Histogram& Metrics::histogram(const std::string& name, const std::string& help, const Labels& labels) {
+    return *find_or_add(name, help, labels, MetricType::HISTOGRAM).histogram;
+}
+
+Histogram& Metrics::stage(const std::string& stage) {
+    return histogram("cybersentinel_stage_seconds", "Latency of each event pipeline stage.",
+                     {{"stage", stage}});
+}
+
+std::string Metrics::render(Format format) {
+    std::string out;
+    if (format == Format::JSON) {
+        render_json(out);
+    } else {
+        render_prometheus(out);
+    }
+    return out;
+}
+
+bool Metrics::write_file(const std::string& path, Format format) {
+    std::string text = render(format);
+
+    std::filesystem::path target = path_from_utf8(path);
+    std::filesystem::path tmp_path = target;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!file.write(text.data(), static_cast<std::streamsize>(text.size()))) {
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, target, ec);
+    return !ec;
+}
+
+bool Metrics::parse_format(const std::string& name, Format& format) {
+    if (name == "prometheus") {
+        format = Format::PROMETHEUS;
+    } else if (name == "json") {
+        format = Format::JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,69 @@
+#include "metrics_exporter.h"
+#include "logger.h"
+#include <algorithm>
+
+namespace cybersentinel {
+
+MetricsExporter::MetricsExporter(const std::string& path, Metrics::Format format,
+                                 std::chrono::seconds interval, CollectHook collect)
+    : path_(path), format_(format), interval_((std::max)(interval, std::chrono::seconds(1))),
+      collect_(std::move(collect)) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+void MetricsExporter::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+
+    stopping_ = false;
+    thread_ = std::thread([this]() {
+        run();
+    });
+    Logger::info("Exporting metrics to " + path_ + " every " + std::to_string(interval_.count()) + "s");
+}
+
+void MetricsExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+
+    if (thread_.joinable()) {
+        thread_.join();
+        export_now();
+    }
+}
+
+bool MetricsExporter::export_now() {
+    if (collect_) {
+        collect_();
+    }
+
+    bool written = Metrics::write_file(path_, format_);
+    if (!written && !failing_) {
+        Logger::warning("Could not write metrics to " + path_);
+    }
+    failing_ = !written;
+    return written;
+}
+
+void MetricsExporter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopping_) {
+        if (cv_.wait_for(lock, interval_, [this]() { return stopping_; })) {
+            break;
+        }
+
+        lock.unlock();
+        export_now();
+        lock.lock();
+    }
+}
+
+} // namespace cybersentinel
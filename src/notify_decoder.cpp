@@ -0,0 +1,128 @@
+#include "notify_decoder.h"
+#include "utf8.h"
+#include <cstring>
+
+namespace cybersentinel {
+
+bool notify_action_to_file_action(uint32_t action, FileAction& out) {
+    switch (action) {
+        case kNotifyActionAdded:
+            out = FileAction::CREATED;
+            return true;
+        case kNotifyActionRemoved:
+            out = FileAction::DELETED;
+            return true;
+        case kNotifyActionModified:
+            out = FileAction::MODIFIED;
+            return true;
+        case kNotifyActionRenamedOldName:
+        case kNotifyActionRenamedNewName:
+            out = FileAction::MOVED;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+NotifyDecodeStatus decode_notifications(const uint8_t* data, size_t length,
+                                        const NotifyEntryHandler& on_entry) {
+    if (length == 0) {
+        return NotifyDecodeStatus::EVENTS_LOST;
+    }
+
+    size_t offset = 0;
+    while (true) {
+        if (length - offset < kNotifyHeaderSize) {
+            return NotifyDecodeStatus::MALFORMED;
+        }
+
+        const uint8_t* record = data + offset;
+        uint32_t next_entry = read_u32(record);
+        uint32_t action = read_u32(record + 4);
+        uint32_t name_bytes = read_u32(record + 8);
+
+        if (name_bytes % sizeof(char16_t) != 0 ||
+            name_bytes > length - offset - kNotifyHeaderSize ||
+            (next_entry != 0 && next_entry < kNotifyHeaderSize + name_bytes)) {
+            return NotifyDecodeStatus::MALFORMED;
+        }
+
+        // Records are DWORD-aligned, so the name is char16_t-aligned
+        const char16_t* name = reinterpret_cast<const char16_t*>(record + kNotifyHeaderSize);
+        on_entry(action, std::u16string_view(name, name_bytes / sizeof(char16_t)));
+
+        if (next_entry == 0) {
+            return NotifyDecodeStatus::OK;
+        }
+        if (next_entry % sizeof(uint32_t) != 0 || next_entry > length - offset) {
+            return NotifyDecodeStatus::MALFORMED;
+        }
+        offset += next_entry;
+    }
+}
+
+bool NotifyEventBuilder::build(uint32_t root, uint32_t action, std::u16string_view name,
+                               WatchEvent& event) {
+    FileAction file_action;
+    if (!notify_action_to_file_action(action, file_action)) {
+        return false;
+    }
+
+    // Names are relative to the root and may include subdirectories
+    uint32_t directory = root;
+    std::u16string_view leaf = name;
+    size_t separator = name.find_last_of(u'\\');
+
+    // No file to report: an empty name or one ending in a separator
+    if (name.empty() || separator == name.size() - 1) {
+        return false;
+    }
+
+    if (separator != std::u16string_view::npos) {
+        std::u16string_view units = name.substr(0, separator);
+        if (root != cached_root_ || units != cached_units_ || paths_.generation() != cached_generation_) {
+            std::string_view root_path = paths_.get(root);
+            directory_.assign(root_path.data(), root_path.size());
+            if (root_path.empty() || root_path.back() != kPathSeparator) {
+                directory_.push_back(kPathSeparator);
+            }
+            append_utf16_as_utf8(units, directory_);
+
+            cached_directory_ = paths_.intern(directory_);
+            cached_generation_ = paths_.generation();
+            cached_root_ = root;
+            cached_units_.assign(units.data(), units.size());
+        }
+        directory = cached_directory_;
+        leaf = name.substr(separator + 1);
+    }
+
+    name_.clear();
+    append_utf16_as_utf8(leaf, name_);
+
+    event.directory = directory;
+    event.name = name_;
+    event.action = file_action;
+    return true;
+}
+
+NotifyBuffers::NotifyBuffers(size_t buffer_size)
+    : size_((buffer_size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1)), armed_(0) {
+    for (auto& storage : storage_) {
+        storage = std::make_unique<uint32_t[]>(size_ / sizeof(uint32_t));
+    }
+}
+
+NotifyBuffers::Chunk NotifyBuffers::swap(size_t bytes) {
+    Chunk completed{armed(), bytes < size_ ? bytes : size_};
+    armed_ ^= 1;
+    return completed;
+}
+
+} // namespace cybersentinel
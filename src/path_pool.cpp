@@ -0,0 +1,71 @@
+#include "path_pool.h"
+#include "watcher_backend.h"
+
+namespace cybersentinel {
+
+uint32_t PathPool::intern(std::string_view path) {
+    auto it = ids_.find(path);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+
+    uint32_t id;
+    if (!free_ids_.empty()) {
+        id = free_ids_.back();
+        free_ids_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(entries_.size());
+        entries_.emplace_back();
+    }
+
+    Entry& entry = entries_[id];
+    entry.path.assign(path.data(), path.size());
+    entry.references = 0;
+    entry.live = true;
+    ids_.emplace(entry.path, id);
+    bytes_ += path.size();
+
+    if (++unreferenced_ > kMaxUnreferenced) {
+        trim(id);
+    }
+    return id;
+}
+
+void PathPool::acquire(uint32_t id) {
+    if (entries_[id].references++ == 0) {
+        --unreferenced_;
+    }
+}
+
+void PathPool::release(uint32_t id) {
+    if (--entries_[id].references == 0) {
+        ++unreferenced_;
+    }
+}
+
+void PathPool::join(uint32_t directory, std::string_view name, std::string& out) const {
+    std::string_view prefix = entries_[directory].path;
+    out.assign(prefix.data(), prefix.size());
+    if (prefix.empty() || prefix.back() != kPathSeparator) {  // drive roots end in one
+        out.push_back(kPathSeparator);
+    }
+    out.append(name.data(), name.size());
+}
+
+void PathPool::trim(uint32_t keep) {
+    for (uint32_t id = 0; id < entries_.size(); ++id) {
+        Entry& entry = entries_[id];
+        if (!entry.live || entry.references > 0 || id == keep) {
+            continue;
+        }
+        ids_.erase(entry.path);
+        bytes_ -= entry.path.size();
+        std::string().swap(entry.path);  // frees the heap copy of a long path
+        entry.live = false;
+        free_ids_.push_back(id);
+    }
+    unreferenced_ = 1;
+    ++generation_;
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,371 @@
+#include "policy.h"
+#include "classifier.h"
+#include "fnv_hash.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cybersentinel {
+
+static const char* const kSourceNames[] = {"file", "usb_file", "clipboard"};
+static const char* const kVolumeTypeNames[] = {"local", "usb", "removable"};
+static const char* const kSeverities[] = {"low", "medium", "high", "critical"};
+
+namespace {
+
+bool is_separator(char c) {
+#ifdef _WIN32
+    return c == '\\' || c == '/';
+#else
+    return c == '/';
+#endif
+}
+
+char fold_path(char c) {
+#ifdef _WIN32
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+#else
+    return c;
+#endif
+}
+
+char fold_ascii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// stored is already folded
+int compare_component(const std::string& stored, std::string_view component) {
+    size_t length = (std::min)(stored.size(), component.size());
+    for (size_t i = 0; i < length; ++i) {
+        char c = fold_path(component[i]);
+        if (stored[i] != c) {
+            return static_cast<unsigned char>(stored[i]) < static_cast<unsigned char>(c) ? -1 : 1;
+        }
+    }
+    if (stored.size() == component.size()) {
+        return 0;
+    }
+    return stored.size() < component.size() ? -1 : 1;
+}
+
+// Calls visit for each non-empty component of path
+template <typename Visit>
+void for_each_component(std::string_view path, Visit visit) {
+    size_t pos = 0;
+    while (pos < path.size()) {
+        while (pos < path.size() && is_separator(path[pos])) {
+            ++pos;
+        }
+        size_t end = pos;
+        while (end < path.size() && !is_separator(path[end])) {
+            ++end;
+        }
+        if (end > pos && !visit(path.substr(pos, end - pos))) {
+            return;
+        }
+        pos = end;
+    }
+}
+
+int index_of(const char* const* names, int count, const std::string& value) {
+    for (int i = 0; i < count; ++i) {
+        if (value == names[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int lowest_bit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+void set_bit(std::vector<uint64_t>& bits, uint32_t index) {
+    bits[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+std::string normalize_extension(const std::string& extension) {
+    std::string normalized = extension.empty() || extension[0] != '.' ? extension : extension.substr(1);
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), fold_ascii);
+    return normalized;
+}
+
+// Every field, each value terminated so that moving text between fields
+// changes the result
+uint32_t rules_fingerprint(const std::vector<PolicyRule>& rules) {
+    uint64_t hash = fnv1a_64("");
+    auto add = [&hash](std::string_view value) {
+        hash = fnv1a_64(value, hash);
+        hash = fnv1a_64(std::string_view("\0", 1), hash);
+    };
+    auto add_list = [&](const std::vector<std::string>& values) {
+        add(std::to_string(values.size()));
+        for (const auto& value : values) {
+            add(value);
+        }
+    };
+
+    for (const auto& rule : rules) {
+        add(rule.name);
+        add_list(rule.sources);
+        add_list(rule.volume_types);
+        add_list(rule.labels);
+        add_list(rule.path_prefixes);
+        add_list(rule.extensions);
+        add(std::string_view(reinterpret_cast<const char*>(&rule.min_confidence), sizeof(rule.min_confidence)));
+        add(rule.severity);
+        add(rule.action);
+    }
+
+    uint32_t version = static_cast<uint32_t>(hash ^ (hash >> 32));
+    return version != 0 ? version : 1;
+}
+
+} // namespace
+
+bool PolicyRule::operator==(const PolicyRule& other) const {
+    return name == other.name && sources == other.sources && volume_types == other.volume_types &&
+           labels == other.labels && path_prefixes == other.path_prefixes && extensions == other.extensions &&
+           min_confidence == other.min_confidence && severity == other.severity && action == other.action;
+}
+
+std::unique_ptr<Policy> Policy::compile(const std::vector<PolicyRule>& rules, std::string& error) {
+    std::unique_ptr<Policy> policy(new Policy());
+    policy->words_ = (rules.size() + 63) / 64;
+    Bits empty(policy->words_, 0);
+
+    for (auto& bits : policy->source_bits_) bits = empty;
+    for (auto& bits : policy->volume_bits_) bits = empty;
+    for (auto& bits : policy->label_bits_) bits = empty;
+    policy->any_extension_ = empty;
+    policy->any_path_ = empty;
+    policy->trie_.emplace_back();
+
+    // Extension sets are completed once every rule without extensions is known
+    std::vector<std::pair<std::string, uint32_t>> listed_extensions;
+
+    for (uint32_t index = 0; index < rules.size(); ++index) {
+        const PolicyRule& rule = rules[index];
+        std::string name = rule.name.empty() ? "#" + std::to_string(index + 1) : rule.name;
+        std::string where = "policy rule " + name + ": ";
+
+        if (!rule.severity.empty() && index_of(kSeverities, 4, rule.severity) < 0) {
+            error = where + "unknown severity '" + rule.severity + "'";
+            return nullptr;
+        }
+        if (rule.action != "report" && rule.action != "ignore") {
+            error = where + "unknown action '" + rule.action + "'";
+            return nullptr;
+        }
+
+        for (const auto& source : rule.sources) {
+            int i = index_of(kSourceNames, kSources, source);
+            if (i < 0) {
+                error = where + "unknown source '" + source + "'";
+                return nullptr;
+            }
+            set_bit(policy->source_bits_[i], index);
+        }
+        if (rule.sources.empty()) {
+            for (auto& bits : policy->source_bits_) set_bit(bits, index);
+        }
+
+        for (const auto& type : rule.volume_types) {
+            int i = index_of(kVolumeTypeNames, kVolumeTypes, type);
+            if (i < 0) {
+                error = where + "unknown volume type '" + type + "'";
+                return nullptr;
+            }
+            set_bit(policy->volume_bits_[i], index);
+        }
+        if (rule.volume_types.empty()) {
+            for (auto& bits : policy->volume_bits_) set_bit(bits, index);
+        }
+
+        uint32_t label_mask = 0;
+        for (const auto& label : rule.labels) {
+            uint32_t bit = Classifier::label_mask({label});
+            if (bit == 0) {
+                error = where + "unknown label '" + label + "'";
+                return nullptr;
+            }
+            label_mask |= bit;
+        }
+        for (uint32_t mask = 0; mask < kLabelMasks; ++mask) {
+            if (label_mask == 0 || (label_mask & mask) != 0) {
+                set_bit(policy->label_bits_[mask], index);
+            }
+        }
+
+        for (const auto& extension : rule.extensions) {
+            std::string normalized = normalize_extension(extension);
+            if (normalized.empty()) {
+                error = where + "empty extension";
+                return nullptr;
+            }
+            listed_extensions.emplace_back(normalized, index);
+        }
+        if (rule.extensions.empty()) {
+            set_bit(policy->any_extension_, index);
+        }
+
+        for (const auto& prefix : rule.path_prefixes) {
+            bool has_component = false;
+            for_each_component(prefix, [&](std::string_view) { has_component = true; return false; });
+            if (!has_component) {
+                error = where + "empty path prefix";
+                return nullptr;
+            }
+            policy->add_prefix(prefix, index);
+        }
+        if (rule.path_prefixes.empty()) {
+            set_bit(policy->any_path_, index);
+        }
+
+        CompiledRule compiled;
+        compiled.name = name;
+        compiled.severity = rule.severity;
+        compiled.min_confidence = rule.min_confidence;
+        compiled.report = rule.action == "report";
+        policy->rules_.push_back(std::move(compiled));
+    }
+
+    for (const auto& entry : listed_extensions) {
+        auto it = policy->extension_bits_.emplace(entry.first, policy->any_extension_).first;
+        set_bit(it->second, entry.second);
+    }
+
+    if (!rules.empty()) {
+        policy->version_ = rules_fingerprint(rules);
+    }
+    return policy;
+}
+
+void Policy::add_prefix(const std::string& prefix, uint32_t rule) {
+    uint32_t node = 0;
+    for_each_component(prefix, [&](std::string_view component) {
+        std::string folded(component);
+        std::transform(folded.begin(), folded.end(), folded.begin(), fold_path);
+
+        auto& children = trie_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), folded,
+                                   [](const std::pair<std::string, uint32_t>& child, const std::string& key) {
+                                       return child.first < key;
+                                   });
+        if (it != children.end() && it->first == folded) {
+            node = it->second;
+        } else {
+            uint32_t child = static_cast<uint32_t>(trie_.size());
+            children.insert(it, {folded, child});
+            trie_.emplace_back();  // invalidates children; not used below
+            node = child;
+        }
+        return true;
+    });
+    trie_[node].rules.push_back(rule);
+}
+
+void Policy::collect_path_rules(std::string_view path, Bits& candidates) const {
+    uint32_t node = 0;
+    for_each_component(path, [&](std::string_view component) {
+        const auto& children = trie_[node].children;
+        auto it = std::lower_bound(children.begin(), children.end(), component,
+                                   [](const std::pair<std::string, uint32_t>& child, std::string_view key) {
+                                       return compare_component(child.first, key) < 0;
+                                   });
+        if (it == children.end() || compare_component(it->first, component) != 0) {
+            return false;
+        }
+        node = it->second;
+        for (uint32_t rule : trie_[node].rules) {
+            set_bit(candidates, rule);
+        }
+        return true;
+    });
+}
+
+PolicyDecision Policy::evaluate(const PolicyInput& input) const {
+    if (rules_.empty()) {
+        return default_decision(input);
+    }
+
+    // Per thread, so evaluation allocates nothing once warmed up
+    thread_local Bits candidates;
+    thread_local std::string extension_key;
+
+    candidates.assign(any_path_.begin(), any_path_.end());
+    collect_path_rules(input.path, candidates);
+
+    const Bits* extension = &any_extension_;
+    std::string_view raw_extension = extension_of(input.path);
+    if (!raw_extension.empty() && !extension_bits_.empty()) {
+        extension_key.assign(raw_extension.data(), raw_extension.size());
+        std::transform(extension_key.begin(), extension_key.end(), extension_key.begin(), fold_ascii);
+        auto it = extension_bits_.find(extension_key);
+        if (it != extension_bits_.end()) {
+            extension = &it->second;
+        }
+    }
+
+    const uint64_t* source = source_bits_[static_cast<int>(input.source)].data();
+    const uint64_t* volume = volume_bits_[static_cast<int>(input.volume_type)].data();
+    const uint64_t* labels = label_bits_[input.labels % kLabelMasks].data();
+    const uint64_t* extensions = extension->data();
+
+    for (size_t word = 0; word < words_; ++word) {
+        uint64_t matches = candidates[word] & source[word] & volume[word] & labels[word] & extensions[word];
+        while (matches) {
+            size_t index = word * 64 + lowest_bit(matches);
+            const CompiledRule& rule = rules_[index];
+            if (input.confidence >= rule.min_confidence) {
+                PolicyDecision decision;
+                decision.severity = rule.severity.empty() ? default_decision(input).severity
+                                                          : std::string_view(rule.severity);
+                decision.report = rule.report;
+                decision.rule = static_cast<int>(index);
+                return decision;
+            }
+            matches &= matches - 1;
+        }
+    }
+    return default_decision(input);
+}
+
+PolicyDecision Policy::default_decision(const PolicyInput& input) {
+    PolicyDecision decision;
+    if (input.source == PolicySource::CLIPBOARD) {
+        decision.severity = "medium";
+    } else if (input.source == PolicySource::USB_FILE || input.confidence > 0.8) {
+        decision.severity = "critical";
+    } else {
+        decision.severity = "high";
+    }
+    return decision;
+}
+
+const char* Policy::source_name(PolicySource source) {
+    return kSourceNames[static_cast<int>(source)];
+}
+
+std::string_view Policy::extension_of(std::string_view path) {
+    for (size_t i = path.size(); i > 0; --i) {
+        char c = path[i - 1];
+        if (c == '.') {
+            return path.substr(i);
+        }
+        if (is_separator(c)) {
+            break;
+        }
+    }
+    return std::string_view();
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,170 @@
+#include "removable_volumes.h"
+#include "classifier.h"
+#include "logger.h"
+#include "utf8.h"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+RemovableVolumeWatcher::RemovableVolumeWatcher(VolumeFileCallback callback, FileStateIndex* index,
+                                               const Options& options)
+    : callback_(callback), index_(index), options_(options) {
+}
+
+RemovableVolumeWatcher::~RemovableVolumeWatcher() {
+    detach_all();
+}
+
+bool RemovableVolumeWatcher::attach(const VolumeInfo& volume) {
+    std::error_code ec;
+    if (!fs::is_directory(path_from_utf8(volume.root), ec)) {
+        Logger::warning("Removable volume root is not accessible: " + volume.root);
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (volumes_.count(volume.root)) {
+            return false;
+        }
+    }
+
+    // Index entries left from an earlier mount at this root (the agent may
+    // have stopped while it was attached) describe some other medium
+    forget_volume(volume.root);
+
+    // Built and started outside the lock, which stats() and the heartbeat
+    // take; starting a watcher and a crawl can take a while
+    auto attached = std::make_unique<AttachedVolume>();
+    attached->volume = volume;
+    AttachedVolume* target = attached.get();
+
+    // Writes to the volume are what a copy to USB looks like
+    attached->monitor = std::make_unique<FileMonitor>(
+        std::vector<std::string>{volume.root},
+        [this, target](const std::string& path, const std::string& event_type) {
+            ++target->file_events;
+            callback_(path, event_type, target->volume);
+        },
+        index_
+    );
+
+    if (!attached->monitor->start()) {
+        Logger::error("Failed to watch removable volume " + volume.root);
+        return false;
+    }
+
+    // Budgeted separately from the baseline crawl of the monitored paths;
+    // the volume may be gone again in minutes, so there is no checkpoint
+    if (options_.scan_existing) {
+        BaselineCrawler::Options crawl;
+        crawl.threads = options_.scan_threads;
+        crawl.max_files_per_sec = options_.scan_max_files_per_sec;
+        crawl.max_mb_per_sec = options_.scan_max_mb_per_sec;
+        crawl.rules_version = Classifier::kRulesVersion;
+
+        attached->crawler = std::make_unique<BaselineCrawler>(
+            std::vector<std::string>{volume.root},
+            [this, target](const std::string& path, const std::string& event_type) {
+                callback_(path, event_type, target->volume);
+            },
+            index_,
+            crawl
+        );
+        attached->crawler->start();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!volumes_.count(volume.root)) {
+            volumes_[volume.root] = std::move(attached);
+        }
+    }
+
+    // Lost a race with another attach of the same root
+    if (attached) {
+        shut_down(*attached);
+        return false;
+    }
+
+    Logger::info("Watching removable volume " + volume.root + " (label \"" + volume.label +
+                 "\", serial " + volume.serial + ", " + volume.file_system + ")");
+    return true;
+}
+
+bool RemovableVolumeWatcher::detach(const std::string& root) {
+    std::unique_ptr<AttachedVolume> attached;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = volumes_.find(root);
+        if (it == volumes_.end()) {
+            return false;
+        }
+        attached = std::move(it->second);
+        volumes_.erase(it);
+    }
+
+    // Outside the lock: stopping waits for callbacks in flight
+    shut_down(*attached);
+    forget_volume(root);
+    Logger::info("Stopped watching removable volume " + root + " after " +
+                 std::to_string(attached->file_events.load()) + " file events");
+    return true;
+}
+
+void RemovableVolumeWatcher::detach_all() {
+    std::map<std::string, std::unique_ptr<AttachedVolume>> volumes;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        volumes.swap(volumes_);
+    }
+
+    for (auto& entry : volumes) {
+        shut_down(*entry.second);
+        forget_volume(entry.first);
+    }
+}
+
+size_t RemovableVolumeWatcher::attached_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return volumes_.size();
+}
+
+std::vector<RemovableVolumeWatcher::VolumeStats> RemovableVolumeWatcher::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<VolumeStats> result;
+    for (const auto& entry : volumes_) {
+        const AttachedVolume& attached = *entry.second;
+        VolumeStats stats;
+        stats.volume = attached.volume;
+        stats.file_events = attached.file_events;
+        if (attached.crawler) {
+            stats.scan = attached.crawler->stats();
+            stats.scanning = !stats.scan.complete;
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+void RemovableVolumeWatcher::forget_volume(const std::string& root) {
+    // Paths on a removable volume only identify a file while that medium
+    // is mounted; the next one at the same root is a different file system
+    if (!index_) {
+        return;
+    }
+    for (const auto& path : index_->paths_under(root)) {
+        index_->erase(path);
+    }
+}
+
+void RemovableVolumeWatcher::shut_down(AttachedVolume& attached) {
+    if (attached.crawler) {
+        attached.crawler->stop();
+    }
+    attached.monitor->stop();
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,54 @@
+#include "token_bucket.h"
+#include <algorithm>
+
+namespace cybersentinel {
+
+TokenBucket::TokenBucket(double rate, double burst)
+    : rate_(0.0), burst_(0.0), tokens_(0.0), refilled_(std::chrono::steady_clock::now()) {
+    set_rate(rate, burst);
+}
+
+void TokenBucket::set_rate(double rate, double burst) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto now = std::chrono::steady_clock::now();
+    bool was_limited = rate_ > 0.0;
+    if (was_limited) {
+        refill(now);
+    }
+
+    rate_ = (std::max)(rate, 0.0);
+    burst_ = burst > 0.0 ? burst : rate_;
+
+    // Debt carries over a rate change, so changing rates never cancels a wait
+    tokens_ = was_limited ? (std::min)(tokens_, burst_) : burst_;
+    refilled_ = now;
+}
+
+bool TokenBucket::limited() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rate_ > 0.0;
+}
+
+std::chrono::microseconds TokenBucket::take(double amount) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (rate_ <= 0.0) {
+        return std::chrono::microseconds(0);
+    }
+
+    refill(std::chrono::steady_clock::now());
+    tokens_ -= amount;
+    if (tokens_ >= 0.0) {
+        return std::chrono::microseconds(0);
+    }
+
+    // Time until the debt is paid off at the configured rate
+    return std::chrono::microseconds(static_cast<long long>(-tokens_ / rate_ * 1e6));
+}
+
+void TokenBucket::refill(std::chrono::steady_clock::time_point now) {
+    double elapsed = std::chrono::duration<double>(now - refilled_).count();
+    refilled_ = now;
+    tokens_ = (std::min)(burst_, tokens_ + elapsed * rate_);
+}
+
+} // namespace cybersentinel
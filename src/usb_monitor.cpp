@@ -1,11 +1,90 @@
 #include "usb_monitor.h"
 #include "logger.h"
+#include "utf8.h"
 #include <dbt.h>
+#include <winioctl.h>
+#include <cstdio>
+#include <string_view>
 
 namespace cybersentinel {
 
-USBMonitor::USBMonitor(USBEventCallback callback)
-    : callback_(callback) {
+// Drive letters are assigned a moment after the device arrives; volumes are
+// re-enumerated once device changes have been quiet for this long
+static const UINT kSettleTimerId = 1;
+static const UINT kSettleDelayMs = 1000;
+
+namespace {
+
+// USB hard disks and some sticks report DRIVE_FIXED; the bus type tells
+std::string bus_type(wchar_t letter) {
+    wchar_t device[] = L"\\\\.\\?:";
+    device[4] = letter;
+
+    HANDLE handle = CreateFileW(device, 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return "";
+    }
+
+    STORAGE_PROPERTY_QUERY query = {};
+    query.PropertyId = StorageDeviceProperty;
+    query.QueryType = PropertyStandardQuery;
+
+    STORAGE_DEVICE_DESCRIPTOR descriptor = {};
+    DWORD returned = 0;
+    BOOL ok = DeviceIoControl(handle, IOCTL_STORAGE_QUERY_PROPERTY, &query, sizeof(query),
+                              &descriptor, sizeof(descriptor), &returned, nullptr);
+    CloseHandle(handle);
+
+    if (!ok) {
+        return "";
+    }
+    return descriptor.BusType == BusTypeUsb ? "usb" : "other";
+}
+
+// False for internal disks, network and optical drives, and empty readers
+bool describe_volume(wchar_t letter, VolumeInfo& volume) {
+    wchar_t root[] = L"?:\\";
+    root[0] = letter;
+
+    UINT type = GetDriveTypeW(root);
+    if (type != DRIVE_REMOVABLE && type != DRIVE_FIXED) {
+        return false;
+    }
+
+    std::string bus = bus_type(letter);
+    if (type == DRIVE_FIXED && bus != "usb") {
+        return false;
+    }
+
+    wchar_t label[MAX_PATH + 1] = {};
+    wchar_t file_system[MAX_PATH + 1] = {};
+    DWORD serial = 0;
+    if (!GetVolumeInformationW(root, label, MAX_PATH + 1, &serial, nullptr, nullptr, file_system, MAX_PATH + 1)) {
+        return false;
+    }
+
+    static_assert(sizeof(wchar_t) == sizeof(char16_t), "Windows wchar_t is UTF-16");
+    volume = VolumeInfo();
+    append_utf16_as_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(root)), volume.root);
+    append_utf16_as_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(label)), volume.label);
+    append_utf16_as_utf8(std::u16string_view(reinterpret_cast<const char16_t*>(file_system)), volume.file_system);
+
+    char serial_text[16];
+    std::snprintf(serial_text, sizeof(serial_text), "%04lX-%04lX", (serial >> 16) & 0xFFFF, serial & 0xFFFF);
+    volume.serial = serial_text;
+    volume.bus = bus == "usb" ? "usb" : "removable";
+
+    ULARGE_INTEGER total;
+    if (GetDiskFreeSpaceExW(root, nullptr, &total, nullptr)) {
+        volume.total_bytes = total.QuadPart;
+    }
+    return true;
+}
+
+} // namespace
+
+USBMonitor::USBMonitor(VolumeEventCallback on_arrival, VolumeEventCallback on_removal)
+    : on_arrival_(on_arrival), on_removal_(on_removal) {
 }
 
 USBMonitor::~USBMonitor() {
@@ -45,6 +124,10 @@ void USBMonitor::stop() {
 }
 
 void USBMonitor::monitor_loop() {
+    // Probing an empty card reader must not pop up "insert a disk"
+    DWORD previous_mode = 0;
+    SetThreadErrorMode(SEM_FAILCRITICALERRORS, &previous_mode);
+
     // Create message-only window
     WNDCLASSEX wc = {0};
     wc.cbSize = sizeof(WNDCLASSEX);
@@ -74,7 +157,8 @@ void USBMonitor::monitor_loop() {
         return;
     }
 
-    // Register for device notifications
+    // Register for device notifications. Volume broadcasts only reach
+    // top-level windows, so any device change triggers a re-enumeration.
     DEV_BROADCAST_DEVICEINTERFACE notification_filter = {0};
     notification_filter.dbcc_size = sizeof(DEV_BROADCAST_DEVICEINTERFACE);
     notification_filter.dbcc_devicetype = DBT_DEVTYP_DEVICEINTERFACE;
@@ -91,6 +175,9 @@ void USBMonitor::monitor_loop() {
         return;
     }
 
+    // Volumes plugged in before the agent started
+    check_usb_devices();
+
     // Message loop
     MSG msg;
     while (running_ && GetMessage(&msg, nullptr, 0, 0)) {
@@ -99,14 +186,44 @@ void USBMonitor::monitor_loop() {
     }
 
     // Cleanup
+    KillTimer(hwnd_, kSettleTimerId);
     UnregisterDeviceNotification(h_notify);
     DestroyWindow(hwnd_);
     UnregisterClass("USBMonitorClass", GetModuleHandle(nullptr));
 }
 
 void USBMonitor::check_usb_devices() {
-    // This would require WMI or other APIs to enumerate USB devices
-    // For now, we rely on WM_DEVICECHANGE messages
+    std::map<std::string, VolumeInfo> mounted;
+    DWORD drives = GetLogicalDrives();
+    for (wchar_t letter = L'C'; letter <= L'Z'; ++letter) {
+        VolumeInfo volume;
+        if ((drives & (1u << (letter - L'A'))) && describe_volume(letter, volume)) {
+            mounted[volume.root] = volume;
+        }
+    }
+
+    // Gone, or a different medium under the same letter
+    for (auto it = volumes_.begin(); it != volumes_.end();) {
+        auto current = mounted.find(it->first);
+        if (current == mounted.end() || current->second.serial != it->second.serial) {
+            if (on_removal_) {
+                on_removal_(it->second);
+            }
+            it = volumes_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto& entry : mounted) {
+        if (volumes_.count(entry.first)) {
+            continue;
+        }
+        volumes_[entry.first] = entry.second;
+        if (on_arrival_) {
+            on_arrival_(entry.second);
+        }
+    }
 }
 
 LRESULT CALLBACK USBMonitor::window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam) {
@@ -121,30 +238,20 @@ LRESULT CALLBACK USBMonitor::window_proc(HWND hwnd, UINT msg, WPARAM wparam, LPA
     );
 
     if (msg == WM_DEVICECHANGE && monitor) {
-        if (wparam == DBT_DEVICEARRIVAL) {
-            DEV_BROADCAST_HDR* hdr = reinterpret_cast<DEV_BROADCAST_HDR*>(lparam);
-
-            if (hdr->dbch_devicetype == DBT_DEVTYP_VOLUME) {
-                DEV_BROADCAST_VOLUME* vol = reinterpret_cast<DEV_BROADCAST_VOLUME*>(lparam);
-
-                // Get drive letter
-                char drive_letter = 'A';
-                DWORD mask = vol->dbcv_unitmask;
-                while (mask > 1) {
-                    mask >>= 1;
-                    drive_letter++;
-                }
-
-                std::string device_name = std::string(1, drive_letter) + ":\\";
-
-                if (monitor->callback_) {
-                    monitor->callback_(device_name);
-                }
-            }
+        if (wparam == DBT_DEVICEARRIVAL || wparam == DBT_DEVICEREMOVECOMPLETE) {
+            // Restarts the timer, so a burst of interface arrivals for one
+            // stick is handled once
+            SetTimer(hwnd, kSettleTimerId, kSettleDelayMs, nullptr);
         }
         return TRUE;
     }
 
+    if (msg == WM_TIMER && wparam == kSettleTimerId && monitor) {
+        KillTimer(hwnd, kSettleTimerId);
+        monitor->check_usb_devices();
+        return 0;
+    }
+
     return DefWindowProc(hwnd, msg, wparam, lparam);
 }
 
@@ -0,0 +1,134 @@
+#include "utf8.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CYBERSENTINEL_UTF8_SSE2
+#endif
+
+namespace cybersentinel {
+
+size_t utf8_sequence_length(std::string_view text, size_t pos) {
+    auto byte = [&](size_t k) { return static_cast<unsigned char>(text[k]); };
+    auto continuation = [&](size_t k) { return k < text.size() && (byte(k) & 0xC0) == 0x80; };
+
+    unsigned char lead = byte(pos);
+    if (lead < 0x80) {
+        return 1;
+    }
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        return continuation(pos + 1) ? 2 : 0;
+    }
+    if (lead >= 0xE0 && lead <= 0xEF) {
+        if (!continuation(pos + 1) || !continuation(pos + 2)) return 0;
+        unsigned char second = byte(pos + 1);
+        if (lead == 0xE0 && second < 0xA0) return 0;  // overlong
+        if (lead == 0xED && second > 0x9F) return 0;  // surrogate
+        return 3;
+    }
+    if (lead >= 0xF0 && lead <= 0xF4) {
+        if (!continuation(pos + 1) || !continuation(pos + 2) || !continuation(pos + 3)) return 0;
+        unsigned char second = byte(pos + 1);
+        if (lead == 0xF0 && second < 0x90) return 0;  // overlong
+        if (lead == 0xF4 && second > 0x8F) return 0;  // above U+10FFFF
+        return 4;
+    }
+    return 0;
+}
+
+namespace {
+
+// Writes one code point; returns the new end
+char* put_code_point(char* out, uint32_t cp) {
+    if (cp < 0x80) {
+        *out++ = static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        *out++ = static_cast<char>(0xC0 | (cp >> 6));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *out++ = static_cast<char>(0xE0 | (cp >> 12));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        *out++ = static_cast<char>(0xF0 | (cp >> 18));
+        *out++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+// Copies the leading ASCII run of in[0, count) to out; returns its length
+size_t copy_ascii(const char16_t* in, size_t count, char* out) {
+    size_t i = 0;
+#ifdef CYBERSENTINEL_UTF8_SSE2
+    const __m128i high_bits = _mm_set1_epi16(-128);  // 0xFF80 in every lane
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= count; i += 8) {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, high_bits), zero);
+        if (_mm_movemask_epi8(ascii) != 0xFFFF) {
+            break;
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(units, units));
+    }
+#else
+    // Four units per 64-bit word
+    for (; i + 4 <= count; i += 4) {
+        uint64_t word;
+        std::memcpy(&word, in + i, sizeof(word));
+        if (word & 0xFF80FF80FF80FF80ULL) {
+            break;
+        }
+        for (size_t k = 0; k < 4; ++k) {
+            out[i + k] = static_cast<char>(in[i + k]);
+        }
+    }
+#endif
+    for (; i < count && in[i] < 0x80; ++i) {
+        out[i] = static_cast<char>(in[i]);
+    }
+    return i;
+}
+
+} // namespace
+
+void append_utf16_as_utf8(std::u16string_view text, std::string& out) {
+    // At most three bytes per unit: a surrogate pair is two units, four bytes
+    size_t start = out.size();
+    out.resize(start + text.size() * 3);
+    char* dest = &out[start];
+
+    const char16_t* in = text.data();
+    size_t count = text.size();
+    size_t i = 0;
+    while (i < count) {
+        size_t ascii = copy_ascii(in + i, count - i, dest);
+        i += ascii;
+        dest += ascii;
+
+        // Non-ASCII units until the next ASCII one
+        while (i < count && in[i] >= 0x80) {
+            uint32_t unit = in[i++];
+            if (unit >= 0xD800 && unit <= 0xDBFF && i < count && in[i] >= 0xDC00 && in[i] <= 0xDFFF) {
+                unit = 0x10000 + ((unit - 0xD800) << 10) + (in[i++] - 0xDC00);
+            } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+                unit = 0xFFFD;
+            }
+            dest = put_code_point(dest, unit);
+        }
+    }
+
+    out.resize(static_cast<size_t>(dest - out.data()));
+}
+
+std::filesystem::path path_from_utf8(std::string_view text) {
+    return std::filesystem::u8path(text.begin(), text.end());
+}
+
+std::string path_to_utf8(const std::filesystem::path& path) {
+    return path.u8string();
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,56 @@
+#include "watcher_backend.h"
+
+namespace cybersentinel {
+
+const char* file_action_to_string(FileAction action) {
+    switch (action) {
+        case FileAction::CREATED:  return "created";
+        case FileAction::DELETED:  return "deleted";
+        case FileAction::MODIFIED: return "modified";
+        case FileAction::MOVED:    return "moved";
+    }
+    return "unknown";
+}
+
+bool WatcherBackend::run_on_backend_thread(std::function<bool()> command) {
+    std::packaged_task<bool()> task(std::move(command));
+    std::future<bool> result = task.get_future();
+    {
+        std::unique_lock<std::mutex> lock(commands_mutex_);
+        if (!serving_) {
+            lock.unlock();
+            task();
+            return result.get();
+        }
+        commands_.push_back(std::move(task));
+    }
+    wake();
+    return result.get();
+}
+
+void WatcherBackend::serve_commands(bool serving) {
+    {
+        std::lock_guard<std::mutex> lock(commands_mutex_);
+        serving_ = serving;
+    }
+    if (!serving) {
+        run_commands();
+    }
+}
+
+void WatcherBackend::run_commands() {
+    for (;;) {
+        std::packaged_task<bool()> task;
+        {
+            std::lock_guard<std::mutex> lock(commands_mutex_);
+            if (commands_.empty()) {
+                return;
+            }
+            task = std::move(commands_.front());
+            commands_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace cybersentinel
@@ -0,0 +1,359 @@
+#ifdef __linux__
+
+#include "watcher_backend.h"
+#include "logger.h"
+#include "utf8.h"
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+namespace fs = std::filesystem;
+
+namespace cybersentinel {
+
+// inotify backend. inotify is not recursive, so every directory below a root
+// gets its own watch; directories created later are added as they appear.
+// A single thread serves all roots, and adds and removes roots while running.
+class InotifyWatcherBackend : public WatcherBackend {
+public:
+    explicit InotifyWatcherBackend(size_t buffer_size);
+    ~InotifyWatcherBackend() override;
+
+    bool add_watch(const std::string& root) override;
+    bool remove_watch(const std::string& root) override;
+    bool start(WatchEventHandler on_event, WatchOverflowHandler on_overflow) override;
+    void stop() override;
+
+    const char* name() const override { return "inotify"; }
+
+protected:
+    void wake() override;
+
+private:
+    // Ids in paths_
+    struct WatchedDir {
+        uint32_t path;
+        uint32_t root;
+    };
+
+    int inotify_fd_;
+    int wake_fd_;  // stop() and queued commands
+    std::vector<uint32_t> buffer_;  // uint32_t for inotify_event alignment
+    using WatchMap = std::unordered_map<int, WatchedDir>;
+    WatchMap watches_;  // each pins its path in paths_; roots_ pin theirs
+    std::vector<std::string> roots_;
+    bool watch_limit_logged_{false};
+    std::string created_path_;  // scratch for directories created or moved under a watch
+
+    WatchEventHandler on_event_;
+    WatchOverflowHandler on_overflow_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    bool add_root(const std::string& root);
+    bool remove_root(const std::string& root);
+    bool add_directory(const std::string& path, uint32_t root);
+    void add_tree(const std::string& path, uint32_t root, bool report_files);
+    void remove_tree(const std::string& path);
+    WatchMap::iterator forget_watch(WatchMap::iterator watch);
+    void watch_loop();
+    void dispatch(const struct inotify_event* event, std::chrono::steady_clock::time_point received);
+};
+
+static const uint32_t kWatchMask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE |
+                                   IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_EXCL_UNLINK;
+
+// Default read size; overflow is governed by fs.inotify.max_queued_events,
+// not by this buffer
+static const size_t kDefaultReadBufferSize = 64 * 1024;
+
+// A read must fit at least one event with a maximal name
+static const size_t kMinReadBufferSize = sizeof(struct inotify_event) + NAME_MAX + 1;
+
+InotifyWatcherBackend::InotifyWatcherBackend(size_t buffer_size)
+    : inotify_fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+      wake_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      buffer_((std::max(buffer_size, kMinReadBufferSize) + sizeof(uint32_t) - 1) / sizeof(uint32_t)) {
+    if (inotify_fd_ < 0) {
+        Logger::error(std::string("inotify_init1 failed: ") + std::strerror(errno));
+    }
+}
+
+InotifyWatcherBackend::~InotifyWatcherBackend() {
+    stop();
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+}
+
+bool InotifyWatcherBackend::add_watch(const std::string& root) {
+    return run_on_backend_thread([this, root]() { return add_root(root); });
+}
+
+bool InotifyWatcherBackend::remove_watch(const std::string& root) {
+    return run_on_backend_thread([this, root]() { return remove_root(root); });
+}
+
+bool InotifyWatcherBackend::add_root(const std::string& root) {
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+
+    uint32_t root_id = paths_.intern(root);
+    if (!add_directory(root, root_id)) {
+        Logger::error("Failed to watch directory: " + root);
+        return false;
+    }
+
+    paths_.acquire(root_id);
+    roots_.push_back(root);
+    add_tree(root, root_id, false);
+    return true;
+}
+
+// Events already read for its directories find no watch and are dropped
+bool InotifyWatcherBackend::remove_root(const std::string& root) {
+    auto it = std::find(roots_.begin(), roots_.end(), root);
+    if (it == roots_.end()) {
+        return false;
+    }
+    roots_.erase(it);
+
+    uint32_t root_id = paths_.intern(root);
+    for (auto watch = watches_.begin(); watch != watches_.end();) {
+        if (watch->second.root == root_id) {
+            inotify_rm_watch(inotify_fd_, watch->first);
+            watch = forget_watch(watch);
+        } else {
+            ++watch;
+        }
+    }
+    paths_.release(root_id);
+    return true;
+}
+
+bool InotifyWatcherBackend::add_directory(const std::string& path, uint32_t root) {
+    int wd = inotify_add_watch(inotify_fd_, path.c_str(), kWatchMask);
+    if (wd < 0) {
+        if (errno == ENOSPC && !watch_limit_logged_) {
+            watch_limit_logged_ = true;
+            Logger::warning("inotify watch limit reached; raise fs.inotify.max_user_watches");
+        }
+        return false;
+    }
+
+    uint32_t id = paths_.intern(path);
+    paths_.acquire(id);
+    auto it = watches_.find(wd);
+    if (it != watches_.end()) {
+        paths_.release(it->second.path);  // the same directory again, under a new path
+    }
+    watches_[wd] = WatchedDir{id, root};
+    return true;
+}
+
+InotifyWatcherBackend::WatchMap::iterator InotifyWatcherBackend::forget_watch(WatchMap::iterator watch) {
+    paths_.release(watch->second.path);
+    return watches_.erase(watch);
+}
+
+void InotifyWatcherBackend::add_tree(const std::string& path, uint32_t root, bool report_files) {
+    std::error_code ec;
+    fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec);
+
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            add_directory(path_to_utf8(it->path()), root);
+        } else if (report_files && on_event_) {
+            // Created before its directory's watch existed; would be missed otherwise
+            std::string name = path_to_utf8(it->path().filename());
+            on_event_(WatchEvent{paths_.intern(path_to_utf8(it->path().parent_path())), name,
+                                 FileAction::CREATED, std::chrono::steady_clock::now()});
+        }
+    }
+}
+
+// Drops the watches of path and every directory below it. Their paths are
+// interned and would go stale once the tree is renamed or moved elsewhere.
+void InotifyWatcherBackend::remove_tree(const std::string& path) {
+    for (auto watch = watches_.begin(); watch != watches_.end();) {
+        std::string_view watched = paths_.get(watch->second.path);
+        bool below = watched.size() > path.size() && watched[path.size()] == kPathSeparator &&
+                     watched.compare(0, path.size(), path) == 0;
+        if (watched == path || below) {
+            inotify_rm_watch(inotify_fd_, watch->first);
+            watch = forget_watch(watch);
+        } else {
+            ++watch;
+        }
+    }
+}
+
+bool InotifyWatcherBackend::start(WatchEventHandler on_event, WatchOverflowHandler on_overflow) {
+    if (inotify_fd_ < 0 || wake_fd_ < 0) {
+        return false;
+    }
+
+    on_event_ = std::move(on_event);
+    on_overflow_ = std::move(on_overflow);
+    running_ = true;
+    serve_commands(true);
+    thread_ = std::thread([this]() {
+        watch_loop();
+    });
+    return true;
+}
+
+void InotifyWatcherBackend::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    wake();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void InotifyWatcherBackend::wake() {
+    uint64_t one = 1;
+    if (write(wake_fd_, &one, sizeof(one)) < 0) {
+        Logger::warning("Failed to signal inotify watcher thread");
+    }
+}
+
+void InotifyWatcherBackend::watch_loop() {
+    char* buffer = reinterpret_cast<char*>(buffer_.data());
+    size_t buffer_bytes = buffer_.size() * sizeof(uint32_t);
+
+    struct pollfd fds[2];
+    fds[0].fd = inotify_fd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd_;
+    fds[1].events = POLLIN;
+
+    while (running_) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error(std::string("poll failed on inotify descriptor: ") + std::strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t count;
+            if (read(wake_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                Logger::warning("Failed to reset inotify wake descriptor");
+            }
+            if (!running_) {
+                break;
+            }
+            run_commands();
+        }
+
+        while (true) {
+            ssize_t length = read(inotify_fd_, buffer, buffer_bytes);
+            if (length <= 0) {
+                break;
+            }
+
+            auto received = std::chrono::steady_clock::now();
+            for (char* p = buffer; p < buffer + length; ) {
+                auto* event = reinterpret_cast<struct inotify_event*>(p);
+                dispatch(event, received);
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+
+    serve_commands(false);
+}
+
+void InotifyWatcherBackend::dispatch(const struct inotify_event* event,
+                                     std::chrono::steady_clock::time_point received) {
+    if (event->mask & IN_Q_OVERFLOW) {
+        for (const auto& root : roots_) {
+            // Directories created while events were dropped have no watch yet
+            add_tree(root, paths_.intern(root), false);
+            if (on_overflow_) {
+                on_overflow_(root);
+            }
+        }
+        return;
+    }
+
+    auto it = watches_.find(event->wd);
+    if (it == watches_.end()) {
+        return;
+    }
+
+    if (event->mask & IN_IGNORED) {
+        forget_watch(it);
+        return;
+    }
+
+    if (event->len == 0) {
+        return;
+    }
+
+    WatchedDir directory = it->second;
+
+    // A directory renamed within the tree arrives as MOVED_FROM then MOVED_TO
+    // and is watched again under its new path; one moved out only as
+    // MOVED_FROM, and its watches must not report the new location under
+    // the old path
+    if ((event->mask & IN_ISDIR) && (event->mask & IN_MOVED_FROM)) {
+        paths_.join(directory.path, event->name, created_path_);
+        remove_tree(created_path_);
+        return;
+    }
+
+    if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+        paths_.join(directory.path, event->name, created_path_);
+        if (add_directory(created_path_, directory.root)) {
+            add_tree(created_path_, directory.root, true);
+        }
+        return;
+    }
+
+    if (!on_event_ || (event->mask & IN_ISDIR)) {
+        return;
+    }
+
+    WatchEvent watch_event{directory.path, event->name, FileAction::CREATED, received};
+    if (event->mask & IN_CREATE) {
+        watch_event.action = FileAction::CREATED;
+    } else if (event->mask & IN_DELETE) {
+        watch_event.action = FileAction::DELETED;
+    } else if (event->mask & IN_CLOSE_WRITE) {
+        watch_event.action = FileAction::MODIFIED;
+    } else if (event->mask & (IN_MOVED_FROM | IN_MOVED_TO)) {
+        watch_event.action = FileAction::MOVED;
+    } else {
+        return;
+    }
+    on_event_(watch_event);
+}
+
+std::unique_ptr<WatcherBackend> WatcherBackend::create(size_t buffer_size) {
+    return std::make_unique<InotifyWatcherBackend>(buffer_size ? buffer_size : kDefaultReadBufferSize);
+}
+
+} // namespace cybersentinel
+
+#endif // __linux__
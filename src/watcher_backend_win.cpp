@@ -0,0 +1,309 @@
+#ifdef _WIN32
+
+#include "watcher_backend.h"
+#include "notify_decoder.h"
+#include "utf8.h"
+#include "logger.h"
+#include <windows.h>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+namespace cybersentinel {
+
+// 64 KB is the largest buffer ReadDirectoryChangesW accepts for network shares
+static const size_t kDefaultNotifyBufferSize = 64 * 1024;
+
+// Completion keys posted by stop() and for queued commands; watch keys are
+// Watch pointers
+static const ULONG_PTR kStopKey = 0;
+static const ULONG_PTR kCommandKey = 1;
+
+// ReadDirectoryChangesW backend. All roots share one I/O completion port
+// served by a single thread. Each root has two notification buffers: when a
+// read completes the other buffer is re-armed before the completed one is
+// decoded, so the kernel always has somewhere to queue changes. Roots added
+// or removed while running are handled on that thread too.
+class WindowsWatcherBackend : public WatcherBackend {
+public:
+    explicit WindowsWatcherBackend(size_t buffer_size);
+    ~WindowsWatcherBackend() override;
+
+    bool add_watch(const std::string& root) override;
+    bool remove_watch(const std::string& root) override;
+    bool start(WatchEventHandler on_event, WatchOverflowHandler on_overflow) override;
+    void stop() override;
+
+    const char* name() const override { return "ReadDirectoryChangesW (IOCP)"; }
+
+protected:
+    void wake() override;
+
+private:
+    struct Watch {
+        std::string root;
+        uint32_t root_id = 0;  // pinned in paths_ while the watch exists
+        HANDLE dir_handle = INVALID_HANDLE_VALUE;
+        OVERLAPPED overlapped{};
+        NotifyBuffers buffers;
+        bool armed = false;
+        bool removed = false;  // freed once its cancelled read completes
+
+        explicit Watch(size_t buffer_size) : buffers(buffer_size) {}
+    };
+
+    size_t buffer_size_;
+    HANDLE port_;
+    std::vector<std::unique_ptr<Watch>> watches_;
+    WatchEventHandler on_event_;
+    WatchOverflowHandler on_overflow_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    NotifyEventBuilder builder_{paths_};  // used on the completion thread
+
+    bool add_root(const std::string& root);
+    bool remove_root(const std::string& root);
+    void release(Watch& watch);
+    bool arm(Watch& watch);
+    void completion_loop();
+    void dispatch(Watch& watch, const NotifyBuffers::Chunk& chunk,
+                  std::chrono::steady_clock::time_point received);
+};
+
+WindowsWatcherBackend::WindowsWatcherBackend(size_t buffer_size)
+    : buffer_size_(buffer_size),
+      port_(CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1)) {
+    if (!port_) {
+        Logger::error("CreateIoCompletionPort failed: " + std::to_string(GetLastError()));
+    }
+}
+
+WindowsWatcherBackend::~WindowsWatcherBackend() {
+    stop();
+    for (auto& watch : watches_) {
+        CloseHandle(watch->dir_handle);
+    }
+    if (port_) {
+        CloseHandle(port_);
+    }
+}
+
+bool WindowsWatcherBackend::add_watch(const std::string& root) {
+    return run_on_backend_thread([this, root]() { return add_root(root); });
+}
+
+bool WindowsWatcherBackend::remove_watch(const std::string& root) {
+    return run_on_backend_thread([this, root]() { return remove_root(root); });
+}
+
+bool WindowsWatcherBackend::add_root(const std::string& root) {
+    if (!port_) {
+        return false;
+    }
+
+    auto watch = std::make_unique<Watch>(buffer_size_);
+    watch->root = root;
+    watch->dir_handle = CreateFileW(
+        path_from_utf8(root).c_str(),
+        FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+        nullptr
+    );
+
+    if (watch->dir_handle == INVALID_HANDLE_VALUE) {
+        Logger::error("Failed to open directory: " + root);
+        return false;
+    }
+
+    if (!CreateIoCompletionPort(watch->dir_handle, port_, reinterpret_cast<ULONG_PTR>(watch.get()), 0)) {
+        Logger::error("Failed to associate directory with completion port: " + root);
+        CloseHandle(watch->dir_handle);
+        return false;
+    }
+
+    watch->root_id = paths_.intern(root);
+    paths_.acquire(watch->root_id);
+
+    // Added while running: start reading now; start() arms the others
+    if (running_) {
+        arm(*watch);
+    }
+    watches_.push_back(std::move(watch));
+    return true;
+}
+
+// The kernel may still write to the buffers until the cancelled read
+// completes, so the watch is only released then
+bool WindowsWatcherBackend::remove_root(const std::string& root) {
+    for (auto& watch : watches_) {
+        if (watch->root == root && !watch->removed) {
+            watch->removed = true;
+            if (watch->armed) {
+                CancelIoEx(watch->dir_handle, &watch->overlapped);
+            } else {
+                release(*watch);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void WindowsWatcherBackend::release(Watch& watch) {
+    CloseHandle(watch.dir_handle);
+    paths_.release(watch.root_id);
+    watches_.erase(std::find_if(watches_.begin(), watches_.end(),
+                                [&watch](const std::unique_ptr<Watch>& entry) { return entry.get() == &watch; }));
+}
+
+bool WindowsWatcherBackend::start(WatchEventHandler on_event, WatchOverflowHandler on_overflow) {
+    if (!port_) {
+        return false;
+    }
+
+    on_event_ = std::move(on_event);
+    on_overflow_ = std::move(on_overflow);
+
+    // Arm before the thread starts; completions simply queue on the port
+    for (auto& watch : watches_) {
+        arm(*watch);
+    }
+
+    running_ = true;
+    serve_commands(true);
+    thread_ = std::thread([this]() {
+        completion_loop();
+    });
+    return true;
+}
+
+void WindowsWatcherBackend::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // The completion thread cancels the reads: watches_ is its own
+    PostQueuedCompletionStatus(port_, 0, kStopKey, nullptr);
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void WindowsWatcherBackend::wake() {
+    PostQueuedCompletionStatus(port_, 0, kCommandKey, nullptr);
+}
+
+bool WindowsWatcherBackend::arm(Watch& watch) {
+    watch.overlapped = OVERLAPPED{};
+    watch.armed = ReadDirectoryChangesW(
+        watch.dir_handle,
+        watch.buffers.armed(),
+        static_cast<DWORD>(watch.buffers.size()),
+        TRUE, // Watch subdirectories
+        FILE_NOTIFY_CHANGE_FILE_NAME |
+        FILE_NOTIFY_CHANGE_DIR_NAME |
+        FILE_NOTIFY_CHANGE_SIZE |
+        FILE_NOTIFY_CHANGE_LAST_WRITE,
+        nullptr,
+        &watch.overlapped,
+        nullptr
+    ) != FALSE;
+
+    if (!watch.armed) {
+        Logger::error("ReadDirectoryChangesW failed for " + watch.root + ": " +
+                      std::to_string(GetLastError()));
+    }
+    return watch.armed;
+}
+
+void WindowsWatcherBackend::completion_loop() {
+    bool stopping = false;
+
+    while (true) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* overlapped = nullptr;
+        BOOL ok = GetQueuedCompletionStatus(port_, &bytes, &key, &overlapped, INFINITE);
+        DWORD error = ok ? 0 : GetLastError();
+
+        if (key == kStopKey && !overlapped) {
+            // Cancelled reads complete with ERROR_OPERATION_ABORTED; the loop
+            // exits once no read is outstanding, so no buffer is freed while
+            // the kernel may still write to it
+            stopping = true;
+            for (auto& watch : watches_) {
+                CancelIoEx(watch->dir_handle, nullptr);
+            }
+        } else if (key == kCommandKey && !overlapped) {
+            run_commands();
+        } else if (overlapped) {
+            Watch& watch = *reinterpret_cast<Watch*>(key);
+            watch.armed = false;
+
+            if (watch.removed) {
+                release(watch);
+            } else if (!stopping && running_ && error != ERROR_OPERATION_ABORTED) {
+                // Swap first and re-arm, then decode the completed buffer
+                auto received = std::chrono::steady_clock::now();
+                NotifyBuffers::Chunk chunk = watch.buffers.swap(ok ? bytes : 0);
+                arm(watch);
+
+                if (ok || error == ERROR_NOTIFY_ENUM_DIR) {
+                    dispatch(watch, chunk, received);
+                } else {
+                    Logger::error("Directory watch failed for " + watch.root + ": " +
+                                  std::to_string(error));
+                }
+            }
+        } else {
+            Logger::error("GetQueuedCompletionStatus failed: " + std::to_string(error));
+            break;
+        }
+
+        if (stopping) {
+            bool outstanding = false;
+            for (const auto& watch : watches_) {
+                outstanding = outstanding || watch->armed;
+            }
+            if (!outstanding) {
+                break;
+            }
+        }
+    }
+
+    serve_commands(false);
+}
+
+void WindowsWatcherBackend::dispatch(Watch& watch, const NotifyBuffers::Chunk& chunk,
+                                     std::chrono::steady_clock::time_point received) {
+    NotifyDecodeStatus status = decode_notifications(chunk.data, chunk.length,
+        [this, &watch, received](uint32_t action, std::u16string_view name) {
+            WatchEvent event;
+            event.received = received;
+            if (on_event_ && builder_.build(watch.root_id, action, name, event)) {
+                on_event_(event);
+            }
+        });
+
+    if (status == NotifyDecodeStatus::EVENTS_LOST) {
+        // Zero bytes means the kernel buffer overflowed and changes were lost
+        if (on_overflow_) {
+            on_overflow_(watch.root);
+        }
+    } else if (status == NotifyDecodeStatus::MALFORMED) {
+        Logger::warning("Malformed change notification buffer for " + watch.root);
+    }
+}
+
+std::unique_ptr<WatcherBackend> WatcherBackend::create(size_t buffer_size) {
+    return std::make_unique<WindowsWatcherBackend>(buffer_size ? buffer_size : kDefaultNotifyBufferSize);
+}
+
+} // namespace cybersentinel
+
+#endif // _WIN32
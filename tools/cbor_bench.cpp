@@ -0,0 +1,297 @@
+// CBOR uplink check and benchmark: every record type is encoded both ways,
+// the CBOR is decoded with an independent decoder (nlohmann::json::from_cbor,
+// strict) and must equal the JSON form field for field; then payload sizes
+// and encode times are compared.
+//
+//   cbor_bench
+//   cbor_bench --iterations 1000000 --fuzz 200000
+//
+// Exits non-zero if any CBOR payload is malformed or decodes to something
+// other than its JSON form.
+
+#include "events.h"
+#include "logger.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    int iterations = 200000;
+    int fuzz = 50000;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--iterations") {
+            options.iterations = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--fuzz") {
+            options.fuzz = std::max(0, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+// JSON has no NaN or infinity and writes null; CBOR keeps the float. Null in
+// the JSON form therefore matches a non-finite float in the CBOR form.
+bool same_value(const nlohmann::json& json, const nlohmann::json& cbor) {
+    if (json.is_null() && cbor.is_number_float()) {
+        return !std::isfinite(cbor.get<double>());
+    }
+    if (json.is_object()) {
+        if (!cbor.is_object() || json.size() != cbor.size()) {
+            return false;
+        }
+        for (auto it = json.begin(); it != json.end(); ++it) {
+            if (!cbor.contains(it.key()) || !same_value(it.value(), cbor.at(it.key()))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (json.is_array()) {
+        if (!cbor.is_array() || json.size() != cbor.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < json.size(); ++i) {
+            if (!same_value(json[i], cbor[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return json == cbor;
+}
+
+template <typename Record>
+bool check_record(const Record& record, std::string& error) {
+    std::string json_payload = encode_payload(WireFormat::JSON, record);
+    std::string cbor_payload = encode_payload(WireFormat::CBOR, record);
+
+    nlohmann::json from_json = nlohmann::json::parse(json_payload, nullptr, false);
+    if (from_json.is_discarded()) {
+        error = "JSON form does not parse";
+        return false;
+    }
+    nlohmann::json from_cbor = nlohmann::json::from_cbor(cbor_payload, true, false);
+    if (from_cbor.is_discarded()) {
+        error = "CBOR form is malformed";
+        return false;
+    }
+    if (!same_value(from_json, from_cbor)) {
+        error = "CBOR decodes to " + from_cbor.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) +
+                ", JSON to " + from_json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+        return false;
+    }
+    return true;
+}
+
+struct Samples {
+    AgentRegistration registration;
+    AgentHealth health;
+    Heartbeat heartbeat;
+    ClassificationResult classification;
+    VolumeInfo volume;
+    DlpEvent file_event;
+    DlpEvent clipboard_event;
+    DlpEvent usb_event;
+
+    Samples() {
+        registration.agent_id = "WS-FIN-0042";
+        registration.agent_name = "WS-FIN-0042";
+        registration.hostname = "ws-fin-0042.corp.example.com";
+        registration.os_type = "windows";
+        registration.os_version = "10.0.22631";
+        registration.ip_address = "10.20.30.40";
+        registration.agent_version = "1.0.0";
+        registration.capabilities = {true, true, true};
+        registration.offer_cbor = true;
+
+        health.events_reported = 1234567;
+        health.events_spooled = 321;
+        health.events_dropped = 2;
+        health.spool_bytes = 5ull * 1024 * 1024 * 1024;
+        health.uplink_queue = 3;
+        health.files_scanned = 88000;
+        health.scan_rate = 412.5;
+        health.open_circuits = 1;
+        health.watcher_overflows = 4;
+        health.rescan_ms = 1500;
+        health.removable_volumes = 1;
+        heartbeat.agent_id = "WS-FIN-0042";
+        heartbeat.status = "online";
+        heartbeat.health = &health;
+
+        classification.labels = {"PAN", "SSN", "EMAIL"};
+        classification.confidence = 0.93;
+
+        volume.root = "E:\\";
+        volume.label = "KINGSTON";
+        volume.serial = "1A2B-3C4D";
+        volume.file_system = "exFAT";
+        volume.bus = "usb";
+        volume.total_bytes = 64ull * 1024 * 1024 * 1024;
+
+        file_event.event_id = "evt-WS-FIN-0042-1760000000000-17";
+        file_event.event_type = "file_modified";
+        file_event.severity = "high";
+        file_event.agent_id = "WS-FIN-0042";
+        file_event.file_path = "C:\\Users\\jsmith\\Documents\\Finance\\Q3 forecast (draft).xlsx";
+        file_event.classification = &classification;
+
+        clipboard_event = file_event;
+        clipboard_event.event_type = "clipboard_copy";
+        clipboard_event.severity = "medium";
+        clipboard_event.file_path = "";
+
+        usb_event = file_event;
+        usb_event.event_type = "usb_file_created";
+        usb_event.file_path = "E:\\export\\customers.csv";
+        usb_event.volume = &volume;
+    }
+};
+
+bool check_equivalence(const Options& options) {
+    Samples samples;
+    size_t failures = 0;
+    std::string error;
+    auto expect = [&](bool ok, const std::string& what) {
+        if (!ok && failures++ < 10) {
+            std::printf("  FAILED %s: %s\n", what.c_str(), error.c_str());
+        }
+    };
+
+    expect(check_record(samples.registration, error), "registration");
+    expect(check_record(samples.heartbeat, error), "heartbeat");
+    Heartbeat bare = samples.heartbeat;
+    bare.health = nullptr;
+    expect(check_record(bare, error), "heartbeat without health");
+    expect(check_record(samples.file_event, error), "file event");
+    expect(check_record(samples.clipboard_event, error), "clipboard event");
+    expect(check_record(samples.usb_event, error), "usb event");
+
+    // Values at the edges of each CBOR head size, and floats that do and do
+    // not fit single precision
+    AgentHealth health = samples.health;
+    Heartbeat heartbeat = samples.heartbeat;
+    heartbeat.health = &health;
+    for (uint64_t n : {0ull, 23ull, 24ull, 255ull, 256ull, 65535ull, 65536ull, 4294967295ull, 4294967296ull,
+                       18446744073709551615ull}) {
+        health.events_reported = n;
+        expect(check_record(heartbeat, error), "count " + std::to_string(n));
+    }
+    for (double x : {0.0, -0.0, 0.5, 0.1, 412.5, 1e-300, 1e300, 3.4028234663852886e38, std::nan(""),
+                     HUGE_VAL, -HUGE_VAL}) {
+        health.scan_rate = x;
+        expect(check_record(heartbeat, error), "scan rate " + std::to_string(x));
+    }
+
+    // Strings: empty, long (every text head size), escapes, non-ASCII,
+    // invalid UTF-8 (replaced the same way in both forms)
+    std::vector<std::string> texts = {
+        "", "a", std::string(23, 'x'), std::string(24, 'x'), std::string(255, 'x'), std::string(256, 'x'),
+        std::string(70000, 'x'), "quote \" backslash \\ tab \t nul " + std::string(1, '\0'),
+        "\xC3\xA9t\xC3\xA9 \xE6\x8A\xA5\xE5\x91\x8A \xF0\x9F\x93\x81", "bad \xFF \xE2\x82 \xC0\xAF \xED\xA0\x80",
+    };
+    ClassificationResult classification = samples.classification;
+    DlpEvent event = samples.usb_event;
+    VolumeInfo volume = samples.volume;
+    event.classification = &classification;
+    event.volume = &volume;
+    for (const auto& text : texts) {
+        event.file_path = text;
+        classification.labels = {text};
+        volume.label = text;
+        expect(check_record(event, error), "text of " + std::to_string(text.size()) + " bytes");
+    }
+
+    std::mt19937 random(2024);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_int_distribution<int> length(0, 60);
+    std::uniform_int_distribution<int> labels(0, 5);
+    for (int i = 0; i < options.fuzz; ++i) {
+        std::string text;
+        for (int n = length(random); n > 0; --n) {
+            text.push_back(static_cast<char>(byte(random)));
+        }
+        event.file_path = text;
+        classification.labels.assign(static_cast<size_t>(labels(random)), text);
+        classification.confidence = byte(random) / 255.0;
+        volume.total_bytes = (uint64_t(random()) << 32) | random();
+        expect(check_record(event, error), "random event " + std::to_string(i));
+    }
+
+    std::printf("CBOR decodes to the JSON form: %zu failures (%d random events)\n", failures, options.fuzz);
+    return failures == 0;
+}
+
+template <typename Record>
+double encode_ns(WireFormat format, const Record& record, int iterations, size_t& bytes) {
+    bytes = encode_payload(format, record).size();
+    auto start = Clock::now();
+    size_t checksum = 0;
+    for (int i = 0; i < iterations; ++i) {
+        checksum += encode_payload(format, record).size();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    if (checksum != bytes * static_cast<size_t>(iterations)) {
+        std::printf("  unstable payload size\n");
+    }
+    return ns;
+}
+
+template <typename Record>
+void bench_record(const char* name, const Record& record, int iterations) {
+    size_t json_bytes = 0;
+    size_t cbor_bytes = 0;
+    double json_ns = encode_ns(WireFormat::JSON, record, iterations, json_bytes);
+    double cbor_ns = encode_ns(WireFormat::CBOR, record, iterations, cbor_bytes);
+    std::printf("  %-14s %10zu %10zu %7.0f%% %10.0f %10.0f\n", name, json_bytes, cbor_bytes,
+                100.0 * cbor_bytes / json_bytes, json_ns, cbor_ns);
+}
+
+void bench_encoding(const Options& options) {
+    Samples samples;
+    std::printf("\n%d encodes per record\n", options.iterations);
+    std::printf("  %-14s %10s %10s %8s %10s %10s\n", "record", "JSON bytes", "CBOR bytes", "size",
+                "JSON ns", "CBOR ns");
+    bench_record("registration", samples.registration, options.iterations);
+    bench_record("heartbeat", samples.heartbeat, options.iterations);
+    bench_record("file event", samples.file_event, options.iterations);
+    bench_record("clipboard", samples.clipboard_event, options.iterations);
+    bench_record("usb event", samples.usb_event, options.iterations);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--iterations N] [--fuzz N]\n", argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::WARNING);
+
+    bool ok = check_equivalence(options);
+    bench_encoding(options);
+
+    std::printf("\n%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+// Clipboard dispatch harness: replays synthetic clipboard sequences through
+// ClipboardDispatcher (hash dedup and handoff to the classification worker)
+// and checks what reaches the callback. Runs on any platform; only the Win32
+// capture is left out.
+//
+//   clipboard_bench
+//   clipboard_bench --classify        # run the Classifier in the callback
+//   clipboard_bench --work-us 5000    # slower simulated classification
+//
+// Each scenario prints how many copies were captured, skipped as duplicates,
+// dropped because the worker fell behind and delivered, plus the time the
+// capture thread spent in submit(). The exit status is non-zero when a
+// scenario delivers something other than expected.
+
+#include "clipboard_dispatcher.h"
+#include "classifier.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    bool classify = false;
+    int work_us = 2000;  // simulated classification time without --classify
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--classify") {
+            options.classify = true;
+        } else if (arg == "--work-us" && i + 1 < argc) {
+            options.work_us = std::max(0, std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string sample(int i) {
+    return "Meeting notes " + std::to_string(i) + ": contact bob@example.com, card 4111 1111 1111 1111";
+}
+
+struct Scenario {
+    const char* name;
+    ClipboardDispatcher::Options options;
+    std::vector<std::string> copies;
+    std::vector<int> pauses_ms;  // before each copy; empty = back to back
+    uint64_t expected_delivered;
+};
+
+struct Outcome {
+    ClipboardDispatcher::Stats stats;
+    double submit_p99_us = 0.0;
+    double submit_max_us = 0.0;
+};
+
+Outcome run(const Scenario& scenario, const Options& options) {
+    Classifier classifier;
+    ClipboardDispatcher dispatcher([&](const std::string& content) {
+        if (options.classify) {
+            classifier.classify_text(content);
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(options.work_us));
+        }
+    }, scenario.options);
+    dispatcher.start();
+
+    std::vector<double> submit_us;
+    for (size_t i = 0; i < scenario.copies.size(); ++i) {
+        if (!scenario.pauses_ms.empty() && scenario.pauses_ms[i] > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(scenario.pauses_ms[i]));
+        }
+
+        auto start = Clock::now();
+        dispatcher.submit(scenario.copies[i]);
+        submit_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    dispatcher.wait_idle();
+
+    Outcome outcome;
+    outcome.stats = dispatcher.stats();
+    dispatcher.stop();
+
+    std::sort(submit_us.begin(), submit_us.end());
+    outcome.submit_p99_us = submit_us[static_cast<size_t>(0.99 * (submit_us.size() - 1) + 0.5)];
+    outcome.submit_max_us = submit_us.back();
+    return outcome;
+}
+
+std::vector<Scenario> make_scenarios() {
+    std::vector<Scenario> scenarios;
+    ClipboardDispatcher::Options defaults;
+
+    // The same few snippets pasted over and over
+    {
+        Scenario s{"repeats", defaults, {}, {}, 4};
+        for (int i = 0; i < 200; ++i) {
+            s.copies.push_back(sample(i % 4));
+        }
+        scenarios.push_back(s);
+    }
+
+    // Cycling through fewer snippets than the LRU holds: one pass delivered
+    {
+        Scenario s{"lru-fits", defaults, {}, {}, 0};
+        s.options.dedup_entries = 8;
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 8; ++i) {
+                s.copies.push_back(sample(i));
+            }
+        }
+        s.expected_delivered = 8;
+        scenarios.push_back(s);
+    }
+
+    // One more snippet than the LRU holds: every copy evicts the next one
+    {
+        Scenario s{"lru-thrash", defaults, {}, {}, 0};
+        s.options.dedup_entries = 8;
+        for (int round = 0; round < 10; ++round) {
+            for (int i = 0; i < 9; ++i) {
+                s.copies.push_back(sample(i));
+            }
+        }
+        s.expected_delivered = 90;
+        s.options.max_pending = 100;
+        scenarios.push_back(s);
+    }
+
+    // A repeat after the dedup window is new content again
+    {
+        Scenario s{"window", defaults, {sample(0), sample(0), sample(0)}, {0, 100, 1100}, 2};
+        s.options.dedup_window = std::chrono::seconds(1);
+        scenarios.push_back(s);
+    }
+
+    // A burst of distinct copies faster than classification: the capture
+    // thread never waits, the oldest pending content is dropped
+    {
+        Scenario s{"burst", defaults, {}, {}, 0};
+        s.options.max_pending = 16;
+        for (int i = 0; i < 500; ++i) {
+            s.copies.push_back(sample(1000 + i));
+        }
+        s.expected_delivered = 0;  // depends on timing; checked separately
+        scenarios.push_back(s);
+    }
+
+    return scenarios;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--classify] [--work-us N]\n", argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::ERROR);
+
+    std::printf("Callback: %s\n\n", options.classify ? "Classifier::classify_text"
+                                                    : (std::to_string(options.work_us) + " us simulated").c_str());
+    std::printf("%-11s %8s %10s %8s %9s %9s %12s %12s\n",
+                "scenario", "captured", "duplicates", "dropped", "delivered", "expected",
+                "submit p99us", "submit maxus");
+
+    bool all_ok = true;
+    for (const auto& scenario : make_scenarios()) {
+        Outcome outcome = run(scenario, options);
+        const auto& stats = outcome.stats;
+
+        bool ok;
+        std::string expected;
+        if (std::string(scenario.name) == "burst") {
+            // Everything is either delivered or dropped, and the queue bound holds
+            ok = stats.delivered + stats.dropped == stats.captured && stats.duplicates == 0;
+            expected = "all/drop";
+        } else {
+            ok = stats.delivered == scenario.expected_delivered && stats.dropped == 0;
+            expected = std::to_string(scenario.expected_delivered);
+        }
+        all_ok = all_ok && ok;
+
+        std::printf("%-11s %8llu %10llu %8llu %9llu %9s %12.1f %12.1f%s\n",
+                    scenario.name,
+                    static_cast<unsigned long long>(stats.captured),
+                    static_cast<unsigned long long>(stats.duplicates),
+                    static_cast<unsigned long long>(stats.dropped),
+                    static_cast<unsigned long long>(stats.delivered),
+                    expected.c_str(), outcome.submit_p99_us, outcome.submit_max_us,
+                    ok ? "" : "  UNEXPECTED");
+    }
+
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,406 @@
+// JSON payload benchmark and round-trip check: encoding an event with
+// JsonWriter against the ostringstream code it replaced, whether every
+// payload parses back to what was encoded, and whether event ids stay
+// unique when many events are reported in the same millisecond.
+//
+//   json_bench
+//   json_bench --events 1000000 --fuzz 200000
+//
+// Payloads are parsed with nlohmann::json. Invalid UTF-8 must come back as
+// U+FFFD with the valid text around it intact; everything else must come
+// back exactly. Allocations are counted by replacing operator new. Exits
+// non-zero if any payload fails to round-trip or an event id repeats.
+
+#include "events.h"
+#include "event_reporter.h"
+#include "event_spool.h"
+#include "http_client.h"
+#include "logger.h"
+#include "utf8.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct Options {
+    int events = 200000;
+    int fuzz = 100000;
+    int threads = 4;
+    int ids_per_thread = 5000;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--events") {
+            options.events = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--fuzz") {
+            options.fuzz = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--ids") {
+            options.ids_per_thread = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+const std::string kAgentId = "WS-FIN-0042";
+const std::string kPath = "C:\\Users\\jsmith\\Documents\\Finance\\Q3 forecast (draft).xlsx";
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// The event as report_event built it before JsonWriter: the classification
+// fragment and the payload each through an ostringstream, nothing escaped
+std::string legacy_event(const std::string& event_type, const std::string& severity,
+                         const std::string& file_path, const ClassificationResult& result) {
+    std::ostringstream classification;
+    classification << "{\"labels\":[";
+    for (size_t i = 0; i < result.labels.size(); ++i) {
+        if (i > 0) classification << ",";
+        classification << "\"" << result.labels[i] << "\"";
+    }
+    classification << "],\"confidence\":" << result.confidence << "}";
+
+    std::ostringstream event_id;
+    event_id << "evt-" << kAgentId << "-" << now_ms();
+
+    std::ostringstream payload;
+    payload << "{"
+            << "\"event_id\":\"" << event_id.str() << "\","
+            << "\"event_type\":\"" << event_type << "\","
+            << "\"severity\":\"" << severity << "\","
+            << "\"agent_id\":\"" << kAgentId << "\","
+            << "\"source_type\":\"endpoint\"";
+    if (!file_path.empty()) {
+        payload << ",\"file_path\":\"" << file_path << "\"";
+    }
+    payload << ",\"classification\":" << classification.str();
+    payload << "}";
+    return payload.str();
+}
+
+// The event as EventReporter::report builds it now
+std::string& current_event(const std::string& event_type, const std::string& severity,
+                           const std::string& file_path, const ClassificationResult& result,
+                           uint64_t sequence) {
+    char digits[24];
+    static thread_local std::string event_id;
+    event_id.assign("evt-").append(kAgentId).append(1, '-');
+    event_id.append(digits, std::to_chars(digits, digits + sizeof(digits), now_ms()).ptr);
+    event_id.append(1, '-');
+    event_id.append(digits, std::to_chars(digits, digits + sizeof(digits), sequence).ptr);
+
+    DlpEvent event;
+    event.event_id = event_id;
+    event.event_type = event_type;
+    event.severity = severity;
+    event.agent_id = kAgentId;
+    event.file_path = file_path;
+    event.classification = &result;
+    return encode_payload(WireFormat::JSON, event);
+}
+
+void bench_encoding(const Options& options) {
+    ClassificationResult result;
+    result.labels = {"PAN", "SSN", "EMAIL"};
+    result.confidence = 0.93;
+    std::string event_type = "file_modified";
+    std::string severity = "high";
+    size_t checksum = 0;
+
+    uint64_t allocations = g_allocations;
+    auto start = Clock::now();
+    for (int i = 0; i < options.events; ++i) {
+        checksum += legacy_event(event_type, severity, kPath, result).size();
+    }
+    double legacy_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / options.events;
+    double legacy_allocations = double(g_allocations - allocations) / options.events;
+
+    current_event(event_type, severity, kPath, result, 0);  // warm the thread buffers
+    allocations = g_allocations;
+    start = Clock::now();
+    for (int i = 0; i < options.events; ++i) {
+        checksum += current_event(event_type, severity, kPath, result, static_cast<uint64_t>(i)).size();
+    }
+    double current_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / options.events;
+    double current_allocations = double(g_allocations - allocations) / options.events;
+
+    std::printf("%d events, %zu payload bytes\n", options.events, checksum);
+    std::printf("  %-14s %10s %14s\n", "encoder", "ns/event", "allocs/event");
+    std::printf("  %-14s %10.0f %14.2f\n", "ostringstream", legacy_ns, legacy_allocations);
+    std::printf("  %-14s %10.0f %14.2f\n", "JsonWriter", current_ns, current_allocations);
+}
+
+bool valid_utf8(const std::string& text) {
+    for (size_t i = 0; i < text.size();) {
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t length = utf8_sequence_length(text, i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+std::string without_replacements(std::string text) {
+    static const std::string replacement = "\xEF\xBF\xBD";
+    for (size_t pos; (pos = text.find(replacement)) != std::string::npos;) {
+        text.erase(pos, replacement.size());
+    }
+    return text;
+}
+
+// What a decoder should see for input: the input itself when it is valid
+// UTF-8; otherwise nlohmann's own U+FFFD substitution, compared with the
+// replacement characters removed, since the two may replace a truncated
+// sequence with one or several of them
+bool same_text(const std::string& input, const std::string& decoded) {
+    if (valid_utf8(input)) {
+        return decoded == input;
+    }
+    std::string reference = nlohmann::json(input).dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+    return without_replacements(nlohmann::json::parse(reference).get<std::string>()) ==
+           without_replacements(decoded);
+}
+
+// Encodes an event carrying text as path and label and checks the decode
+bool round_trips(const std::string& text, double confidence, std::string& error) {
+    ClassificationResult result;
+    result.labels = {text, "PAN"};
+    result.confidence = confidence;
+    VolumeInfo volume;
+    volume.root = "E:\\";
+    volume.label = text;
+    volume.serial = "1A2B-3C4D";
+    volume.total_bytes = 64ull * 1024 * 1024 * 1024;
+
+    DlpEvent event;
+    event.event_id = "evt-check-1";
+    event.event_type = "usb_file_created";
+    event.severity = "high";
+    event.agent_id = kAgentId;
+    event.file_path = text;
+    event.classification = &result;
+    event.volume = &volume;
+    std::string payload = encode_payload(WireFormat::JSON, event);
+
+    nlohmann::json decoded = nlohmann::json::parse(payload, nullptr, false);
+    if (decoded.is_discarded()) {
+        error = "does not parse";
+        return false;
+    }
+    bool ok = decoded.at("event_id") == "evt-check-1" && decoded.at("source_type") == "endpoint" &&
+              decoded.at("classification").at("labels").size() == 2 &&
+              decoded.at("classification").at("labels").at(1) == "PAN" &&
+              decoded.at("volume").at("total_bytes") == volume.total_bytes;
+    if (text.empty()) {
+        ok = ok && !decoded.contains("file_path");
+    } else {
+        ok = ok && same_text(text, decoded.at("file_path").get<std::string>());
+    }
+    ok = ok && same_text(text, decoded.at("classification").at("labels").at(0).get<std::string>()) &&
+         same_text(text, decoded.at("volume").at("label").get<std::string>());
+
+    // Doubles are written in shortest round-trip form; non-finite ones as null
+    const nlohmann::json& written = decoded.at("classification").at("confidence");
+    ok = ok && (std::isfinite(confidence) ? written.get<double>() == confidence : written.is_null());
+    if (!ok) {
+        error = "decoded fields differ";
+    }
+    return ok;
+}
+
+std::string printable(const std::string& text) {
+    std::string out;
+    for (unsigned char c : text) {
+        if (c >= 0x20 && c < 0x7f) {
+            out.push_back(static_cast<char>(c));
+        } else {
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out.append(hex);
+        }
+    }
+    return out;
+}
+
+bool check_round_trip(const Options& options) {
+    const std::vector<std::string> cases = {
+        "",
+        kPath,
+        "C:\\Users\\a \"quoted\" name\\file.txt",
+        "tab\there, newline\nthere, cr\r, backspace\b, formfeed\f",
+        std::string("nul\0inside", 10),
+        "\x01\x02\x1f\x7f",
+        "\\\\server\\share\\\\double\\\\",
+        "Rapport financier \xC3\xA9t\xC3\xA9 2024.docx",
+        "\xE6\x8A\xA5\xE5\x91\x8A\xE4\xB9\xA6.pdf",
+        "emoji \xF0\x9F\x93\x81 folder",
+        "invalid \xFF byte",
+        "truncated \xE2\x82",
+        "overlong \xC0\xAF slash",
+        "surrogate \xED\xA0\x80 half",
+        "beyond \xF4\x90\x80\x80 range",
+        "trailing lead \xF0",
+        std::string(70000, 'x'),
+    };
+
+    size_t failures = 0;
+    std::string error;
+    for (const auto& text : cases) {
+        for (double confidence : {0.93, 0.1 + 0.2, 1e-300, 0.0, std::nan(""), HUGE_VAL}) {
+            if (!round_trips(text, confidence, error)) {
+                if (failures++ < 10) {
+                    std::printf("  FAILED (%s): \"%s\" confidence %g\n", error.c_str(),
+                                printable(text.substr(0, 80)).c_str(), confidence);
+                }
+            }
+        }
+    }
+
+    // Random strings weighted towards what needs escaping or replacing
+    std::mt19937 random(2024);
+    std::uniform_int_distribution<int> length(0, 40);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const char* fragments[] = {"\"", "\\", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x93\x81", "\xE2\x82", "\x80"};
+    for (int i = 0; i < options.fuzz; ++i) {
+        std::string text;
+        for (int n = length(random); n > 0; --n) {
+            int k = kind(random);
+            if (k < 4) {
+                text.push_back(static_cast<char>('a' + byte(random) % 26));
+            } else if (k < 6) {
+                text.push_back(static_cast<char>(byte(random) % 0x20));
+            } else if (k < 9) {
+                text.append(fragments[byte(random) % 7]);
+            } else {
+                text.push_back(static_cast<char>(byte(random)));
+            }
+        }
+        if (!round_trips(text, 0.5, error)) {
+            if (failures++ < 10) {
+                std::printf("  FAILED (%s): \"%s\"\n", error.c_str(), printable(text).c_str());
+            }
+        }
+    }
+
+    std::printf("round trip: %zu fixed cases x 6 confidences, %d random strings, %zu failures\n",
+                cases.size(), options.fuzz, failures);
+    return failures == 0;
+}
+
+// Reports events from several threads into a paused reporter's spool and
+// checks every event id is distinct; also counts how many the millisecond
+// ids used before would have repeated
+bool check_event_ids(const Options& options) {
+    fs::path directory = fs::temp_directory_path() /
+                         ("json_bench_" + std::to_string(Clock::now().time_since_epoch().count()));
+    EventSpool spool(directory.string(), 256ull * 1024 * 1024);
+    if (!spool.open()) {
+        return false;
+    }
+
+    HttpClient client("http://127.0.0.1:9");
+    EventReporter reporter(client, kAgentId, &spool);
+    reporter.pause_delivery();
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < options.ids_per_thread; ++i) {
+                reporter.report("file_created", "low", kPath);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::set<std::string> ids;
+    std::set<std::string> millisecond_ids;
+    size_t events = 0;
+    SpoolRecord record;
+    while (spool.peek(record)) {
+        std::string id = nlohmann::json::parse(record.payload).at("event_id").get<std::string>();
+        ids.insert(id);
+        millisecond_ids.insert(id.substr(0, id.rfind('-')));
+        ++events;
+        spool.pop();
+    }
+    spool.close();
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+
+    size_t expected = size_t(options.threads) * options.ids_per_thread;
+    std::printf("event ids: %zu events from %d threads, %zu distinct (%zu with millisecond ids)\n",
+                events, options.threads, ids.size(), millisecond_ids.size());
+    return events == expected && ids.size() == expected;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--events N] [--fuzz N] [--threads N] [--ids N]\n", argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::WARNING);
+
+    bench_encoding(options);
+    bool ok = check_round_trip(options);
+    ok = check_event_ids(options) && ok;
+
+    std::printf("\n%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
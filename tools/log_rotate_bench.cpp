@@ -0,0 +1,245 @@
+// Log rotation check: several threads log numbered messages while the file
+// rotates every few hundred KB and the archiver gzips the segments.
+//
+//   log_rotate_bench
+//   log_rotate_bench --threads 8 --messages 50000 --max-kb 128 --files 3
+//
+// Two runs:
+//   no loss  retention large enough to keep every segment, producers paced
+//            to keep at most half the ring in flight; nothing may be dropped
+//            and every message must appear exactly once across the
+//            compressed segments and the live file
+//   bounded  retention of --files segments; the log directory is sampled
+//            during the run and may never exceed the live file (limit plus
+//            one batch), --files segments kept, --files waiting for the
+//            archiver, the one being compressed and its partial .gz, each
+//            counted at the full limit
+
+#include "logger.h"
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+const size_t kRingCapacity = 8192;
+
+struct Options {
+    int threads = 4;
+    int messages = 30000;  // per thread
+    int max_kb = 256;
+    int files = 3;
+    std::string directory = "/tmp/log_rotate_bench";
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--threads") {
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--messages") {
+            options.messages = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--max-kb") {
+            options.max_kb = std::max(16, std::atoi(value.c_str()));
+        } else if (arg == "--files") {
+            options.files = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--dir") {
+            options.directory = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+uint64_t directory_bytes(const std::string& directory) {
+    uint64_t total = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        std::error_code size_ec;
+        uint64_t size = it->file_size(size_ec);
+        if (!size_ec) {
+            total += size;
+        }
+    }
+    return total;
+}
+
+// "msg <thread> <sequence> ..." lines from a plain or gzipped file
+void collect(const std::string& path, std::vector<std::vector<uint8_t>>& seen, uint64_t& duplicates) {
+    gzFile file = gzopen(path.c_str(), "rb");  // reads plain files as they are
+    if (!file) {
+        return;
+    }
+    char line[1024];
+    while (gzgets(file, line, sizeof(line))) {
+        const char* message = std::strstr(line, "] msg ");
+        int thread = 0, sequence = 0;
+        if (!message || std::sscanf(message, "] msg %d %d", &thread, &sequence) != 2) {
+            continue;
+        }
+        if (thread < 0 || thread >= static_cast<int>(seen.size()) || sequence < 0 ||
+            sequence >= static_cast<int>(seen[thread].size())) {
+            continue;
+        }
+        if (seen[thread][sequence]++) {
+            ++duplicates;
+        }
+    }
+    gzclose(file);
+}
+
+struct RunResult {
+    Logger::Stats stats;
+    uint64_t max_directory_bytes = 0;
+    double seconds = 0.0;
+};
+
+// With paced set, a producer waits while more than half the ring is
+// queued, well short of the last eighth where INFO is dropped
+RunResult run(const Options& options, const std::string& directory, int max_files, bool paced) {
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    fs::create_directories(directory, ec);
+
+    Logger::init(directory + "/agent.log", kRingCapacity);
+    Logger::set_console_output(false);
+    Logger::set_level(Logger::Level::INFO);
+
+    Logger::RotationPolicy policy;
+    policy.max_file_bytes = static_cast<uint64_t>(options.max_kb) * 1024;
+    policy.max_files = max_files;
+    policy.compress = true;
+    Logger::set_rotation(policy);
+
+    Logger::Stats before = Logger::stats();
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> logged{0};
+    RunResult result;
+
+    std::thread sampler([&]() {
+        while (!done) {
+            result.max_directory_bytes = std::max(result.max_directory_bytes, directory_bytes(directory));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    });
+
+    auto start = Clock::now();
+    std::vector<std::thread> producers;
+    for (int t = 0; t < options.threads; ++t) {
+        producers.emplace_back([&, t]() {
+            for (int i = 0; i < options.messages; ++i) {
+                // Checked every 64 messages; the overshoot stays far below
+                // the drop threshold
+                while (paced && i % 64 == 0 &&
+                       logged - (Logger::stats().written - before.written) > kRingCapacity / 2) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+                ++logged;
+                CS_LOG_INFO("msg {} {}", t, i, kv("path", "C:\\Users\\alice\\Documents\\report_final.docx"),
+                            kv("type", "modified"));
+                // Bursts with short pauses, so the ring drops only now and then
+                if (i % 512 == 511) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    Logger::shutdown();  // writes the rest and finishes compression
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done = true;
+    sampler.join();
+    result.max_directory_bytes = std::max(result.max_directory_bytes, directory_bytes(directory));
+
+    Logger::Stats after = Logger::stats();
+    result.stats.written = after.written - before.written;
+    result.stats.dropped = after.dropped - before.dropped;
+    result.stats.rotations = after.rotations - before.rotations;
+    result.stats.archived = after.archived - before.archived;
+    result.stats.removed = after.removed - before.removed;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--threads N] [--messages N] [--max-kb N] [--files N] [--dir DIR]\n", argv[0]);
+        return 1;
+    }
+
+    uint64_t total = uint64_t(options.threads) * options.messages;
+    std::printf("%d threads x %d messages, rotate at %d KB\n\n", options.threads, options.messages, options.max_kb);
+
+    // No loss: keep every segment and account for every message
+    std::string lossless_directory = options.directory + "/no_loss";
+    RunResult lossless = run(options, lossless_directory, 1000000, true);
+
+    std::vector<std::vector<uint8_t>> seen(options.threads, std::vector<uint8_t>(options.messages, 0));
+    uint64_t duplicates = 0;
+    size_t segments = 0;
+    std::error_code ec;
+    for (fs::directory_iterator it(lossless_directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        collect(it->path().string(), seen, duplicates);
+        segments += it->path().extension() == ".gz";
+    }
+    uint64_t found = 0;
+    for (const auto& thread : seen) {
+        for (uint8_t count : thread) {
+            found += count ? 1 : 0;
+        }
+    }
+    bool lossless_ok = duplicates == 0 && lossless.stats.dropped == 0 && found == total &&
+                       segments == lossless.stats.archived && lossless.stats.archived == lossless.stats.rotations;
+
+    std::printf("no loss  %.2f s, %llu rotations, %zu .gz segments, %llu logged, %llu dropped, "
+                "%llu found, %llu duplicates: %s\n",
+                lossless.seconds, static_cast<unsigned long long>(lossless.stats.rotations), segments,
+                static_cast<unsigned long long>(total), static_cast<unsigned long long>(lossless.stats.dropped),
+                static_cast<unsigned long long>(found), static_cast<unsigned long long>(duplicates),
+                lossless_ok ? "ok" : "MISMATCH");
+
+    // Bounded: retention keeps the directory small however much is logged
+    std::string bounded_directory = options.directory + "/bounded";
+    RunResult bounded = run(options, bounded_directory, options.files, false);
+
+    uint64_t limit = static_cast<uint64_t>(options.max_kb) * 1024;
+    uint64_t bound = limit + 64 * 1024 + uint64_t(2 * options.files + 2) * limit;
+    size_t remaining = 0;
+    for (fs::directory_iterator it(bounded_directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        remaining += it->path().extension() == ".gz";
+    }
+    bool bounded_ok = bounded.max_directory_bytes <= bound && remaining <= static_cast<size_t>(options.files);
+
+    std::printf("bounded  %.2f s, %llu rotations, %llu compressed, %llu deleted, %zu segments left; "
+                "directory peak %llu KB (bound %llu KB, uncompressed total %llu KB): %s\n",
+                bounded.seconds, static_cast<unsigned long long>(bounded.stats.rotations),
+                static_cast<unsigned long long>(bounded.stats.archived),
+                static_cast<unsigned long long>(bounded.stats.removed), remaining,
+                static_cast<unsigned long long>(bounded.max_directory_bytes / 1024),
+                static_cast<unsigned long long>(bound / 1024),
+                static_cast<unsigned long long>((bounded.stats.rotations + 1) * limit / 1024),
+                bounded_ok ? "ok" : "EXCEEDED");
+
+    return lossless_ok && bounded_ok ? 0 : 1;
+}
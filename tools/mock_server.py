@@ -0,0 +1,365 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the CyberSentinel DLP server.
+
+Serves the three endpoints the agent uses, under any URL prefix (so
+"server_url": "http://127.0.0.1:8000/api/v1" works unchanged):
+
+    POST /agents                     registration
+    PUT  /agents/{id}/heartbeat      heartbeat
+    POST /events                     event ingestion
+
+Latency, error rate and a throughput cap can be injected to exercise the
+agent's retry, circuit breaker and spool paths. A "delay_ms" query parameter
+delays that one request, e.g. POST /events?delay_ms=2000; a "/delay_ms/N/"
+segment in the URL prefix delays every request under it, so a client whose
+server URL ends in /delay_ms/2000 sees a slow server. A "status" parameter
+answers the request with that error status, e.g. POST /events?status=503 (a
+server failing on demand), and a "/status/N/" prefix segment answers every
+request under it so. GET /events?agent_id=X lists the ids of that agent's
+accepted events in arrival order. GET /stats returns request
+counters as JSON, including the number of TCP connections accepted, which
+shows whether the client reuses them. Request bodies are decoded as JSON or,
+with a CBOR content type, as CBOR; malformed ones get 400 and are counted
+under "<route>.malformed". Uses only the standard library and
+binds to loopback.
+
+Usage:
+    python tools/mock_server.py --port 8000 --latency-ms 20 --jitter-ms 10 \
+        --error-rate 0.05 --max-rps 500 --accept-cbor
+"""
+
+import argparse
+import collections
+import json
+import random
+import re
+import struct
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlsplit
+
+HEARTBEAT_RE = re.compile(r"/agents/([^/]+)/heartbeat$")
+DELAY_PREFIX_RE = re.compile(r"/delay_ms/([0-9.]+)/")
+STATUS_PREFIX_RE = re.compile(r"/status/([0-9]+)/")
+
+
+class CborError(ValueError):
+    pass
+
+
+def decode_cbor(data):
+    """Decodes one CBOR (RFC 8949) data item that must span all of data."""
+    value, end = _cbor_item(data, 0)
+    if end != len(data):
+        raise CborError("trailing bytes")
+    return value
+
+
+_BREAK = object()
+
+
+def _cbor_item(data, pos):
+    if pos >= len(data):
+        raise CborError("truncated")
+    initial = data[pos]
+    major, info = initial >> 5, initial & 0x1F
+    pos += 1
+
+    if initial == 0xFF:
+        return _BREAK, pos
+    if major == 7:
+        if info == 20:
+            return False, pos
+        if info == 21:
+            return True, pos
+        if info in (22, 23):
+            return None, pos
+        sizes = {25: ("!e", 2), 26: ("!f", 4), 27: ("!d", 8)}
+        if info not in sizes:
+            raise CborError("unsupported simple value %d" % info)
+        fmt, size = sizes[info]
+        if pos + size > len(data):
+            raise CborError("truncated float")
+        return struct.unpack(fmt, data[pos:pos + size])[0], pos + size
+
+    if info == 31:
+        if major not in (2, 3, 4, 5):
+            raise CborError("indefinite length on major type %d" % major)
+        return _cbor_indefinite(data, pos, major)
+    if info < 24:
+        argument = info
+    elif info <= 27:
+        size = 1 << (info - 24)
+        if pos + size > len(data):
+            raise CborError("truncated head")
+        argument = int.from_bytes(data[pos:pos + size], "big")
+        pos += size
+    else:
+        raise CborError("reserved additional info %d" % info)
+
+    if major == 0:
+        return argument, pos
+    if major == 1:
+        return -1 - argument, pos
+    if major in (2, 3):
+        if pos + argument > len(data):
+            raise CborError("truncated string")
+        raw = data[pos:pos + argument]
+        return (raw if major == 2 else raw.decode("utf-8")), pos + argument
+    if major == 4:
+        items = []
+        for _ in range(argument):
+            item, pos = _cbor_item(data, pos)
+            items.append(item)
+        return items, pos
+    if major == 5:
+        result = {}
+        for _ in range(argument):
+            key, pos = _cbor_item(data, pos)
+            result[key], pos = _cbor_item(data, pos)
+        return result, pos
+    # Tags: the tagged item stands for itself here
+    return _cbor_item(data, pos)
+
+
+def _cbor_indefinite(data, pos, major):
+    items = []
+    while True:
+        item, pos = _cbor_item(data, pos)
+        if item is _BREAK:
+            break
+        items.append(item)
+    if major == 2:
+        return b"".join(items), pos
+    if major == 3:
+        return "".join(items), pos
+    if major == 4:
+        return items, pos
+    if len(items) % 2:
+        raise CborError("map with a key but no value")
+    return dict(zip(items[0::2], items[1::2])), pos
+
+
+class TokenBucket:
+    """Admits up to `rate` requests per second with a one-second burst."""
+
+    def __init__(self, rate):
+        self.rate = rate
+        self.tokens = rate
+        self.last = time.monotonic()
+        self.lock = threading.Lock()
+
+    def take(self):
+        if self.rate <= 0:
+            return True
+        with self.lock:
+            now = time.monotonic()
+            self.tokens = min(self.rate, self.tokens + (now - self.last) * self.rate)
+            self.last = now
+            if self.tokens >= 1:
+                self.tokens -= 1
+                return True
+            return False
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.counters = {}
+        self.event_ids = collections.deque(maxlen=100000)
+
+    def incr(self, name):
+        with self.lock:
+            self.counters[name] = self.counters.get(name, 0) + 1
+
+    def record_event(self, event_id):
+        with self.lock:
+            self.event_ids.append(event_id)
+
+    def recent_events(self, agent_id):
+        prefix = "evt-" + agent_id + "-"
+        with self.lock:
+            return [event_id for event_id in self.event_ids if event_id.startswith(prefix)]
+
+    def snapshot(self):
+        with self.lock:
+            return dict(self.counters)
+
+
+class MockServerHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    # Send headers and body in one write; avoids Nagle/delayed-ACK stalls
+    wbufsize = 64 * 1024
+
+    def setup(self):
+        super().setup()
+        self.server.stats.incr("connections")
+
+    def log_message(self, fmt, *args):
+        if self.server.options.verbose:
+            super().log_message(fmt, *args)
+
+    def _respond(self, status, body=None):
+        payload = json.dumps(body if body is not None else {}).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(payload)))
+        self.end_headers()
+        self.wfile.write(payload)
+        self.wfile.flush()
+
+    def _route_path(self):
+        return urlsplit(self.path).path
+
+    def _request_delay_ms(self):
+        values = parse_qs(urlsplit(self.path).query).get("delay_ms")
+        match = DELAY_PREFIX_RE.search(self._route_path())
+        try:
+            if values:
+                return float(values[0])
+            return float(match.group(1)) if match else 0.0
+        except ValueError:
+            return 0.0
+
+    def _request_status(self):
+        values = parse_qs(urlsplit(self.path).query).get("status")
+        match = STATUS_PREFIX_RE.search(self._route_path())
+        try:
+            if values:
+                return int(values[0])
+            return int(match.group(1)) if match else None
+        except ValueError:
+            return None
+
+    def _read_body(self):
+        length = int(self.headers.get("Content-Length") or 0)
+        return self.rfile.read(length) if length else b""
+
+    def _inject_faults(self, route):
+        """Returns an error status to send, or None to serve normally."""
+        options = self.server.options
+        if not self.server.bucket.take():
+            self.server.stats.incr(route + ".throttled")
+            return 429
+
+        delay = options.latency_ms + random.uniform(0, options.jitter_ms) + self._request_delay_ms()
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+        status = self._request_status()
+        if status is None and random.random() < options.error_rate:
+            status = 503
+        if status is not None:
+            self.server.stats.incr(route + ".errors")
+        return status
+
+    def do_GET(self):
+        path = self._route_path()
+        if path.endswith("/stats"):
+            self._respond(200, self.server.stats.snapshot())
+        elif path.endswith("/events"):
+            agent_id = parse_qs(urlsplit(self.path).query).get("agent_id", [""])[0]
+            self._respond(200, {"event_ids": self.server.stats.recent_events(agent_id)})
+        else:
+            self._respond(404, {"detail": "not found"})
+
+    def do_POST(self):
+        body = self._read_body()
+
+        path = self._route_path()
+        if path.endswith("/agents"):
+            route = "register"
+        elif path.endswith("/events"):
+            route = "events"
+        else:
+            self._respond(404, {"detail": "not found"})
+            return
+
+        self.server.stats.incr(route)
+        self.server.stats.incr(route + ".bytes." + self._encoding())
+
+        document = self._decode(body)
+        if not isinstance(document, dict):
+            self.server.stats.incr(route + ".malformed")
+            self._respond(400, {"detail": "malformed body"})
+            return
+
+        error = self._inject_faults(route)
+        if error:
+            self._respond(error, {"detail": "injected failure"})
+            return
+
+        if route == "register":
+            response = {"status": "registered"}
+            if self.server.options.accept_cbor and "cbor" in document.get("supported_encodings", []):
+                response["encoding"] = "cbor"
+            self._respond(201, response)
+        else:
+            self.server.stats.incr("events.accepted")
+            self.server.stats.record_event(str(document.get("event_id", "")))
+            self._respond(201, {"status": "accepted"})
+
+    def do_PUT(self):
+        body = self._read_body()
+
+        if not HEARTBEAT_RE.search(self._route_path()):
+            self._respond(404, {"detail": "not found"})
+            return
+
+        self.server.stats.incr("heartbeat")
+        if not isinstance(self._decode(body), dict):
+            self.server.stats.incr("heartbeat.malformed")
+            self._respond(400, {"detail": "malformed body"})
+            return
+
+        error = self._inject_faults("heartbeat")
+        if error:
+            self._respond(error, {"detail": "injected failure"})
+            return
+        self._respond(200, {"status": "ok"})
+
+    def _encoding(self):
+        content_type = self.headers.get("Content-Type", "")
+        return "cbor" if "cbor" in content_type else "json"
+
+    def _decode(self, body):
+        """The decoded body, or None if it is malformed."""
+        try:
+            if self._encoding() == "cbor":
+                return decode_cbor(body)
+            return json.loads(body.decode("utf-8")) if body else {}
+        except (ValueError, UnicodeDecodeError):
+            return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local CyberSentinel DLP server stand-in")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="base response latency")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="extra random latency")
+    parser.add_argument("--error-rate", type=float, default=0.0, help="fraction answered with 503")
+    parser.add_argument("--max-rps", type=float, default=0.0, help="throughput cap, 429 beyond (0 = off)")
+    parser.add_argument("--accept-cbor", action="store_true", help="negotiate CBOR at registration")
+    parser.add_argument("--verbose", action="store_true")
+    options = parser.parse_args()
+
+    server = ThreadingHTTPServer((options.host, options.port), MockServerHandler)
+    server.daemon_threads = True
+    server.options = options
+    server.stats = Stats()
+    server.bucket = TokenBucket(options.max_rps)
+
+    print(f"Mock DLP server listening on http://{options.host}:{options.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        print(json.dumps(server.stats.snapshot(), indent=2, sort_keys=True))
+
+
+if __name__ == "__main__":
+    main()
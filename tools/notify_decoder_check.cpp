@@ -0,0 +1,458 @@
+// Checks for the ReadDirectoryChangesW buffer decoder. Runs on any platform;
+// buffers are built in the FILE_NOTIFY_INFORMATION layout, well-formed and
+// damaged, and fed to the same code the Windows backend uses:
+//
+//   notify_decoder_check
+//   notify_decoder_check --fuzz 1000000
+//
+//   well-formed   single and chained records, non-ASCII and surrogate names
+//   overflow      a 0-byte completion reports lost events and no records
+//   truncated     every cut of a chained buffer delivers exactly the
+//                 records that fit whole, then reports it malformed
+//   offsets       NextEntryOffset into its own record, past the buffer,
+//                 unaligned or near UINT32_MAX
+//   lengths       odd, past the buffer and near UINT32_MAX FileNameLength
+//   empty names   decoded, but not turned into events
+//   builder       directories joined to the root and interned once,
+//                 unknown actions skipped
+//   buffers       NotifyBuffers alternates, aligns and clamps lengths
+//   fuzz          random damage never reads outside the buffer or
+//                 delivers a name that is not inside it
+//
+// Exits non-zero if any check fails.
+
+#include "notify_decoder.h"
+#include "path_pool.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cybersentinel;
+
+namespace {
+
+struct Options {
+    int fuzz = 200000;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--fuzz") {
+            options.fuzz = std::max(0, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+struct Record {
+    uint32_t action;
+    std::u16string name;
+};
+
+struct Decoded {
+    NotifyDecodeStatus status;
+    std::vector<Record> records;
+};
+
+void put_u32(std::vector<uint8_t>& buffer, size_t offset, uint32_t value) {
+    std::memcpy(buffer.data() + offset, &value, sizeof(value));
+}
+
+// Records chained the way the kernel writes them, each DWORD-aligned; the
+// last has NextEntryOffset 0. offsets receives where each record starts.
+std::vector<uint8_t> encode(const std::vector<Record>& records, std::vector<size_t>* offsets = nullptr) {
+    std::vector<uint8_t> buffer;
+    size_t previous = 0;
+    for (size_t i = 0; i < records.size(); ++i) {
+        size_t offset = buffer.size();
+        if (i > 0) {
+            put_u32(buffer, previous, static_cast<uint32_t>(offset - previous));
+        }
+        if (offsets) {
+            offsets->push_back(offset);
+        }
+
+        uint32_t name_bytes = static_cast<uint32_t>(records[i].name.size() * sizeof(char16_t));
+        buffer.resize(offset + kNotifyHeaderSize + name_bytes);
+        put_u32(buffer, offset, 0);
+        put_u32(buffer, offset + 4, records[i].action);
+        put_u32(buffer, offset + 8, name_bytes);
+        std::memcpy(buffer.data() + offset + kNotifyHeaderSize, records[i].name.data(), name_bytes);
+        buffer.resize((buffer.size() + 3) & ~size_t(3));
+        previous = offset;
+    }
+    return buffer;
+}
+
+// Decodes a copy in 4-byte aligned storage of exactly length bytes, so a
+// read past the end is caught by sanitizers and names can be bounds-checked
+Decoded decode(const std::vector<uint8_t>& buffer, size_t length, bool* names_inside = nullptr) {
+    std::vector<uint32_t> storage((length + 3) / 4);
+    auto* data = reinterpret_cast<uint8_t*>(storage.data());
+    if (length > 0) {
+        std::memcpy(data, buffer.data(), std::min(length, buffer.size()));
+    }
+
+    Decoded decoded;
+    bool inside = true;
+    decoded.status = decode_notifications(data, length, [&](uint32_t action, std::u16string_view name) {
+        auto* begin = reinterpret_cast<const uint8_t*>(name.data());
+        inside = inside && begin >= data && begin + name.size() * sizeof(char16_t) <= data + length;
+        decoded.records.push_back(Record{action, std::u16string(name)});
+    });
+    if (names_inside) {
+        *names_inside = inside;
+    }
+    return decoded;
+}
+
+const char* status_name(NotifyDecodeStatus status) {
+    switch (status) {
+        case NotifyDecodeStatus::OK:          return "ok";
+        case NotifyDecodeStatus::EVENTS_LOST: return "events lost";
+        case NotifyDecodeStatus::MALFORMED:   return "malformed";
+        default:                              return "?";
+    }
+}
+
+bool same_records(const std::vector<Record>& a, const std::vector<Record>& b, size_t count) {
+    if (a.size() != count || b.size() < count) {
+        return false;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        if (a[i].action != b[i].action || a[i].name != b[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class Checker {
+public:
+    void expect(bool ok, const std::string& what) {
+        ++checks_;
+        if (!ok && failures_++ < 20) {
+            std::printf("  FAILED %s\n", what.c_str());
+        }
+    }
+
+    // Decodes buffer[0, length) and expects status and the first `count` of
+    // `records`
+    void expect_decode(const std::string& what, const std::vector<uint8_t>& buffer, size_t length,
+                       NotifyDecodeStatus status, const std::vector<Record>& records, size_t count) {
+        Decoded decoded = decode(buffer, length);
+        expect(decoded.status == status && same_records(decoded.records, records, count),
+               what + ": " + status_name(decoded.status) + " with " + std::to_string(decoded.records.size()) +
+                   " records, expected " + status_name(status) + " with " + std::to_string(count));
+    }
+
+    bool report(const char* name) {
+        std::printf("  %-12s %6zu checks, %zu failed\n", name, checks_ - reported_checks_,
+                    failures_ - reported_failures_);
+        bool ok = failures_ == reported_failures_;
+        reported_checks_ = checks_;
+        reported_failures_ = failures_;
+        return ok;
+    }
+
+    bool ok() const { return failures_ == 0; }
+
+private:
+    size_t checks_ = 0;
+    size_t failures_ = 0;
+    size_t reported_checks_ = 0;
+    size_t reported_failures_ = 0;
+};
+
+const std::vector<Record> kRecords = {
+    {kNotifyActionAdded, u"report.docx"},
+    {kNotifyActionModified, u"Finance\\Q3\\\u043e\u0442\u0447\u0451\u0442.xlsx"},
+    {kNotifyActionRenamedOldName, u"Photos\\trip_\U0001F600.jpg"},
+    {kNotifyActionRenamedNewName, u"a"},
+    {kNotifyActionRemoved, u"\u8cc7\u6599\\\u5831\u544a.txt"},
+};
+
+void check_well_formed(Checker& checker) {
+    for (size_t count = 1; count <= kRecords.size(); ++count) {
+        std::vector<Record> records(kRecords.begin(), kRecords.begin() + count);
+        std::vector<uint8_t> buffer = encode(records);
+        checker.expect_decode(std::to_string(count) + " records", buffer, buffer.size(), NotifyDecodeStatus::OK,
+                              records, count);
+    }
+
+    // The kernel reports how many bytes it wrote; slack after the last
+    // record is ignored
+    std::vector<uint8_t> buffer = encode(kRecords);
+    size_t written = buffer.size();
+    buffer.resize(written + 64, 0xAB);
+    checker.expect_decode("slack after the last record", buffer, buffer.size(), NotifyDecodeStatus::OK, kRecords,
+                          kRecords.size());
+    checker.expect_decode("exact length", buffer, written, NotifyDecodeStatus::OK, kRecords, kRecords.size());
+}
+
+void check_overflow(Checker& checker) {
+    std::vector<uint8_t> buffer = encode(kRecords);
+    checker.expect_decode("0-byte completion", buffer, 0, NotifyDecodeStatus::EVENTS_LOST, kRecords, 0);
+    // The backend passes the armed buffer with length 0; its old contents
+    // must not be decoded
+    checker.expect(decode_notifications(buffer.data(), 0, [](uint32_t, std::u16string_view) {}) ==
+                       NotifyDecodeStatus::EVENTS_LOST,
+                   "0-byte completion over a full buffer");
+}
+
+void check_truncated(Checker& checker) {
+    std::vector<size_t> offsets;
+    std::vector<uint8_t> buffer = encode(kRecords, &offsets);
+
+    for (size_t length = 1; length < buffer.size(); ++length) {
+        // A record is delivered when its header and name fit in the bytes
+        // the kernel reported
+        size_t whole = 0;
+        while (whole < kRecords.size() &&
+               offsets[whole] + kNotifyHeaderSize + kRecords[whole].name.size() * sizeof(char16_t) <= length) {
+            ++whole;
+        }
+        // Only a cut after the last record's name (in its padding) decodes
+        // cleanly, since that record ends the chain
+        NotifyDecodeStatus status =
+            whole == kRecords.size() ? NotifyDecodeStatus::OK : NotifyDecodeStatus::MALFORMED;
+        checker.expect_decode("cut at " + std::to_string(length) + " of " + std::to_string(buffer.size()), buffer,
+                              length, status, kRecords, whole);
+    }
+}
+
+void check_offsets(Checker& checker) {
+    std::vector<size_t> offsets;
+    const std::vector<uint8_t> good = encode(kRecords, &offsets);
+    uint32_t first_next = static_cast<uint32_t>(offsets[1]);
+    uint32_t first_size = static_cast<uint32_t>(kNotifyHeaderSize + kRecords[0].name.size() * sizeof(char16_t));
+
+    struct Case {
+        const char* what;
+        uint32_t next_entry;
+        size_t delivered;
+    };
+    const Case cases[] = {
+        {"NextEntryOffset into the header", 4, 0},
+        {"NextEntryOffset into the name", first_size - 2, 0},
+        {"NextEntryOffset unaligned", first_next + 2, 1},
+        {"NextEntryOffset to the buffer end", static_cast<uint32_t>(good.size()), 1},
+        {"NextEntryOffset past the buffer", static_cast<uint32_t>(good.size() + 4), 1},
+        {"NextEntryOffset 0xFFFFFFFC", 0xFFFFFFFCu, 1},
+        {"NextEntryOffset 0xFFFFFFFF", 0xFFFFFFFFu, 1},
+    };
+    for (const auto& c : cases) {
+        std::vector<uint8_t> buffer = good;
+        put_u32(buffer, 0, c.next_entry);
+        checker.expect_decode(c.what, buffer, buffer.size(), NotifyDecodeStatus::MALFORMED, kRecords, c.delivered);
+    }
+
+    // 0 ends the chain even when more records follow
+    std::vector<uint8_t> early = good;
+    put_u32(early, 0, 0);
+    checker.expect_decode("NextEntryOffset 0 on the first record", early, early.size(), NotifyDecodeStatus::OK,
+                          kRecords, 1);
+}
+
+void check_lengths(Checker& checker) {
+    std::vector<size_t> offsets;
+    const std::vector<uint8_t> good = encode(kRecords, &offsets);
+    size_t second = offsets[1];
+
+    struct Case {
+        const char* what;
+        size_t record;
+        uint32_t name_bytes;
+    };
+    const Case cases[] = {
+        {"odd FileNameLength", 0, 3},
+        {"FileNameLength past the buffer", 0, static_cast<uint32_t>(good.size())},
+        {"FileNameLength 0xFFFFFFFE", 0, 0xFFFFFFFEu},
+        {"FileNameLength past the next record", 0, static_cast<uint32_t>(second)},
+        {"odd FileNameLength in the second record", 1, 5},
+        {"FileNameLength 0xFFFFFFFE in the second record", 1, 0xFFFFFFFEu},
+    };
+    for (const auto& c : cases) {
+        std::vector<uint8_t> buffer = good;
+        put_u32(buffer, offsets[c.record] + 8, c.name_bytes);
+        checker.expect_decode(c.what, buffer, buffer.size(), NotifyDecodeStatus::MALFORMED, kRecords, c.record);
+    }
+
+    // A header alone, without room for any name, is still a record
+    std::vector<uint8_t> header(kNotifyHeaderSize, 0);
+    put_u32(header, 4, kNotifyActionAdded);
+    checker.expect_decode("header only", header, header.size(), NotifyDecodeStatus::OK, {{kNotifyActionAdded, u""}},
+                          1);
+    put_u32(header, 8, 2);
+    checker.expect_decode("header only, name past the end", header, header.size(), NotifyDecodeStatus::MALFORMED,
+                          {}, 0);
+}
+
+void check_empty_names(Checker& checker) {
+    const std::vector<Record> records = {
+        {kNotifyActionAdded, u""},
+        {kNotifyActionModified, u"kept.txt"},
+        {kNotifyActionRemoved, u"dir\\"},
+    };
+    std::vector<uint8_t> buffer = encode(records);
+    checker.expect_decode("zero-length names", buffer, buffer.size(), NotifyDecodeStatus::OK, records,
+                          records.size());
+
+    // Nothing to report without a file name; the record after it still is
+    PathPool paths;
+    NotifyEventBuilder builder(paths);
+    uint32_t root = paths.intern("C:\\Users\\check");
+    WatchEvent event;
+    checker.expect(!builder.build(root, kNotifyActionAdded, u"", event), "event for an empty name");
+    checker.expect(!builder.build(root, kNotifyActionRemoved, u"dir\\", event), "event for a name ending in \\");
+    checker.expect(builder.build(root, kNotifyActionModified, u"kept.txt", event) && event.name == "kept.txt" &&
+                       event.directory == root,
+                   "event after an empty name");
+}
+
+void check_builder(Checker& checker) {
+    PathPool paths;
+    NotifyEventBuilder builder(paths);
+    uint32_t root = paths.intern("C:\\Users\\check");
+    std::string sep(1, kPathSeparator);
+
+    struct Case {
+        std::u16string name;
+        std::string directory;
+        std::string leaf;
+        FileAction action;
+        uint32_t notify_action;
+    };
+    const Case cases[] = {
+        {u"a.txt", "C:\\Users\\check", "a.txt", FileAction::CREATED, kNotifyActionAdded},
+        {u"Finance\\Q3\\plan.xlsx", "C:\\Users\\check" + sep + "Finance\\Q3", "plan.xlsx", FileAction::MODIFIED,
+         kNotifyActionModified},
+        {u"Finance\\Q3\\other.xlsx", "C:\\Users\\check" + sep + "Finance\\Q3", "other.xlsx", FileAction::DELETED,
+         kNotifyActionRemoved},
+        {u"\u8cc7\u6599\\\u5831\u544a.txt", "C:\\Users\\check" + sep + "\xE8\xB3\x87\xE6\x96\x99",
+         "\xE5\xA0\xB1\xE5\x91\x8A.txt", FileAction::MOVED, kNotifyActionRenamedNewName},
+        {u"x\\trip_\U0001F600.jpg", "C:\\Users\\check" + sep + "x", "trip_\xF0\x9F\x98\x80.jpg", FileAction::MOVED,
+         kNotifyActionRenamedOldName},
+        // An unpaired surrogate is replaced, not dropped
+        {std::u16string(u"bad_") + char16_t(0xD800) + u".txt", "C:\\Users\\check", "bad_\xEF\xBF\xBD.txt",
+         FileAction::CREATED, kNotifyActionAdded},
+    };
+    for (const auto& c : cases) {
+        WatchEvent event;
+        bool built = builder.build(root, c.notify_action, c.name, event);
+        std::string leaf(event.name);
+        checker.expect(built && paths.get(event.directory) == c.directory && leaf == c.leaf &&
+                           event.action == c.action,
+                       "build " + c.leaf + ": got " + std::string(paths.get(event.directory)) + " | " + leaf);
+    }
+
+    // Directories are interned once however often they are seen, also when
+    // alternating defeats the one-directory cache
+    size_t interned = paths.size();
+    WatchEvent event;
+    for (int i = 0; i < 100; ++i) {
+        builder.build(root, kNotifyActionModified, i % 2 ? u"Archive\\2024\\plan.xlsx" : u"Archive\\2025\\y.txt",
+                      event);
+    }
+    checker.expect(paths.size() == interned + 2, "directories interned once");
+
+    // A root with a trailing separator is not doubled
+    uint32_t drive = paths.intern("D:" + sep);
+    checker.expect(builder.build(drive, kNotifyActionAdded, u"dir\\f.txt", event) &&
+                       paths.get(event.directory) == "D:" + sep + "dir",
+                   "root with a trailing separator");
+
+    for (uint32_t action : {0u, 6u, 0xFFFFFFFFu}) {
+        checker.expect(!builder.build(root, action, u"a.txt", event), "unknown action " + std::to_string(action));
+    }
+}
+
+void check_buffers(Checker& checker) {
+    NotifyBuffers buffers(1001);
+    checker.expect(buffers.size() == 1004, "size rounded up to a DWORD multiple");
+    uint8_t* first = buffers.armed();
+    checker.expect(reinterpret_cast<uintptr_t>(first) % 4 == 0, "armed buffer DWORD-aligned");
+
+    NotifyBuffers::Chunk chunk = buffers.swap(100);
+    uint8_t* second = buffers.armed();
+    checker.expect(chunk.data == first && chunk.length == 100 && second != first, "swap hands out the filled buffer");
+    chunk = buffers.swap(5000);
+    checker.expect(chunk.data == second && chunk.length == buffers.size() && buffers.armed() == first,
+                   "swap clamps to the buffer size and alternates");
+    chunk = buffers.swap(0);
+    checker.expect(chunk.data == first && chunk.length == 0, "0-byte completion passed through");
+}
+
+void check_fuzz(Checker& checker, int iterations) {
+    std::mt19937 random(2024);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<uint8_t> good = encode(kRecords);
+
+    size_t outside = 0;
+    size_t malformed = 0;
+    for (int i = 0; i < iterations; ++i) {
+        std::vector<uint8_t> buffer = good;
+        // A few random bytes, biased towards the header fields
+        int damage = 1 + i % 4;
+        for (int d = 0; d < damage; ++d) {
+            size_t at = static_cast<size_t>(random() % buffer.size());
+            if (i % 3 == 0) {
+                at = (at & ~size_t(3)) + static_cast<size_t>(random() % 12);
+                at = std::min(at, buffer.size() - 1);
+            }
+            buffer[at] = static_cast<uint8_t>(byte(random));
+        }
+        size_t length = i % 5 == 0 ? static_cast<size_t>(random() % (buffer.size() + 1)) : buffer.size();
+
+        bool inside = true;
+        Decoded decoded = decode(buffer, length, &inside);
+        outside += inside ? 0 : 1;
+        malformed += decoded.status == NotifyDecodeStatus::MALFORMED;
+    }
+    checker.expect(outside == 0, std::to_string(outside) + " damaged buffers delivered names outside the buffer");
+    std::printf("  %d damaged buffers, %zu reported malformed\n", iterations, malformed);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--fuzz N]\n", argv[0]);
+        return 1;
+    }
+
+    Checker checker;
+    bool ok = true;
+    check_well_formed(checker);
+    ok = checker.report("well-formed") && ok;
+    check_overflow(checker);
+    ok = checker.report("overflow") && ok;
+    check_truncated(checker);
+    ok = checker.report("truncated") && ok;
+    check_offsets(checker);
+    ok = checker.report("offsets") && ok;
+    check_lengths(checker);
+    ok = checker.report("lengths") && ok;
+    check_empty_names(checker);
+    ok = checker.report("empty names") && ok;
+    check_builder(checker);
+    ok = checker.report("builder") && ok;
+    check_buffers(checker);
+    ok = checker.report("buffers") && ok;
+    check_fuzz(checker, options.fuzz);
+    ok = checker.report("fuzz") && ok;
+
+    std::printf("\n%s\n", ok && checker.ok() ? "OK" : "FAIL");
+    return ok && checker.ok() ? 0 : 1;
+}
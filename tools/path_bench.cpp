@@ -0,0 +1,339 @@
+// Notification path benchmark: UTF-16 to UTF-8 conversion throughput and
+// the cost per event of turning ReadDirectoryChangesW records into paths.
+// Runs on any platform; the records are synthesized in the
+// FILE_NOTIFY_INFORMATION layout and decoded with the same code the Windows
+// backend uses.
+//
+//   path_bench
+//   path_bench --events 200000 --dirs 50
+//
+// Conversion is measured for ASCII and non-ASCII names against a plain
+// unit-at-a-time encoder, and checked against it. Dispatch compares the old
+// narrowing loop plus string concatenation with NotifyEventBuilder and
+// PathPool; allocations are counted by replacing operator new. Churn
+// sends events from a new directory each time and fails if the pool grows
+// past its bound.
+
+#include "notify_decoder.h"
+#include "path_pool.h"
+#include "utf8.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+struct Options {
+    int events = 100000;
+    int dirs = 20;
+    int conversions = 2000000;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        int value = std::max(1, std::atoi(argv[i + 1]));
+
+        if (arg == "--events") {
+            options.events = value;
+        } else if (arg == "--dirs") {
+            options.dirs = value;
+        } else if (arg == "--conversions") {
+            options.conversions = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::u16string widen(const std::string& ascii) {
+    return std::u16string(ascii.begin(), ascii.end());
+}
+
+// Relative names as they appear in notifications under a watched profile
+// folder: plain ASCII, Cyrillic, CJK and a name with a surrogate pair
+std::u16string make_name(int kind, int dir, int i) {
+    std::u16string number = widen(std::to_string(i));
+    std::u16string folder = widen(std::to_string(dir));
+    switch (kind) {
+        case 0:
+            return u"Projects\\team" + folder + u"\\quarterly_report_" + number + u".docx";
+        case 1:
+            return u"\u0414\u043e\u043a\u0443\u043c\u0435\u043d\u0442\u044b" + folder +
+                   u"\\\u043e\u0442\u0447\u0451\u0442_" + number + u".docx";
+        case 2:
+            return u"\u8cc7\u6599" + folder + u"\\\u5831\u544a_" + number + u".xlsx";
+        default:
+            return u"Photos" + folder + u"\\trip_\U0001F600_" + number + u".jpg";
+    }
+}
+
+// Reference encoder: one unit at a time, no fast path
+void reference_utf8(std::u16string_view text, std::string& out) {
+    for (size_t i = 0; i < text.size(); ++i) {
+        uint32_t cp = text[i];
+        if (cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (text[++i] - 0xDC00);
+        } else if (cp >= 0xD800 && cp <= 0xDFFF) {
+            cp = 0xFFFD;
+        }
+
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+}
+
+// FILE_NOTIFY_INFORMATION records for the given names
+std::vector<uint32_t> make_buffer(const std::vector<std::u16string>& names) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i < names.size(); ++i) {
+        uint32_t name_bytes = static_cast<uint32_t>(names[i].size() * sizeof(char16_t));
+        uint32_t record = (kNotifyHeaderSize + name_bytes + 3) & ~3u;
+        uint32_t header[3] = {i + 1 < names.size() ? record : 0, kNotifyActionModified, name_bytes};
+
+        size_t offset = bytes.size();
+        bytes.resize(offset + record);
+        std::memcpy(&bytes[offset], header, sizeof(header));
+        std::memcpy(&bytes[offset + kNotifyHeaderSize], names[i].data(), name_bytes);
+    }
+
+    std::vector<uint32_t> aligned((bytes.size() + 3) / 4);
+    std::memcpy(aligned.data(), bytes.data(), bytes.size());
+    return aligned;
+}
+
+void bench_conversion(const char* label, const std::vector<std::u16string>& names, int conversions) {
+    size_t units = 0;
+    for (const auto& name : names) {
+        units += name.size();
+    }
+
+    // Correctness first
+    std::string fast, reference;
+    for (const auto& name : names) {
+        fast.clear();
+        reference.clear();
+        append_utf16_as_utf8(name, fast);
+        reference_utf8(name, reference);
+        if (fast != reference) {
+            std::printf("%-10s MISMATCH\n", label);
+            return;
+        }
+    }
+
+    int rounds = std::max(1, conversions / static_cast<int>(names.size()));
+    size_t checksum = 0;
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& name : names) {
+            fast.clear();
+            append_utf16_as_utf8(name, fast);
+            checksum += fast.size();
+        }
+    }
+    double fast_seconds = seconds_since(start);
+
+    start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const auto& name : names) {
+            reference.clear();
+            reference_utf8(name, reference);
+            checksum += reference.size();
+        }
+    }
+    double reference_seconds = seconds_since(start);
+
+    double input_mb = double(units) * sizeof(char16_t) * rounds / (1024.0 * 1024.0);
+    std::printf("%-10s %8.0f MB/s %8.0f MB/s %7.1fx   (%zu units, checksum %zu)\n",
+                label, input_mb / fast_seconds, input_mb / reference_seconds,
+                reference_seconds / fast_seconds, units, checksum % 1000);
+}
+
+// Per-record work of the previous Windows dispatch: narrowing copy into a
+// new string, concatenation with the root, and the callback's action string
+void old_dispatch(const std::string& root, const uint8_t* data, size_t length, size_t& checksum) {
+    decode_notifications(data, length, [&](uint32_t, std::u16string_view name) {
+        std::u16string wide(name);
+        std::string filename;
+        filename.reserve(wide.size());
+        for (char16_t unit : wide) {
+            filename.push_back(static_cast<char>(unit));
+        }
+        std::string full_path = root + '\\' + filename;
+        std::string action = "modified";
+        checksum += full_path.size() + action.size();
+    });
+}
+
+void new_dispatch(NotifyEventBuilder& builder, const PathPool& paths, uint32_t root,
+                  const uint8_t* data, size_t length, std::string& path, size_t& checksum) {
+    decode_notifications(data, length, [&](uint32_t action, std::u16string_view name) {
+        WatchEvent event;
+        if (builder.build(root, action, name, event)) {
+            paths.join(event.directory, event.name, path);
+            checksum += path.size();
+        }
+    });
+}
+
+// Events from a new directory each time (build output, temp folders) and
+// watches added and removed, as a long-running agent sees them. The pool
+// holds the pinned root plus at most PathPool::kMaxUnreferenced others
+// however many directories pass through it.
+bool bench_churn(const Options& options) {
+    PathPool paths;
+    NotifyEventBuilder builder(paths);
+    uint32_t root = paths.intern("C:\\Users\\benchmark\\Documents");
+    paths.acquire(root);
+    std::string path;
+    size_t checksum = 0;
+
+    const int kRounds = 4;
+    const size_t bound = 1 + PathPool::kMaxUnreferenced;
+    int per_round = std::max(1, options.events / kRounds);
+    bool flat = true;
+
+    std::printf("\nChurn (each event in a new directory, a watch added and removed every 16)\n");
+    std::printf("  %10s %12s %10s\n", "events", "directories", "bytes");
+    for (int round = 0; round < kRounds; ++round) {
+        for (int i = 0; i < per_round; ++i) {
+            int n = round * per_round + i;
+            std::vector<uint32_t> buffer = make_buffer({u"Build\\tmp" + widen(std::to_string(n)) + u"\\obj.o"});
+            new_dispatch(builder, paths, root, reinterpret_cast<const uint8_t*>(buffer.data()),
+                         buffer.size() * sizeof(uint32_t), path, checksum);
+            if (n % 16 == 0) {
+                uint32_t watched = paths.intern("C:\\Users\\benchmark\\Build\\tmp" + std::to_string(n));
+                paths.acquire(watched);
+                paths.release(watched);
+            }
+        }
+        flat = flat && paths.size() <= bound;
+        std::printf("  %10d %12zu %10zu\n", (round + 1) * per_round, paths.size(), paths.bytes());
+    }
+    std::printf("  bound %zu directories: %s (checksum %zu)\n", bound, flat ? "ok" : "EXCEEDED",
+                checksum % 1000);
+    return flat;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--events N] [--dirs N] [--conversions N]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("UTF-16 -> UTF-8      fast    reference  speedup\n");
+    const char* labels[] = {"ascii", "cyrillic", "cjk", "surrogate"};
+    for (int kind = 0; kind < 4; ++kind) {
+        std::vector<std::u16string> names;
+        for (int i = 0; i < 256; ++i) {
+            names.push_back(make_name(kind, i % options.dirs, i));
+        }
+        bench_conversion(labels[kind], names, options.conversions);
+    }
+
+    // One notification buffer per 64 events, like a busy 64 KB read; three
+    // in four names are ASCII
+    const int kPerBuffer = 64;
+    std::vector<std::vector<uint32_t>> buffers;
+    std::vector<size_t> lengths;
+    for (int base = 0; base < options.events; base += kPerBuffer) {
+        std::vector<std::u16string> names;
+        for (int i = base; i < std::min(base + kPerBuffer, options.events); ++i) {
+            names.push_back(make_name(i % 4 == 3 ? 1 + (i / 4) % 3 : 0, i % options.dirs, i));
+        }
+        size_t bytes = 0;
+        for (const auto& name : names) {
+            bytes += (kNotifyHeaderSize + name.size() * sizeof(char16_t) + 3) & ~size_t(3);
+        }
+        buffers.push_back(make_buffer(names));
+        lengths.push_back(bytes);
+    }
+
+    std::string root = "C:\\Users\\benchmark\\Documents";
+    size_t checksum = 0;
+
+    uint64_t allocations = g_allocations;
+    auto start = Clock::now();
+    for (size_t b = 0; b < buffers.size(); ++b) {
+        old_dispatch(root, reinterpret_cast<const uint8_t*>(buffers[b].data()), lengths[b], checksum);
+    }
+    double old_seconds = seconds_since(start);
+    uint64_t old_allocations = g_allocations - allocations;
+
+    PathPool paths;
+    NotifyEventBuilder builder(paths);
+    uint32_t root_id = paths.intern(root);
+    std::string path;
+
+    // Warm up: intern the directories and size the buffers once
+    new_dispatch(builder, paths, root_id, reinterpret_cast<const uint8_t*>(buffers[0].data()),
+                 lengths[0], path, checksum);
+
+    allocations = g_allocations;
+    start = Clock::now();
+    for (size_t b = 0; b < buffers.size(); ++b) {
+        new_dispatch(builder, paths, root_id, reinterpret_cast<const uint8_t*>(buffers[b].data()),
+                     lengths[b], path, checksum);
+    }
+    double new_seconds = seconds_since(start);
+    uint64_t new_allocations = g_allocations - allocations;
+
+    double events = options.events;
+    std::printf("\nDispatch (%d events, %d directories)\n", options.events, options.dirs);
+    std::printf("  narrowing + concat   %6.2f M events/s   %.2f allocations/event  (mangles non-ASCII)\n",
+                events / old_seconds / 1e6, old_allocations / events);
+    std::printf("  builder + pool       %6.2f M events/s   %.2f allocations/event\n",
+                events / new_seconds / 1e6, new_allocations / events);
+    std::printf("  pool: %zu directories, %zu bytes (checksum %zu)\n",
+                paths.size(), paths.bytes(), checksum % 1000);
+
+    return bench_churn(options) ? 0 : 1;
+}
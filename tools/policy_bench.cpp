@@ -0,0 +1,343 @@
+// Policy benchmark: compiles generated rule sets of increasing size and
+// evaluates random classified events against them, through the compiled
+// decision table and through a plain first-match scan of the rules. The
+// table's decisions are checked against the scan's (for a sample of the
+// events at large rule counts, where the scan is slow).
+//
+//   policy_bench
+//   policy_bench --rules 100,1000,4000,16000 --events 200000
+//
+// Rules are scoped to user or project directories of a synthetic tree and
+// constrain random subsets of source, volume type, labels, extensions and
+// minimum confidence, as a large deployment's policy might. Compile
+// time is what a hot swap of the rule set costs; evaluation must not
+// allocate, counted by replacing operator new.
+
+#include "policy.h"
+#include "classifier.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void* operator new(size_t size) {
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+#ifdef _WIN32
+const char kSeparator = '\\';
+const char* const kRoot = "C:\\Users";
+#else
+const char kSeparator = '/';
+const char* const kRoot = "/home";
+#endif
+
+const char* const kSources[] = {"file", "usb_file", "clipboard"};
+const char* const kVolumeTypes[] = {"local", "usb", "removable"};
+const char* const kLabels[] = {"PAN", "SSN", "EMAIL", "API_KEY", "SECRET"};
+const char* const kExtensions[] = {"docx", "xlsx", "pdf", "csv", "txt", "pptx",
+                                   "zip", "json", "pem", "key", "sql", "md"};
+const char* const kSeverities[] = {"low", "medium", "high", "critical"};
+
+const int kUsers = 50;
+const int kProjects = 20;
+
+struct Options {
+    std::vector<int> rule_counts = {100, 1000, 4000, 16000};
+    int events = 200000;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--rules") {
+            options.rule_counts.clear();
+            std::stringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ',')) {
+                options.rule_counts.push_back(std::max(1, std::atoi(item.c_str())));
+            }
+        } else if (arg == "--events") {
+            options.events = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+std::string user_dir(int user) {
+    return std::string(kRoot) + kSeparator + "user" + std::to_string(user);
+}
+
+std::string project_dir(int user, int project) {
+    return user_dir(user) + kSeparator + "Projects" + kSeparator + "p" + std::to_string(project);
+}
+
+std::vector<PolicyRule> generate_rules(int count, std::mt19937& rng) {
+    auto chance = [&](double p) { return std::uniform_real_distribution<double>(0.0, 1.0)(rng) < p; };
+    auto pick = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+
+    std::vector<PolicyRule> rules;
+    for (int i = 0; i < count; ++i) {
+        PolicyRule rule;
+        rule.name = "rule" + std::to_string(i);
+        if (chance(0.3)) {
+            rule.sources.push_back(kSources[pick(3)]);
+        }
+        if (chance(0.2)) {
+            rule.volume_types.push_back(kVolumeTypes[pick(3)]);
+        }
+        if (chance(0.6)) {
+            for (int n = 1 + pick(2); n > 0; --n) {
+                rule.labels.push_back(kLabels[pick(5)]);
+            }
+        }
+        // Every rule is scoped to some directories, as a deployment's would be
+        {
+            for (int n = 1 + pick(3); n > 0; --n) {
+                int user = pick(kUsers);
+                rule.path_prefixes.push_back(chance(0.3) ? user_dir(user) : project_dir(user, pick(kProjects)));
+            }
+        }
+        if (chance(0.6)) {
+            for (int n = 1 + pick(3); n > 0; --n) {
+                rule.extensions.push_back(std::string(chance(0.5) ? "." : "") + kExtensions[pick(12)]);
+            }
+        }
+        if (chance(0.2)) {
+            rule.min_confidence = 0.75 + 0.05 * pick(5);
+        }
+        rule.severity = kSeverities[pick(4)];
+        rule.action = chance(0.1) ? "ignore" : "report";
+        rules.push_back(std::move(rule));
+    }
+    return rules;
+}
+
+struct Event {
+    PolicyInput input;
+    std::string path;
+};
+
+std::vector<Event> generate_events(int count, std::mt19937& rng) {
+    auto pick = [&](int n) { return std::uniform_int_distribution<int>(0, n - 1)(rng); };
+
+    std::vector<Event> events(count);
+    for (auto& event : events) {
+        event.input.source = static_cast<PolicySource>(pick(3));
+        if (event.input.source == PolicySource::USB_FILE) {
+            event.input.volume_type = pick(2) ? VolumeType::USB : VolumeType::REMOVABLE;
+        }
+        event.input.labels = 1 + pick(31);
+        event.input.confidence = 0.7 + 0.01 * pick(31);
+
+        if (event.input.source != PolicySource::CLIPBOARD) {
+            event.path = project_dir(pick(kUsers), pick(kProjects + 5));
+            for (int depth = pick(4); depth > 0; --depth) {
+                event.path += kSeparator + std::string("dir") + std::to_string(pick(10));
+            }
+            // Some extensions no rule lists
+            std::string extension = pick(6) ? kExtensions[pick(12)] : "bin";
+            event.path += kSeparator + std::string("file") + std::to_string(pick(1000)) + "." + extension;
+        }
+    }
+    for (auto& event : events) {
+        event.input.path = event.path;
+    }
+    return events;
+}
+
+// The reference semantics, rule by rule, with strings split up front so
+// the scan measures matching rather than parsing
+
+std::vector<std::string> components(const std::string& path) {
+    std::vector<std::string> parts;
+    std::string part;
+    for (char c : path) {
+        if (c == '/' || c == kSeparator) {
+            if (!part.empty()) {
+                parts.push_back(part);
+            }
+            part.clear();
+        } else {
+#ifdef _WIN32
+            part.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+#else
+            part.push_back(c);
+#endif
+        }
+    }
+    if (!part.empty()) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+    return text;
+}
+
+struct ReferenceRule {
+    const PolicyRule* rule;
+    uint32_t labels = 0;
+    std::vector<std::vector<std::string>> prefixes;
+    std::vector<std::string> extensions;
+};
+
+struct ReferenceEvent {
+    std::vector<std::string> path;
+    std::string extension;
+};
+
+std::vector<ReferenceRule> reference_rules(const std::vector<PolicyRule>& rules) {
+    std::vector<ReferenceRule> reference;
+    for (const auto& rule : rules) {
+        ReferenceRule entry;
+        entry.rule = &rule;
+        entry.labels = Classifier::label_mask(rule.labels);
+        for (const auto& prefix : rule.path_prefixes) {
+            entry.prefixes.push_back(components(prefix));
+        }
+        for (const auto& extension : rule.extensions) {
+            entry.extensions.push_back(lower(extension[0] == '.' ? extension.substr(1) : extension));
+        }
+        reference.push_back(std::move(entry));
+    }
+    return reference;
+}
+
+PolicyDecision linear_decision(const std::vector<ReferenceRule>& rules, const PolicyInput& input,
+                               const ReferenceEvent& event) {
+    auto listed = [](const std::vector<std::string>& values, const std::string& value) {
+        return values.empty() || std::find(values.begin(), values.end(), value) != values.end();
+    };
+
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const ReferenceRule& entry = rules[i];
+        const PolicyRule& rule = *entry.rule;
+
+        bool match = listed(rule.sources, Policy::source_name(input.source)) &&
+                     listed(rule.volume_types, kVolumeTypes[static_cast<int>(input.volume_type)]) &&
+                     input.confidence >= rule.min_confidence &&
+                     (entry.labels == 0 || (entry.labels & input.labels) != 0) &&
+                     (entry.extensions.empty() || (!event.extension.empty() && listed(entry.extensions, event.extension)));
+
+        if (match && !entry.prefixes.empty()) {
+            match = std::any_of(entry.prefixes.begin(), entry.prefixes.end(), [&](const std::vector<std::string>& prefix) {
+                return prefix.size() <= event.path.size() && std::equal(prefix.begin(), prefix.end(), event.path.begin());
+            });
+        }
+
+        if (match) {
+            PolicyDecision decision;
+            decision.severity = rule.severity;
+            decision.report = rule.action == "report";
+            decision.rule = static_cast<int>(i);
+            return decision;
+        }
+    }
+    return Policy::default_decision(input);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--rules N,N,...] [--events N]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937 rng(12345);
+    std::vector<Event> events = generate_events(options.events, rng);
+    std::printf("%d events, %d users x %d projects\n\n", options.events, kUsers, kProjects);
+    std::printf("%7s %11s %13s %12s %9s %9s %12s %s\n", "rules", "compile ms", "table ns/evt", "scan ns/evt",
+                "matched", "ignored", "allocs/evt", "checked");
+
+    bool ok = true;
+    for (int count : options.rule_counts) {
+        std::vector<PolicyRule> rules = generate_rules(count, rng);
+
+        auto compile_start = Clock::now();
+        std::string error;
+        auto policy = Policy::compile(rules, error);
+        double compile_ms = std::chrono::duration<double, std::milli>(Clock::now() - compile_start).count();
+        if (!policy) {
+            std::printf("compile failed: %s\n", error.c_str());
+            return 1;
+        }
+
+        // Warm up the per-thread scratch space, then time
+        policy->evaluate(events[0].input);
+        uint64_t matched = 0, ignored = 0;
+        uint64_t allocations_before = g_allocations;
+        auto start = Clock::now();
+        for (const auto& event : events) {
+            PolicyDecision decision = policy->evaluate(event.input);
+            matched += decision.rule >= 0;
+            ignored += !decision.report;
+        }
+        double table_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / events.size();
+        double allocations = double(g_allocations - allocations_before) / events.size();
+
+        // The scan is slow at thousands of rules: time and check a sample
+        std::vector<ReferenceRule> reference = reference_rules(rules);
+        size_t sample = std::min(events.size(), static_cast<size_t>(std::max(1000, 200000000 / count)));
+        std::vector<ReferenceEvent> reference_events(sample);
+        for (size_t i = 0; i < sample; ++i) {
+            reference_events[i].path = components(events[i].path);
+            reference_events[i].extension = lower(std::string(Policy::extension_of(events[i].path)));
+        }
+
+        std::vector<PolicyDecision> expected(sample);
+        start = Clock::now();
+        for (size_t i = 0; i < sample; ++i) {
+            expected[i] = linear_decision(reference, events[i].input, reference_events[i]);
+        }
+        double scan_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / sample;
+
+        uint64_t mismatches = 0;
+        for (size_t i = 0; i < sample; ++i) {
+            PolicyDecision actual = policy->evaluate(events[i].input);
+            mismatches += expected[i].rule != actual.rule || expected[i].report != actual.report ||
+                          expected[i].severity != actual.severity;
+        }
+
+        std::printf("%7d %11.2f %13.1f %12.1f %8.1f%% %8.1f%% %12.3f %s\n", count, compile_ms, table_ns, scan_ns,
+                    100.0 * matched / events.size(), 100.0 * ignored / events.size(), allocations,
+                    mismatches ? "MISMATCH" : ("ok (" + std::to_string(sample) + ")").c_str());
+        ok = ok && mismatches == 0 && allocations == 0.0;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,457 @@
+// Event spool checks: recovery after the writer is killed mid-append, after
+// appends that fail part way, and after on-disk damage, plus how fast replay
+// drains a backlog against the mock server.
+//
+//   spool_bench
+//   spool_bench --rounds 50
+//   spool_bench --server http://127.0.0.1:8000/api/v1 --backlog 5000 --live-rate 200
+//
+// Every check reads the spool back and verifies the record sequence: nothing
+// out of order or duplicated, nothing acknowledged lost, and the reader
+// always drains to empty. The replay checks need a running
+// tools/mock_server.py and are skipped without --server. Exits non-zero if
+// any check fails.
+
+#include "event_spool.h"
+#include "event_reporter.h"
+#include "http_client.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    int rounds = 20;
+    std::string server;
+    int backlog = 2000;
+    int live_rate = 100;     // events/sec offered during the sustained check
+    int replay_rate = 20;    // the agent's default spool.replay_rate
+    int duration_s = 10;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--rounds") {
+            options.rounds = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--backlog") {
+            options.backlog = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--live-rate") {
+            options.live_rate = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--replay-rate") {
+            options.replay_rate = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--duration") {
+            options.duration_s = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+fs::path scratch_directory(const std::string& name) {
+    fs::path path = fs::temp_directory_path() /
+                    ("spool_bench_" + std::to_string(Clock::now().time_since_epoch().count())) / name;
+    fs::create_directories(path);
+    return path;
+}
+
+// Record i: its index, then filler so records straddle stdio buffer and
+// segment boundaries
+std::string make_record(uint32_t index, size_t length) {
+    std::string payload = std::to_string(index) + ":";
+    payload.resize(std::max(length, payload.size()), static_cast<char>('a' + index % 26));
+    return payload;
+}
+
+uint32_t record_index(const SpoolRecord& record) {
+    return static_cast<uint32_t>(std::strtoul(record.payload.c_str(), nullptr, 10));
+}
+
+// Reads the spool to empty in small batches, as replay does
+std::vector<uint32_t> drain(EventSpool& spool) {
+    std::vector<uint32_t> indices;
+    std::vector<SpoolRecord> batch;
+    while (size_t count = spool.peek(batch, 8)) {
+        for (size_t i = 0; i < count; ++i) {
+            indices.push_back(record_index(batch[i]));
+        }
+        spool.pop(count);
+    }
+    return indices;
+}
+
+bool strictly_increasing(const std::vector<uint32_t>& indices) {
+    for (size_t i = 1; i < indices.size(); ++i) {
+        if (indices[i] <= indices[i - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Appending after recovery lands on a frame boundary and reads back
+bool append_after_recovery(EventSpool& spool) {
+    if (!spool.append(make_record(999999, 100))) {
+        return false;
+    }
+    SpoolRecord record;
+    bool ok = spool.peek(record) && record_index(record) == 999999;
+    spool.pop();
+    return ok && spool.empty();
+}
+
+#ifdef __linux__
+
+// A child appends numbered records, syncing every 64 and reporting the
+// synced count and spool size through a pipe, until it is SIGKILLed at a
+// random moment. Every other round also simulates power loss by cutting
+// the last segment at a random point after the synced data, which tears the
+// final frame. The recovered spool must hold a gapless prefix at least as
+// long as the last synced count.
+bool check_kill_during_write(const Options& options) {
+    std::printf("kill during write: %d rounds\n", options.rounds);
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> kill_after_ms(5, 60);
+    std::uniform_int_distribution<size_t> length(40, 3000);
+
+    struct Progress {
+        uint64_t records;
+        uint64_t bytes;
+    };
+
+    bool ok = true;
+    size_t torn_rounds = 0;
+    for (int round = 0; round < options.rounds; ++round) {
+        fs::path directory = scratch_directory("kill" + std::to_string(round));
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            std::perror("pipe");
+            return false;
+        }
+        unsigned seed = random();
+
+        pid_t child = fork();
+        if (child == 0) {
+            close(pipe_fds[0]);
+            std::mt19937 child_random(seed);
+            EventSpool spool(directory.string(), 256ull * 1024 * 1024);
+            if (!spool.open()) {
+                _exit(2);
+            }
+            for (uint32_t i = 0;; ++i) {
+                spool.append(make_record(i, length(child_random)));
+                if (i % 64 == 63) {
+                    spool.sync();
+                    Progress synced{i + 1u, spool.size_bytes()};
+                    if (write(pipe_fds[1], &synced, sizeof(synced)) != sizeof(synced)) {
+                        _exit(3);
+                    }
+                }
+            }
+        }
+
+        close(pipe_fds[1]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(kill_after_ms(random)));
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+
+        Progress synced{0, 0};
+        Progress value;
+        while (read(pipe_fds[0], &value, sizeof(value)) == sizeof(value)) {
+            synced = value;
+        }
+        close(pipe_fds[0]);
+
+        std::vector<fs::path> segments;
+        uint64_t bytes_on_disk = 0;
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.path().extension() == ".seg") {
+                segments.push_back(entry.path());
+                bytes_on_disk += entry.file_size();
+            }
+        }
+        std::sort(segments.begin(), segments.end());
+
+        if (round % 2 == 1 && !segments.empty()) {
+            // Synced bytes in the last segment are kept; anything after may go
+            uint64_t last_size = fs::file_size(segments.back());
+            uint64_t earlier = bytes_on_disk - last_size;
+            uint64_t keep = synced.bytes > earlier ? synced.bytes - earlier : 0;
+            if (last_size > keep) {
+                uint64_t cut = keep + random() % (last_size - keep);
+                fs::resize_file(segments.back(), cut);
+                bytes_on_disk -= last_size - cut;
+            }
+        }
+
+        EventSpool spool(directory.string(), 256ull * 1024 * 1024);
+        bool opened = spool.open();
+        torn_rounds += opened && spool.size_bytes() < bytes_on_disk ? 1 : 0;
+        std::vector<uint32_t> indices = opened ? drain(spool) : std::vector<uint32_t>();
+
+        bool gapless = true;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            gapless = gapless && indices[i] == i;
+        }
+        bool round_ok = opened && gapless && indices.size() >= synced.records &&
+                        spool.corrupt_records() == 0 && append_after_recovery(spool);
+        if (!round_ok) {
+            std::printf("  round %d: synced %llu, recovered %zu, %s\n", round,
+                        static_cast<unsigned long long>(synced.records), indices.size(),
+                        gapless ? "in order" : "GAPS OR DUPLICATES");
+        }
+        ok = ok && round_ok;
+    }
+    std::printf("  %d rounds, %zu with a torn tail truncated on open: %s\n", options.rounds, torn_rounds,
+                ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Appends while the file size limit makes writes fail part way (EFBIG), as
+// a full disk would. Acknowledged-then-lost records are only possible in the
+// failing window; everything before and after must read back in order, and
+// the reader must drain.
+bool check_short_writes() {
+    fs::path directory = scratch_directory("short");
+    EventSpool spool(directory.string(), 64ull * 1024 * 1024);
+    if (!spool.open()) {
+        return false;
+    }
+
+    const uint32_t before = 100;
+    const uint32_t failing = 300;
+    const uint32_t after = 100;
+    for (uint32_t i = 0; i < before; ++i) {
+        spool.append(make_record(i, 500));
+    }
+    spool.sync();
+
+    rlimit original;
+    getrlimit(RLIMIT_FSIZE, &original);
+    std::signal(SIGXFSZ, SIG_IGN);
+
+    rlimit limited = original;
+    limited.rlim_cur = spool.size_bytes() + 20000;
+    setrlimit(RLIMIT_FSIZE, &limited);
+    uint32_t rejected = 0;
+    for (uint32_t i = before; i < before + failing; ++i) {
+        rejected += spool.append(make_record(i, 500)) ? 0 : 1;
+    }
+    spool.sync();
+    setrlimit(RLIMIT_FSIZE, &original);
+
+    for (uint32_t i = before + failing; i < before + failing + after; ++i) {
+        spool.append(make_record(i, 500));
+    }
+
+    std::vector<uint32_t> indices = drain(spool);
+    size_t head = std::count_if(indices.begin(), indices.end(), [&](uint32_t i) { return i < before; });
+    size_t tail = std::count_if(indices.begin(), indices.end(),
+                                [&](uint32_t i) { return i >= before + failing; });
+    bool ok = strictly_increasing(indices) && head == before && tail == after && spool.empty() &&
+              spool.corrupt_records() == 0 && append_after_recovery(spool);
+
+    std::printf("short writes: %u appends rejected, %zu of %u in the failing window kept, %zu before, "
+                "%zu after: %s\n", rejected, indices.size() - head - tail, failing, head, tail,
+                ok ? "ok" : "FAILED");
+    return ok;
+}
+
+#endif
+
+// Damage on disk: a record with a bad checksum is skipped alone, a segment
+// whose framing is lost is set aside, and stray *.seg names are ignored
+bool check_damage() {
+    fs::path directory = scratch_directory("damage");
+    const size_t payload = 1000;
+    const uint64_t frame = 16 + payload;
+    uint32_t written = 0;
+    {
+        // 512 KiB spool: 64 KiB segments
+        EventSpool spool(directory.string(), 512 * 1024);
+        spool.open();
+        while (written < 200) {
+            spool.append(make_record(written++, payload));
+        }
+        spool.close();
+    }
+
+    std::vector<fs::path> segments;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        if (entry.path().extension() == ".seg") {
+            segments.push_back(entry.path());
+        }
+    }
+    std::sort(segments.begin(), segments.end());
+    if (segments.size() < 3) {
+        std::printf("damage: expected at least 3 segments, got %zu\n", segments.size());
+        return false;
+    }
+    uint32_t first_segment_records = static_cast<uint32_t>(fs::file_size(segments[0]) / frame);
+    uint32_t second_segment_records = static_cast<uint32_t>(fs::file_size(segments[1]) / frame);
+
+    auto corrupt_byte = [](const fs::path& path, uint64_t offset) {
+        std::FILE* file = std::fopen(path.string().c_str(), "r+b");
+        std::fseek(file, static_cast<long>(offset), SEEK_SET);
+        int c = std::fgetc(file);
+        std::fseek(file, static_cast<long>(offset), SEEK_SET);
+        std::fputc(c ^ 0x5a, file);
+        std::fclose(file);
+    };
+    // Payload of record 5 (checksum), magic of the fourth record of segment 2
+    corrupt_byte(segments[0], 5 * frame + 16 + 10);
+    corrupt_byte(segments[1], 3 * frame);
+
+    for (const char* stray : {"notes.seg", "7.seg", "abc.seg", "00000000099.seg", "12345678901234567890123.seg"}) {
+        std::FILE* file = std::fopen((directory / stray).string().c_str(), "wb");
+        std::fputs("not a segment", file);
+        std::fclose(file);
+    }
+
+    EventSpool spool(directory.string(), 512 * 1024);
+    bool opened = spool.open();
+    std::vector<uint32_t> indices = opened ? drain(spool) : std::vector<uint32_t>();
+
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < written; ++i) {
+        bool skipped = i == 5;
+        bool set_aside = i >= first_segment_records + 3 && i < first_segment_records + second_segment_records;
+        if (!skipped && !set_aside) {
+            expected.push_back(i);
+        }
+    }
+
+    size_t bad_segments = 0;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        bad_segments += entry.path().extension() == ".bad" ? 1 : 0;
+    }
+
+    bool ok = opened && indices == expected && spool.corrupt_records() == 2 && bad_segments == 1 &&
+              append_after_recovery(spool);
+    std::printf("damage: opened with stray files %s, read %zu of %u records, %llu corrupt, "
+                "%zu segment set aside: %s\n", opened ? "ok" : "FAILED", indices.size(), written,
+                static_cast<unsigned long long>(spool.corrupt_records()), bad_segments, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+std::string event_payload(uint32_t index) {
+    return "{\"event_id\":\"evt-spool-bench-" + std::to_string(index) +
+           "\",\"event_type\":\"file\",\"severity\":\"high\",\"agent_id\":\"spool-bench\"}";
+}
+
+bool wait_until_empty(EventSpool& spool, double limit_s, double& elapsed_s) {
+    auto start = Clock::now();
+    while (!spool.empty() && seconds_since(start) < limit_s) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    elapsed_s = seconds_since(start);
+    return spool.empty();
+}
+
+// Replay drains a backlog faster than the configured rate, and catches up
+// while live events keep arriving above that rate (they queue behind the
+// backlog in the spool)
+bool check_replay(const Options& options) {
+    HttpClient client(options.server);
+    fs::path directory = scratch_directory("replay");
+    EventSpool spool(directory.string(), 256ull * 1024 * 1024);
+    if (!spool.open()) {
+        return false;
+    }
+    EventReporter reporter(client, "spool-bench", &spool);
+
+    for (int i = 0; i < options.backlog; ++i) {
+        spool.append(event_payload(i));
+    }
+    reporter.start_replay(options.replay_rate);
+    double drain_s = 0.0;
+    bool drained = wait_until_empty(spool, options.backlog / double(options.replay_rate), drain_s);
+    double drain_rate = options.backlog / drain_s;
+    std::printf("replay: %d-event backlog drained in %.2f s (%.0f events/s, configured rate %d/s)\n",
+                options.backlog, drain_s, drain_rate, options.replay_rate);
+    bool ok = drained && drain_rate >= 5.0 * options.replay_rate;
+
+    // The same backlog again, with live events on top
+    for (int i = 0; i < options.backlog; ++i) {
+        spool.append(event_payload(i));
+    }
+    auto start = Clock::now();
+    auto interval = std::chrono::duration<double>(1.0 / options.live_rate);
+    auto next = start;
+    int live = 0;
+    while (seconds_since(start) < options.duration_s) {
+        std::this_thread::sleep_until(next);
+        reporter.report("file", "high", "/home/user/Documents/live-" + std::to_string(live++) + ".docx");
+        next += std::chrono::duration_cast<Clock::duration>(interval);
+    }
+    double backlog_left = static_cast<double>(spool.size_bytes());
+    double catch_up_s = 0.0;
+    bool caught_up = wait_until_empty(spool, options.duration_s, catch_up_s);
+    reporter.stop_replay();
+
+    std::printf("replay under load: %d live events at %d/s on a %d-event backlog, %s %.2f s after the "
+                "load ended (%.0f bytes still spooled then)\n", live, options.live_rate, options.backlog,
+                caught_up ? "drained" : "NOT DRAINED", catch_up_s, backlog_left);
+    return ok && caught_up;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--rounds N] [--server url] [--backlog N] [--live-rate N] "
+                     "[--replay-rate N] [--duration S]\n", argv[0]);
+        return 1;
+    }
+
+    // Recovery and damage warnings are expected
+    Logger::set_level(Logger::Level::ERROR);
+
+    bool ok = true;
+#ifdef __linux__
+    ok = check_kill_during_write(options) && ok;
+    ok = check_short_writes() && ok;
+#else
+    std::printf("kill during write, short writes: skipped (Linux only)\n");
+#endif
+    ok = check_damage() && ok;
+
+    if (options.server.empty()) {
+        std::printf("replay: skipped (no --server)\n");
+    } else {
+        ok = check_replay(options) && ok;
+    }
+
+    std::printf("\n%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,468 @@
+// Event trace recording and replay: feeds a recorded (or generated) event
+// trace through the agent's pipeline (file-state index check, classifier,
+// EventReporter) against a local server, and reports throughput and
+// per-stage latency. Replays are deterministic: events run in trace order on
+// one thread, each run starts from an empty index, and the content of every
+// event is staged to disk before the pipeline sees it. Pair with
+// tools/mock_server.py:
+//
+//   python tools/mock_server.py --port 8000 &
+//   trace_replay generate --trace /tmp/trace --events 5000
+//   trace_replay record --trace /tmp/trace --watch ~/Documents --duration 60
+//   trace_replay replay --trace /tmp/trace --speed max --repeat 5
+//
+// Agents record traces themselves when "event_trace" is enabled in
+// agent_config.json.
+
+#include "event_pipeline.h"
+#include "event_reporter.h"
+#include "event_trace.h"
+#include "file_monitor.h"
+#include "file_state_index.h"
+#include "fnv_hash.h"
+#include "http_client.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string mode;
+    std::string trace;
+    std::string watch;
+    std::string server = "http://127.0.0.1:8000/api/v1";
+    std::string work;         // empty = temporary directory
+    std::string encoding = "json";
+    bool original_speed = false;
+    bool record_content = false;
+    int duration_s = 60;
+    int events = 5000;
+    int repeat = 1;
+};
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s generate --trace DIR [--events N]\n"
+        "       %s record --trace DIR --watch DIR [--duration S] [--content 0|1]\n"
+        "       %s replay --trace DIR [options]\n"
+        "  --server URL       Server base URL (default http://127.0.0.1:8000/api/v1)\n"
+        "  --speed MODE       original (keep recorded timing) or max (default max)\n"
+        "  --repeat N         Replay the trace N times (default 1)\n"
+        "  --work DIR         Where file content is staged (default: temporary)\n"
+        "  --encoding FMT     json or cbor (default json)\n",
+        program, program, program);
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    if (argc < 2) {
+        usage(argv[0]);
+        return false;
+    }
+    options.mode = argv[1];
+
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--trace") {
+            options.trace = value;
+        } else if (arg == "--watch") {
+            options.watch = value;
+        } else if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--work") {
+            options.work = value;
+        } else if (arg == "--encoding") {
+            options.encoding = value;
+        } else if (arg == "--speed") {
+            options.original_speed = value == "original";
+        } else if (arg == "--content") {
+            options.record_content = value != "0";
+        } else if (arg == "--duration") {
+            options.duration_s = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--events") {
+            options.events = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--repeat") {
+            options.repeat = std::max(1, std::atoi(value.c_str()));
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    bool valid = !options.trace.empty() &&
+                 (options.mode == "generate" || options.mode == "replay" ||
+                  (options.mode == "record" && !options.watch.empty()));
+    if (!valid) {
+        usage(argv[0]);
+    }
+    return valid;
+}
+
+// Deterministic stand-in for content that was recorded as a hash only:
+// printable text of the recorded size, so read and scan costs match
+std::string filler_content(uint64_t hash, uint64_t size) {
+    std::mt19937_64 random(hash);
+    std::string content(static_cast<size_t>(size), ' ');
+    for (auto& c : content) {
+        c = static_cast<char>('a' + random() % 26);
+    }
+    for (size_t i = 79; i < content.size(); i += 80) {
+        content[i] = '\n';
+    }
+    return content;
+}
+
+// ---- generate ------------------------------------------------------------
+
+// A mixed office workload: mostly document saves, a fraction of them with
+// sensitive data, plus clipboard copies and the occasional USB device
+int generate(const Options& options) {
+    std::mt19937 random(1234);
+    std::string directory = (fs::temp_directory_path() / "trace_generate").string();
+    fs::create_directories(directory);
+
+    TraceWriter writer;
+    if (!writer.open(options.trace, true)) {
+        return 1;
+    }
+
+    const char* samples[] = {
+        "Quarterly numbers attached, see the summary sheet.\n",
+        "Card on file: 4111 1111 1111 1111, expires 12/29\n",
+        "Employee SSN 123-45-6789 for the benefits form\n",
+        "Contact alice@example.com about the contract\n",
+        "api_key = AKIAIOSFODNN7EXAMPLEKEY123\n",
+    };
+
+    for (int i = 0; i < options.events; ++i) {
+        int kind = static_cast<int>(random() % 100);
+        bool sensitive = random() % 10 == 0;
+        const char* text = samples[sensitive ? 1 + random() % 4 : 0];
+
+        if (kind < 85) {
+            std::string path = directory + "/doc" + std::to_string(random() % 500) + ".txt";
+            std::string content;
+            size_t size = 512 + random() % (8 * 1024);
+            while (content.size() < size) {
+                content += samples[0];
+            }
+            content += text;
+            {
+                std::ofstream file(path, std::ios::binary | std::ios::trunc);
+                file << content;
+            }
+            writer.record_file(path, kind < 15 ? "created" : "modified");
+        } else if (kind < 97) {
+            writer.record_clipboard(text);
+        } else {
+            writer.record_usb(std::string(1, static_cast<char>('E' + random() % 4)) + ":\\", "connected");
+        }
+    }
+
+    std::printf("Generated %llu events in %s\n",
+                static_cast<unsigned long long>(writer.events_recorded()), options.trace.c_str());
+    writer.close();
+    fs::remove_all(directory);
+    return 0;
+}
+
+// ---- record --------------------------------------------------------------
+
+int record(const Options& options) {
+    TraceWriter writer;
+    if (!writer.open(options.trace, options.record_content)) {
+        return 1;
+    }
+
+    FileMonitor monitor({options.watch}, [&writer](const std::string& path, const std::string& event_type) {
+        writer.record_file(path, event_type);
+    });
+    if (!monitor.start()) {
+        std::fprintf(stderr, "Failed to watch %s\n", options.watch.c_str());
+        return 1;
+    }
+
+    std::printf("Recording file events under %s for %ds...\n", options.watch.c_str(), options.duration_s);
+    std::this_thread::sleep_for(std::chrono::seconds(options.duration_s));
+    monitor.stop();
+
+    std::printf("Recorded %llu events in %s\n",
+                static_cast<unsigned long long>(writer.events_recorded()), options.trace.c_str());
+    return 0;
+}
+
+// ---- replay --------------------------------------------------------------
+
+struct ReplayEvent {
+    TraceEvent event;
+    std::string staged_path;       // where file content is written before dispatch
+    const std::string* content = nullptr;
+};
+
+struct LatencySummary {
+    size_t count = 0;
+    double p50_us = 0.0;
+    double p90_us = 0.0;
+    double p99_us = 0.0;
+    double max_us = 0.0;
+};
+
+LatencySummary summarize(std::vector<double>& samples) {
+    LatencySummary summary;
+    summary.count = samples.size();
+    if (samples.empty()) {
+        return summary;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double fraction) {
+        size_t index = static_cast<size_t>(fraction * (samples.size() - 1) + 0.5);
+        return samples[(std::min)(index, samples.size() - 1)];
+    };
+    summary.p50_us = percentile(0.50);
+    summary.p90_us = percentile(0.90);
+    summary.p99_us = percentile(0.99);
+    summary.max_us = samples.back();
+    return summary;
+}
+
+struct RunResult {
+    double seconds = 0.0;
+    double events_per_sec = 0.0;
+    uint64_t files_scanned = 0;
+    EventReporter::Stats uplink;
+    std::vector<double> stage_samples[3];
+    std::vector<double> event_samples;
+    std::vector<double> lag_samples;  // dispatch delay behind the recorded schedule
+};
+
+// Replayed files live under the work directory, one subdirectory per
+// original path, so repeated events on a file hit the same index entry
+std::string staged_path(const fs::path& work, const std::string& original) {
+    size_t separator = original.find_last_of("/\\");
+    std::string name = separator == std::string::npos ? original : original.substr(separator + 1);
+    char bucket[17];
+    std::snprintf(bucket, sizeof(bucket), "%016llx", static_cast<unsigned long long>(fnv1a_64(original)));
+    return (work / bucket / name).string();
+}
+
+RunResult replay_once(std::vector<ReplayEvent>& events, HttpClient& http_client,
+                      const Options& options, const fs::path& work) {
+    RunResult result;
+
+    std::error_code ec;
+    fs::remove_all(work, ec);
+    fs::create_directories(work, ec);
+
+    // A fresh, in-memory index per run so every run does the same work
+    FileStateIndex index;
+    EventReporter reporter(http_client, "replay-agent");
+    reporter.set_wire_format(options.encoding == "cbor" ? WireFormat::CBOR : WireFormat::JSON);
+
+    EventPipeline pipeline(reporter, index);
+    pipeline.set_stage_observer([&result](EventPipeline::Stage stage, std::chrono::nanoseconds elapsed) {
+        result.stage_samples[static_cast<int>(stage)].push_back(elapsed.count() / 1000.0);
+    });
+
+    result.event_samples.reserve(events.size());
+    auto start = Clock::now();
+    for (auto& replay : events) {
+        const TraceEvent& event = replay.event;
+
+        if (options.original_speed) {
+            auto due = start + std::chrono::microseconds(event.offset_us);
+            std::this_thread::sleep_until(due);
+            result.lag_samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - due).count());
+        }
+
+        // Staging plays the part of the application that saved the file and
+        // is not part of the measured event
+        if (event.source == TraceSource::FILE) {
+            if (event.action == "deleted") {
+                fs::remove(replay.staged_path, ec);
+            } else if (replay.content) {
+                fs::create_directories(fs::path(replay.staged_path).parent_path(), ec);
+                std::ofstream file(replay.staged_path, std::ios::binary | std::ios::trunc);
+                file.write(replay.content->data(), static_cast<std::streamsize>(replay.content->size()));
+            }
+        }
+
+        auto dispatched = Clock::now();
+        switch (event.source) {
+            case TraceSource::FILE:
+                pipeline.handle_file_event(replay.staged_path, event.action);
+                break;
+            case TraceSource::CLIPBOARD:
+                pipeline.handle_clipboard_event(replay.content ? *replay.content : std::string());
+                break;
+            case TraceSource::USB: {
+                // Traces keep only the root; older ones record "-" for arrivals
+                VolumeInfo volume;
+                volume.root = event.subject;
+                volume.bus = "usb";
+                if (event.action == "removed") {
+                    pipeline.handle_usb_removal(volume);
+                } else {
+                    pipeline.handle_usb_event(volume);
+                }
+                break;
+            }
+        }
+        result.event_samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - dispatched).count());
+    }
+
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.events_per_sec = events.size() / result.seconds;
+    result.files_scanned = pipeline.files_scanned();
+    // Reports are posted in the background; count them once answered
+    reporter.drain(std::chrono::seconds(30));
+    result.uplink = reporter.stats();
+    return result;
+}
+
+void print_latency(const char* name, std::vector<double>& samples) {
+    LatencySummary summary = summarize(samples);
+    std::printf("  %-10s %8zu %10.1f %10.1f %10.1f %10.1f\n",
+                name, summary.count, summary.p50_us, summary.p90_us, summary.p99_us, summary.max_us);
+}
+
+int replay(const Options& options) {
+    TraceReader reader;
+    if (!reader.open(options.trace)) {
+        return 1;
+    }
+
+    fs::path work = options.work.empty()
+        ? fs::temp_directory_path() / ("trace_replay_" + std::to_string(Clock::now().time_since_epoch().count()))
+        : fs::path(options.work);
+
+    // Load everything up front so trace I/O stays out of the measurement
+    std::vector<ReplayEvent> events;
+    std::unordered_map<uint64_t, std::string> contents;
+    size_t counts[3] = {0, 0, 0};
+    size_t synthesized = 0;
+
+    TraceEvent event;
+    while (reader.next(event)) {
+        ReplayEvent replay;
+        replay.event = event;
+        ++counts[static_cast<int>(event.source)];
+
+        if (event.source == TraceSource::FILE) {
+            replay.staged_path = staged_path(work, event.subject);
+        }
+
+        if (event.source != TraceSource::USB && event.action != "deleted") {
+            auto found = contents.find(event.content_hash);
+            if (found == contents.end()) {
+                std::string content;
+                if (!reader.load_content(event, content)) {
+                    content = filler_content(event.content_hash, event.content_size);
+                    ++synthesized;
+                }
+                found = contents.emplace(event.content_hash, std::move(content)).first;
+            }
+            replay.content = &found->second;
+        }
+        events.push_back(std::move(replay));
+    }
+
+    if (events.empty()) {
+        std::fprintf(stderr, "Trace %s has no events\n", options.trace.c_str());
+        return 1;
+    }
+
+    HttpClient http_client(options.server);
+
+    std::printf("Trace replay: %s, %zu events (%zu file, %zu clipboard, %zu usb), %s speed, %s\n",
+                options.trace.c_str(), events.size(), counts[0], counts[1], counts[2],
+                options.original_speed ? "original" : "max", options.encoding.c_str());
+    if (synthesized > 0) {
+        std::printf("Content recorded as hashes only; %zu contents synthesized from size and hash\n",
+                    synthesized);
+    }
+
+    std::vector<double> rates;
+    for (int run = 1; run <= options.repeat; ++run) {
+        RunResult result = replay_once(events, http_client, options, work);
+        rates.push_back(result.events_per_sec);
+
+        std::printf("\nRun %d: %.3f s, %.0f events/sec, %llu files classified, "
+                    "%llu reported, %llu dropped\n",
+                    run, result.seconds, result.events_per_sec,
+                    static_cast<unsigned long long>(result.files_scanned),
+                    static_cast<unsigned long long>(result.uplink.events_reported),
+                    static_cast<unsigned long long>(result.uplink.events_dropped));
+        std::printf("  %-10s %8s %10s %10s %10s %10s\n", "stage", "count", "p50 us", "p90 us", "p99 us", "max us");
+        print_latency(stage_name(EventPipeline::Stage::INDEX), result.stage_samples[0]);
+        print_latency(stage_name(EventPipeline::Stage::CLASSIFY), result.stage_samples[1]);
+        print_latency(stage_name(EventPipeline::Stage::REPORT), result.stage_samples[2]);
+        print_latency("event", result.event_samples);
+        if (options.original_speed) {
+            print_latency("lag", result.lag_samples);
+        }
+        std::fflush(stdout);
+    }
+
+    if (rates.size() > 1) {
+        double mean = 0.0;
+        for (double rate : rates) {
+            mean += rate;
+        }
+        mean /= rates.size();
+        double variance = 0.0;
+        for (double rate : rates) {
+            variance += (rate - mean) * (rate - mean);
+        }
+        double deviation = std::sqrt(variance / (rates.size() - 1));
+        std::printf("\nThroughput over %zu runs: %.0f events/sec mean, %.1f%% relative deviation\n",
+                    rates.size(), mean, mean > 0 ? deviation / mean * 100.0 : 0.0);
+    }
+
+    if (options.work.empty()) {
+        std::error_code ec;
+        fs::remove_all(work, ec);
+    }
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    // Per-event logging would dominate the measurement
+    Logger::set_level(Logger::Level::WARNING);
+
+    if (options.mode == "generate") {
+        return generate(options);
+    }
+    if (options.mode == "record") {
+        return record(options);
+    }
+    return replay(options);
+}
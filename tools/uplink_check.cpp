@@ -0,0 +1,635 @@
+// Uplink regression checks against the local mock server. Each scenario
+// measures one property of the HTTP client and reporter, prints what it
+// saw, and fails when the property no longer holds:
+//
+//   python3 tools/mock_server.py --port 8000 &
+//   uplink_check --server http://127.0.0.1:8000/api/v1
+//   uplink_check --server http://127.0.0.1:8000/api/v1 --scenario pooling
+//
+//   pooling  pooled, kept-alive handles against a fresh curl handle per
+//            request (the client before pooling): fewer connections, and
+//            at least the same request rate
+//   async    requests overlap on the I/O thread: a fast request is not
+//            held up by a slow one, a deadline fails the request on time,
+//            and max_in_flight bounds concurrency
+//   breaker  against a server failing on demand: the circuit opens after
+//            the threshold and fails fast, lets one half-open probe through,
+//            re-opens on a failed probe and closes on a good one; breakers
+//            for many distinct endpoints stay bounded
+//   heartbeat  heartbeats a fixed 60 s schedule sends against the adaptive
+//            one over two simulated hours (idle, then events with a healthy
+//            server, with a local drop, and with the server failing),
+//            counted by the server: fewer in every phase with events, the
+//            drop reported within 15 s, the same while idle
+//   startup  time to the first monitored event with registration blocking
+//            startup against registration in the background, with a slow
+//            server and one that does not answer; events reported while held events
+//            are flushed arrive after them, in order, none left behind
+//   live     live events against a server answering after 1 s: report()
+//            returns at once instead of waiting for the post, and the
+//            events arrive in order once answered
+//
+// The mock server must run without injected faults; scenarios that need
+// them set them up themselves. Exits non-zero if any scenario fails.
+
+#include "event_reporter.h"
+#include "heartbeat_scheduler.h"
+#include "http_client.h"
+#include "logger.h"
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <future>
+#include <thread>
+#include <string>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string server = "http://127.0.0.1:8000/api/v1";
+    std::string scenario = "all";
+    int requests = 500;
+};
+
+struct Scenario {
+    const char* name;
+    std::function<bool(const Options&)> run;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--scenario") {
+            options.scenario = value;
+        } else if (arg == "--requests") {
+            options.requests = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Counter from the mock server's /stats; -1 if the server is unreachable
+long server_counter(HttpClient& client, const std::string& name) {
+    HttpResponse response = client.get("/stats");
+    if (response.status_code != 200) {
+        return -1;
+    }
+    nlohmann::json stats = nlohmann::json::parse(response.body, nullptr, false);
+    if (!stats.is_object()) {
+        return -1;
+    }
+    return stats.value(name, 0L);
+}
+
+const char* kEventBody =
+    "{\"event_type\":\"file\",\"severity\":\"high\",\"file_path\":\"C:\\\\Users\\\\check\\\\report.xlsx\"}";
+
+size_t discard_body(void*, size_t size, size_t nmemb, void*) {
+    return size * nmemb;
+}
+
+// One request the way HttpClient sent it before handles were pooled: a new
+// easy handle, and so a new connection, per request
+bool fresh_handle_post(const std::string& url) {
+    CURL* curl = curl_easy_init();
+    if (!curl) {
+        return false;
+    }
+    curl_slist* headers = curl_slist_append(nullptr, "Content-Type: application/json");
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, kEventBody);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_body);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+
+    long status = 0;
+    bool ok = curl_easy_perform(curl) == CURLE_OK;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+    return ok && status == 201;
+}
+
+bool check_pooling(const Options& options) {
+    HttpClient stats_client(options.server);
+    int n = options.requests;
+
+    long connections = server_counter(stats_client, "connections");
+    auto start = Clock::now();
+    int fresh_failures = 0;
+    for (int i = 0; i < n; ++i) {
+        fresh_failures += fresh_handle_post(options.server + "/events") ? 0 : 1;
+    }
+    double fresh_rate = n / seconds_since(start);
+    long fresh_connections = server_counter(stats_client, "connections") - connections;
+
+    HttpClient client(options.server);
+    connections = server_counter(stats_client, "connections");
+    start = Clock::now();
+    int pooled_failures = 0;
+    for (int i = 0; i < n; ++i) {
+        pooled_failures += client.post("/events", kEventBody).status_code == 201 ? 0 : 1;
+    }
+    double pooled_rate = n / seconds_since(start);
+    long pooled_connections = server_counter(stats_client, "connections") - connections;
+
+    std::printf("%d sequential POST /events\n", n);
+    std::printf("  %-8s %10s %12s %9s\n", "mode", "req/s", "connections", "failures");
+    std::printf("  %-8s %10.0f %12ld %9d\n", "fresh", fresh_rate, fresh_connections, fresh_failures);
+    std::printf("  %-8s %10.0f %12ld %9d\n", "pooled", pooled_rate, pooled_connections, pooled_failures);
+
+    // Pooled requests share one kept-alive connection; the rate is allowed
+    // some noise but must not fall behind connection-per-request
+    return fresh_failures == 0 && pooled_failures == 0 && pooled_connections <= 2 &&
+           pooled_rate >= 0.9 * fresh_rate;
+}
+
+// Whether future completes within the given time from start, and when
+template <typename T>
+bool ready_by(std::future<T>& future, Clock::time_point start, double limit_s, double& elapsed_s) {
+    bool ready = future.wait_until(start + std::chrono::duration_cast<Clock::duration>(
+                                               std::chrono::duration<double>(limit_s))) ==
+                 std::future_status::ready;
+    elapsed_s = seconds_since(start);
+    return ready;
+}
+
+bool check_async(const Options& options) {
+    HttpClient client(options.server);
+    client.set_retry_policy(1, 100, 100);
+    bool ok = true;
+
+    // A fast request next to an outstanding 2 s one
+    auto start = Clock::now();
+    auto slow = client.request_async("POST", "/events?delay_ms=2000", kEventBody);
+    auto fast = client.request_async("POST", "/events", kEventBody);
+    double fast_s = 0.0;
+    bool fast_ok = ready_by(fast, start, 0.5, fast_s) && fast.get().status_code == 201;
+    bool slow_pending = slow.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    double slow_s = 0.0;
+    bool slow_ok = ready_by(slow, start, 5.0, slow_s) && slow.get().status_code == 201;
+    std::printf("  fast request beside a 2 s one: %.3f s%s; slow one %.3f s\n", fast_s,
+                slow_pending ? "" : " (slow one already done)", slow_s);
+    ok = ok && fast_ok && slow_pending && slow_ok;
+
+    // A 500 ms deadline on a 2 s response
+    start = Clock::now();
+    auto bounded = client.request_async("POST", "/events?delay_ms=2000", kEventBody, 500);
+    double bounded_s = 0.0;
+    bool bounded_ready = ready_by(bounded, start, 1.5, bounded_s);
+    int bounded_status = bounded_ready ? bounded.get().status_code : -1;
+    std::printf("  500 ms deadline on a 2 s response: status %d after %.3f s\n", bounded_status, bounded_s);
+    ok = ok && bounded_ready && bounded_status == 0 && bounded_s >= 0.45 && bounded_s < 1.0;
+
+    // Four 1 s requests through two slots take two rounds
+    client.set_max_in_flight(2);
+    start = Clock::now();
+    std::vector<std::future<HttpResponse>> batch;
+    for (int i = 0; i < 4; ++i) {
+        batch.push_back(client.request_async("POST", "/events?delay_ms=1000", kEventBody, 10000));
+    }
+    bool batch_ok = true;
+    for (auto& future : batch) {
+        batch_ok = batch_ok && future.get().status_code == 201;
+    }
+    double batch_s = seconds_since(start);
+    std::printf("  four 1 s requests, 2 in flight: %.3f s\n", batch_s);
+    ok = ok && batch_ok && batch_s >= 1.9 && batch_s < 3.0;
+
+    return ok;
+}
+
+CircuitBreaker::Stats breaker_stats(HttpClient& client, const std::string& endpoint) {
+    auto stats = client.circuit_stats();
+    auto it = stats.find(endpoint);
+    return it != stats.end() ? it->second : CircuitBreaker::Stats();
+}
+
+bool check_breaker(const Options& options) {
+    HttpClient stats_client(options.server);
+    HttpClient client(options.server);
+    client.set_retry_policy(1, 100, 100);
+    // Open for 0.5-1 s after tripping, 1-2 s after a failed probe
+    client.set_circuit_breaker(3, 1, 2);
+    bool ok = true;
+
+    auto report = [&](const char* step, bool passed) {
+        auto stats = breaker_stats(client, "/events");
+        std::printf("  %-44s %-9s opened %llu, half-opened %llu, closed %llu  %s\n", step,
+                    CircuitBreaker::state_to_string(stats.state),
+                    static_cast<unsigned long long>(stats.times_opened),
+                    static_cast<unsigned long long>(stats.times_half_opened),
+                    static_cast<unsigned long long>(stats.times_closed), passed ? "ok" : "FAILED");
+        ok = ok && passed;
+    };
+
+    // Three 503s trip it
+    bool tripped = true;
+    for (int i = 0; i < 3; ++i) {
+        tripped = tripped && client.post("/events?status=503", kEventBody).status_code == 503;
+    }
+    tripped = tripped && breaker_stats(client, "/events").state == CircuitBreaker::State::OPEN;
+    report("three 503s", tripped);
+
+    // Open: requests fail at once and never reach the server
+    long events = server_counter(stats_client, "events");
+    auto start = Clock::now();
+    bool fast_fail = true;
+    for (int i = 0; i < 20; ++i) {
+        fast_fail = fast_fail && client.post("/events", kEventBody).status_code == 0;
+    }
+    double fail_s = seconds_since(start);
+    fast_fail = fast_fail && fail_s < 0.2 && server_counter(stats_client, "events") == events;
+    report("20 requests while open", fast_fail);
+
+    // Half-open: one slow failing probe goes out, the others are rejected
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    events = server_counter(stats_client, "events");
+    auto probe = client.request_async("POST", "/events?status=503&delay_ms=300", kEventBody);
+    std::vector<std::future<HttpResponse>> rejected;
+    for (int i = 0; i < 5; ++i) {
+        rejected.push_back(client.request_async("POST", "/events", kEventBody));
+    }
+    bool one_probe = true;
+    for (auto& future : rejected) {
+        one_probe = one_probe && future.get().status_code == 0;
+    }
+    one_probe = one_probe && probe.get().status_code == 503 &&
+                server_counter(stats_client, "events") == events + 1 &&
+                breaker_stats(client, "/events").state == CircuitBreaker::State::OPEN;
+    report("failed probe beside 5 requests", one_probe);
+
+    // The next probe succeeds and closes it
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    bool closed = client.post("/events", kEventBody).status_code == 201 &&
+                  client.post("/events", kEventBody).status_code == 201;
+    auto stats = breaker_stats(client, "/events");
+    closed = closed && stats.state == CircuitBreaker::State::CLOSED && stats.times_opened == 2 &&
+             stats.times_half_opened == 2 && stats.times_closed == 1;
+    report("good probe", closed);
+
+    // Many distinct endpoints: idle closed breakers are pruned, an open one
+    // is kept
+    for (int i = 0; i < 3; ++i) {
+        client.post("/agents?status=503", "{}");
+    }
+    for (int i = 0; i < 300; ++i) {
+        client.get("/reports/" + std::to_string(i));
+    }
+    size_t breakers = client.circuit_stats().size();
+    bool bounded = breakers <= 64 &&
+                   breaker_stats(client, "/agents").state == CircuitBreaker::State::OPEN;
+    std::printf("  300 distinct endpoints: %zu breakers, /agents still %s  %s\n", breakers,
+                CircuitBreaker::state_to_string(breaker_stats(client, "/agents").state),
+                bounded ? "ok" : "FAILED");
+    ok = ok && bounded;
+
+    return ok;
+}
+
+enum HeartbeatPhase { IDLE, BUSY, DROP, FAILING, PHASES };
+
+struct HeartbeatCounts {
+    long heartbeats[PHASES] = {};
+    long events[PHASES] = {};
+    long drop_reported_after = -1;  // seconds from the drop to the next heartbeat
+    uint64_t scheduled = 0;
+};
+
+// Two hours on a simulated clock, one tick per second, 30 minutes each:
+// idle, then an event every 10 s: with a healthy server, with one more event
+// dropped locally, and with the server answering 503 to everything.
+// Heartbeats and events are real requests, counted by the server per phase.
+// Degraded follows the agent: events dropped since the last heartbeat.
+HeartbeatCounts run_heartbeats(HttpClient& stats_client, HttpClient& client, HttpClient& failing_client,
+                               HeartbeatScheduler& scheduler) {
+    const int phase_seconds = 1800;
+    const int drop_second = 7;
+    EventReporter healthy(client, "uplink-check");
+    EventReporter failing(failing_client, "uplink-check");
+    AgentHealth health;
+    uint64_t dropped_at_last_heartbeat = 0;
+    HeartbeatCounts counts;
+
+    auto now = HeartbeatScheduler::Clock::time_point() + std::chrono::hours(1);
+    auto last_contact = HeartbeatScheduler::Clock::time_point();
+    for (int phase = 0; phase < PHASES; ++phase) {
+        long heartbeats = server_counter(stats_client, "heartbeat");
+        long events = server_counter(stats_client, "events");
+        EventReporter& reporter = phase == FAILING ? failing : healthy;
+        for (int second = 0; second < phase_seconds; ++second, now += std::chrono::seconds(1)) {
+            if (phase != IDLE && second % 10 == 0) {
+                ++health.events_reported;
+                uint64_t reported = reporter.stats().events_reported;
+                reporter.report("file_modified", "low", "C:\\Users\\check\\notes.txt");
+                reporter.drain(std::chrono::seconds(5));
+                if (reporter.stats().events_reported > reported) {
+                    last_contact = now;
+                } else {
+                    ++health.events_dropped;
+                }
+            }
+            if (phase == DROP && second == drop_second) {
+                ++health.events_dropped;
+            }
+
+            bool degraded = health.events_dropped > dropped_at_last_heartbeat;
+            if (scheduler.due(now, last_contact, degraded)) {
+                if (phase == DROP && second >= drop_second && counts.drop_reported_after < 0) {
+                    counts.drop_reported_after = second - drop_second;
+                }
+                dropped_at_last_heartbeat = health.events_dropped;
+                bool sent = reporter.send_heartbeat("online", &health);
+                if (sent) {
+                    last_contact = now;
+                }
+                scheduler.record_sent(now, sent);
+            }
+        }
+        counts.heartbeats[phase] = server_counter(stats_client, "heartbeat") - heartbeats;
+        counts.events[phase] = server_counter(stats_client, "events") - events;
+    }
+    counts.scheduled = scheduler.sent();
+    return counts;
+}
+
+bool check_heartbeat(const Options& options) {
+    HttpClient stats_client(options.server);
+    HttpClient client(options.server);
+    // No retries and no breaker, so every heartbeat reaches the server
+    HttpClient failing_client(options.server + "/status/503");
+    failing_client.set_retry_policy(1, 100, 100);
+    failing_client.set_circuit_breaker(1000000, 1, 1);
+
+    // The fixed schedule is the adaptive one with all three intervals equal
+    HeartbeatScheduler fixed(std::chrono::seconds(60), std::chrono::seconds(60), std::chrono::seconds(60));
+    HeartbeatScheduler adaptive(std::chrono::seconds(60), std::chrono::seconds(15), std::chrono::seconds(300));
+    long malformed = server_counter(stats_client, "heartbeat.malformed");
+    HeartbeatCounts before = run_heartbeats(stats_client, client, failing_client, fixed);
+    HeartbeatCounts after = run_heartbeats(stats_client, client, failing_client, adaptive);
+    malformed = server_counter(stats_client, "heartbeat.malformed") - malformed;
+
+    const char* phases[] = {"idle", "busy", "drop", "failing"};
+    std::printf("  %-9s %8s %16s %18s %16s\n", "phase", "events", "fixed heartbeats", "adaptive heartbeats",
+                "requests saved");
+    long fixed_total = before.heartbeats[IDLE];
+    long adaptive_total = after.heartbeats[IDLE];
+    bool fewer = true;
+    for (int phase = BUSY; phase < PHASES; ++phase) {
+        long saved = before.heartbeats[phase] + before.events[phase] - after.heartbeats[phase] - after.events[phase];
+        std::printf("  %-9s %8ld %16ld %18ld %16ld\n", phases[phase], after.events[phase],
+                    before.heartbeats[phase], after.heartbeats[phase], saved);
+        fixed_total += before.heartbeats[phase];
+        adaptive_total += after.heartbeats[phase];
+        fewer = fewer && after.heartbeats[phase] < before.heartbeats[phase];
+    }
+    std::printf("  idle (nothing else proves liveness): fixed %ld, adaptive %ld\n", before.heartbeats[IDLE],
+                after.heartbeats[IDLE]);
+    std::printf("  total heartbeats: fixed %ld, adaptive %ld; malformed %ld\n", fixed_total, adaptive_total,
+                malformed);
+    std::printf("  local drop reported after: fixed %ld s, adaptive %ld s\n", before.drop_reported_after,
+                after.drop_reported_after);
+
+    // The server saw exactly what the schedulers sent. With events flowing
+    // the adaptive schedule sends fewer heartbeats in every phase: stretched
+    // while busy, one extra to report the drop within its 15 s minimum
+    // interval, backed off against the failing server. Idle it keeps the
+    // 60 s interval.
+    return malformed == 0 && fixed_total == static_cast<long>(before.scheduled) &&
+           adaptive_total == static_cast<long>(after.scheduled) && fewer &&
+           std::abs(after.heartbeats[IDLE] - before.heartbeats[IDLE]) <= 1 &&
+           after.heartbeats[BUSY] * 4 <= before.heartbeats[BUSY] + 4 &&
+           after.heartbeats[FAILING] * 2 <= before.heartbeats[FAILING] &&
+           after.drop_reported_after >= 0 && after.drop_reported_after <= 15;
+}
+
+// Sequence numbers (the last part of the event id) of an agent's events in
+// the order the server accepted them
+std::vector<uint64_t> accepted_sequences(HttpClient& client, const std::string& agent_id) {
+    std::vector<uint64_t> sequences;
+    HttpResponse response = client.get("/events?agent_id=" + agent_id);
+    nlohmann::json document = nlohmann::json::parse(response.body, nullptr, false);
+    if (response.status_code != 200 || !document.is_object()) {
+        return sequences;
+    }
+    for (const auto& id : document.value("event_ids", nlohmann::json::array())) {
+        std::string text = id.get<std::string>();
+        sequences.push_back(std::strtoull(text.c_str() + text.rfind('-') + 1, nullptr, 10));
+    }
+    return sequences;
+}
+
+std::string registration_payload(const std::string& agent_id) {
+    AgentRegistration registration;
+    registration.agent_id = agent_id;
+    registration.agent_name = agent_id;
+    registration.hostname = "uplink-check";
+    registration.os_type = "linux";
+    registration.agent_version = "1.0.0";
+    return encode_payload(WireFormat::JSON, registration);
+}
+
+bool check_startup(const Options& options) {
+    auto run_id = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+    HttpClient client(options.server);
+    client.set_retry_policy(1, 100, 100);
+    bool ok = true;
+
+    // Registration answered after 200 ms, or not within its 2 s timeout
+    std::printf("  %-11s %-11s %18s  %s\n", "server", "startup", "first event (ms)", "first event");
+    for (int delay_ms : {200, 5000}) {
+        const char* name = delay_ms < 2000 ? "slow" : "no answer";
+        const std::string endpoint = "/agents?delay_ms=" + std::to_string(delay_ms);
+        const std::string registration = registration_payload("startup-" + run_id);
+
+        auto start = Clock::now();
+        bool registered = client.request_async("POST", endpoint, registration, 2000).get().status_code == 201;
+        EventReporter blocking(client, "startup-blocking-" + run_id);
+        // The old startup gave up when registration failed: no monitors
+        if (registered) {
+            blocking.report("file_created", "low", "C:\\check.txt");
+            blocking.drain(std::chrono::seconds(5));
+        }
+        double blocking_ms = seconds_since(start) * 1000.0;
+        std::printf("  %-11s %-11s %18.1f  %s\n", name, "blocking", blocking_ms,
+                    blocking.stats().events_reported == 1 ? "delivered" : "no monitoring");
+
+        EventReporter async(client, "startup-async-" + run_id);
+        async.pause_delivery();
+        start = Clock::now();
+        auto pending = client.request_async("POST", endpoint, registration, 2000);
+        DeliveryResult first = async.report("file_created", "low", "C:\\check.txt");
+        double async_ms = seconds_since(start) * 1000.0;
+        std::printf("  %-11s %-11s %18.1f  %s\n", name, "background", async_ms,
+                    first == DeliveryResult::SPOOLED ? "buffered" : "LOST");
+        ok = ok && first == DeliveryResult::SPOOLED && async_ms < 50.0 && blocking_ms >= 200.0;
+
+        if (pending.get().status_code == 201) {
+            async.resume_delivery();
+            async.drain(std::chrono::seconds(5));
+            ok = ok && registered && accepted_sequences(client, "startup-async-" + run_id).size() == 1;
+        }
+    }
+
+    // 500 held events flushed while another thread keeps reporting
+    const std::string agent_id = "startup-order-" + run_id;
+    EventReporter reporter(client, agent_id);
+    reporter.pause_delivery();
+    for (int i = 0; i < 500; ++i) {
+        reporter.report("file_modified", "low", "C:\\held.txt");
+    }
+    // Paced so the live events overlap the flush rather than all landing in
+    // the buffer before it starts
+    std::atomic<bool> flushing{false};
+    std::thread live([&reporter, &flushing]() {
+        while (!flushing) {
+            std::this_thread::yield();
+        }
+        for (int i = 0; i < 500; ++i) {
+            reporter.report("file_modified", "low", "C:\\live.txt");
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+    flushing = true;
+    reporter.resume_delivery();
+    live.join();
+    // Anything still held after both finished was stranded
+    reporter.resume_delivery();
+    reporter.drain(std::chrono::seconds(30));
+
+    std::vector<uint64_t> sequences = accepted_sequences(client, agent_id);
+    size_t out_of_order = 0;
+    for (size_t i = 1; i < sequences.size(); ++i) {
+        out_of_order += sequences[i] < sequences[i - 1];
+    }
+    auto stats = reporter.stats();
+    std::printf("  1000 events, 500 reported during the flush: %zu accepted, %zu out of order, %llu dropped\n",
+                sequences.size(), out_of_order, static_cast<unsigned long long>(stats.events_dropped));
+    ok = ok && sequences.size() == 1000 && out_of_order == 0 && stats.events_dropped == 0;
+
+    return ok;
+}
+
+// Live events against a server that answers each request after 1 s: the
+// thread reporting them (the monitor thread in the agent) gets control back
+// at once, and the events still arrive, in order
+bool check_live(const Options& options) {
+    auto run_id = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                     std::chrono::system_clock::now().time_since_epoch())
+                                     .count());
+    HttpClient stats_client(options.server);
+    HttpClient slow_client(options.server + "/delay_ms/1000");
+    const int n = 5;
+
+    // What report() used to cost the monitor thread: one blocking post
+    auto start = Clock::now();
+    bool blocking_ok = slow_client.post("/events", kEventBody).status_code == 201;
+    double blocking_ms = seconds_since(start) * 1000.0;
+
+    const std::string agent_id = "live-" + run_id;
+    EventReporter reporter(slow_client, agent_id);
+    double worst_ms = 0.0;
+    start = Clock::now();
+    std::thread monitor([&reporter, &worst_ms]() {
+        for (int i = 0; i < n; ++i) {
+            auto reported = Clock::now();
+            reporter.report("file_modified", "low", "C:\\Users\\check\\live.txt");
+            worst_ms = (std::max)(worst_ms, seconds_since(reported) * 1000.0);
+        }
+    });
+    monitor.join();
+    double monitor_ms = seconds_since(start) * 1000.0;
+    uint64_t answered_early = reporter.stats().events_reported;
+
+    reporter.drain(std::chrono::seconds(30));
+    double delivered_s = seconds_since(start);
+    std::vector<uint64_t> sequences = accepted_sequences(stats_client, agent_id);
+    size_t out_of_order = 0;
+    for (size_t i = 1; i < sequences.size(); ++i) {
+        out_of_order += sequences[i] < sequences[i - 1];
+    }
+
+    std::printf("  blocking post to a 1 s server: %.1f ms\n", blocking_ms);
+    std::printf("  %d live events: monitor thread busy %.1f ms (slowest report() %.1f ms), "
+                "%llu answered by then\n",
+                n, monitor_ms, worst_ms, static_cast<unsigned long long>(answered_early));
+    std::printf("  all delivered after %.3f s: %zu accepted, %zu out of order\n", delivered_s,
+                sequences.size(), out_of_order);
+
+    return blocking_ok && blocking_ms >= 1000.0 && worst_ms < 50.0 && answered_early == 0 &&
+           reporter.stats().events_reported == static_cast<uint64_t>(n) &&
+           sequences.size() == static_cast<size_t>(n) && out_of_order == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--server url] [--scenario name|all] [--requests N]\n", argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::WARNING);
+
+    const std::vector<Scenario> scenarios = {
+        {"pooling", check_pooling},
+        {"async", check_async},
+        {"breaker", check_breaker},
+        {"heartbeat", check_heartbeat},
+        {"startup", check_startup},
+        {"live", check_live},
+    };
+
+    {
+        HttpClient probe(options.server);
+        if (server_counter(probe, "connections") < 0) {
+            std::fprintf(stderr, "No mock server at %s (start tools/mock_server.py)\n", options.server.c_str());
+            return 1;
+        }
+    }
+
+    bool ok = true;
+    int run = 0;
+    for (const auto& scenario : scenarios) {
+        if (options.scenario != "all" && options.scenario != scenario.name) {
+            continue;
+        }
+        ++run;
+        std::printf("== %s\n", scenario.name);
+        std::fflush(stdout);
+        bool passed = scenario.run(options);
+        std::printf("%s: %s\n\n", scenario.name, passed ? "OK" : "FAIL");
+        std::fflush(stdout);
+        ok = ok && passed;
+    }
+
+    if (run == 0) {
+        std::fprintf(stderr, "Unknown scenario: %s\n", options.scenario.c_str());
+        return 1;
+    }
+    std::printf("%s\n", ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+// Uplink load test: drives the agent's reporting stack (EventReporter over
+// HttpClient, optionally with the disk spool) against a local server and
+// reports report() latency percentiles (report() only queues the event; the
+// post happens on the client's I/O thread, one per reporting thread in
+// flight) plus the highest event rate the uplink sustains. Pair with
+// tools/mock_server.py:
+//
+//   python tools/mock_server.py --port 8000 --latency-ms 5 &
+//   uplink_loadtest --server http://127.0.0.1:8000/api/v1 --threads 8
+//
+// The offered rate doubles every stage, starting at --start-rate, until a
+// stage fails to keep up or --max-rate is reached. A stage is sustainable
+// when at least 95% of the offered rate was delivered and nothing had to be
+// spooled or dropped.
+
+#include "event_reporter.h"
+#include "event_spool.h"
+#include "http_client.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string server = "http://127.0.0.1:8000/api/v1";
+    int threads = 4;
+    int duration_s = 10;
+    int start_rate = 100;
+    int max_rate = 100000;
+    std::string encoding = "json";
+    std::string spool_directory;  // empty = no spool, failures are dropped
+};
+
+struct StageResult {
+    int offered_rate = 0;
+    double achieved_rate = 0.0;
+    size_t delivered = 0;
+    size_t spooled = 0;
+    size_t dropped = 0;
+    double p50_ms = 0.0;
+    double p90_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+
+    bool sustainable() const {
+        return spooled == 0 && dropped == 0 && achieved_rate >= offered_rate * 0.95;
+    }
+};
+
+void usage(const char* program) {
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --server URL       Server base URL (default http://127.0.0.1:8000/api/v1)\n"
+        "  --threads N        Reporting threads (default 4)\n"
+        "  --duration S       Seconds per stage (default 10)\n"
+        "  --start-rate R     Offered events/sec of the first stage (default 100)\n"
+        "  --max-rate R       Stop after the stage at or above this rate (default 100000)\n"
+        "  --encoding FMT     json or cbor (default json)\n"
+        "  --spool DIR        Spool undeliverable events to DIR\n",
+        program);
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--threads") {
+            options.threads = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--duration") {
+            options.duration_s = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--start-rate") {
+            options.start_rate = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--max-rate") {
+            options.max_rate = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--encoding") {
+            options.encoding = value;
+        } else if (arg == "--spool") {
+            options.spool_directory = value;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (options.encoding != "json" && options.encoding != "cbor") {
+        std::fprintf(stderr, "Unknown encoding: %s\n", options.encoding.c_str());
+        return false;
+    }
+    return true;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// Open-loop load: each thread sends on a fixed schedule so a slow server
+// shows up as missed send slots (lower achieved rate) rather than as a
+// silently lower offered rate.
+StageResult run_stage(EventReporter& reporter, const Options& options, int offered_rate) {
+    StageResult result;
+    result.offered_rate = offered_rate;
+
+    EventReporter::Stats before = reporter.stats();
+    std::vector<std::vector<double>> latencies(options.threads);
+
+    ClassificationResult classification;
+    classification.labels = {"PAN", "SSN"};
+    classification.confidence = 0.9;
+
+    auto start = Clock::now();
+    auto end = start + std::chrono::seconds(options.duration_s);
+    auto interval = std::chrono::duration<double>(double(options.threads) / offered_rate);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            std::vector<double>& samples = latencies[t];
+            std::string path = "C:\\Users\\loadtest\\Documents\\report-" + std::to_string(t) + ".xlsx";
+
+            // Stagger threads across the first interval
+            auto next = start + std::chrono::duration_cast<Clock::duration>(interval * t / options.threads);
+            while (next < end) {
+                std::this_thread::sleep_until(next);
+
+                auto sent = Clock::now();
+                reporter.report("file", "high", path, &classification);
+                samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - sent).count());
+
+                next += std::chrono::duration_cast<Clock::duration>(interval);
+                // A thread that fell behind skips the slots it missed
+                next = (std::max)(next, Clock::now() - std::chrono::duration_cast<Clock::duration>(interval));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // Events still queued when the load stops count against the stage
+    reporter.drain(std::chrono::seconds(30));
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    EventReporter::Stats after = reporter.stats();
+
+    std::vector<double> all;
+    for (const auto& samples : latencies) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    result.delivered = after.events_reported - before.events_reported;
+    result.spooled = after.events_spooled - before.events_spooled;
+    result.dropped = after.events_dropped - before.events_dropped;
+    result.achieved_rate = result.delivered / elapsed;
+    result.p50_ms = percentile(all, 0.50);
+    result.p90_ms = percentile(all, 0.90);
+    result.p99_ms = percentile(all, 0.99);
+    result.max_ms = all.empty() ? 0.0 : all.back();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    // Per-event logging would dominate the measurement
+    Logger::set_level(Logger::Level::WARNING);
+
+    HttpClient http_client(options.server);
+    http_client.set_max_in_flight(options.threads * 2);
+
+    std::unique_ptr<EventSpool> spool;
+    if (!options.spool_directory.empty()) {
+        std::filesystem::create_directories(options.spool_directory);
+        spool = std::make_unique<EventSpool>(options.spool_directory, 256ull * 1024 * 1024);
+        if (!spool->open()) {
+            std::fprintf(stderr, "Failed to open spool at %s\n", options.spool_directory.c_str());
+            return 1;
+        }
+    }
+
+    EventReporter reporter(http_client, "loadtest-agent", spool.get());
+    reporter.set_wire_format(options.encoding == "cbor" ? WireFormat::CBOR : WireFormat::JSON);
+    reporter.set_send_window(options.threads);
+    reporter.start_replay(1000);
+
+    std::printf("Uplink load test: %s, %d threads, %ds per stage, %s\n\n",
+                options.server.c_str(), options.threads, options.duration_s, options.encoding.c_str());
+    std::printf("%10s %10s %9s %8s %8s %9s %9s %9s %9s\n",
+                "offered/s", "achieved/s", "delivered", "spooled", "dropped",
+                "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+    int best_rate = 0;
+    for (int rate = options.start_rate; ; rate *= 2) {
+        rate = (std::min)(rate, options.max_rate);
+        StageResult stage = run_stage(reporter, options, rate);
+
+        std::printf("%10d %10.0f %9zu %8zu %8zu %9.2f %9.2f %9.2f %9.2f%s\n",
+                    stage.offered_rate, stage.achieved_rate, stage.delivered, stage.spooled,
+                    stage.dropped, stage.p50_ms, stage.p90_ms, stage.p99_ms, stage.max_ms,
+                    stage.sustainable() ? "" : "  (not sustained)");
+        std::fflush(stdout);
+
+        if (!stage.sustainable()) {
+            break;
+        }
+        best_rate = rate;
+        if (rate >= options.max_rate) {
+            break;
+        }
+    }
+
+    std::printf("\nMax sustainable rate: %d events/sec\n", best_rate);
+    return 0;
+}
@@ -0,0 +1,284 @@
+// Removable volume harness: attaches a directory as a stand-in removable
+// volume and drives RemovableVolumeWatcher and EventPipeline the way the
+// agent does when a USB drive is plugged in. Runs on any platform; only the
+// Win32 device detection in USBMonitor is left out.
+//
+//   volume_bench
+//   volume_bench --mount /tmp/volume_mount --files 500 --copies 50
+//   volume_bench --server http://127.0.0.1:8741   # deliver events to the mock server
+//
+// The mount is filled with existing files, attached, and files are copied
+// onto it while the budgeted scan of the existing contents runs. Reported:
+// the scan rate against its budget, how long a copied file takes to be
+// classified (those reads skip the I/O governor queue), whether every event
+// carried the volume's identity, that detaching stops all events and drops
+// the volume's index entries, and that mounting again rescans every file.
+
+#include "removable_volumes.h"
+#include "event_pipeline.h"
+#include "event_reporter.h"
+#include "file_state_index.h"
+#include "http_client.h"
+#include "io_governor.h"
+#include "json_writer.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string mount = "/tmp/volume_mount";
+    std::string server;            // empty = keep events in memory
+    int files = 300;               // already on the volume
+    int copies = 40;               // copied while it is scanned
+    double scan_files_per_sec = 100.0;
+    double io_iops = 20.0;         // I/O governor cap for normal reads
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+
+        if (arg == "--mount") {
+            options.mount = value;
+        } else if (arg == "--server") {
+            options.server = value;
+        } else if (arg == "--files") {
+            options.files = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--copies") {
+            options.copies = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--scan-files-per-sec") {
+            options.scan_files_per_sec = std::atof(value.c_str());
+        } else if (arg == "--io-iops") {
+            options.io_iops = std::atof(value.c_str());
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1;
+}
+
+void write_file(const fs::path& path, int i) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    for (int line = 0; line < 40 + i % 60; ++line) {
+        file << "Quarterly figures, row " << line << ": revenue and costs per region\n";
+    }
+    if (i % 3 == 0) {
+        file << "Customer card 4111 1111 1111 1111, contact jane.doe@example.com\n";
+    }
+}
+
+double percentile(std::vector<double> samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[static_cast<size_t>(p * (samples.size() - 1) + 0.5)];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "Usage: %s [--mount DIR] [--files N] [--copies N] [--scan-files-per-sec R] "
+                             "[--io-iops R] [--server URL]\n", argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::ERROR);
+
+    std::error_code ec;
+    fs::remove_all(options.mount, ec);
+    fs::create_directories(fs::path(options.mount) / "reports", ec);
+    for (int i = 0; i < options.files; ++i) {
+        write_file(fs::path(options.mount) / "reports" / ("existing_" + std::to_string(i) + ".txt"), i);
+    }
+
+    IoGovernor::Limits limits;
+    limits.max_iops = options.io_iops;
+    limits.idle_multiplier = 1.0;
+    IoGovernor::configure(limits);
+
+    HttpClient http_client(options.server.empty() ? "http://127.0.0.1:9/api/v1" : options.server);
+    EventReporter reporter(http_client, "volume-bench");
+    if (options.server.empty()) {
+        reporter.pause_delivery();
+    }
+    FileStateIndex index;
+    EventPipeline pipeline(reporter, index);
+
+    VolumeInfo volume;
+    volume.root = options.mount;
+    volume.label = "KINGSTON";
+    volume.serial = "1A2B-3C4D";
+    volume.file_system = "exFAT";
+    volume.bus = "usb";
+    volume.total_bytes = 16ull * 1024 * 1024 * 1024;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Clock::time_point> copied_at;
+    std::vector<double> copy_latency_ms;
+    std::atomic<uint64_t> events{0}, baseline_events{0}, foreign_volume{0}, after_detach{0};
+    std::atomic<bool> detached{false};
+
+    RemovableVolumeWatcher::Options watcher_options;
+    watcher_options.scan_threads = 2;
+    watcher_options.scan_max_files_per_sec = options.scan_files_per_sec;
+    watcher_options.scan_max_mb_per_sec = 0.0;
+
+    RemovableVolumeWatcher watcher(
+        [&](const std::string& path, const std::string& event_type, const VolumeInfo& event_volume) {
+            ++events;
+            if (detached) {
+                ++after_detach;
+            }
+            if (event_volume.serial != volume.serial || event_volume.root != volume.root) {
+                ++foreign_volume;
+            }
+            if (event_type == "baseline") {
+                ++baseline_events;
+            }
+
+            pipeline.handle_file_event(path, event_type, &event_volume);
+
+            // First classification of each copied file
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = copied_at.find(path);
+            if (it != copied_at.end()) {
+                copy_latency_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - it->second).count());
+                copied_at.erase(it);
+            }
+        },
+        &index,
+        watcher_options
+    );
+
+    pipeline.handle_usb_event(volume);
+    auto attached = Clock::now();
+    if (!watcher.attach(volume)) {
+        std::fprintf(stderr, "Cannot attach %s\n", options.mount.c_str());
+        return 1;
+    }
+
+    // Copy files onto the volume at a few per second while the scan runs
+    fs::create_directories(fs::path(options.mount) / "outgoing", ec);
+    for (int i = 0; i < options.copies; ++i) {
+        fs::path path = fs::path(options.mount) / "outgoing" / ("copy_" + std::to_string(i) + ".txt");
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            copied_at[path.string()] = Clock::now();
+        }
+        write_file(path, i);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    // Let the scan finish
+    RemovableVolumeWatcher::VolumeStats stats;
+    for (;;) {
+        auto all = watcher.stats();
+        stats = all.empty() ? RemovableVolumeWatcher::VolumeStats() : all.front();
+        if (!stats.scanning) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    double scan_seconds = std::chrono::duration<double>(Clock::now() - attached).count();
+
+    // Nothing may arrive once the volume is detached
+    watcher.detach(volume.root);
+    pipeline.handle_usb_removal(volume);
+    detached = true;
+    write_file(fs::path(options.mount) / "outgoing" / "after_detach.txt", 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    size_t missed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        missed = copied_at.size();
+    }
+    uint64_t stray = after_detach;
+
+    // The next medium mounted at the same root must be scanned in full, not
+    // skipped on the previous one's index entries
+    size_t left_in_index = index.paths_under(options.mount).size();
+    detached = false;
+    RemovableVolumeWatcher::VolumeStats remount;
+    if (watcher.attach(volume)) {
+        for (;;) {
+            auto all = watcher.stats();
+            remount = all.empty() ? RemovableVolumeWatcher::VolumeStats() : all.front();
+            if (!remount.scanning) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        watcher.detach(volume.root);
+    }
+    uint64_t on_volume = static_cast<uint64_t>(options.files + options.copies + 1);
+
+    auto io = IoGovernor::stats();
+    auto uplink = reporter.stats();
+    double scan_rate = stats.scan.files_classified / (stats.scan.elapsed_ms / 1000.0);
+
+    std::printf("Volume %s (%s, serial %s)\n", volume.root.c_str(), volume.file_system.c_str(), volume.serial.c_str());
+    std::printf("  scan        %llu files in %.1f s, %.0f files/s (budget %.0f), complete %s\n",
+                static_cast<unsigned long long>(stats.scan.files_classified), scan_seconds, scan_rate,
+                options.scan_files_per_sec, stats.scan.complete ? "yes" : "no");
+    std::printf("  copies      %d written, %zu not classified, latency p50 %.1f ms p99 %.1f ms max %.1f ms\n",
+                options.copies, missed, percentile(copy_latency_ms, 0.5), percentile(copy_latency_ms, 0.99),
+                percentile(copy_latency_ms, 1.0));
+    std::printf("  events      %llu (%llu baseline), %llu without this volume's identity, %llu after detach\n",
+                static_cast<unsigned long long>(events.load()), static_cast<unsigned long long>(baseline_events.load()),
+                static_cast<unsigned long long>(foreign_volume.load()),
+                static_cast<unsigned long long>(stray));
+    std::printf("  remount     %zu index entries left after detach, %llu of %llu files scanned again\n",
+                left_in_index, static_cast<unsigned long long>(remount.scan.files_classified),
+                static_cast<unsigned long long>(on_volume));
+    std::printf("  io governor %llu reads, %llu throttled (%llu ms), %llu priority\n",
+                static_cast<unsigned long long>(io.reads), static_cast<unsigned long long>(io.throttled_reads),
+                static_cast<unsigned long long>(io.throttle_wait_ms), static_cast<unsigned long long>(io.priority_reads));
+    std::printf("  uplink      %llu reported, %llu spooled, %llu dropped%s\n",
+                static_cast<unsigned long long>(uplink.events_reported),
+                static_cast<unsigned long long>(uplink.events_spooled),
+                static_cast<unsigned long long>(uplink.events_dropped),
+                options.server.empty() ? " (delivery paused, no --server)" : "");
+
+    // What the server receives for a sensitive file copied to the volume
+    ClassificationResult sample;
+    sample.labels = {"pan", "email"};
+    sample.confidence = 0.9;
+    DlpEvent event;
+    event.event_id = "evt-sample";
+    event.event_type = "usb_file_created";
+    event.severity = "critical";
+    event.agent_id = "volume-bench";
+    std::string sample_path = options.mount + "/outgoing/copy_0.txt";
+    event.file_path = sample_path;
+    event.classification = &sample;
+    event.volume = &volume;
+    std::string payload;
+    JsonWriter writer(payload);
+    encode(writer, event);
+    std::printf("  sample      %s\n", payload.c_str());
+
+    bool ok = missed == 0 && foreign_volume == 0 && stray == 0 && stats.scan.complete && left_in_index == 0 &&
+              remount.scan.files_classified == on_volume;
+    return ok ? 0 : 1;
+}
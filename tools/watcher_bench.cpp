@@ -0,0 +1,324 @@
+// File watcher benchmark: writes a burst of files into a scratch directory
+// watched by FileMonitor and reports notification throughput (events/sec)
+// and latency from close() of each file to its "modified" callback. With
+// --classify every notification also runs through the Classifier, which
+// measures the agent's file pipeline end to end.
+//
+// Notifications lost to overflow are recovered by FileMonitor's rescan
+// against a FileStateIndex maintained the way the agent does; "missing"
+// counts files that never produced an event. To force overflow, slow the
+// consumer with --slow-us and shrink the OS queue: a small --buffer on
+// Windows, fs.inotify.max_queued_events on Linux.
+//
+// --io-mb-per-sec and --io-iops cap classifier reads through the IoGovernor
+// as the agent does; the report then includes how often reads waited.
+//
+// --check makes it a pass/fail test of overflow recovery: notifications
+// must overflow at least once (the consumer defaults to 200us per event),
+// then every file is deleted the same way, and every created and deleted
+// file must have been reported. Exits non-zero otherwise.
+//
+//   watcher_bench --files 20000 --subdirs 16 --classify
+//   watcher_bench --files 5000 --classify --io-iops 1000
+//   sysctl fs.inotify.max_queued_events=256 && watcher_bench --files 5000 --slow-us 200
+//   watcher_bench --files 20000 --check
+//   watcher_bench --files 5000 --buffer 4096 --check          (Windows)
+
+#include "file_monitor.h"
+#include "classifier.h"
+#include "file_state_index.h"
+#include "io_governor.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace cybersentinel;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct Options {
+    std::string directory;  // empty = temporary directory
+    int files = 10000;
+    int subdirs = 8;
+    int rate = 0;           // files/sec, 0 = as fast as possible
+    int slow_us = 0;        // extra time spent per notification
+    size_t buffer = 0;      // notification buffer, 0 = backend default
+    bool classify = false;
+    bool check = false;
+    double io_mb_per_sec = 0.0;
+    double io_iops = 0.0;
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--classify") {
+            options.classify = true;
+            continue;
+        }
+        if (arg == "--check") {
+            options.check = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        if (arg == "--dir") {
+            options.directory = value;
+        } else if (arg == "--files") {
+            options.files = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--subdirs") {
+            options.subdirs = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--rate") {
+            options.rate = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--slow-us") {
+            options.slow_us = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--buffer") {
+            options.buffer = static_cast<size_t>(std::max(0, std::atoi(value.c_str())));
+        } else if (arg == "--io-mb-per-sec") {
+            options.io_mb_per_sec = std::max(0.0, std::atof(value.c_str()));
+        } else if (arg == "--io-iops") {
+            options.io_iops = std::max(0.0, std::atof(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr,
+            "Usage: %s [--dir DIR] [--files N] [--subdirs N] [--rate FILES_PER_SEC]\n"
+            "          [--slow-us N] [--buffer BYTES] [--classify] [--check]\n"
+            "          [--io-mb-per-sec N] [--io-iops N]\n",
+            argv[0]);
+        return 1;
+    }
+
+    Logger::set_level(Logger::Level::WARNING);
+    if (options.check && options.slow_us == 0) {
+        options.slow_us = 200;
+    }
+
+    IoGovernor::Limits io_limits;
+    io_limits.max_bytes_per_sec = options.io_mb_per_sec * 1024 * 1024;
+    io_limits.max_iops = options.io_iops;
+    IoGovernor::configure(io_limits);
+
+    fs::path root = options.directory.empty()
+        ? fs::temp_directory_path() / ("watcher_bench_" + std::to_string(Clock::now().time_since_epoch().count()))
+        : fs::path(options.directory);
+    fs::create_directories(root);
+    for (int d = 0; d < options.subdirs; ++d) {
+        fs::create_directories(root / ("dir" + std::to_string(d)));
+    }
+
+    // close() time per file, read by the watcher thread
+    std::unordered_map<std::string, Clock::time_point> written;
+    std::mutex written_mutex;
+    std::vector<double> latencies;
+    latencies.reserve(options.files);
+
+    std::atomic<size_t> events{0};
+    std::atomic<size_t> sensitive{0};
+    std::atomic<Clock::rep> last_event{0};
+    FileStateIndex index;
+    const Classifier classifier;
+
+    // Deleted files not yet reported, for --check
+    std::unordered_map<std::string, bool> deleted;
+
+    FileMonitor monitor({root.string()}, [&](const std::string& path, const std::string& event_type) {
+        auto now = Clock::now();
+        ++events;
+        last_event = now.time_since_epoch().count();
+
+        if (options.slow_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(options.slow_us));
+        }
+
+        if (event_type == "deleted") {
+            index.erase(path);
+            std::lock_guard<std::mutex> lock(written_mutex);
+            deleted.erase(path);
+            return;
+        }
+
+        // Rescans report files missed during overflow as created/modified
+        {
+            std::lock_guard<std::mutex> lock(written_mutex);
+            auto it = written.find(path);
+            if (it != written.end()) {
+                latencies.push_back(std::chrono::duration<double, std::milli>(now - it->second).count());
+                written.erase(it);
+            }
+        }
+
+        if (options.classify) {
+            if (!classifier.classify_file(path).labels.empty()) {
+                ++sensitive;
+            }
+        }
+
+        FileState state;
+        if (FileStateIndex::stat(path, state)) {
+            index.update(path, state);
+        }
+    }, &index);
+    monitor.set_notify_buffer_size(options.buffer);
+
+    if (!monitor.start()) {
+        std::fprintf(stderr, "Failed to start file monitor on %s\n", root.string().c_str());
+        return 1;
+    }
+
+    const std::string content =
+        "Quarterly report draft\nContact: jane.doe@example.com\nSSN 123-45-6789\n";
+
+    auto start = Clock::now();
+    auto interval = options.rate > 0 ? std::chrono::duration<double>(1.0 / options.rate)
+                                     : std::chrono::duration<double>(0);
+    for (int i = 0; i < options.files; ++i) {
+        if (options.rate > 0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(interval * i));
+        }
+
+        fs::path file = root / ("dir" + std::to_string(i % options.subdirs)) / ("file" + std::to_string(i) + ".txt");
+        std::ofstream out(file, std::ios::binary);
+        out << content;
+
+        // Hold the lock across close() so the notification cannot be
+        // matched before its timestamp is recorded
+        std::lock_guard<std::mutex> lock(written_mutex);
+        auto closed = Clock::now();
+        out.close();
+        written[file.string()] = closed;
+    }
+    auto write_end = Clock::now();
+
+    // Wait until notifications stop arriving and no rescan finishes
+    auto wait_quiet = [&]() {
+        size_t seen = 0;
+        uint64_t rescans = 0;
+        do {
+            seen = events;
+            rescans = monitor.rescan_stats().rescans;
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        } while (events != seen || monitor.rescan_stats().rescans != rescans);
+    };
+    wait_quiet();
+
+    // Then delete everything the same way
+    uint64_t create_overflows = monitor.overflow_count();
+    size_t files_deleted = 0;
+    if (options.check) {
+        std::error_code ec;
+        for (int i = 0; i < options.files; ++i) {
+            fs::path file = root / ("dir" + std::to_string(i % options.subdirs)) /
+                            ("file" + std::to_string(i) + ".txt");
+            std::lock_guard<std::mutex> lock(written_mutex);
+            deleted[file.string()] = true;
+            if (fs::remove(file, ec)) {
+                ++files_deleted;
+            } else {
+                deleted.erase(file.string());
+            }
+        }
+        wait_quiet();
+    }
+
+    monitor.stop();
+
+    double write_seconds = std::chrono::duration<double>(write_end - start).count();
+    double event_seconds = std::chrono::duration<double>(
+        Clock::time_point(Clock::duration(last_event.load())) - start).count();
+    auto rescan = monitor.rescan_stats();
+
+    std::lock_guard<std::mutex> lock(written_mutex);
+    std::sort(latencies.begin(), latencies.end());
+
+    std::printf("Backend:          %s\n", monitor.backend_name().c_str());
+    std::printf("Files written:    %d in %.2fs (%.0f files/sec)\n",
+                options.files, write_seconds, options.files / write_seconds);
+    std::printf("Events received:  %zu in %.2fs (%.0f events/sec)\n",
+                events.load(), event_seconds, events / event_seconds);
+    std::printf("Files seen:       %zu, missing: %zu\n", latencies.size(), written.size());
+    std::printf("Overflows:        %llu, rescans: %llu (%llu files examined, %llu changed, %llu ms)\n",
+                static_cast<unsigned long long>(rescan.overflows),
+                static_cast<unsigned long long>(rescan.rescans),
+                static_cast<unsigned long long>(rescan.files_examined),
+                static_cast<unsigned long long>(rescan.files_changed),
+                static_cast<unsigned long long>(rescan.rescan_ms));
+    std::printf("Latency ms:       p50 %.3f  p90 %.3f  p99 %.3f  max %.3f\n",
+                percentile(latencies, 0.50), percentile(latencies, 0.90),
+                percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back());
+    if (options.classify) {
+        auto io = IoGovernor::stats();
+        std::printf("Classified:       %zu sensitive\n", sensitive.load());
+        std::printf("I/O governor:     %llu reads, %llu throttled, %llu ms waited%s\n",
+                    static_cast<unsigned long long>(io.reads),
+                    static_cast<unsigned long long>(io.throttled_reads),
+                    static_cast<unsigned long long>(io.throttle_wait_ms),
+                    io.idle ? " (caps relaxed: system idle)" : "");
+    }
+
+    bool ok = true;
+    if (options.check) {
+        uint64_t delete_overflows = monitor.overflow_count() - create_overflows;
+        std::printf("Check:            created %zu/%d reported (%llu overflows), deleted %zu/%zu reported "
+                    "(%llu overflows)\n",
+                    options.files - written.size(), options.files,
+                    static_cast<unsigned long long>(create_overflows), files_deleted - deleted.size(),
+                    files_deleted, static_cast<unsigned long long>(delete_overflows));
+        int shown = 0;
+        for (const auto& entry : written) {
+            if (shown++ < 5) {
+                std::printf("  never reported created: %s\n", entry.first.c_str());
+            }
+        }
+        for (const auto& entry : deleted) {
+            if (shown++ < 10) {
+                std::printf("  never reported deleted: %s\n", entry.first.c_str());
+            }
+        }
+        if (create_overflows == 0) {
+            std::printf("  no overflow was forced; raise --files or --slow-us, or lower --buffer (Windows) or "
+                        "fs.inotify.max_queued_events (Linux)\n");
+        }
+        ok = create_overflows > 0 && written.empty() && deleted.empty() &&
+             files_deleted == static_cast<size_t>(options.files);
+        std::printf("\n%s\n", ok ? "OK" : "FAIL");
+    }
+
+    if (options.directory.empty()) {
+        std::error_code ec;
+        fs::remove_all(root, ec);
+    }
+    return ok ? 0 : 1;
+}